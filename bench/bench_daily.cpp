@@ -0,0 +1,39 @@
+/**
+ * @file bench_daily.cpp
+ * @brief Défi du jour (engine/daily.h) : jugement des graines candidates
+ *
+ * BM_judgeSeed : parties simulées demandées par candidate. Un tour juge
+ * KBenchSeeds graines consécutives, avec les critères de candy_daily ; les
+ * compteurs donnent les parties réellement jouées (le jugement s'arrête au
+ * refus certain) et la part de graines acceptées.
+ */
+#include "harness.h"
+#include "../engine/daily.h"
+#include "../engine/grid.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t KBenchSeed (42);
+const unsigned KBenchSeeds (4);
+
+void BM_judgeSeed (BenchState & state) {
+    const DailyCriteria criteria = {KGridSize, KNbCandies, unsigned(state.range(0)), 3, 150, 5, 10, 1, 0, 0};
+    uint64_t games = 0, accepted = 0;
+    while (state.keepRunning()) {
+        for (unsigned k = 0; k < KBenchSeeds; ++k) {
+            const SeedVerdict verdict = judgeSeed(KBenchSeed + k, criteria);
+            games += verdict.games;
+            accepted += verdict.accepted;
+        }
+    }
+    const double judged = double(state.iterations()) * KBenchSeeds;
+    state.setCounter("games", games / judged);
+    state.setCounter("accepted", accepted / judged);
+    state.setItemsProcessed(games);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_judgeSeed, argsProduct({{300, 1000, 3000}}));
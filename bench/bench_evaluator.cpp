@@ -0,0 +1,39 @@
+/**
+ * @file bench_evaluator.cpp
+ * @brief Benchmarks de l'évaluation parallèle des coups (engine/evaluator.h)
+ *
+ * Argument : taille de la grille puis nombre de fils (fil appelant compris).
+ */
+#include "harness.h"
+#include "../engine/evaluator.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+/**
+ * @brief Tous les coups légaux d'une grille joués jusqu'au bout de la réaction en chaîne (règles de main.cpp)
+ */
+void BM_evaluateMoves (BenchState & state) {
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, state.range(0));
+    MoveEvaluator evaluator(state.range(1));
+    const EvalConfig config = {RuleFibonacci, false, false, KNbCandies, 3, 0, KBenchSeed, nullptr};
+    vector<MoveScore> best;
+    EvalReport report = {0, 0, true};
+    while (state.keepRunning()) {
+        report = evaluator.evaluate(grid, config, best);
+        doNotOptimize(best.data());
+    }
+    state.setItemsProcessed(state.iterations() * report.candidates);
+    state.setCounter("candidates", report.candidates);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_evaluateMoves, argsProduct({{8, 16, 32}, {1, 4}}));
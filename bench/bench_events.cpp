@@ -0,0 +1,71 @@
+/**
+ * @file bench_events.cpp
+ * @brief Benchmarks du flux d'événements (engine/events.h)
+ *
+ * BM_eventPublish : abonnés qui lisent le flux (0, 1 ou 4). BM_eventClear :
+ * taille de la grille puis flux installé (0 ou 1).
+ */
+#include "harness.h"
+#include "../engine/events.h"
+#include "../engine/grid.h"
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+/**
+ * @brief Publication seule : le producteur ne doit pas ralentir quand des abonnés lisent
+ */
+void BM_eventPublish (BenchState & state) {
+    EventStream stream;
+    vector<unique_ptr<EventSubscriber> > subscribers;
+    vector<uint64_t> seen (state.range(0), 0);   // une somme par abonné (chacun sur son fil)
+    for (long s = 0; s < state.range(0); ++s) {
+        uint64_t * sum = &seen[s];
+        subscribers.emplace_back(new EventSubscriber(stream, [sum] (const GameEvent & event) { *sum += event.value; }));
+    }
+
+    uint64_t n = 0;
+    while (state.keepRunning()) {
+        stream.publish(GameEvent {EventScoreChanged, 0, 0, 0, 0, n});
+        n++;
+    }
+    uint64_t dropped = 0;
+    for (unique_ptr<EventSubscriber> & subscriber : subscribers) {
+        subscriber->stop();
+        dropped += subscriber->dropped();
+    }
+    doNotOptimize(seen.data());
+    if (!subscribers.empty()) state.setCounter("dropped_per_subscriber", double(dropped) / subscribers.size() / n);
+    state.setItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Coût des événements dans un noyau : une colonne vidée puis remplie, avec ou sans EventScope
+ */
+void BM_eventClear (BenchState & state) {
+    const unsigned size = state.range(0);
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, size);
+    EventStream stream;
+    EventScope scope(state.range(1) ? &stream : nullptr);
+    unsigned abs = 0;
+    while (state.keepRunning()) {
+        removalInColumn(grid, maPosition {abs, size - 3}, 3);
+        abs = (abs + 1) % size;
+    }
+    doNotOptimize(grid[0][0]);
+    state.setCounter("events", stream.published());
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_eventPublish, argsProduct({{0, 1, 4}}));
+BENCHMARK_ARGS(BM_eventClear, argsProduct({{8, 64, 1024}, {0, 1}}));
@@ -0,0 +1,88 @@
+/**
+ * @file bench_history.cpp
+ * @brief Benchmarks de l'historique des coups (engine/history.h)
+ *
+ * Argument : taille de la grille. Le coup mesuré est le premier coup légal de
+ * la grille, suivi de sa réaction en chaîne. L'historique suit les cases
+ * modifiées pendant le coup : BM_recordMove compte le coup, son
+ * enregistrement et son annulation (le coût de l'annulation seule est celui
+ * de BM_undoRedo).
+ */
+#include "harness.h"
+#include "../engine/history.h"
+#include "../engine/spawn.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+/**
+ * @brief Grille de départ et premier coup légal
+ */
+void findMove (unsigned size, mat & grid, maPosition & pos, char & direction) {
+    srand(KBenchSeed);
+    initGrid(grid, size);
+    for (unsigned ord = 0; ord < size; ++ord)
+        for (unsigned abs = 0; abs < size; ++abs)
+            for (char tried : {'S', 'D'}) {
+                if (!isLegalMove(grid, maPosition {abs, ord}, tried)) continue;
+                pos = maPosition {abs, ord};
+                direction = tried;
+                return;
+            }
+}
+
+/**
+ * @brief Coup et réaction en chaîne joués sur la grille (mêmes bonbons à chaque fois)
+ */
+uint64_t playMove (mat & grid, const maPosition & pos, char direction) {
+    uint64_t spawnState = KBenchSeed;
+    RandomScope randomScope(&spawnState);
+    makeAMove(grid, pos, direction);
+    return resolveCascade(grid);
+}
+
+/**
+ * @brief Coup enregistré : cases signalées pendant le coup, puis différences, puis annulé
+ */
+void BM_recordMove (BenchState & state) {
+    mat grid;
+    maPosition pos = {0, 0};
+    char direction = 'S';
+    findMove(state.range(0), grid, pos, direction);
+    MoveHistory history;
+    uint64_t score = 0;
+    while (state.keepRunning()) {
+        history.beginMove(grid, score);
+        score += playMove(grid, pos, direction);
+        history.endMove(grid, score);
+        history.undo(grid, score);
+    }
+    state.setCounter("bytes_per_move", double(history.bytes()));
+}
+
+void BM_undoRedo (BenchState & state) {
+    mat grid;
+    maPosition pos = {0, 0};
+    char direction = 'S';
+    findMove(state.range(0), grid, pos, direction);
+    MoveHistory history;
+    uint64_t score = 0;
+    history.beginMove(grid, score);
+    score += playMove(grid, pos, direction);
+    history.endMove(grid, score);
+    while (state.keepRunning()) {
+        history.undo(grid, score);
+        history.redo(grid, score);
+        doNotOptimize(grid[0][0]);
+    }
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_recordMove, argsProduct({{8, 64, 1024}}));
+BENCHMARK_ARGS(BM_undoRedo, argsProduct({{8, 64, 1024}}));
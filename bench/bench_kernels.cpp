@@ -0,0 +1,152 @@
+/**
+ * @file bench_kernels.cpp
+ * @brief Benchmarks des noyaux de la grille (engine/grid.h)
+ *
+ * Arguments de chaque benchmark : taille de la grille puis nombre de types de bonbons.
+ * Les grilles de départ sont générées par initGrid, donc sans alignement :
+ * les fonctions de détection parcourent toute la grille (pire cas).
+ */
+#include "harness.h"
+#include "../engine/grid.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+/**
+ * @brief Grille de départ reproductible pour une taille et un nombre de bonbons
+ */
+mat makeBoard (const BenchState & state) {
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, state.range(0), state.range(1));
+    return grid;
+}
+
+long cellsOf (const BenchState & state) {
+    return state.range(0) * state.range(0);
+}
+
+void BM_initGrid (BenchState & state) {
+    srand(KBenchSeed);
+    mat grid;
+    while (state.keepRunning()) {
+        initGrid(grid, state.range(0), state.range(1));
+        doNotOptimize(grid[0][0]);
+    }
+    state.setItemsProcessed(state.iterations() * cellsOf(state));
+}
+
+void BM_checkInitialMatch (BenchState & state) {
+    mat grid = makeBoard(state);
+    while (state.keepRunning()) {
+        bool found = checkInitialMatch(grid);
+        doNotOptimize(found);
+    }
+    state.setItemsProcessed(state.iterations() * cellsOf(state));
+}
+
+void BM_atLeastThreeInAColumn (BenchState & state) {
+    mat grid = makeBoard(state);
+    maPosition pos;
+    unsigned howMany = 0;
+    while (state.keepRunning()) {
+        bool found = atLeastThreeInAColumn(grid, pos, howMany);
+        doNotOptimize(found);
+    }
+    state.setItemsProcessed(state.iterations() * cellsOf(state));
+}
+
+void BM_atLeastThreeInARow (BenchState & state) {
+    mat grid = makeBoard(state);
+    maPosition pos;
+    unsigned howMany = 0;
+    while (state.keepRunning()) {
+        bool found = atLeastThreeInARow(grid, pos, howMany);
+        doNotOptimize(found);
+    }
+    state.setItemsProcessed(state.iterations() * cellsOf(state));
+}
+
+/**
+ * @brief Supprime un alignement de 3 dans une colonne tirée au hasard (gravité + remplissage)
+ */
+void BM_removalInColumn (BenchState & state) {
+    mat grid = makeBoard(state);
+    const unsigned size = state.range(0);
+    const unsigned nbCandies = state.range(1);
+    while (state.keepRunning()) {
+        maPosition pos = {unsigned(rand()) % size, unsigned(rand()) % (size - 2)};
+        removalInColumn(grid, pos, 3, nbCandies);
+        doNotOptimize(grid[0][pos.abs]);
+    }
+    state.setItemsProcessed(state.iterations() * size);
+}
+
+/**
+ * @brief Supprime un alignement de 3 dans une ligne tirée au hasard (3 colonnes à faire tomber)
+ */
+void BM_removalInRow (BenchState & state) {
+    mat grid = makeBoard(state);
+    const unsigned size = state.range(0);
+    const unsigned nbCandies = state.range(1);
+    while (state.keepRunning()) {
+        maPosition pos = {unsigned(rand()) % (size - 2), unsigned(rand()) % size};
+        removalInRow(grid, pos, 3, nbCandies);
+        doNotOptimize(grid[0][pos.abs]);
+    }
+    state.setItemsProcessed(state.iterations() * 3 * size);
+}
+
+void BM_makeAMove (BenchState & state) {
+    mat grid = makeBoard(state);
+    const unsigned size = state.range(0);
+    const char directions[] = {'Q', 'Z', 'D', 'S'};
+    while (state.keepRunning()) {
+        maPosition pos = {unsigned(rand()) % size, unsigned(rand()) % size};
+        makeAMove(grid, pos, directions[rand() % 4]);
+        doNotOptimize(grid[pos.ord][pos.abs]);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Force un alignement vertical de 3 puis résout toute la réaction en chaîne
+ *
+ * L'alignement est placé dans les 8 premières lignes (la hauteur d'une grille
+ * de jeu) : plus bas, la chute décale des centaines de cases et chaque pas de
+ * cascade refait un parcours complet de la grille, ce qui rend la mesure
+ * interminable sur 1024x1024 avec 3 couleurs.
+ * Le compteur combo_per_move donne la profondeur moyenne des cascades mesurées.
+ */
+void BM_resolveCascade (BenchState & state) {
+    mat grid = makeBoard(state);
+    const unsigned size = state.range(0);
+    const unsigned nbCandies = state.range(1);
+    unsigned long long totalCombo = 0;
+    while (state.keepRunning()) {
+        unsigned col = unsigned(rand()) % size;
+        unsigned row = unsigned(rand()) % (min(size, KGridSize) - 2);
+        grid[row][col] = grid[row + 1][col] = grid[row + 2][col] = 1 + rand() % nbCandies;
+        totalCombo += resolveCascade(grid, nbCandies);
+    }
+    doNotOptimize(totalCombo);
+    state.setItemsProcessed(state.iterations());
+    state.setCounter("combo_per_move", double(totalCombo) / state.iterations());
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_initGrid, gridArgs());
+BENCHMARK_ARGS(BM_checkInitialMatch, gridArgs());
+BENCHMARK_ARGS(BM_atLeastThreeInAColumn, gridArgs());
+BENCHMARK_ARGS(BM_atLeastThreeInARow, gridArgs());
+BENCHMARK_ARGS(BM_removalInColumn, gridArgs());
+BENCHMARK_ARGS(BM_removalInRow, gridArgs());
+BENCHMARK_ARGS(BM_makeAMove, gridArgs());
+BENCHMARK_ARGS(BM_resolveCascade, gridArgs());
@@ -0,0 +1,118 @@
+/**
+ * @file bench_leaderboard.cpp
+ * @brief Classement des scores (engine/leaderboard.h) contre le tableau trié des anciennes versions
+ *
+ * BM_leaderboardRecord : nombre d'entrées puis stockage (0 : tableau trié,
+ * 1 : Leaderboard). Un tour ajoute une partie et lit son rang et les dix
+ * premiers, comme la fin d'une partie. BM_leaderboardLookup : nombre
+ * d'entrées ; un tour lit le rang d'un score et le score d'un rang tirés au hasard.
+ * BM_playerIntern : nombre de joueurs différents ; un tour donne son numéro
+ * à un pseudo tiré parmi eux, le compteur registry_bytes donne la mémoire du registre.
+ * BM_leaderboardLoad : nombre d'entrées du fichier puis lecture (0 : flux
+ * ifstream ligne par ligne comme les anciennes versions, 1 : Leaderboard::load,
+ * fichier projeté) ; un tour relit tout le fichier de scores.
+ */
+#include "harness.h"
+#include "../engine/leaderboard.h"
+#include "../engine/players.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+const unsigned KBenchScoreRange (1000000);
+const size_t KBenchShown (10);
+
+Leaderboard makeLeaderboard (size_t entries) {
+    srand(KBenchSeed);
+    Leaderboard board(RankHighFirst);
+    for (size_t k = 0; k < entries; ++k) board.insert("joueur", rand() % KBenchScoreRange);
+    return board;
+}
+
+void BM_leaderboardRecord (BenchState & state) {
+    const size_t entries = state.range(0);
+    if (state.range(1) == 0) {
+        // Meilleurs scores d'abord : le rang est la place d'insertion
+        srand(KBenchSeed);
+        vector<RankEntry> scores (entries, RankEntry {"joueur", 0});
+        for (RankEntry & entry : scores) entry.value = rand() % KBenchScoreRange;
+        auto better = [] (const RankEntry & a, const RankEntry & b) { return a.value > b.value; };
+        sort(scores.begin(), scores.end(), better);
+        while (state.keepRunning()) {
+            const RankEntry entry = {"joueur", uint64_t(rand() % KBenchScoreRange)};
+            const auto place = upper_bound(scores.begin(), scores.end(), entry, better);
+            const size_t rank = scores.insert(place, entry) - scores.begin() + 1;
+            const vector<RankEntry> best (scores.begin(), scores.begin() + KBenchShown);
+            doNotOptimize(rank);
+            doNotOptimize(best);
+        }
+    }
+    else {
+        Leaderboard board = makeLeaderboard(entries);
+        vector<RankEntry> best;
+        while (state.keepRunning()) {
+            doNotOptimize(board.insert("joueur", rand() % KBenchScoreRange));
+            board.page(1, KBenchShown, best);
+            doNotOptimize(best);
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_leaderboardLookup (BenchState & state) {
+    const size_t entries = state.range(0);
+    const Leaderboard board = makeLeaderboard(entries);
+    RankEntry entry;
+    while (state.keepRunning()) {
+        doNotOptimize(board.rankOf(rand() % KBenchScoreRange));
+        doNotOptimize(board.at(1 + size_t(rand()) % entries, entry));
+    }
+    state.setItemsProcessed(2 * state.iterations());
+}
+
+void BM_playerIntern (BenchState & state) {
+    const size_t players = state.range(0);
+    vector<string> pseudos (players);
+    for (size_t k = 0; k < players; ++k) pseudos[k] = "joueur_" + to_string(k);
+    srand(KBenchSeed);
+    PlayerRegistry registry;
+    while (state.keepRunning()) doNotOptimize(registry.intern(pseudos[size_t(rand()) % players]));
+    state.setCounter("registry_bytes", registry.bytes());
+    state.setItemsProcessed(state.iterations());
+}
+
+void BM_leaderboardLoad (BenchState & state) {
+    const size_t entries = state.range(0);
+    const string fileName = "bench_scores_" + to_string(entries) + ".txt";
+    makeLeaderboard(entries).save(fileName);
+    Leaderboard board(RankHighFirst);
+    while (state.keepRunning()) {
+        if (state.range(1) == 0) {
+            board.clear();
+            ifstream file(fileName);
+            uint64_t value;
+            string pseudo;
+            while (file >> value >> pseudo) board.insert(pseudo, value);
+        }
+        else {
+            board.load(fileName);
+        }
+        doNotOptimize(board.size());
+    }
+    remove(fileName.c_str());
+    state.setItemsProcessed(state.iterations() * entries);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_leaderboardRecord, argsProduct({{1000, 100000, 2000000}, {0, 1}}));
+BENCHMARK_ARGS(BM_leaderboardLookup, argsProduct({{1000, 100000, 2000000}}));
+BENCHMARK_ARGS(BM_playerIntern, argsProduct({{100, 10000, 1000000}}));
+BENCHMARK_ARGS(BM_leaderboardLoad, argsProduct({{1000, 100000, 2000000}, {0, 1}}));
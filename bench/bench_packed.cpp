@@ -0,0 +1,116 @@
+/**
+ * @file bench_packed.cpp
+ * @brief Grille compacte (engine/packed.h) contre la grille mat (un vector<unsigned> par ligne)
+ *
+ * Arguments : taille de la grille puis stockage (0 : mat, 1 : PackedGrid).
+ * Les grilles sont générées par initGrid avec la même graine : les deux
+ * stockages mesurent exactement la même grille. Le compteur bytes_per_cell
+ * donne la mémoire occupée par case.
+ */
+#include "harness.h"
+#include "../engine/packed.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+const unsigned KBenchCandies (4);
+
+double bytesPerCell (const mat & grid) {
+    double bytes = grid.capacity() * sizeof(line);
+    for (const line & row : grid) bytes += row.capacity() * sizeof(unsigned);
+    return bytes / (double(grid.size()) * grid.size());
+}
+
+double bytesPerCell (const PackedGrid & grid) {
+    return double(packedBytes(grid)) / (double(grid.size) * grid.size);
+}
+
+template <typename Grid>
+Grid makeBoard (unsigned size) {
+    srand(KBenchSeed);
+    Grid grid;
+    initGrid(grid, size, KBenchCandies);
+    return grid;
+}
+
+/**
+ * @brief Détection sur une grille sans alignement : toute la grille est lue
+ */
+template <typename Grid>
+void scanColumns (BenchState & state) {
+    const unsigned size = state.range(0);
+    const Grid grid = makeBoard<Grid>(size);
+    maPosition pos;
+    unsigned howMany = 0;
+    while (state.keepRunning()) doNotOptimize(atLeastThreeInAColumn(grid, pos, howMany));
+    state.setCounter("bytes_per_cell", bytesPerCell(grid));
+    state.setItemsProcessed(state.iterations() * size * size);
+}
+
+template <typename Grid>
+void scanRows (BenchState & state) {
+    const unsigned size = state.range(0);
+    const Grid grid = makeBoard<Grid>(size);
+    maPosition pos;
+    unsigned howMany = 0;
+    while (state.keepRunning()) doNotOptimize(atLeastThreeInARow(grid, pos, howMany));
+    state.setCounter("bytes_per_cell", bytesPerCell(grid));
+    state.setItemsProcessed(state.iterations() * size * size);
+}
+
+/**
+ * @brief Match horizontal de 3 au milieu de la grille : la moitié des lignes descend sous le masque
+ */
+template <typename Grid>
+void gravityRow (BenchState & state) {
+    const unsigned size = state.range(0);
+    Grid grid = makeBoard<Grid>(size);
+    unsigned abs = 0;
+    while (state.keepRunning()) {
+        removalInRow(grid, maPosition {abs, size / 2}, 3, KBenchCandies);
+        abs = (abs + 3) % (size - 2);
+    }
+    state.setItemsProcessed(state.iterations() * 3 * (size / 2));
+}
+
+/**
+ * @brief Match vertical de 3 au bas de la grille : toute la colonne descend
+ */
+template <typename Grid>
+void gravityColumn (BenchState & state) {
+    const unsigned size = state.range(0);
+    Grid grid = makeBoard<Grid>(size);
+    unsigned abs = 0;
+    while (state.keepRunning()) {
+        removalInColumn(grid, maPosition {abs, size - 3}, 3, KBenchCandies);
+        abs = (abs + 1) % size;
+    }
+    state.setItemsProcessed(state.iterations() * size);
+}
+
+void BM_layoutColumnScan (BenchState & state) {
+    state.range(1) ? scanColumns<PackedGrid>(state) : scanColumns<mat>(state);
+}
+
+void BM_layoutRowScan (BenchState & state) {
+    state.range(1) ? scanRows<PackedGrid>(state) : scanRows<mat>(state);
+}
+
+void BM_layoutGravityRow (BenchState & state) {
+    state.range(1) ? gravityRow<PackedGrid>(state) : gravityRow<mat>(state);
+}
+
+void BM_layoutGravityColumn (BenchState & state) {
+    state.range(1) ? gravityColumn<PackedGrid>(state) : gravityColumn<mat>(state);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_layoutColumnScan, argsProduct({{64, 1024, 4096}, {0, 1}}));
+BENCHMARK_ARGS(BM_layoutRowScan, argsProduct({{64, 1024, 4096}, {0, 1}}));
+BENCHMARK_ARGS(BM_layoutGravityRow, argsProduct({{64, 1024, 4096}, {0, 1}}));
+BENCHMARK_ARGS(BM_layoutGravityColumn, argsProduct({{64, 1024, 4096}, {0, 1}}));
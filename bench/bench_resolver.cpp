@@ -0,0 +1,54 @@
+/**
+ * @file bench_resolver.cpp
+ * @brief Benchmarks de la réaction en chaîne répartie entre les fils (engine/resolver.h)
+ *
+ * BM_bandResolve : taille de la grille puis nombre de fils (fil appelant compris).
+ * A chaque tour, KForcedMatches alignements verticaux de 3 sont posés au
+ * hasard puis toute la réaction en chaîne est résolue. Le compteur
+ * steps_per_resolve donne le nombre moyen de pas ; le débit compte toute la
+ * grille à chaque pas, même si seules les lignes qui ont bougé sont relues.
+ *
+ * Les grilles de 16384 ne tournent qu'avec --benchmark_long : 1 Gio pour la
+ * seule grille, et une réaction en chaîne de quelques milliers de pas (le
+ * nombre de pas croît comme la taille) qui demande des heures sur un fil,
+ * d'où seulement 8 fils et plus.
+ */
+#include "harness.h"
+#include "../engine/resolver.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+const unsigned KBenchCandies (5);
+const unsigned KForcedMatches (64);
+
+void BM_bandResolve (BenchState & state) {
+    const unsigned size = state.range(0);
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, size, KBenchCandies);
+    BandResolver resolver(state.range(1));
+
+    uint64_t seed = KBenchSeed;
+    unsigned long long steps = 0;
+    while (state.keepRunning()) {
+        for (unsigned k = 0; k < KForcedMatches; ++k) {
+            const unsigned col = unsigned(rand()) % size;
+            const unsigned row = unsigned(rand()) % (size - 2);
+            grid[row][col] = grid[row + 1][col] = grid[row + 2][col] = 1 + rand() % KBenchCandies;
+        }
+        steps += resolver.resolve(grid, RuleFibonacci, KBenchCandies, seed++).steps;
+    }
+    doNotOptimize(grid[0][0]);
+    state.setCounter("steps_per_resolve", double(steps) / state.iterations());
+    state.setItemsProcessed(steps * size * size);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_bandResolve, argsProduct({{256, 1024}, {1, 2, 4, 8, 16, 32}}));
+BENCHMARK_LONG_ARGS(BM_bandResolve, argsProduct({{16384}, {8, 16, 32}}));
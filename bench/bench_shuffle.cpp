@@ -0,0 +1,68 @@
+/**
+ * @file bench_shuffle.cpp
+ * @brief Benchmarks des grilles bloquées (engine/shuffle.h)
+ *
+ * BM_hasLegalMove : taille de la grille (grille bloquée : toutes les cases sont essayées).
+ * BM_reshuffleGrid : taille de la grille puis grille de départ (0 : bloquée, 1 : une couleur sur 60 %).
+ */
+#include "harness.h"
+#include "../engine/shuffle.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Grille pleine sans aucun coup légal : carrés 2x2 de quatre couleurs répétés
+ */
+mat deadlockedGrid (unsigned size) {
+    mat grid(size, line(size));
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) grid[i][j] = (i % 2) * 2 + (j % 2) + 1;
+    }
+    return grid;
+}
+
+/**
+ * @brief Grille pleine où la couleur 1 occupe 60 % des cases : le remplissage doit la caser partout
+ */
+mat skewedGrid (unsigned size) {
+    mat grid(size, line(size));
+    unsigned k = 0;
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j, ++k) grid[i][j] = (k * 37) % 100 < 60 ? 1 : 2 + k % 3;
+    }
+    return grid;
+}
+
+/**
+ * @brief Pire cas de la détection : aucun échange ne marche, les deux échanges de chaque case sont essayés
+ */
+void BM_hasLegalMove (BenchState & state) {
+    const unsigned size = state.range(0);
+    mat grid = deadlockedGrid(size);
+    while (state.keepRunning()) doNotOptimize(hasLegalMove(grid));
+    state.setItemsProcessed(state.iterations() * size * size);
+}
+
+/**
+ * @brief Mélange d'une grille pleine (la grille de départ est recopiée à chaque tour)
+ */
+void BM_reshuffleGrid (BenchState & state) {
+    const unsigned size = state.range(0);
+    const mat start = state.range(1) ? skewedGrid(size) : deadlockedGrid(size);
+    mat grid;
+    unsigned long long shuffled = 0;
+    while (state.keepRunning()) {
+        grid = start;
+        shuffled += reshuffleGrid(grid);
+        doNotOptimize(grid[0][0]);
+    }
+    state.setCounter("shuffled", double(shuffled) / state.iterations());
+    state.setItemsProcessed(state.iterations() * size * size);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_hasLegalMove, argsProduct({{8, 64, 1024}}));
+BENCHMARK_ARGS(BM_reshuffleGrid, argsProduct({{8, 64, 1024}, {0, 1}}));
@@ -0,0 +1,69 @@
+/**
+ * @file bench_snapshot.cpp
+ * @brief Benchmarks de la sauvegarde des parties (engine/snapshot.h)
+ *
+ * Argument : taille de la grille. BM_checkpoint écrit dans le dossier temporaire.
+ */
+#include "harness.h"
+#include "../engine/snapshot.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+GameSnapshot makeSnapshot (unsigned size) {
+    srand(KBenchSeed);
+    GameSnapshot snapshot = {ModeClassic, KNoLevel, KBenchSeed, 7, 1234, KNbCandies, mat(), mat(), 0,
+                             vector<uint32_t>()};
+    initGrid(snapshot.grid, size);
+    snapshot.grid[0][0] = makeSpecial(2, SpecialWrapped);
+    return snapshot;
+}
+
+void BM_snapshotPack (BenchState & state) {
+    const GameSnapshot snapshot = makeSnapshot(state.range(0));
+    vector<uint8_t> bytes;
+    while (state.keepRunning()) {
+        packSnapshot(snapshot, bytes);
+        doNotOptimize(bytes.data());
+    }
+    state.setCounter("bytes", bytes.size());
+}
+
+void BM_snapshotUnpack (BenchState & state) {
+    vector<uint8_t> bytes;
+    packSnapshot(makeSnapshot(state.range(0)), bytes);
+    GameSnapshot snapshot;
+    while (state.keepRunning()) {
+        bool valid = unpackSnapshot(bytes.data(), bytes.size(), snapshot);
+        doNotOptimize(valid);
+    }
+}
+
+/**
+ * @brief Point de reprise après un coup : encodage et ajout au journal (report tous les KJournalCompact)
+ */
+void BM_checkpoint (BenchState & state) {
+    const GameSnapshot snapshot = makeSnapshot(state.range(0));
+    const string fileName = string(P_tmpdir) + "/candy_bench.sav";
+    SaveJournal journal(fileName);
+    journal.discard();
+    vector<uint8_t> bytes;
+    while (state.keepRunning()) {
+        packSnapshot(snapshot, bytes);
+        journal.checkpoint(bytes);
+    }
+    journal.discard();
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_snapshotPack, argsProduct({{8, 64, 1024}}));
+BENCHMARK_ARGS(BM_snapshotUnpack, argsProduct({{8, 64, 1024}}));
+BENCHMARK_ARGS(BM_checkpoint, argsProduct({{8, 64, 1024}}));
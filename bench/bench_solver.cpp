@@ -0,0 +1,53 @@
+/**
+ * @file bench_solver.cpp
+ * @brief Solveur du mode Cible (engine/solver.h) : par d'une série de graines
+ *
+ * BM_solveTarget : score cible puis preuve (0 : faisceau seul, 1 : faisceau
+ * puis approfondissement itératif). Un tour résout KBenchSeeds graines
+ * consécutives ; les compteurs donnent le par moyen, la part de par prouvés
+ * et les coups joués par graine.
+ */
+#include "harness.h"
+#include "../engine/game.h"
+#include "../engine/solver.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t KBenchSeed (42);
+const unsigned KBenchSeeds (8);
+const unsigned KBenchBeam (64);
+const size_t KBenchTableBytes (size_t(16) << 20);
+const uint64_t KBenchProofBudget (2000000);
+
+void BM_solveTarget (BenchState & state) {
+    SolveConfig config;
+    config.gridSize = KGridSize;
+    config.nbCandies = KNbCandies;
+    config.targetScore = state.range(0);
+    config.beamWidth = KBenchBeam;
+    config.maxMoves = KSolveMaxMoves;
+    config.threads = 0;
+    config.proofBudget = state.range(1) ? KBenchProofBudget : 0;
+    config.tableBytes = KBenchTableBytes;
+    uint64_t pars = 0, proven = 0, nodes = 0;
+    while (state.keepRunning()) {
+        for (unsigned k = 0; k < KBenchSeeds; ++k) {
+            config.seed = KBenchSeed + k;
+            const SolveResult result = solveTarget(config);
+            pars += result.par;
+            proven += result.proven;
+            nodes += result.nodes;
+        }
+    }
+    const double solved = double(state.iterations()) * KBenchSeeds;
+    state.setCounter("par", pars / solved);
+    state.setCounter("proven", proven / solved);
+    state.setCounter("nodes", nodes / solved);
+    state.setItemsProcessed(state.iterations() * KBenchSeeds);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_solveTarget, argsProduct({{1000, 10000, 20000}, {0, 1}}));
@@ -0,0 +1,59 @@
+/**
+ * @file bench_spawn.cpp
+ * @brief Benchmarks de l'apparition des bonbons (engine/spawn.h)
+ *
+ * BM_aliasDraw : nombre de couleurs.
+ * BM_refillColumn : taille de la grille puis politique (0 : tirage uniforme historique, 1 : poids).
+ */
+#include "harness.h"
+#include "../engine/spawn.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+/**
+ * @brief Un tirage pondéré : un rand() et une comparaison, quel que soit le nombre de couleurs
+ */
+void BM_aliasDraw (BenchState & state) {
+    const unsigned nbColours = state.range(0);
+    unsigned weights[KMaxSpawnColours];
+    for (unsigned c = 0; c < nbColours; ++c) weights[c] = 1 + c * c;
+    AliasTable table;
+    buildAliasTable(table, weights, nbColours);
+    srand(KBenchSeed);
+    unsigned long long sum = 0;
+    while (state.keepRunning()) sum += aliasDraw(table, rand());
+    doNotOptimize(sum);
+    state.setItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Remplissage d'une colonne entière tirée au hasard
+ */
+void BM_refillColumn (BenchState & state) {
+    const unsigned size = state.range(0);
+    const bool weighted = state.range(1) != 0;
+    const unsigned weights[KNbCandies] = {4, 2, 1, 1};
+    SpawnPolicy policy(KNbCandies);
+    policy.setWeights(weights, KNbCandies);
+    SpawnScope scope(weighted ? &policy : nullptr);
+
+    srand(KBenchSeed);
+    mat grid(size, line(size, KImpossible));
+    while (state.keepRunning()) {
+        const unsigned abs = unsigned(rand()) % size;
+        refillColumn(grid, abs, 0, size - 1, KNbCandies);
+        doNotOptimize(grid[0][abs]);
+    }
+    state.setItemsProcessed(state.iterations() * size);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_aliasDraw, argsProduct({{2, 4, 8, 15}}));
+BENCHMARK_ARGS(BM_refillColumn, argsProduct({{8, 64, 1024}, {0, 1}}));
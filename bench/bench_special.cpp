@@ -0,0 +1,120 @@
+/**
+ * @file bench_special.cpp
+ * @brief Benchmarks des bonbons spéciaux (engine/special.h)
+ *
+ * BM_specialChain : taille de la grille puis longueur de la chaîne.
+ * BM_colourBomb, BM_doubleBomb et BM_clearMatch : taille de la grille puis nombre de types de bonbons.
+ */
+#include "harness.h"
+#include "../engine/special.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+mat makeBoard (unsigned size, unsigned nbCandies) {
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, size, nbCandies);
+    return grid;
+}
+
+/**
+ * @brief Pire cas : chaque spécial est dans la ligne ou la colonne vidée par le précédent
+ *
+ * Les rayés sont posés en escalier : (0,0) ligne, (0,1) colonne, (1,1) ligne,
+ * (1,2) colonne... Le dernier est une bombe, qui relit toute la grille. La
+ * chaîne est raccourcie si la grille est trop petite (compteur specials).
+ */
+void BM_specialChain (BenchState & state) {
+    const unsigned size = state.range(0);
+    const unsigned chain = min<unsigned>(state.range(1), 2 * (size - 1));
+    mat grid = makeBoard(size, KNbCandies);
+    BoardMask clear;
+    unsigned long long cleared = 0;
+    while (state.keepRunning()) {
+        for (unsigned k = 0; k < chain; ++k) {
+            unsigned ord = k / 2;
+            unsigned abs = k / 2 + k % 2;
+            SpecialKind kind = k % 2 == 0 ? SpecialStripedRow : SpecialStripedColumn;
+            if (k + 1 == chain && chain > 1) kind = SpecialColourBomb;
+            grid[ord][abs] = makeSpecial(kind == SpecialColourBomb ? KImpossible : 1, kind);
+        }
+        maskReset(clear, size);
+        maskSet(clear, 0, 0);
+        cleared += detonate(grid, clear, 1);
+    }
+    doNotOptimize(cleared);
+    state.setItemsProcessed(state.iterations() * chain);
+    state.setCounter("specials", chain);
+    state.setCounter("cells_per_chain", double(cleared) / state.iterations());
+}
+
+/**
+ * @brief Bombe échangée avec un bonbon : toute une couleur vidée, gravité sur toutes les colonnes
+ */
+void BM_colourBomb (BenchState & state) {
+    const unsigned size = state.range(0);
+    const unsigned nbCandies = state.range(1);
+    mat grid = makeBoard(size, nbCandies);
+    unsigned long long cleared = 0;
+    while (state.keepRunning()) {
+        maPosition pos = {unsigned(rand()) % (size - 1), unsigned(rand()) % size};
+        grid[pos.ord][pos.abs] = makeSpecial(KImpossible, SpecialColourBomb);
+        cleared += activateSwap(grid, pos, 'D', nbCandies);
+    }
+    doNotOptimize(cleared);
+    state.setItemsProcessed(state.iterations() * size * size);
+}
+
+/**
+ * @brief Deux bombes échangées : toute la grille vidée, tous les spéciaux touchés, gravité sur toutes les colonnes
+ *
+ * Pire cas d'un seul coup : chaque case est dans le masque et chaque
+ * dixième case est un spécial, qui ne doit rien ajouter au masque plein.
+ */
+void BM_doubleBomb (BenchState & state) {
+    const unsigned size = state.range(0);
+    const unsigned nbCandies = state.range(1);
+    mat grid = makeBoard(size, nbCandies);
+    unsigned long long cleared = 0;
+    while (state.keepRunning()) {
+        for (unsigned k = 0; k < size * size; k += 10)
+            grid[k / size][k % size] = makeSpecial(1 + k % nbCandies, SpecialKind(1 + k % 3));
+        grid[0][0] = makeSpecial(KImpossible, SpecialColourBomb);
+        grid[0][1] = makeSpecial(KImpossible, SpecialColourBomb);
+        cleared += activateSwap(grid, maPosition {0, 0}, 'D', nbCandies);
+    }
+    doNotOptimize(cleared);
+    state.setItemsProcessed(state.iterations() * size * size);
+}
+
+/**
+ * @brief Match de 4 dans une colonne tirée au hasard : création du rayé, gravité et remplissage
+ *
+ * A comparer avec BM_removalInColumn pour le surcoût des masques.
+ */
+void BM_clearMatch (BenchState & state) {
+    const unsigned size = state.range(0);
+    const unsigned nbCandies = state.range(1);
+    mat grid = makeBoard(size, nbCandies);
+    while (state.keepRunning()) {
+        maPosition pos = {unsigned(rand()) % size, unsigned(rand()) % (size - 3)};
+        unsigned consumed = clearMatch(grid, pos, 4, MatchVertical, nbCandies);
+        doNotOptimize(consumed);
+        grid[pos.ord + 3][pos.abs] = 1 + rand() % nbCandies;   // retire le rayé créé (tombé d'une case)
+    }
+    state.setItemsProcessed(state.iterations() * size);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_specialChain, argsProduct({{8, 16, 64, 256, 1024}, {1, 5, 20}}));
+BENCHMARK_ARGS(BM_colourBomb, gridArgs());
+BENCHMARK_ARGS(BM_doubleBomb, gridArgs());
+BENCHMARK_ARGS(BM_clearMatch, gridArgs());
@@ -0,0 +1,126 @@
+/**
+ * @file bench_startup.cpp
+ * @brief Démarrage à froid du jeu : temps jusqu'au premier écran de candycrush
+ *
+ * BM_coldStart : dossier de lancement (0 : vide, 1 : fichiers de scores de
+ * KStartupEntries parties chacun). Un tour lance l'exécutable candycrush
+ * construit à côté de candy_bench, l'entrée fermée, et mesure le temps
+ * jusqu'à la demande du pseudo (premier écran). Les compteurs donnent la
+ * moyenne et le pire premier écran, et le budget à tenir (KFirstFrameBudgetUs) :
+ * les classements ne sont lus qu'en fin de partie, le dossier 1 ne doit rien coûter.
+ */
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const double KFirstFrameBudgetUs (5000);
+const size_t KStartupEntries (200000);
+const char * const KFirstFramePrompt ("pseudo");
+
+/**
+ * @brief Chemin d'un exécutable construit dans le même dossier que candy_bench
+ */
+string siblingExecutable (const string & name) {
+    char path [4096];
+    const ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) return name;
+    const string self (path, length);
+    return self.substr(0, self.rfind('/') + 1) + name;
+}
+
+/**
+ * @brief Dossier de lancement : vide, ou avec des fichiers de scores déjà longs
+ */
+string startupDirectory (bool withScores) {
+    char pattern [] = "/tmp/candy_startup_XXXXXX";
+    if (!mkdtemp(pattern)) return string();
+    const string directory = pattern;
+    if (withScores) {
+        srand(KStartupEntries);
+        for (const char * name : {"scores_classique.txt", "scores_clm.txt", "scores_cible.txt"}) {
+            ofstream file(directory + "/" + name);
+            for (size_t k = 0; k < KStartupEntries; ++k) file << rand() % 100000 << " joueur_" << k % 1000 << "\n";
+        }
+    }
+    return directory;
+}
+
+/**
+ * @brief Lance le jeu dans directory et rend le temps jusqu'au premier écran (microsecondes, négatif en cas d'échec)
+ */
+double firstFrameUs (const string & game, const string & directory) {
+    int output [2];
+    if (pipe(output) != 0) return -1;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    const pid_t child = fork();
+    if (child == 0) {
+        const int input = open("/dev/null", O_RDONLY);
+        dup2(input, STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        close(output[0]);
+        close(output[1]);
+        if (chdir(directory.c_str()) != 0) _exit(127);
+        execl(game.c_str(), game.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+    close(output[1]);
+    if (child < 0) {
+        close(output[0]);
+        return -1;
+    }
+
+    // Le prompt est vidé sur la sortie juste avant la lecture du pseudo
+    string screen;
+    double elapsed = -1;
+    char buffer [4096];
+    ssize_t bytes;
+    while ((bytes = read(output[0], buffer, sizeof(buffer))) > 0) {
+        screen.append(buffer, bytes);
+        if (elapsed < 0 && screen.find(KFirstFramePrompt) != string::npos)
+            elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    }
+    close(output[0]);
+    int status;
+    waitpid(child, &status, 0);
+    return elapsed;
+}
+
+void BM_coldStart (BenchState & state) {
+    const string game = siblingExecutable("candycrush");
+    const string directory = startupDirectory(state.range(0) == 1);
+    double total = 0, worst = 0;
+    size_t failures = 0;
+    while (state.keepRunning()) {
+        const double elapsed = firstFrameUs(game, directory);
+        if (elapsed < 0) failures++;
+        total += max(0.0, elapsed);
+        worst = max(worst, elapsed);
+    }
+    const size_t measured = state.iterations() - failures;
+    state.setCounter("first_frame_us", measured ? total / measured : 0);
+    state.setCounter("worst_us", worst);
+    state.setCounter("budget_us", KFirstFrameBudgetUs);
+    state.setCounter("failures", failures);
+    state.setItemsProcessed(state.iterations());
+    if (!directory.empty()) {
+        for (const char * name : {"scores_classique.txt", "scores_clm.txt", "scores_cible.txt"})
+            unlink((directory + "/" + name).c_str());
+        rmdir(directory.c_str());
+    }
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_coldStart, argsProduct({{0, 1}}));
@@ -0,0 +1,140 @@
+/**
+ * @file bench_stats.cpp
+ * @brief Requêtes de l'entrepôt des statistiques (engine/stats.h) sur des colonnes en mémoire
+ *
+ * BM_statsSummary : nombre de parties puis rangement (0 : tableau de
+ * GameRecord parcouru avec un test par partie, 1 : colonnes et boucle à
+ * masques de summarizeGames). Un tour fait le bilan d'un mode pour tous les
+ * joueurs. BM_statsQueries : nombre de parties puis requête (0 : parties
+ * par mode d'un joueur, 1 : centiles des scores d'un mode, 2 : coups pour
+ * atteindre la cible jour par jour d'un joueur).
+ */
+#include "harness.h"
+#include "../engine/spawn.h"
+#include "../engine/stats.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+const uint64_t KBenchSeed (42);
+const uint32_t KBenchPlayers (50000);
+const uint32_t KBenchDay (86400);
+
+/**
+ * @brief Parties tirées au hasard, rangées en colonnes
+ */
+struct BenchColumns {
+    vector<uint32_t> players;
+    vector<uint8_t> modes;
+    vector<uint64_t> scores;
+    vector<uint32_t> moves;
+    vector<uint32_t> comboSteps;
+    vector<uint32_t> times;
+
+    StatColumns view () const {
+        StatColumns columns;
+        columns.players = players.data();
+        columns.modes = modes.data();
+        columns.scores = scores.data();
+        columns.moves = moves.data();
+        columns.comboSteps = comboSteps.data();
+        columns.times = times.data();
+        columns.count = players.size();
+        return columns;
+    }
+};
+
+GameRecord randomGame () {
+    GameRecord game;
+    game.player = spawnRandom() % KBenchPlayers;
+    game.mode = spawnRandom() % KNbGameModes;
+    game.moves = 10 + spawnRandom() % 40;
+    game.comboSteps = game.moves + spawnRandom() % game.moves;
+    game.score = spawnRandom() % 100000;
+    game.time = spawnRandom() % (365 * KBenchDay);
+    return game;
+}
+
+void makeColumns (size_t games, BenchColumns & columns) {
+    uint64_t state = KBenchSeed;
+    RandomScope randomScope(&state);
+    columns.players.resize(games);
+    columns.modes.resize(games);
+    columns.scores.resize(games);
+    columns.moves.resize(games);
+    columns.comboSteps.resize(games);
+    columns.times.resize(games);
+    for (size_t i = 0; i < games; ++i) {
+        const GameRecord game = randomGame();
+        columns.players[i] = game.player;
+        columns.modes[i] = game.mode;
+        columns.scores[i] = game.score;
+        columns.moves[i] = game.moves;
+        columns.comboSteps[i] = game.comboSteps;
+        columns.times[i] = game.time;
+    }
+}
+
+void BM_statsSummary (BenchState & state) {
+    const size_t games = state.range(0);
+    if (state.range(1) == 0) {
+        uint64_t seed = KBenchSeed;
+        RandomScope randomScope(&seed);
+        vector<GameRecord> records (games);
+        for (GameRecord & game : records) game = randomGame();
+        while (state.keepRunning()) {
+            StatSummary summary;
+            for (const GameRecord & game : records) {
+                if (game.mode != ModeClassic) continue;
+                summary.games++;
+                summary.totalScore += game.score;
+                summary.bestScore = max(summary.bestScore, game.score);
+                summary.moves += game.moves;
+                summary.comboSteps += game.comboSteps;
+            }
+            doNotOptimize(summary);
+        }
+    }
+    else {
+        BenchColumns columns;
+        makeColumns(games, columns);
+        const StatColumns view = columns.view();
+        while (state.keepRunning()) doNotOptimize(summarizeGames(view, KNoPlayer, ModeClassic));
+    }
+    state.setItemsProcessed(state.iterations() * games);
+}
+
+void BM_statsQueries (BenchState & state) {
+    const size_t games = state.range(0);
+    BenchColumns columns;
+    makeColumns(games, columns);
+    const StatColumns view = columns.view();
+    const vector<double> percents = {50, 90, 99};
+    uint64_t counts [KNbGameModes];
+    vector<uint64_t> scores;
+    vector<TimeBucket> buckets;
+    while (state.keepRunning()) {
+        switch (state.range(1)) {
+        case 0:
+            countGamesPerMode(view, 7, counts);
+            doNotOptimize(counts);
+            break;
+        case 1:
+            doNotOptimize(scorePercentiles(view, KNoPlayer, ModeTimeTrial, percents, scores));
+            break;
+        default:
+            movesOverTime(view, 7, KBenchDay, buckets);
+            doNotOptimize(buckets);
+            break;
+        }
+    }
+    state.setItemsProcessed(state.iterations() * games);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_statsSummary, argsProduct({{1000000, 10000000, 100000000}, {0, 1}}));
+BENCHMARK_ARGS(BM_statsQueries, argsProduct({{1000000, 10000000, 100000000}, {0, 1, 2}}));
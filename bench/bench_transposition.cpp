@@ -0,0 +1,79 @@
+/**
+ * @file bench_transposition.cpp
+ * @brief Benchmarks du hachage des grilles et de la table de transposition
+ *        (engine/zobrist.h, engine/transposition.h)
+ *
+ * BM_boardHash : taille de la grille. BM_hashedClear : taille de la grille puis
+ * hash tenu à jour (0 ou 1). BM_tableProbe : taille de la table en Kio.
+ */
+#include "harness.h"
+#include "../engine/special.h"
+#include "../engine/transposition.h"
+#include "../engine/zobrist.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const unsigned KBenchSeed (42);
+
+// Positions différentes cherchées par BM_tableProbe
+const uint64_t KProbePositions (1 << 20);
+
+void BM_boardHash (BenchState & state) {
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, state.range(0));
+    while (state.keepRunning()) {
+        uint64_t hash = boardHash(grid);
+        doNotOptimize(hash);
+    }
+    state.setItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+
+/**
+ * @brief Coût de la mise à jour incrémentale : une colonne vidée puis remplie, avec ou sans HashScope
+ */
+void BM_hashedClear (BenchState & state) {
+    const unsigned size = state.range(0);
+    srand(KBenchSeed);
+    mat grid;
+    initGrid(grid, size);
+    uint64_t hash = boardHash(grid);
+    HashScope scope(state.range(1) ? &hash : nullptr);
+    unsigned abs = 0;
+    while (state.keepRunning()) {
+        removalInColumn(grid, maPosition {abs, size - 3}, 3);
+        abs = (abs + 1) % size;
+    }
+    doNotOptimize(hash);
+}
+
+/**
+ * @brief Une recherche puis, si elle échoue, une écriture, sur des positions tirées au hasard
+ */
+void BM_tableProbe (BenchState & state) {
+    TranspositionTable table(size_t(state.range(0)) * 1024);
+    uint64_t x = KBenchSeed;
+    uint64_t found = 0;
+    while (state.keepRunning()) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint64_t hash = zobristKey(x >> 44, 0);
+        uint64_t score;
+        unsigned depth;
+        if (table.probe(hash, 1, score, depth)) found += score;
+        else table.store(hash, 1 + (x >> 62), x >> 40);
+    }
+    doNotOptimize(found);
+    state.setCounter("entries", table.entries());
+    state.setCounter("hit_rate", table.stats().hitRate());
+    state.setCounter("positions", KProbePositions);
+}
+
+} // namespace
+
+BENCHMARK_ARGS(BM_boardHash, argsProduct({{8, 64, 1024}}));
+BENCHMARK_ARGS(BM_hashedClear, argsProduct({{8, 64, 1024}, {0, 1}}));
+BENCHMARK_ARGS(BM_tableProbe, argsProduct({{64, 4096, 262144}}));
@@ -0,0 +1,291 @@
+#include "harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+// --- 1. LE REGISTRE DES BENCHMARKS ---
+
+namespace {
+
+struct BenchEntry {
+    string name;
+    BenchFunction fn;
+    vector<long> args;
+    bool longRun;       // lancé seulement avec --benchmark_long
+};
+
+struct BenchResult {
+    string name;
+    size_t iterations;
+    double realTimeNs;  // par itération
+    double cpuTimeNs;   // par itération
+    double itemsPerSecond;
+    vector<pair<string, double> > counters;
+};
+
+/**
+ * @brief Registre global (statique local pour éviter l'ordre d'initialisation entre fichiers)
+ */
+vector<BenchEntry> & registry () {
+    static vector<BenchEntry> entries;
+    return entries;
+}
+
+string fullName (const BenchEntry & entry) {
+    string name = entry.name;
+    for (long arg : entry.args) name += "/" + to_string(arg);
+    return name;
+}
+
+/**
+ * @brief Echappe une chaîne pour l'écrire dans le JSON
+ */
+string jsonEscape (const string & text) {
+    string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// --- 2. LA MESURE ---
+
+/**
+ * @brief Lance un benchmark pour un nombre fixé d'itérations
+ */
+BenchResult runOnce (const BenchEntry & entry, size_t iterations) {
+    BenchState state(iterations, entry.args);
+    entry.fn(state);
+
+    double realSeconds = state.realSeconds();
+    double cpuSeconds = state.cpuSeconds();
+
+    BenchResult result;
+    result.name = fullName(entry);
+    result.iterations = iterations;
+    result.realTimeNs = realSeconds * 1e9 / iterations;
+    result.cpuTimeNs = cpuSeconds * 1e9 / iterations;
+    result.itemsPerSecond = (state.itemsProcessed() > 0 && realSeconds > 0) ? state.itemsProcessed() / realSeconds : 0;
+    result.counters = state.counters();
+    return result;
+}
+
+/**
+ * @brief Calibre le nombre d'itérations pour que la mesure dure au moins minTime secondes
+ */
+BenchResult runCalibrated (const BenchEntry & entry, double minTime) {
+    const size_t KMaxIterations = 1000000000;
+    size_t iterations = 1;
+    while (true) {
+        BenchResult result = runOnce(entry, iterations);
+        double elapsed = result.realTimeNs * iterations / 1e9;
+        if (elapsed >= minTime || iterations >= KMaxIterations) return result;
+
+        // Estimation du nombre d'itérations nécessaires, avec une marge de 40%
+        double factor = (elapsed > 0) ? minTime * 1.4 / elapsed : 10.0;
+        if (factor > 10.0 && elapsed > minTime / 10) factor = 10.0;
+        if (factor < 2.0) factor = 2.0;
+        size_t next = size_t(iterations * factor);
+        iterations = min(next, KMaxIterations);
+    }
+}
+
+// --- 3. LES SORTIES ---
+
+void printConsoleHeader () {
+    cout << left << setw(40) << "Benchmark" << right << setw(16) << "Time" << setw(16) << "CPU"
+         << setw(14) << "Iterations" << "  UserCounters" << endl;
+    cout << string(100, '-') << endl;
+}
+
+void printConsoleLine (const BenchResult & result) {
+    cout << left << setw(40) << result.name << right
+         << setw(13) << fixed << setprecision(0) << result.realTimeNs << " ns"
+         << setw(13) << result.cpuTimeNs << " ns"
+         << setw(14) << result.iterations;
+    if (result.itemsPerSecond > 0) cout << "  items_per_second=" << setprecision(3) << scientific << result.itemsPerSecond;
+    for (const pair<string, double> & counter : result.counters) {
+        cout << "  " << counter.first << "=" << defaultfloat << setprecision(6) << counter.second;
+    }
+    cout << defaultfloat << endl;
+}
+
+void writeJson (ostream & out, const vector<BenchResult> & results, const string & executable) {
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+    out << "    \"executable\": \"" << jsonEscape(executable) << "\",\n";
+    out << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+    out << "    \"library_build_type\": \"release\"\n";
+#else
+    out << "    \"library_build_type\": \"debug\"\n";
+#endif
+    out << "  },\n";
+    out << "  \"benchmarks\": [\n";
+    out << setprecision(17);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult & result = results[i];
+        out << "    {\n";
+        out << "      \"name\": \"" << jsonEscape(result.name) << "\",\n";
+        out << "      \"run_name\": \"" << jsonEscape(result.name) << "\",\n";
+        out << "      \"run_type\": \"iteration\",\n";
+        out << "      \"iterations\": " << result.iterations << ",\n";
+        out << "      \"real_time\": " << result.realTimeNs << ",\n";
+        out << "      \"cpu_time\": " << result.cpuTimeNs << ",\n";
+        if (result.itemsPerSecond > 0) out << "      \"items_per_second\": " << result.itemsPerSecond << ",\n";
+        for (const pair<string, double> & counter : result.counters) {
+            out << "      \"" << jsonEscape(counter.first) << "\": " << counter.second << ",\n";
+        }
+        out << "      \"time_unit\": \"ns\"\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+/**
+ * @brief Le nom contient-il le filtre ? Un filtre qui commence par ^ doit être au début du nom
+ *
+ * Plusieurs filtres séparés par | : le nom doit en vérifier un.
+ */
+bool matchesFilter (const string & name, const string & filter) {
+    const size_t bar = filter.find('|');
+    if (bar != string::npos)
+        return matchesFilter(name, filter.substr(0, bar)) || matchesFilter(name, filter.substr(bar + 1));
+    if (!filter.empty() && filter[0] == '^') return name.compare(0, filter.size() - 1, filter, 1, string::npos) == 0;
+    return name.find(filter) != string::npos;
+}
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " [options]\n"
+         << "  --benchmark_filter=TEXTE     ne lance que les benchmarks dont le nom contient TEXTE (^TEXTE : commence par,\n"
+         << "                               A|B : l'un ou l'autre ; aucun benchmark retenu : erreur)\n"
+         << "  --benchmark_min_time=SEC     durée minimale de mesure par benchmark (defaut 0.1)\n"
+         << "  --benchmark_out=FICHIER      écrit les résultats en JSON dans FICHIER\n"
+         << "  --benchmark_format=json      écrit le JSON sur la sortie standard\n"
+         << "  --benchmark_list_tests       liste les benchmarks sans les lancer\n"
+         << "  --benchmark_long             retient aussi les benchmarks longs (ex: grilles de 16384)\n";
+}
+
+} // namespace
+
+// --- 4. L'API PUBLIQUE ---
+
+void registerBenchmark (const string & name, BenchFunction fn, const vector<vector<long> > & argSets, bool longRun) {
+    if (argSets.empty()) {
+        registry().push_back({name, fn, vector<long>(), longRun});
+        return;
+    }
+    for (const vector<long> & args : argSets) {
+        registry().push_back({name, fn, args, longRun});
+    }
+}
+
+vector<vector<long> > argsProduct (const vector<vector<long> > & lists) {
+    vector<vector<long> > product(1);
+    for (const vector<long> & list : lists) {
+        vector<vector<long> > next;
+        for (const vector<long> & prefix : product) {
+            for (long value : list) {
+                vector<long> args = prefix;
+                args.push_back(value);
+                next.push_back(args);
+            }
+        }
+        product = next;
+    }
+    return product;
+}
+
+vector<vector<long> > gridArgs () {
+    return argsProduct({{8, 16, 32, 64, 128, 256, 512, 1024}, {3, 4, 5, 6, 7}});
+}
+
+int main (int argc, char ** argv) {
+    string filter;
+    double minTime = 0.1;
+    string outFile;
+    bool jsonToStdout = false;
+    bool listOnly = false;
+    bool withLong = false;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--benchmark_filter=", 0) == 0) {
+            filter = arg.substr(19);
+        } else if (arg.rfind("--benchmark_min_time=", 0) == 0) {
+            minTime = atof(arg.substr(21).c_str()); // "0.5" ou "0.5s"
+        } else if (arg.rfind("--benchmark_out=", 0) == 0) {
+            outFile = arg.substr(16);
+        } else if (arg == "--benchmark_format=json") {
+            jsonToStdout = true;
+        } else if (arg == "--benchmark_list_tests") {
+            listOnly = true;
+        } else if (arg == "--benchmark_long") {
+            withLong = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.rfind("--benchmark_out_format=", 0) == 0) {
+            // Seul le JSON est supporté, option acceptée pour compatibilité
+        } else {
+            cerr << "Option inconnue : " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    vector<BenchResult> results;
+    if (!jsonToStdout && !listOnly) printConsoleHeader();
+    unsigned matched = 0;
+    unsigned skippedLong = 0;
+    for (const BenchEntry & entry : registry()) {
+        string name = fullName(entry);
+        if (!matchesFilter(name, filter)) continue;
+        if (entry.longRun && !withLong) {
+            skippedLong++;
+            continue;
+        }
+        matched++;
+        if (listOnly) {
+            cout << name << endl;
+            continue;
+        }
+        BenchResult result = runCalibrated(entry, minTime);
+        if (!jsonToStdout) printConsoleLine(result);
+        results.push_back(result);
+    }
+    // Un filtre qui ne retient rien est une faute de frappe : un JSON vide passerait pour une mesure
+    if (matched == 0) {
+        cerr << "Error: No benchmark matches filter " << filter;
+        if (skippedLong > 0) cerr << " (" << skippedLong << " long benchmarks need --benchmark_long)";
+        cerr << endl;
+        return 1;
+    }
+    if (listOnly) return 0;
+
+    if (jsonToStdout) writeJson(cout, results, argv[0]);
+    if (!outFile.empty()) {
+        ofstream file(outFile);
+        if (!file.is_open()) {
+            cerr << "Error: Cannot open output file " << outFile << endl;
+            return 1;
+        }
+        writeJson(file, results, argv[0]);
+    }
+    return 0;
+}
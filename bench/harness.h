@@ -0,0 +1,155 @@
+/**
+ * @file harness.h
+ * @brief Petit moteur de benchmark autonome (style Google Benchmark)
+ *
+ * Chaque benchmark est une fonction qui reçoit un BenchState et répète son
+ * noyau tant que state.keepRunning() renvoie true. Le nombre d'itérations
+ * est calibré automatiquement et les résultats peuvent être écrits en JSON
+ * au même format que Google Benchmark (--benchmark_out=fichier.json), ce qui
+ * permet de comparer deux commits avec les outils habituels (compare.py).
+ */
+#ifndef CANDY_BENCH_HARNESS_H
+#define CANDY_BENCH_HARNESS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Etat passé à un benchmark pendant une mesure
+ */
+class BenchState {
+public:
+    BenchState (std::size_t iterations, const std::vector<long> & args)
+        : myIterations(iterations), myRemaining(iterations), myStarted(false), myArgs(args), myItems(0),
+          myCpuStart(0), myCpuEnd(0) {}
+
+    /**
+     * @brief Renvoie true tant qu'il reste des itérations à mesurer
+     *
+     * Le chronomètre démarre au premier appel et s'arrête au dernier : la
+     * préparation faite avant la boucle (ex: génération de la grille) n'est
+     * pas mesurée.
+     */
+    bool keepRunning () {
+        if (!myStarted) {
+            myStarted = true;
+            myCpuStart = std::clock();
+            myRealStart = std::chrono::steady_clock::now();
+        }
+        if (myRemaining == 0) {
+            myRealEnd = std::chrono::steady_clock::now();
+            myCpuEnd = std::clock();
+            return false;
+        }
+        --myRemaining;
+        return true;
+    }
+
+    /**
+     * @brief Temps réel mesuré (secondes)
+     */
+    double realSeconds () const { return std::chrono::duration<double>(myRealEnd - myRealStart).count(); }
+
+    /**
+     * @brief Temps CPU du processus mesuré (secondes)
+     */
+    double cpuSeconds () const { return double(myCpuEnd - myCpuStart) / CLOCKS_PER_SEC; }
+
+    /**
+     * @brief Argument numéro i du benchmark (ex: taille de grille, nombre de bonbons)
+     */
+    long range (std::size_t i) const { return myArgs[i]; }
+
+    std::size_t iterations () const { return myIterations; }
+
+    /**
+     * @brief Nombre total d'éléments traités, pour le débit items_per_second
+     */
+    void setItemsProcessed (std::int64_t items) { myItems = items; }
+    std::int64_t itemsProcessed () const { return myItems; }
+
+    /**
+     * @brief Ajoute un compteur libre qui sera écrit tel quel dans le JSON
+     */
+    void setCounter (const std::string & name, double value) { myCounters.push_back(std::make_pair(name, value)); }
+    const std::vector<std::pair<std::string, double> > & counters () const { return myCounters; }
+
+private:
+    std::size_t myIterations;
+    std::size_t myRemaining;
+    bool myStarted;
+    std::vector<long> myArgs;
+    std::int64_t myItems;
+    std::chrono::steady_clock::time_point myRealStart;
+    std::chrono::steady_clock::time_point myRealEnd;
+    std::clock_t myCpuStart;
+    std::clock_t myCpuEnd;
+    std::vector<std::pair<std::string, double> > myCounters;
+};
+
+typedef void (*BenchFunction) (BenchState &);
+
+/**
+ * @brief Enregistre un benchmark pour chaque jeu d'arguments donné
+ * @param name Nom de base (le nom final est name/arg0/arg1...)
+ * @param fn Fonction de benchmark
+ * @param argSets Liste des jeux d'arguments
+ * @param longRun Benchmark long (mémoire ou durée) : lancé seulement avec --benchmark_long
+ */
+void registerBenchmark (const std::string & name, BenchFunction fn, const std::vector<std::vector<long> > & argSets,
+                        bool longRun = false);
+
+/**
+ * @brief Produit cartésien des listes d'arguments
+ */
+std::vector<std::vector<long> > argsProduct (const std::vector<std::vector<long> > & lists);
+
+/**
+ * @brief Tailles de grille 8..1024 (puissances de 2) croisées avec 3..7 types de bonbons
+ */
+std::vector<std::vector<long> > gridArgs ();
+
+/**
+ * @brief Empêche le compilateur de supprimer un calcul dont le résultat n'est pas utilisé
+ */
+template <class T>
+inline void doNotOptimize (const T & value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T * sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Objet statique qui enregistre un benchmark au chargement du programme
+ */
+struct BenchRegistrar {
+    BenchRegistrar (const std::string & name, BenchFunction fn, const std::vector<std::vector<long> > & argSets,
+                    bool longRun = false) {
+        registerBenchmark(name, fn, argSets, longRun);
+    }
+};
+
+#define CANDY_BENCH_CONCAT2(a, b) a##b
+#define CANDY_BENCH_CONCAT(a, b) CANDY_BENCH_CONCAT2(a, b)
+
+/**
+ * @brief Enregistre fn avec les jeux d'arguments donnés (ex: BENCHMARK_ARGS(BM_x, gridArgs()))
+ */
+#define BENCHMARK_ARGS(fn, argSets) \
+    static BenchRegistrar CANDY_BENCH_CONCAT(benchRegistrar_, __LINE__) (#fn, fn, argSets)
+
+/**
+ * @brief Comme BENCHMARK_ARGS, pour des jeux d'arguments lancés seulement avec --benchmark_long
+ */
+#define BENCHMARK_LONG_ARGS(fn, argSets) \
+    static BenchRegistrar CANDY_BENCH_CONCAT(benchRegistrar_, __LINE__) (#fn, fn, argSets, true)
+
+#endif // CANDY_BENCH_HARNESS_H
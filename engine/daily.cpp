@@ -0,0 +1,300 @@
+#include "daily.h"
+#include "game.h"
+#include "simulation.h"
+#include "solver.h"
+#include "spawn.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char KCalendarMagic[8] = {'C', 'A', 'N', 'D', 'Y', 'D', 'A', 'Y'};
+const uint32_t KCalendarVersion (1);
+
+// Table de transposition du solveur pour le par d'un jour
+const size_t KDailyTableBytes (size_t(4) << 20);
+
+/**
+ * @struct CalendarHeader
+ * @brief En-tête d'un calendrier, suivi de count DailyRecord (premier jour, puis un par jour)
+ */
+struct CalendarHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint32_t firstDay;
+    uint16_t gridSize;
+    uint16_t nbCandies;
+};
+static_assert(sizeof(CalendarHeader) % alignof(DailyRecord) == 0, "les jours suivent l'en-tête sans bourrage");
+
+/**
+ * @brief Jours depuis le 1er janvier 1970 d'une date du calendrier grégorien
+ */
+int64_t daysFromCivil (int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = unsigned(year - era * 400);
+    const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + int64_t(dayOfEra) - 719468;
+}
+
+/**
+ * @brief Graine candidate attempt du jour day
+ */
+uint64_t candidateSeed (uint64_t baseSeed, uint32_t day, unsigned attempt) {
+    return forkSeed(baseSeed, (uint64_t(day) << 8) | attempt);
+}
+
+/**
+ * @brief Cherche le par du mode Cible d'une graine
+ */
+SolveResult solvePar (uint64_t seed, const DailyCriteria & criteria) {
+    SolveConfig solve;
+    solve.seed = seed;
+    solve.gridSize = criteria.gridSize;
+    solve.nbCandies = criteria.nbCandies;
+    solve.targetScore = KTargetScore;
+    solve.beamWidth = criteria.beamWidth;
+    solve.maxMoves = KSolveMaxMoves;
+    solve.threads = 1;   // les jours sont déjà répartis entre les fils
+    solve.proofBudget = criteria.proofBudget;
+    solve.tableBytes = KDailyTableBytes;
+    return solveTarget(solve);
+}
+
+/**
+ * @brief Rang d'une candidate refusée : quand aucune n'est acceptée, la graine gardée est celle de plus petit rang
+ *
+ * D'abord les candidates refusées pour leur par (leurs parties simulées sont
+ * allées au bout : la moins facile devant), puis celles refusées pour leurs
+ * parties faciles, puis celles qui bloquent. judgeSeed s'arrête dès que le
+ * refus est certain : les proportions de ces deux dernières ne portent que
+ * sur le début des parties et ne se comparent pas. Un refus survient au même
+ * nombre de parties faciles (ou bloquées) : la candidate qui a tenu le plus de
+ * parties avant lui est la moins facile.
+ */
+uint64_t fallbackRank (const SeedVerdict & verdict) {
+    if (verdict.blocks) return (uint64_t(2) << 32) | (UINT32_MAX - verdict.games);
+    if (verdict.tooEasy) return (uint64_t(1) << 32) | (UINT32_MAX - verdict.targetGames);
+    return verdict.easyPerMille();
+}
+
+/**
+ * @brief Choisit la graine d'un jour et cherche son par
+ *
+ * Une candidate acceptée par les parties simulées est encore refusée si le
+ * solveur atteint la cible en au plus easyMoves coups : le robot joue au
+ * hasard, un joueur trouvera ce chemin court.
+ */
+DailyRecord chooseDay (uint64_t baseSeed, uint32_t day, const DailyCriteria & criteria, DailyReport & report) {
+    const unsigned attempts = max(1u, min(criteria.maxAttempts, KDailyMaxAttempts));
+    DailyRecord chosen = {0, 0, 0, 0, 0, 0};
+    bool accepted = false;
+    bool solved = false;       // par de la graine gardée déjà cherché
+    bool partial = false;      // proportions de la graine gardée mesurées sur un jugement arrêté tôt
+    uint64_t chosenRank = 0;
+    for (unsigned attempt = 0; attempt < attempts && !accepted; ++attempt) {
+        const uint64_t seed = candidateSeed(baseSeed, day, attempt);
+        const SeedVerdict verdict = judgeSeed(seed, criteria);
+        report.candidates++;
+        report.games += verdict.games;
+        report.rejectedEasy += verdict.tooEasy;
+        report.rejectedBlocked += verdict.blocks;
+        accepted = verdict.accepted;
+
+        SolveResult result = SolveResult();
+        if (accepted) {
+            result = solvePar(seed, criteria);
+            if (result.found && result.par <= criteria.easyMoves) {
+                accepted = false;
+                report.rejectedEasy++;
+            }
+        }
+        const uint64_t rank = fallbackRank(verdict);
+        if (accepted || attempt == 0 || rank < chosenRank) {
+            chosen.seed = seed;
+            chosen.easyPerMille = verdict.easyPerMille();
+            chosen.blockedPerMille = verdict.blockedPerMille();
+            chosenRank = rank;
+            partial = verdict.partial;
+            solved = verdict.accepted;
+            if (solved) {
+                chosen.par = result.found ? result.par : 0;
+                chosen.parProven = result.found && result.proven;
+            }
+        }
+        chosen.attempts = attempt + 1;
+    }
+    if (!accepted) report.unresolved++;
+
+    // Le calendrier garde les proportions de toutes les parties, pas celles d'un jugement arrêté tôt
+    if (partial) {
+        const SeedVerdict verdict = judgeSeed(chosen.seed, criteria, true);
+        report.games += verdict.games;
+        chosen.easyPerMille = verdict.easyPerMille();
+        chosen.blockedPerMille = verdict.blockedPerMille();
+    }
+    if (!solved) {
+        const SolveResult result = solvePar(chosen.seed, criteria);
+        chosen.par = result.found ? result.par : 0;
+        chosen.parProven = result.found && result.proven;
+    }
+    return chosen;
+}
+
+} // namespace
+
+// --- 1. LES JOURS ---
+
+string dailyDate (uint32_t day) {
+    const time_t seconds = time_t(day) * 86400;
+    struct tm date;
+    gmtime_r(&seconds, &date);
+    char text [16];
+    strftime(text, sizeof(text), "%Y-%m-%d", &date);
+    return text;
+}
+
+bool parseDailyDate (const string & text, uint32_t & day) {
+    int year;
+    unsigned month, dayOfMonth;
+    char end;
+    if (sscanf(text.c_str(), "%4d-%2u-%2u%c", &year, &month, &dayOfMonth, &end) != 3) return false;
+    if (year < 1970 || month < 1 || month > 12 || dayOfMonth < 1 || dayOfMonth > 31) return false;
+    day = uint32_t(daysFromCivil(year, month, dayOfMonth));
+    // Un 31 avril ou un 29 février d'une année non bissextile ne revient pas à la même date
+    return dailyDate(day) == text;
+}
+
+// --- 2. LE CHOIX DES GRAINES ---
+
+SeedVerdict judgeSeed (uint64_t seed, const DailyCriteria & criteria, bool complete) {
+    const GameMode modes[] = {ModeClassic, ModeTimeTrial, ModeTarget};
+    const unsigned nbModes = sizeof(modes) / sizeof(modes[0]);
+    const unsigned targetGames = criteria.games / nbModes;   // le mode Cible est le dernier de chaque tour
+    const uint64_t allowedEasy = uint64_t(targetGames) * criteria.maxEasyPerMille / 1000;
+    const uint64_t allowedBlocked = uint64_t(criteria.games) * criteria.maxBlockedPerMille / 1000;
+
+    SeedVerdict verdict = {true, false, false, false, 0, 0, 0, 0};
+    for (unsigned g = 0; g < criteria.games; ++g) {
+        const GameMode mode = modes[g % nbModes];
+        SimConfig config = {mode, g, criteria.gridSize, criteria.nbCandies, nullptr, nullptr, nullptr, &seed};
+        const SimResult result = simulateGame(config);
+        verdict.games++;
+        if (result.firstBlocked != 0 && result.firstBlocked <= criteria.earlyMoves) verdict.blockedGames++;
+        if (mode == ModeTarget) {
+            verdict.targetGames++;
+            if (result.reachedTarget && result.moves <= criteria.easyMoves) verdict.easyGames++;
+        }
+        // Refus certain : inutile de jouer les parties suivantes
+        verdict.tooEasy = verdict.easyGames > allowedEasy;
+        verdict.blocks = verdict.blockedGames > allowedBlocked;
+        if (verdict.tooEasy || verdict.blocks) {
+            verdict.accepted = false;
+            if (!complete) break;
+        }
+    }
+    verdict.partial = verdict.games < criteria.games;
+    return verdict;
+}
+
+DailyReport generateDailySeeds (uint64_t baseSeed, uint32_t firstDay, unsigned days, const DailyCriteria & criteria,
+                                unsigned nbThreads, vector<DailyRecord> & records) {
+    records.assign(days, DailyRecord {0, 0, 0, 0, 0, 0});
+    DailyReport total = {0, 0, 0, 0, 0};
+    mutex totalMutex;
+    atomic<unsigned> nextDay(0);
+
+    // Chaque fil prend le jour suivant ; les bilans sont additionnés à la fin de chaque fil
+    auto work = [&] () {
+        DailyReport report = {0, 0, 0, 0, 0};
+        while (true) {
+            const unsigned k = nextDay.fetch_add(1, memory_order_relaxed);
+            if (k >= days) break;
+            records[k] = chooseDay(baseSeed, firstDay + k, criteria, report);
+        }
+        lock_guard<mutex> lock(totalMutex);
+        total.candidates += report.candidates;
+        total.rejectedEasy += report.rejectedEasy;
+        total.rejectedBlocked += report.rejectedBlocked;
+        total.unresolved += report.unresolved;
+        total.games += report.games;
+    };
+
+    if (nbThreads == 0) nbThreads = max(1u, thread::hardware_concurrency());
+    nbThreads = max(1u, min(nbThreads, days));
+    vector<thread> workers;
+    for (unsigned t = 0; t + 1 < nbThreads; ++t) workers.emplace_back(work);
+    work();
+    for (thread & worker : workers) worker.join();
+    return total;
+}
+
+// --- 3. LE CALENDRIER ---
+
+bool writeDailyCalendar (const string & fileName, uint32_t firstDay, unsigned gridSize, unsigned nbCandies,
+                         const vector<DailyRecord> & records) {
+    ofstream file(fileName, ios::binary | ios::trunc);
+    if (!file) return false;
+
+    CalendarHeader header;
+    memcpy(header.magic, KCalendarMagic, sizeof(KCalendarMagic));
+    header.version = KCalendarVersion;
+    header.count = records.size();
+    header.firstDay = firstDay;
+    header.gridSize = gridSize;
+    header.nbCandies = nbCandies;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(DailyRecord));
+    return bool(file);
+}
+
+DailyCalendar::~DailyCalendar () {
+    close();
+}
+
+bool DailyCalendar::open (const string & fileName) {
+    close();
+    myFile = ::open(fileName.c_str(), O_RDONLY);
+    if (myFile < 0) return false;
+
+    CalendarHeader header;
+    if (pread(myFile, &header, sizeof(header), 0) != ssize_t(sizeof(header))
+        || memcmp(header.magic, KCalendarMagic, sizeof(KCalendarMagic)) != 0 || header.version != KCalendarVersion) {
+        close();
+        return false;
+    }
+    myFirstDay = header.firstDay;
+    myCount = header.count;
+    myGridSize = header.gridSize;
+    myNbCandies = header.nbCandies;
+    return true;
+}
+
+void DailyCalendar::close () {
+    if (myFile >= 0) ::close(myFile);
+    myFile = -1;
+    myFirstDay = 0;
+    myCount = 0;
+    myGridSize = 0;
+    myNbCandies = 0;
+}
+
+bool DailyCalendar::record (uint32_t day, DailyRecord & out) const {
+    if (myFile < 0 || day < myFirstDay || day - myFirstDay >= myCount) return false;
+    const off_t offset = sizeof(CalendarHeader) + off_t(day - myFirstDay) * sizeof(DailyRecord);
+    return pread(myFile, &out, sizeof(out), offset) == ssize_t(sizeof(out));
+}
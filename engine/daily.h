@@ -0,0 +1,186 @@
+/**
+ * @file daily.h
+ * @brief Défi du jour : calendrier des graines, préparé à l'avance, et choix des graines par des parties simulées
+ *
+ * Chaque jour a sa graine : tous les joueurs y reçoivent la même grille et
+ * les mêmes bonbons qui tombent (partie à graine, seedGame dans spawn.h),
+ * dans les trois modes, avec un classement par jour et par mode.
+ *
+ * Les graines d'une année sont choisies d'avance (candy_daily generate), les
+ * jours répartis entre les fils. Pour un jour, les graines candidates sont
+ * dérivées de la graine du calendrier et du numéro du jour : le calendrier
+ * est le même quel que soit le nombre de fils. Une candidate est jugée sur
+ * des milliers de parties jouées au hasard par le robot du simulateur, sur
+ * sa grille et ses remplissages, à tour de rôle dans les trois modes. Elle
+ * est refusée si :
+ *   - trop de parties du mode Cible atteignent la cible en quelques coups
+ *     (grille trop facile) ;
+ *   - trop de parties trouvent la grille bloquée dès les premiers coups.
+ * Le jugement s'arrête dès que le refus est certain. Le par du mode Cible
+ * d'une candidate acceptée est ensuite cherché par le solveur (solver.h) :
+ * un par d'au plus easyMoves coups la refuse aussi comme trop facile, et
+ * la candidate suivante est essayée. Si aucune n'est acceptée, la moins
+ * facile est gardée : un par trop court plutôt que trop de parties faciles,
+ * trop de parties faciles plutôt qu'un blocage. Ses proportions sont alors
+ * mesurées sur toutes les parties, pas sur un jugement arrêté au refus.
+ *
+ * Le calendrier est un fichier indexé : un en-tête, puis un enregistrement
+ * de taille fixe par jour à partir du premier jour. La graine d'un jour est
+ * lue à sa position, sans parcourir le fichier.
+ */
+#ifndef CANDY_DAILY_H
+#define CANDY_DAILY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Graines candidates essayées au plus pour un jour (numéro de l'essai sur 8 bits)
+const unsigned KDailyMaxAttempts (255);
+
+/**
+ * @struct DailyRecord
+ * @brief Un jour du calendrier tel qu'il est stocké dans le fichier
+ */
+struct DailyRecord {
+    std::uint64_t seed;              // graine de la partie (seedGame)
+    std::uint16_t par;               // par du mode Cible (0 : cible non atteinte par le solveur)
+    std::uint8_t parProven;          // 1 : aucune suite plus courte n'atteint la cible
+    std::uint8_t attempts;           // graines candidates essayées pour ce jour
+    std::uint16_t easyPerMille;      // parties Cible trop faciles, pour mille (sur toutes les parties simulées)
+    std::uint16_t blockedPerMille;   // parties bloquées dès les premiers coups, pour mille (idem)
+};
+static_assert(sizeof(DailyRecord) == 16, "DailyRecord est lu tel quel depuis le calendrier");
+
+/**
+ * @struct DailyCriteria
+ * @brief Règles du choix des graines
+ */
+struct DailyCriteria {
+    unsigned gridSize;
+    unsigned nbCandies;
+    unsigned games;                  // parties simulées par candidate, les trois modes à tour de rôle
+    unsigned easyMoves;              // cible atteinte en au plus easyMoves coups : partie (ou par) trop facile
+    unsigned maxEasyPerMille;        // parties Cible trop faciles admises, pour mille
+    unsigned earlyMoves;             // grille bloquée avant le coup earlyMoves : blocage précoce
+    unsigned maxBlockedPerMille;     // parties bloquées tôt admises, pour mille
+    unsigned maxAttempts;            // candidates au plus par jour (au plus KDailyMaxAttempts)
+    unsigned beamWidth;              // faisceau du solveur pour le par
+    std::uint64_t proofBudget;       // coups joués au plus pour prouver le par (0 : pas de preuve)
+};
+
+/**
+ * @struct SeedVerdict
+ * @brief Jugement d'une graine candidate
+ */
+struct SeedVerdict {
+    bool accepted;
+    bool tooEasy;                    // refusée : trop de parties Cible trop faciles
+    bool blocks;                     // refusée : trop de parties bloquées tôt
+    bool partial;                    // jugement arrêté au refus : les proportions ne portent que sur les parties jouées
+    unsigned games;                  // parties jouées (moins que demandé si le refus est certain plus tôt)
+    unsigned targetGames;
+    unsigned easyGames;
+    unsigned blockedGames;
+
+    std::uint16_t easyPerMille () const { return targetGames ? easyGames * 1000 / targetGames : 0; }
+    std::uint16_t blockedPerMille () const { return games ? blockedGames * 1000 / games : 0; }
+};
+
+/**
+ * @struct DailyReport
+ * @brief Bilan de la préparation d'un calendrier
+ */
+struct DailyReport {
+    unsigned candidates;             // graines jugées
+    unsigned rejectedEasy;           // trop de parties Cible faciles, ou par trop court
+    unsigned rejectedBlocked;
+    unsigned unresolved;             // jours sans candidate acceptée : la moins facile est gardée
+    std::uint64_t games;             // parties simulées
+};
+
+// --- 1. LES JOURS ---
+
+/**
+ * @brief Numéro du jour (UTC) d'un instant : jours depuis le 1er janvier 1970
+ */
+inline std::uint32_t dailyDay (std::time_t when) {
+    return std::uint32_t(when / 86400);
+}
+
+/**
+ * @brief Date AAAA-MM-JJ d'un jour
+ */
+std::string dailyDate (std::uint32_t day);
+
+/**
+ * @brief Jour d'une date AAAA-MM-JJ
+ * @return false si la date est mal écrite
+ */
+bool parseDailyDate (const std::string & text, std::uint32_t & day);
+
+// --- 2. LE CHOIX DES GRAINES ---
+
+/**
+ * @brief Joue les parties simulées d'une graine candidate et la juge
+ * @param complete Vrai : toutes les parties sont jouées, même quand le refus est certain
+ */
+SeedVerdict judgeSeed (std::uint64_t seed, const DailyCriteria & criteria, bool complete = false);
+
+/**
+ * @brief Choisit les graines de days jours à partir de firstDay, et leur par, sur nbThreads fils
+ * @param baseSeed Graine du calendrier : les candidates de chaque jour en sont dérivées
+ * @param nbThreads Fils de calcul, fil appelant compris (0 : un par cœur)
+ * @param[out] records Un enregistrement par jour, dans l'ordre des jours
+ */
+DailyReport generateDailySeeds (std::uint64_t baseSeed, std::uint32_t firstDay, unsigned days,
+                                const DailyCriteria & criteria, unsigned nbThreads,
+                                std::vector<DailyRecord> & records);
+
+// --- 3. LE CALENDRIER ---
+
+/**
+ * @brief Ecrit un calendrier (remplacé en entier)
+ */
+bool writeDailyCalendar (const std::string & fileName, std::uint32_t firstDay, unsigned gridSize, unsigned nbCandies,
+                         const std::vector<DailyRecord> & records);
+
+/**
+ * @brief Calendrier ouvert en lecture : seul l'en-tête est lu, puis un enregistrement par jour demandé
+ */
+class DailyCalendar {
+public:
+    DailyCalendar () = default;
+    ~DailyCalendar ();
+    DailyCalendar (const DailyCalendar &) = delete;
+    DailyCalendar & operator= (const DailyCalendar &) = delete;
+
+    /**
+     * @return false si le fichier est absent ou n'est pas un calendrier
+     */
+    bool open (const std::string & fileName);
+
+    void close ();
+
+    /**
+     * @brief Enregistrement d'un jour
+     * @return false si le jour est hors du calendrier ou illisible
+     */
+    bool record (std::uint32_t day, DailyRecord & out) const;
+
+    std::uint32_t firstDay () const { return myFirstDay; }
+    std::size_t size () const { return myCount; }
+    unsigned gridSize () const { return myGridSize; }
+    unsigned nbCandies () const { return myNbCandies; }
+
+private:
+    int myFile = -1;
+    std::uint32_t myFirstDay = 0;
+    std::size_t myCount = 0;
+    unsigned myGridSize = 0;
+    unsigned myNbCandies = 0;
+};
+
+#endif // CANDY_DAILY_H
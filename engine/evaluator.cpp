@@ -0,0 +1,203 @@
+#include "evaluator.h"
+#include "events.h"
+#include "history.h"
+#include "special.h"
+#include "zobrist.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Ordre des coups rendus : meilleur score, puis position (haut, gauche, 'D' avant 'S')
+ */
+bool better (const MoveScore & a, const MoveScore & b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.pos.ord != b.pos.ord) return a.pos.ord < b.pos.ord;
+    if (a.pos.abs != b.pos.abs) return a.pos.abs < b.pos.abs;
+    return a.direction < b.direction;
+}
+
+/**
+ * @brief Joue un coup et toute sa réaction en chaîne, comme main.cpp ou comme les modes du menu
+ * @param resolver Réaction en chaîne de config.batch, remplie avec la graine seed
+ * @param deadline Fin du budget (nul : sans limite), vérifiée à chaque pas de la réaction en chaîne
+ * @return false si le budget est écoulé avant la fin de la réaction en chaîne
+ */
+bool playMove (mat & grid, MoveScore & move, const EvalConfig & config, BandResolver * resolver, uint64_t seed,
+               const chrono::steady_clock::time_point * deadline) {
+    uint64_t score = 0;
+    unsigned comboLevel = 0;
+    unsigned howMany = 0;
+    maPosition matchPos;
+    makeAMove(grid, move.pos, move.direction);
+
+    if (config.batch) {
+        // Grande grille de la partie libre : tous les matchs d'un pas au même niveau de combo
+        const ResolveReport report = resolver->resolve(grid, config.rule, config.nbCandies, seed);
+        score = report.score;
+        comboLevel = report.steps;
+    }
+    else if (!config.specials) {
+        // Partie libre : un match en colonne puis un en ligne à chaque pas, même niveau de combo
+        bool found = true;
+        while (found) {
+            if (deadline && chrono::steady_clock::now() >= *deadline) return false;
+            found = false;
+            if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
+                removalInColumn(grid, matchPos, howMany, config.nbCandies);
+                score = scoreAdd(score, matchScore(config.rule, howMany, comboLevel + 1));
+                found = true;
+            }
+            if (atLeastThreeInARow(grid, matchPos, howMany)) {
+                removalInRow(grid, matchPos, howMany, config.nbCandies);
+                score = scoreAdd(score, matchScore(config.rule, howMany, comboLevel + 1));
+                found = true;
+            }
+            if (found) comboLevel++;
+        }
+    }
+    else {
+        // Modes du menu : bombe échangée d'abord, puis un match par pas (colonne avant ligne)
+        unsigned bombed = activateSwap(grid, move.pos, move.direction, config.nbCandies);
+        if (bombed > 0) {
+            comboLevel++;
+            score = scoreAdd(score, matchScore(config.rule, bombed, comboLevel));
+        }
+        while (true) {
+            if (deadline && chrono::steady_clock::now() >= *deadline) return false;
+            if (atLeastThreeInAColumn(grid, matchPos, howMany))
+                howMany = clearMatch(grid, matchPos, howMany, MatchVertical, config.nbCandies);
+            else if (atLeastThreeInARow(grid, matchPos, howMany))
+                howMany = clearMatch(grid, matchPos, howMany, MatchHorizontal, config.nbCandies);
+            else
+                break;
+            comboLevel++;
+            score = scoreAdd(score, matchScore(config.rule, howMany, comboLevel));
+        }
+    }
+    move.score = score;
+    move.combo = comboLevel;
+    return true;
+}
+
+} // namespace
+
+MoveEvaluator::MoveEvaluator (unsigned nbThreads)
+    : myGeneration(0), myRunning(0), myStop(false), myConfig(nullptr), myNext(0), myEvaluated(0) {
+    if (nbThreads == 0) nbThreads = max(1u, thread::hardware_concurrency());
+    mySlots.resize(nbThreads);
+    for (unsigned t = 0; t + 1 < nbThreads; ++t) myWorkers.emplace_back(&MoveEvaluator::workerLoop, this, t);
+}
+
+MoveEvaluator::~MoveEvaluator () {
+    {
+        lock_guard<mutex> lock(myMutex);
+        myStop = true;
+    }
+    myWake.notify_all();
+    for (thread & worker : myWorkers) worker.join();
+}
+
+void MoveEvaluator::workerLoop (unsigned slot) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(myMutex);
+            myWake.wait(lock, [&] () { return myStop || myGeneration != seen; });
+            if (myStop) return;
+            seen = myGeneration;
+        }
+        runJob(mySlots[slot]);
+        {
+            lock_guard<mutex> lock(myMutex);
+            if (--myRunning == 0) myDone.notify_one();
+        }
+    }
+}
+
+void MoveEvaluator::runJob (Slot & slot) {
+    const EvalConfig & config = *myConfig;
+    const uint64_t size = myBase.size();
+    const chrono::steady_clock::time_point * deadline = config.budgetMs > 0 ? &myDeadline : nullptr;
+    // Le hash, le flux d'événements et l'historique d'une partie du fil appelant ne doivent pas suivre les coups essayés
+    HashScope hashScope(nullptr);
+    EventScope eventScope(nullptr);
+    HistoryPause historyPause;
+    // Un fil par BandResolver : les coups sont déjà répartis entre les fils de l'évaluateur
+    if (config.batch && !slot.resolver) slot.resolver.reset(new BandResolver(1));
+
+    while (true) {
+        if (deadline && chrono::steady_clock::now() >= *deadline) break;
+        const size_t i = myNext.fetch_add(1, memory_order_relaxed);
+        if (i >= myCandidates.size()) break;
+
+        MoveScore move = myCandidates[i];
+        slot.grid = myBase;
+        uint64_t state = forkSeed(config.seed, (move.pos.ord * size + move.pos.abs) * 2 + (move.direction == 'S'));
+        const uint64_t seed = state;
+        RandomScope randomScope(&state);
+        SpawnPolicy * policy = nullptr;
+        if (config.spawn) {
+            slot.spawn = *config.spawn;
+            policy = &slot.spawn;
+        }
+        SpawnScope spawnScope(policy);
+        // Une longue réaction en chaîne coupée par le budget ne compte pas
+        if (!playMove(slot.grid, move, config, slot.resolver.get(), seed, deadline)) break;
+        myEvaluated.fetch_add(1, memory_order_relaxed);
+
+        // Tas des topK meilleurs : le moins bon en tête
+        slot.best.push_back(move);
+        push_heap(slot.best.begin(), slot.best.end(), better);
+        if (slot.best.size() > config.topK) {
+            pop_heap(slot.best.begin(), slot.best.end(), better);
+            slot.best.pop_back();
+        }
+    }
+}
+
+EvalReport MoveEvaluator::evaluate (const mat & grid, const EvalConfig & config, vector<MoveScore> & best) {
+    myDeadline = chrono::steady_clock::now() + chrono::milliseconds(config.budgetMs);
+
+    // --- 1. Coups légaux (chaque échange une seule fois : vers la droite et vers le bas) ---
+    myBase = grid;
+    myCandidates.clear();
+    const unsigned size = myBase.size();
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            for (char direction : {'D', 'S'}) {
+                maPosition here = {j, i};
+                if (isLegalMove(myBase, here, direction)) myCandidates.push_back({here, direction, 0, 0});
+            }
+        }
+    }
+
+    // --- 2. Evaluation par tous les fils ---
+    myConfig = &config;
+    myNext.store(0, memory_order_relaxed);
+    myEvaluated.store(0, memory_order_relaxed);
+    for (Slot & slot : mySlots) slot.best.clear();
+    {
+        lock_guard<mutex> lock(myMutex);
+        myRunning = myWorkers.size();
+        myGeneration++;
+    }
+    myWake.notify_all();
+    runJob(mySlots.back());
+    {
+        unique_lock<mutex> lock(myMutex);
+        myDone.wait(lock, [&] () { return myRunning == 0; });
+    }
+
+    // --- 3. Meilleurs coups de tous les fils ---
+    best.clear();
+    for (const Slot & slot : mySlots) best.insert(best.end(), slot.best.begin(), slot.best.end());
+    sort(best.begin(), best.end(), better);
+    if (best.size() > config.topK) best.resize(config.topK);
+
+    const size_t evaluated = myEvaluated.load(memory_order_relaxed);
+    return EvalReport {myCandidates.size(), evaluated, evaluated == myCandidates.size()};
+}
@@ -0,0 +1,136 @@
+/**
+ * @file evaluator.h
+ * @brief Evaluation de tous les coups légaux en parallèle, pour les conseils et le robot
+ *
+ * Chaque échange légal est joué jusqu'au bout de sa réaction en chaîne sur une
+ * copie privée de la grille et reçoit le score qu'il rapporte. Les coups sont
+ * répartis entre les fils d'un groupe créé une fois pour toutes avec
+ * l'évaluateur (le fil appelant travaille aussi).
+ *
+ * Les bonbons qui tombent pendant l'évaluation d'un coup sont tirés dans un
+ * générateur propre à ce coup (forkSeed de la graine et de la position du
+ * coup, voir spawn.h) : pour une même grille et une même graine, les scores
+ * sont les mêmes quel que soit le nombre de fils.
+ *
+ * Avec un budget de temps, l'évaluation s'arrête quand il est écoulé, même
+ * au milieu d'une réaction en chaîne (sur une grande grille, certaines durent
+ * des milliers de pas), et rend les meilleurs coups parmi ceux déjà évalués.
+ *
+ * Les coups sont joués avec les règles de la partie qui demande le conseil :
+ * modes du menu (bonbons spéciaux), partie libre avec un match par pas, ou
+ * partie libre des grandes grilles, où BandResolver supprime tous les matchs
+ * d'un pas à la fois. Chaque fil a alors son propre BandResolver à un fil ;
+ * le budget n'est vérifié qu'entre deux coups.
+ */
+#ifndef CANDY_EVALUATOR_H
+#define CANDY_EVALUATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "grid.h"
+#include "resolver.h"
+#include "score.h"
+#include "spawn.h"
+
+/**
+ * @struct EvalConfig
+ * @brief Règles et limites d'une évaluation
+ */
+struct EvalConfig {
+    ScoreRule rule;             // règle de score
+    bool specials;              // true : règles des modes du menu (bonbons spéciaux) ; false : partie libre (main.cpp)
+    bool batch;                 // partie libre : tous les matchs d'un pas à la fois, comme BandResolver (grandes grilles)
+    unsigned nbCandies;         // types de bonbons pour le remplissage
+    unsigned topK;              // nombre de coups rendus
+    unsigned budgetMs;          // temps maximal (0 : tous les coups sont évalués)
+    std::uint64_t seed;         // graine des remplissages
+    const SpawnPolicy * spawn;  // si non nul : politique d'apparition copiée pour chaque coup
+};
+
+/**
+ * @struct MoveScore
+ * @brief Un coup évalué
+ */
+struct MoveScore {
+    maPosition pos;
+    char direction;             // 'D' ou 'S' : chaque échange n'est compté qu'une fois
+    std::uint64_t score;        // points du coup et de sa réaction en chaîne
+    unsigned combo;             // pas de la réaction en chaîne
+};
+
+/**
+ * @struct EvalReport
+ * @brief Bilan d'une évaluation
+ */
+struct EvalReport {
+    std::size_t candidates;     // coups légaux
+    std::size_t evaluated;      // coups évalués avant la fin du budget
+    bool complete;              // tous les coups ont été évalués
+};
+
+/**
+ * @brief Evalue les coups légaux d'une grille sur un groupe de fils
+ */
+class MoveEvaluator {
+public:
+    /**
+     * @param nbThreads Fils de calcul, fil appelant compris (0 : un par cœur)
+     */
+    explicit MoveEvaluator (unsigned nbThreads = 0);
+    ~MoveEvaluator ();
+    MoveEvaluator (const MoveEvaluator &) = delete;
+    MoveEvaluator & operator= (const MoveEvaluator &) = delete;
+
+    /**
+     * @brief Meilleurs coups d'une grille
+     * @param grid Grille (inchangée)
+     * @param config Règles, nombre de coups rendus, budget et graine
+     * @param[out] best Au plus config.topK coups, du meilleur au moins bon
+     *                  (à score égal : de haut en bas, puis de gauche à droite)
+     */
+    EvalReport evaluate (const mat & grid, const EvalConfig & config, std::vector<MoveScore> & best);
+
+    unsigned threads () const { return myWorkers.size() + 1; }
+
+private:
+    /**
+     * @brief Copie de travail et meilleurs coups d'un fil
+     */
+    struct Slot {
+        mat grid;
+        SpawnPolicy spawn;
+        std::unique_ptr<BandResolver> resolver;   // réaction en chaîne de config.batch, créé au premier besoin
+        std::vector<MoveScore> best;   // tas : le moins bon en tête
+    };
+
+    void workerLoop (unsigned slot);
+    void runJob (Slot & slot);
+
+    std::vector<std::thread> myWorkers;
+    std::vector<Slot> mySlots;         // un par fil, le dernier pour le fil appelant
+
+    std::mutex myMutex;
+    std::condition_variable myWake;
+    std::condition_variable myDone;
+    std::uint64_t myGeneration;        // numéro de l'évaluation en cours
+    unsigned myRunning;                // fils encore au travail
+    bool myStop;
+
+    // Evaluation en cours
+    mat myBase;
+    const EvalConfig * myConfig;
+    std::vector<MoveScore> myCandidates;
+    std::atomic<std::size_t> myNext;
+    std::atomic<std::size_t> myEvaluated;
+    std::chrono::steady_clock::time_point myDeadline;
+};
+
+#endif // CANDY_EVALUATOR_H
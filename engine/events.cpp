@@ -0,0 +1,172 @@
+#include "events.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ostream>
+
+using namespace std;
+
+namespace {
+
+const size_t KEventWords (3);
+
+void packEvent (const GameEvent & event, uint64_t words [KEventWords]) {
+    memset(words, 0, KEventWords * sizeof(uint64_t));
+    memcpy(words, &event, sizeof(GameEvent));
+}
+
+GameEvent unpackEvent (const uint64_t words [KEventWords]) {
+    GameEvent event;
+    memcpy(&event, words, sizeof(GameEvent));
+    return event;
+}
+
+} // namespace
+
+const char * eventName (EventKind kind) {
+    switch (kind) {
+    case EventMoveApplied: return "coup";
+    case EventMatchFound: return "match";
+    case EventCascadeStep: return "cascade";
+    case EventSpawned: return "remplissage";
+    case EventScoreChanged: return "score";
+    case EventGameOver: return "fin";
+    }
+    return "?";
+}
+
+void writeEvent (ostream & out, const GameEvent & event) {
+    out << eventName(event.kind);
+    switch (event.kind) {
+    case EventMoveApplied: out << ' ' << event.ord << ' ' << event.abs << ' ' << event.direction; break;
+    case EventMatchFound: out << ' ' << event.ord << ' ' << event.abs << ' ' << event.length << ' ' << event.direction; break;
+    case EventCascadeStep: out << ' ' << event.length; break;
+    case EventSpawned: out << ' ' << event.ord << ' ' << event.abs << ' ' << event.length; break;
+    case EventScoreChanged: out << ' ' << event.value; break;
+    case EventGameOver: out << ' ' << event.value << ' ' << event.length; break;
+    }
+    out << '\n';
+}
+
+// --- 1. L'ANNEAU ---
+
+EventStream::EventStream (size_t capacity) : myHead(0) {
+    size_t nbSlots = 1;
+    while (nbSlots < capacity) nbSlots *= 2;
+    mySlots = vector<Slot>(nbSlots);
+    myMask = nbSlots - 1;
+    for (Slot & slot : mySlots) {
+        slot.sequence.store(0, memory_order_relaxed);
+        for (atomic<uint64_t> & word : slot.words) word.store(0, memory_order_relaxed);
+    }
+}
+
+void EventStream::publish (const GameEvent & event) {
+    // Seul le producteur écrit myHead : une lecture relâchée suffit
+    const uint64_t n = myHead.load(memory_order_relaxed);
+    Slot & slot = mySlots[n & myMask];
+    uint64_t words [KEventWords];
+    packEvent(event, words);
+
+    // Séquence impaire pendant l'écriture : un lecteur qui croise l'écriture la voit changer
+    slot.sequence.store(2 * n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t k = 0; k < KEventWords; ++k) slot.words[k].store(words[k], memory_order_relaxed);
+    slot.sequence.store(2 * n + 2, memory_order_release);
+    myHead.store(n + 1, memory_order_release);
+}
+
+// --- 2. LA LECTURE ---
+
+EventCursor::EventCursor (const EventStream & stream)
+    : myStream(stream), myNext(stream.published()), myDropped(0) {}
+
+void EventCursor::resync () {
+    const uint64_t head = myStream.published();
+    const uint64_t capacity = myStream.mySlots.size();
+    // La plus ancienne case peut être en cours de réécriture : on reprend juste après
+    const uint64_t oldest = head > capacity ? head - capacity + 1 : 0;
+    if (oldest > myNext) {
+        myDropped += oldest - myNext;
+        myNext = oldest;
+    }
+}
+
+size_t EventCursor::poll (GameEvent * events, size_t max) {
+    if (myStream.published() - myNext > myStream.mySlots.size()) resync();
+
+    size_t count = 0;
+    while (count < max) {
+        if (myNext >= myStream.published()) break;
+        const EventStream::Slot & slot = myStream.mySlots[myNext & myStream.myMask];
+        const uint64_t expected = 2 * myNext + 2;
+        const uint64_t before = slot.sequence.load(memory_order_acquire);
+        uint64_t words [KEventWords];
+        for (size_t k = 0; k < KEventWords; ++k) words[k] = slot.words[k].load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        const uint64_t after = slot.sequence.load(memory_order_relaxed);
+
+        // La case a déjà été réécrite par un événement plus récent : l'abonné est dépassé
+        if (before != expected || after != expected) {
+            resync();
+            continue;
+        }
+        events[count++] = unpackEvent(words);
+        myNext++;
+    }
+    return count;
+}
+
+// --- 3. LES ABONNES ---
+
+EventSubscriber::EventSubscriber (const EventStream & stream, function<void (const GameEvent &)> handler)
+    : myCursor(stream), myHandler(move(handler)), myStop(false), myReceived(0), myDropped(0),
+      myThread(&EventSubscriber::run, this) {}
+
+EventSubscriber::~EventSubscriber () {
+    stop();
+}
+
+void EventSubscriber::stop () {
+    myStop.store(true, memory_order_release);
+    if (myThread.joinable()) myThread.join();
+}
+
+void EventSubscriber::run () {
+    vector<GameEvent> batch (KEventBatch);
+    unsigned idleUs = 0;
+    while (true) {
+        // Lu avant poll : après l'arrêt demandé, le dernier tour lit tout ce qui a été publié
+        const bool stopping = myStop.load(memory_order_acquire);
+        const size_t count = myCursor.poll(batch.data(), batch.size());
+        for (size_t k = 0; k < count; ++k) myHandler(batch[k]);
+        myReceived.fetch_add(count, memory_order_relaxed);
+        myDropped.store(myCursor.dropped(), memory_order_relaxed);
+
+        if (count > 0) {
+            idleUs = 0;
+            continue;
+        }
+        if (stopping) break;
+        // Anneau vide : attente de plus en plus longue, sans jamais faire attendre le producteur
+        if (idleUs == 0) {
+            this_thread::yield();
+            idleUs = 1;
+        }
+        else {
+            this_thread::sleep_for(chrono::microseconds(idleUs));
+            idleUs = min(idleUs * 2, KEventIdleUs);
+        }
+    }
+}
+
+// --- 4. LE FLUX DU FIL COURANT ---
+
+EventScope::EventScope (EventStream * stream) : myPrevious(tlsEvents) {
+    tlsEvents = stream;
+}
+
+EventScope::~EventScope () {
+    tlsEvents = myPrevious;
+}
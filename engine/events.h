@@ -0,0 +1,221 @@
+/**
+ * @file events.h
+ * @brief Flux d'événements d'une partie, pour les consommateurs extérieurs au jeu
+ *
+ * Le moteur publie ce qui se passe pendant une partie sous forme de petits
+ * événements de taille fixe : échange joué, match supprimé, pas de réaction
+ * en chaîne, bonbons tombés, score, fin de partie. Ils sont écrits dans un
+ * anneau à un seul producteur (le fil de la partie) et lus par autant
+ * d'abonnés que l'on veut, chacun sur son fil (affichage, statistiques,
+ * enregistrement d'une partie, diffusion réseau).
+ *
+ * Le producteur n'attend jamais : il écrit la case suivante de l'anneau sans
+ * regarder où en sont les abonnés. Un abonné trop lent se fait dépasser, il
+ * le voit au numéro de séquence de la case et compte les événements perdus
+ * au lieu de ralentir la partie.
+ *
+ * Un EventScope installe le flux pour le fil courant : l'échange (makeAMove),
+ * les matchs (removalInColumn, removalInRow, clearMatch) et le remplissage
+ * (refillColumn) publient d'eux-mêmes ; les boucles des modes publient les
+ * pas de réaction en chaîne, le score et la fin de partie. Sans EventScope,
+ * chaque point de publication ne coûte qu'un test de pointeur.
+ */
+#ifndef CANDY_EVENTS_H
+#define CANDY_EVENTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <thread>
+#include <vector>
+
+// Cases de l'anneau par défaut (puissance de 2)
+const std::size_t KEventCapacity (1 << 16);
+
+// Evénements lus d'un coup par un abonné
+const std::size_t KEventBatch (256);
+
+// Attente maximale d'un abonné quand l'anneau est vide (microsecondes)
+const unsigned KEventIdleUs (500);
+
+/**
+ * @brief Types d'événements
+ */
+enum EventKind : std::uint8_t {
+    EventMoveApplied,    // échange joué : ord, abs, direction
+    EventMatchFound,     // match supprimé : premier bonbon (ord, abs), length bonbons, direction 'V' ou 'H'
+    EventCascadeStep,    // pas de réaction en chaîne : length = niveau de combo
+    EventSpawned,        // remplissage : length bonbons tombés en haut de la colonne abs (à partir de la ligne ord)
+    EventScoreChanged,   // nouveau score : value
+    EventGameOver        // fin de partie : value = score final, length = coups joués
+};
+
+/**
+ * @struct GameEvent
+ * @brief Un événement (24 octets)
+ */
+struct GameEvent {
+    EventKind kind;
+    char direction;
+    std::uint32_t length;
+    std::uint32_t ord;
+    std::uint32_t abs;
+    std::uint64_t value;
+};
+
+/**
+ * @brief Nom d'un type d'événement ("coup", "match", "cascade", "remplissage", "score", "fin")
+ */
+const char * eventName (EventKind kind);
+
+/**
+ * @brief Ecrit un événement sur une ligne de texte (enregistrement d'une partie)
+ *
+ * Le nom, puis les champs utiles au type : "coup ligne colonne direction",
+ * "match ligne colonne longueur sens", "cascade combo",
+ * "remplissage ligne colonne nombre", "score score", "fin score coups".
+ */
+void writeEvent (std::ostream & out, const GameEvent & event);
+
+/**
+ * @brief Anneau d'événements : un fil producteur, des abonnés qui lisent chacun à leur rythme
+ */
+class EventStream {
+public:
+    /**
+     * @param capacity Cases de l'anneau (arrondi à la puissance de 2 supérieure)
+     */
+    explicit EventStream (std::size_t capacity = KEventCapacity);
+    EventStream (const EventStream &) = delete;
+    EventStream & operator= (const EventStream &) = delete;
+
+    /**
+     * @brief Publie un événement (depuis le seul fil producteur) ; n'attend jamais
+     */
+    void publish (const GameEvent & event);
+
+    /**
+     * @brief Nombre d'événements publiés depuis la création
+     */
+    std::uint64_t published () const { return myHead.load(std::memory_order_acquire); }
+
+    std::size_t capacity () const { return mySlots.size(); }
+
+private:
+    friend class EventCursor;
+
+    // Numéro de séquence : 2n+1 pendant l'écriture de l'événement n, 2n+2 une fois publié
+    struct alignas(32) Slot {
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<std::uint64_t> words[3];
+    };
+
+    std::vector<Slot> mySlots;
+    std::uint64_t myMask;
+    alignas(64) std::atomic<std::uint64_t> myHead;
+};
+
+/**
+ * @brief Position de lecture d'un abonné dans un EventStream
+ */
+class EventCursor {
+public:
+    /**
+     * @brief Lira les événements publiés à partir de maintenant
+     */
+    explicit EventCursor (const EventStream & stream);
+
+    /**
+     * @brief Lit les événements disponibles sans attendre
+     * @param[out] events Au plus max événements, dans l'ordre de publication
+     * @return Nombre d'événements lus (0 si l'abonné est à jour)
+     */
+    std::size_t poll (GameEvent * events, std::size_t max);
+
+    /**
+     * @brief Evénements écrasés avant d'avoir été lus (abonné dépassé par le producteur)
+     */
+    std::uint64_t dropped () const { return myDropped; }
+
+private:
+    /**
+     * @brief Reprend au plus ancien événement encore dans l'anneau
+     */
+    void resync ();
+
+    const EventStream & myStream;
+    std::uint64_t myNext;      // numéro du prochain événement à lire
+    std::uint64_t myDropped;
+};
+
+/**
+ * @brief Abonné qui lit le flux sur son propre fil et passe chaque événement à handler
+ *
+ * Quand l'anneau est vide, le fil attend de plus en plus longtemps (au plus
+ * KEventIdleUs). A l'arrêt (stop ou destruction), il lit ce qui reste puis s'arrête.
+ */
+class EventSubscriber {
+public:
+    EventSubscriber (const EventStream & stream, std::function<void (const GameEvent &)> handler);
+    ~EventSubscriber ();
+    EventSubscriber (const EventSubscriber &) = delete;
+    EventSubscriber & operator= (const EventSubscriber &) = delete;
+
+    /**
+     * @brief Lit les derniers événements publiés puis arrête le fil (le producteur doit avoir fini)
+     */
+    void stop ();
+
+    std::uint64_t received () const { return myReceived.load(std::memory_order_relaxed); }
+    std::uint64_t dropped () const { return myDropped.load(std::memory_order_relaxed); }
+
+private:
+    void run ();
+
+    EventCursor myCursor;
+    std::function<void (const GameEvent &)> myHandler;
+    std::atomic<bool> myStop;
+    std::atomic<std::uint64_t> myReceived;
+    std::atomic<std::uint64_t> myDropped;
+    std::thread myThread;
+};
+
+// Flux du fil courant (nul : aucun)
+inline thread_local EventStream * tlsEvents = nullptr;
+
+/**
+ * @brief Publie les événements du fil courant dans stream, le temps de sa portée
+ *
+ * Les portées s'emboîtent : EventScope(nullptr) coupe la publication (coups
+ * essayés par l'évaluateur, par exemple).
+ */
+class EventScope {
+public:
+    explicit EventScope (EventStream * stream);
+    ~EventScope ();
+    EventScope (const EventScope &) = delete;
+    EventScope & operator= (const EventScope &) = delete;
+
+private:
+    EventStream * myPrevious;
+};
+
+/**
+ * @brief Publie un événement dans le flux du fil courant, s'il y en a un
+ */
+inline void emitEvent (EventKind kind, char direction, std::uint32_t length, std::uint32_t ord, std::uint32_t abs,
+                       std::uint64_t value) {
+    if (tlsEvents) tlsEvents->publish(GameEvent {kind, direction, length, ord, abs, value});
+}
+
+/**
+ * @brief Pas de réaction en chaîne d'une boucle de jeu : le pas, puis le score qu'il donne
+ */
+inline void emitScoredStep (unsigned comboLevel, std::uint64_t score) {
+    emitEvent(EventCascadeStep, 0, comboLevel, 0, 0, 0);
+    emitEvent(EventScoreChanged, 0, 0, 0, 0, score);
+}
+
+#endif // CANDY_EVENTS_H
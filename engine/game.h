@@ -0,0 +1,34 @@
+/**
+ * @file game.h
+ * @brief Règles communes des modes de jeu (objectifs et calcul du score)
+ */
+#ifndef CANDY_GAME_H
+#define CANDY_GAME_H
+
+#include "score.h"
+
+/**
+ * @brief Les trois modes de jeu du menu
+ */
+enum GameMode {
+    ModeClassic,    // Coups limités, meilleur score
+    ModeTimeTrial,  // Temps limité, meilleur score
+    ModeTarget      // Atteindre KTargetScore avec le moins de coups
+};
+
+// Objectifs des modes
+const unsigned KMaxMoves (20);      // Nombre maximal de coups (Mode Classique)
+const unsigned KTimeLimit (60);     // Limite de temps pour le Mode Contre-la-montre (secondes)
+const unsigned KTargetScore (1000); // Score à atteindre (Mode Cible)
+
+// Règle de score de chaque mode, dans l'ordre de GameMode
+const ScoreRule KModeScoreRules[] = {RuleCombo, RuleCombo, RuleCombo};
+
+/**
+ * @brief Règle de score d'un mode de jeu
+ */
+inline ScoreRule scoreRuleFor (GameMode mode) {
+    return KModeScoreRules[mode];
+}
+
+#endif // CANDY_GAME_H
@@ -0,0 +1,303 @@
+#include "grid.h"
+#include "events.h"
+#include "history.h"
+#include "instrument.h"
+#include "spawn.h"
+#include "trace.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+using namespace std;
+
+bool checkInitialMatch(const mat & grid) {
+    const unsigned size = grid.size();
+    if (size < 3) return false;
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j <= size - 3; ++j) {
+            unsigned type = candyColour(grid[i][j]);
+            if (type != KImpossible && type == candyColour(grid[i][j+1]) && type == candyColour(grid[i][j+2])) return true;
+        }
+    }
+    for (unsigned j = 0; j < size; ++j) {
+        for (unsigned i = 0; i <= size - 3; ++i) {
+            unsigned type = candyColour(grid[i][j]);
+            if (type != KImpossible && type == candyColour(grid[i+1][j]) && type == candyColour(grid[i+2][j])) return true;
+        }
+    }
+    return false;
+}
+
+void initGrid (mat & grid, const size_t & matSize, unsigned nbCandies) {
+    grid.assign(matSize, line(matSize));
+
+    for (unsigned i = 0; i < matSize; ++i) {
+        for (unsigned j = 0; j < matSize; ++j) {
+            // Couleurs interdites : celles qui complèteraient un alignement à gauche ou en haut
+            unsigned forbidLeft = KImpossible;
+            unsigned forbidUp = KImpossible;
+            if (j >= 2 && grid[i][j-1] == grid[i][j-2]) forbidLeft = grid[i][j-1];
+            if (i >= 2 && grid[i-1][j] == grid[i-2][j]) forbidUp = grid[i-1][j];
+
+            unsigned nbForbidden = (forbidLeft != KImpossible) + (forbidUp != KImpossible && forbidUp != forbidLeft);
+            if (nbForbidden >= nbCandies) {
+                // Moins de 3 couleurs : on ne peut pas éviter l'alignement
+                grid[i][j] = (spawnRandom() % nbCandies) + 1;
+                continue;
+            }
+
+            // Tire parmi les couleurs autorisées en sautant les couleurs interdites
+            unsigned candy = (spawnRandom() % (nbCandies - nbForbidden)) + 1;
+            for (unsigned type = 1; type <= nbCandies; ++type) {
+                if (type == forbidLeft || type == forbidUp) continue;
+                if (--candy == 0) {
+                    grid[i][j] = type;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void removalInColumn (mat & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies) {
+    CANDY_TIMER(PhaseGravity);
+    const unsigned size = grid.size();
+    unsigned abs = pos.abs;
+    unsigned startord = pos.ord;
+    if (abs >= size) return;
+    if (howMany > 0) emitEvent(EventMatchFound, 'V', howMany, startord, abs, 0);
+
+    // Case vidée la plus basse (ce match, ou les cases déjà vidées par removalInRow) : rien ne bouge en dessous
+    int lowest = int(min(startord + howMany, size)) - 1;
+    for (int i = size - 1; i > lowest; --i) {
+        if (grid[i][abs] == KImpossible) {
+            lowest = i;
+            break;
+        }
+    }
+    CANDY_COUNT(CounterCellsTouched, lowest + 1);
+    hashColumn(grid, abs, 0, lowest);
+    historyColumn(grid, abs, 0, lowest);
+
+    for (unsigned i = startord; i < startord + howMany; ++i) {
+        if (i < size && grid[i][abs] != KImpossible) {
+            grid[i][abs] = KImpossible;
+        }
+    }
+
+    CANDY_TRACE_BEGIN("gravite");
+    int next_write_ord = lowest;
+    while (next_write_ord >= 0 && grid[next_write_ord][abs] == KHole) next_write_ord--;
+
+    for (int i = lowest; i >= 0; --i) {
+        const unsigned cell = grid[i][abs];
+        if (cell == KImpossible || cell == KHole) continue;
+        if (cell == KBlocker) {
+            // Le segment sous le bloqueur ne reçoit rien d'en haut : il se remplit sur place
+            refillColumn(grid, abs, i + 1, next_write_ord, nbCandies);
+            next_write_ord = i - 1;
+        }
+        else {
+            if (i != next_write_ord) {
+                grid[next_write_ord][abs] = cell;
+                grid[i][abs] = KImpossible;
+            }
+            next_write_ord--;
+        }
+        while (next_write_ord >= 0 && grid[next_write_ord][abs] == KHole) next_write_ord--;
+    }
+    CANDY_TRACE_END("gravite");
+
+    CANDY_TRACE_BEGIN("remplissage");
+    refillColumn(grid, abs, 0, next_write_ord, nbCandies);
+    CANDY_TRACE_END("remplissage");
+    hashColumn(grid, abs, 0, lowest);
+}
+
+void removalInRow (mat & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies) {
+    const unsigned size = grid.size();
+    unsigned ord = pos.ord;
+    unsigned startabs = pos.abs;
+    if (ord >= size) return;
+    emitEvent(EventMatchFound, 'H', howMany, ord, startabs, 0);
+
+    for (unsigned j = startabs; j < startabs + howMany; ++j) {
+        if (j < size) {
+            historyColumn(grid, j, ord, ord);
+            hashCell(grid, ord, j);
+            grid[ord][j] = KImpossible;
+            hashCell(grid, ord, j);
+        }
+    }
+
+    for (unsigned j = startabs; j < startabs + howMany; ++j) {
+        if (j < size) {
+            maPosition tmpPos = {j, 0};
+            removalInColumn(grid, tmpPos, 0, nbCandies);
+        }
+    }
+}
+
+bool atLeastThreeInAColumn (const mat & grid, maPosition & pos, unsigned & howMany) {
+    CANDY_TIMER(PhaseMatchScan);
+    CANDY_TRACE_SCOPE("detection_colonnes");
+    CANDY_COUNT(CounterScans, 1);
+    const unsigned size = grid.size();
+    if (size < 3) return false;
+    for (unsigned j = 0; j < size; ++j) {
+        for (unsigned i = 0; i <= size - 3; ++i) {
+            unsigned type = candyColour(grid[i][j]);
+            if (type == KImpossible) continue;
+
+            if (type == candyColour(grid[i+1][j]) && type == candyColour(grid[i+2][j])) {
+                howMany = 3;
+                unsigned k = i + 3;
+                while (k < size && candyColour(grid[k][j]) == type) {
+                    howMany++;
+                    k++;
+                }
+                pos = {j, i};
+                CANDY_TRACE_INSTANT("match", howMany);
+                CANDY_COUNT(CounterCellsTouched, j * (size - 2) + i + 1);
+                return true;
+            }
+        }
+    }
+    CANDY_COUNT(CounterCellsTouched, size * (size - 2));
+    return false;
+}
+
+bool atLeastThreeInARow (const mat & grid, maPosition & pos, unsigned & howMany) {
+    CANDY_TIMER(PhaseMatchScan);
+    CANDY_TRACE_SCOPE("detection_lignes");
+    CANDY_COUNT(CounterScans, 1);
+    const unsigned size = grid.size();
+    if (size < 3) return false;
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j <= size - 3; ++j) {
+            unsigned type = candyColour(grid[i][j]);
+            if (type == KImpossible) continue;
+
+            if (type == candyColour(grid[i][j+1]) && type == candyColour(grid[i][j+2])) {
+                howMany = 3;
+                unsigned k = j + 3;
+                while (k < size && candyColour(grid[i][k]) == type) {
+                    howMany++;
+                    k++;
+                }
+                pos = {j, i};
+                CANDY_TRACE_INSTANT("match", howMany);
+                CANDY_COUNT(CounterCellsTouched, i * (size - 2) + j + 1);
+                return true;
+            }
+        }
+    }
+    CANDY_COUNT(CounterCellsTouched, size * (size - 2));
+    return false;
+}
+
+void makeAMove (mat & grid, const maPosition & pos, const char & direction) {
+    CANDY_TIMER(PhaseMove);
+    CANDY_TRACE_SCOPE("echange");
+    const unsigned size = grid.size();
+    unsigned r2 = pos.ord;
+    unsigned c2 = pos.abs;
+    if (pos.ord >= size || pos.abs >= size) return;
+
+    switch (direction) {
+    case 'Q': // Gauche
+        if (pos.abs == 0) return;
+        c2 = pos.abs - 1;
+        break;
+    case 'Z': // Haut
+        if (pos.ord == 0) return;
+        r2 = pos.ord - 1;
+        break;
+    case 'D': // Droit
+        if (pos.abs == size - 1) return;
+        c2 = pos.abs + 1;
+        break;
+    case 'S': // Bas
+        if (pos.ord == size - 1) return;
+        r2 = pos.ord + 1;
+        break;
+    default:
+        return;
+    }
+
+    if (isFixedCell(grid[pos.ord][pos.abs]) || isFixedCell(grid[r2][c2])) return;
+    historyColumn(grid, pos.abs, pos.ord, pos.ord);
+    historyColumn(grid, c2, r2, r2);
+    hashCell(grid, pos.ord, pos.abs);
+    hashCell(grid, r2, c2);
+    swap(grid[pos.ord][pos.abs], grid[r2][c2]);
+    hashCell(grid, pos.ord, pos.abs);
+    hashCell(grid, r2, c2);
+    emitEvent(EventMoveApplied, direction, 0, pos.ord, pos.abs, 0);
+}
+
+bool hasMatchAt (const mat & grid, unsigned ord, unsigned abs) {
+    const unsigned size = grid.size();
+    const unsigned type = candyColour(grid[ord][abs]);
+    if (type == KImpossible) return false;
+
+    unsigned count = 1;
+    for (unsigned j = abs; j > 0 && candyColour(grid[ord][j-1]) == type; --j) count++;
+    for (unsigned j = abs + 1; j < size && candyColour(grid[ord][j]) == type; ++j) count++;
+    if (count >= 3) return true;
+
+    count = 1;
+    for (unsigned i = ord; i > 0 && candyColour(grid[i-1][abs]) == type; --i) count++;
+    for (unsigned i = ord + 1; i < size && candyColour(grid[i][abs]) == type; ++i) count++;
+    return count >= 3;
+}
+
+bool isLegalMove (mat & grid, const maPosition & pos, char direction) {
+    const unsigned size = grid.size();
+    if (pos.ord >= size || pos.abs >= size) return false;
+
+    unsigned r2 = pos.ord;
+    unsigned c2 = pos.abs;
+    switch (direction) {
+    case 'Q': if (pos.abs == 0) return false; c2--; break;
+    case 'Z': if (pos.ord == 0) return false; r2--; break;
+    case 'D': if (pos.abs == size - 1) return false; c2++; break;
+    case 'S': if (pos.ord == size - 1) return false; r2++; break;
+    default: return false;
+    }
+    if (grid[pos.ord][pos.abs] == grid[r2][c2]) return false;
+    if (isFixedCell(grid[pos.ord][pos.abs]) || isFixedCell(grid[r2][c2])) return false;
+    // Une bombe échangée avec un bonbon se déclenche toujours
+    if (candyKind(grid[pos.ord][pos.abs]) == SpecialColourBomb || candyKind(grid[r2][c2]) == SpecialColourBomb)
+        return grid[pos.ord][pos.abs] != KImpossible && grid[r2][c2] != KImpossible;
+
+    swap(grid[pos.ord][pos.abs], grid[r2][c2]);
+    bool legal = hasMatchAt(grid, pos.ord, pos.abs) || hasMatchAt(grid, r2, c2);
+    swap(grid[pos.ord][pos.abs], grid[r2][c2]);
+    return legal;
+}
+
+unsigned resolveCascade (mat & grid, unsigned nbCandies) {
+    unsigned comboLevel = 0;
+    unsigned howMany = 0;
+    maPosition matchPos;
+
+    while (true) {
+        CANDY_TRACE_SCOPE_ARG("pas_de_cascade", comboLevel + 1);
+        if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
+            removalInColumn(grid, matchPos, howMany, nbCandies);
+        }
+        else if (atLeastThreeInARow(grid, matchPos, howMany)) {
+            removalInRow(grid, matchPos, howMany, nbCandies);
+        }
+        else {
+            break;
+        }
+        comboLevel++;
+        CANDY_COUNT(CounterCascadeSteps, 1);
+        emitEvent(EventCascadeStep, 0, comboLevel, 0, 0, 0);
+    }
+    return comboLevel;
+}
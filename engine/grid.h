@@ -0,0 +1,198 @@
+/**
+ * @file grid.h
+ * @brief Moteur de la grille : types, constantes et noyaux de match/gravité
+ *
+ * Toutes les fonctions prennent la taille de la grille depuis grid.size(),
+ * ce qui permet de les utiliser aussi bien pour le jeu (8x8) que pour les
+ * benchmarks sur de grandes grilles.
+ */
+#ifndef CANDY_GRID_H
+#define CANDY_GRID_H
+
+#include <cstddef>
+#include <vector>
+
+// --- 1. LES DEFINITIONS ET LES CONSTANTES ---
+
+const unsigned KNbCandies (4);  // Types de bonbons (limité à 4)
+const unsigned KGridSize (8);   // Taille de la grille N x N (8x8)
+const unsigned KImpossible (0); // Valeur pour les cases vides/supprimées
+
+/**
+ * @typedef line
+ * @brief Une ligne de la grille (vector d'unsigned)
+ */
+typedef std::vector <unsigned> line;
+
+/**
+ * @typedef mat
+ * @brief La grille de jeu (matrice)
+ */
+typedef std::vector <line> mat;
+
+/**
+ * @struct maPosition
+ * @brief Position dans la grille du jeu
+ * @var maPosition::abs
+ * Abscisse (les colonnes)
+ * @var maPosition::ord
+ * Ordonnée (les lignes)
+ */
+struct maPosition {
+    unsigned abs;
+    unsigned ord;
+}; // une position dans la grille
+
+/**
+ * @brief Types de bonbons spéciaux (voir special.h)
+ *
+ * Une case garde sa couleur sur les 4 bits de poids faible et son type
+ * spécial au-dessus : les détections ne comparent que la couleur, un bonbon
+ * rayé rouge s'aligne donc avec des bonbons rouges ordinaires. La bombe n'a
+ * pas de couleur et ne s'aligne jamais.
+ */
+enum SpecialKind {
+    SpecialNone,           // bonbon ordinaire
+    SpecialStripedRow,     // rayé : vide sa ligne
+    SpecialStripedColumn,  // rayé : vide sa colonne
+    SpecialWrapped,        // emballé : vide le carré 3x3 autour de lui
+    SpecialColourBomb      // bombe : vide toutes les cases d'une couleur
+};
+
+const unsigned KColourMask (0xF);  // Bits de la couleur dans une case
+const unsigned KSpecialShift (4);  // Décalage du type spécial dans une case
+
+// Cases fixes des niveaux (voir level.h) : sans couleur, elles coupent les alignements
+const unsigned KBlocker (6 << KSpecialShift); // Bloqueur : ne tombe pas, détruit par les effets spéciaux
+const unsigned KHole (7 << KSpecialShift);    // Trou : hors du plateau, les bonbons tombent à travers
+
+/**
+ * @brief Regarde si une case est un trou ou un bloqueur (ni échangée ni déplacée par la gravité)
+ */
+inline bool isFixedCell (unsigned cell) {
+    return cell >= KBlocker;
+}
+
+/**
+ * @brief Couleur d'une case (KImpossible pour une case vide ou une bombe)
+ */
+inline unsigned candyColour (unsigned cell) {
+    return cell & KColourMask;
+}
+
+/**
+ * @brief Type spécial d'une case
+ */
+inline SpecialKind candyKind (unsigned cell) {
+    return SpecialKind(cell >> KSpecialShift);
+}
+
+/**
+ * @brief Valeur d'une case pour un bonbon spécial
+ */
+inline unsigned makeSpecial (unsigned colour, SpecialKind kind) {
+    return colour | (unsigned(kind) << KSpecialShift);
+}
+
+
+// --- 2. LES MATCHS ET LES MOUVEMENT ---
+
+/**
+ * @brief Regarde si il y a 3 ou plus de chiffres identiques après l'initialisation.
+ * @param grid Grille à vérifier
+ * @return true si match trouvé, sinon false
+ */
+bool checkInitialMatch (const mat & grid);
+
+/**
+ * @brief Initialise toutes les cellules de la grille avec des chiffres aléatoires, sans alignement de départ.
+ * @param grid Grille à initialiser
+ * @param matSize Taille de la grille
+ * @param nbCandies Nombre de types de bonbons (au moins 3)
+ *
+ * Chaque case est tirée parmi les couleurs qui ne forment pas d'alignement
+ * avec ses deux voisins de gauche et ses deux voisins du haut : la grille
+ * est construite en un seul passage, quelle que soit sa taille. Les tirages
+ * viennent de spawnRandom() : rand(), ou le générateur d'un RandomScope (spawn.h).
+ */
+void initGrid (mat & grid, const size_t & matSize, unsigned nbCandies = KNbCandies);
+
+/**
+ * @brief Enlève tout les bonbons sur les positions données, applique la gravtié et remplit avec de nouveaux bonbons.
+ * @param grid Grille
+ * @param pos Position de départ
+ * @param howMany Nombre de cases à supprimer
+ * @param nbCandies Nombre de types de bonbons pour le remplissage
+ *
+ * Les bonbons tombent à travers les trous. Un bloqueur coupe la colonne :
+ * la partie sous le bloqueur se remplit sur place.
+ */
+void removalInColumn (mat & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies = KNbCandies);
+
+/**
+ * @brief Enlève tout les bonbons sur les positions données et appelle removalInColumn pour qu'il s'occupe de la gravité et du remplissage de nouveaux bonbons.
+ * @param grid Grille
+ * @param pos Position de départ
+ * @param howMany Nombre de cases à supprimer
+ * @param nbCandies Nombre de types de bonbons pour le remplissage
+ */
+void removalInRow (mat & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies = KNbCandies);
+
+/**
+ * @brief Cherche pour un match vertical de 3 ou plus bonbons.
+ * @param grid Grille
+ * @param[out] pos Position premier bonbon du match
+ * @param[out] howMany Nombre de bonbons dans le match
+ * @return true si un match est trouvé
+ */
+bool atLeastThreeInAColumn (const mat & grid, maPosition & pos, unsigned & howMany);
+
+/**
+ * @brief Cherche pour un match horizontal de 3 ou plus bonbons.
+ * @param grid Grille
+ * @param[out] pos Position premier bonbon du match
+ * @param[out] howMany Nombre de bonbons dans le match
+ * @return true si un match est trouvé
+ */
+bool atLeastThreeInARow (const mat & grid, maPosition & pos, unsigned & howMany);
+
+/**
+ * @brief Echange les bonbons à une position donnée avec la direction donnée.
+ * @param grid Grille à modifier
+ * @param pos Position du premier bonbon
+ * @param direction Direction du déplacement (Q, Z, D ou S)
+ */
+void makeAMove (mat & grid, const maPosition & pos, const char & direction);
+
+/**
+ * @brief Regarde si la case (ord, abs) fait partie d'un alignement de 3 ou plus
+ * @param grid Grille
+ * @param ord Ligne de la case
+ * @param abs Colonne de la case
+ * @return true si la case est dans un alignement horizontal ou vertical
+ *
+ * Ne parcourt que les voisins de même couleur sur la ligne et la colonne de la case.
+ */
+bool hasMatchAt (const mat & grid, unsigned ord, unsigned abs);
+
+/**
+ * @brief Regarde si un échange crée au moins un alignement ou déclenche une bombe (coup légal)
+ * @param grid Grille (l'échange est annulé avant de revenir)
+ * @param pos Position du premier bonbon
+ * @param direction Direction du déplacement (Q, Z, D ou S)
+ * @return true si le coup produit un match
+ */
+bool isLegalMove (mat & grid, const maPosition & pos, char direction);
+
+/**
+ * @brief Résout toute la réaction en chaîne (colonnes puis lignes) jusqu'à ce qu'il n'y ait plus de match.
+ * @param grid Grille
+ * @param nbCandies Nombre de types de bonbons pour le remplissage
+ * @return Nombre de matchs supprimés (niveau de combo atteint)
+ *
+ * Même ordre de détection que les boucles des modes de jeu : un match
+ * vertical est toujours traité avant un match horizontal.
+ */
+unsigned resolveCascade (mat & grid, unsigned nbCandies = KNbCandies);
+
+#endif // CANDY_GRID_H
@@ -0,0 +1,278 @@
+#include "history.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Suite de chute : au moins autant de cases pour remplacer des valeurs écrites telles quelles
+const unsigned KMinCopyRun (2);
+
+// Décalages essayés pour une nouvelle suite (au-delà, les cases sont écrites telles quelles)
+const long KShiftTries (16);
+
+void putVarint (vector<uint8_t> & out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+uint64_t getVarint (const uint8_t * & at) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        const uint8_t byte = *at++;
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (byte < 0x80) return value;
+    }
+}
+
+// Décalages négatifs (échange vertical) en zigzag : 0, -1, 1, -2... -> 0, 1, 2, 3...
+uint64_t zigzag (int64_t value) {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+int64_t unzigzag (uint64_t value) {
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+/**
+ * @brief Longueur de la suite « nouvelle case k = ancienne case k - d » qui commence en k
+ */
+unsigned copyRun (const vector<unsigned> & before, const vector<unsigned> & after, long k, long d) {
+    const long count = after.size();
+    if (k - d < 0 || k - d >= count) return 0;
+    long m = k;
+    while (m < count && m - d < count && before[m - d] == after[m]) m++;
+    return m - k;
+}
+
+/**
+ * @brief Ecrit les différences d'une colonne sur les lignes first à first + count - 1
+ *
+ * Opérations de la nouvelle colonne, de haut en bas : (longueur << 1) puis le
+ * décalage pour une suite de chute, (longueur << 1 | 1) puis les valeurs pour
+ * des bonbons apparus. Suivent les valeurs des anciennes cases qu'aucune suite
+ * ne reprend (bonbons vidés), précédées de leur nombre.
+ */
+void encodeColumn (vector<uint8_t> & out, unsigned abs, unsigned first, const vector<unsigned> & before,
+                   const vector<unsigned> & after) {
+    const unsigned count = after.size();
+    putVarint(out, abs);
+    putVarint(out, first);
+    putVarint(out, count);
+
+    vector<bool> covered(count, false);
+    vector<uint8_t> literals;
+    long lastShift = 0;
+    long spawned = 0;   // bonbons apparus jusqu'ici : chute de la première suite sous eux
+    unsigned k = 0;
+    auto flushLiterals = [&] () {
+        if (literals.empty()) return;
+        putVarint(out, (uint64_t(literals.size()) << 1) | 1);
+        out.insert(out.end(), literals.begin(), literals.end());
+        literals.clear();
+    };
+
+    while (k < count) {
+        // Les chutes diminuent en descendant la colonne : décalage précédent, puis des décalages
+        // plus petits ; sous les bonbons apparus, la chute est leur nombre. -1 : échange vertical.
+        long shift = lastShift;
+        unsigned length = copyRun(before, after, k, shift);
+        if (length < KMinCopyRun) {
+            shift = spawned;
+            length = copyRun(before, after, k, shift);
+        }
+        for (long d = lastShift - 1; length < KMinCopyRun && d >= 0 && d >= lastShift - KShiftTries; --d) {
+            shift = d;
+            length = copyRun(before, after, k, d);
+        }
+        if (length < KMinCopyRun) {
+            shift = -1;
+            length = copyRun(before, after, k, shift);
+        }
+        if (length < KMinCopyRun) {
+            literals.push_back(after[k]);
+            spawned++;
+            k++;
+            continue;
+        }
+        flushLiterals();
+        putVarint(out, uint64_t(length) << 1);
+        putVarint(out, zigzag(shift));
+        for (unsigned m = k; m < k + length; ++m) covered[m - shift] = true;
+        lastShift = shift;
+        k += length;
+    }
+    flushLiterals();
+
+    unsigned nbCleared = 0;
+    for (unsigned m = 0; m < count; ++m) nbCleared += !covered[m];
+    putVarint(out, nbCleared);
+    for (unsigned m = 0; m < count; ++m)
+        if (!covered[m]) out.push_back(before[m]);
+}
+
+/**
+ * @brief Applique les différences d'une colonne
+ * @param forward true pour rejouer le coup (ancienne colonne -> nouvelle), false pour l'annuler
+ */
+void applyColumn (const uint8_t * & at, mat & grid, bool forward) {
+    const unsigned abs = getVarint(at);
+    const unsigned first = getVarint(at);
+    const unsigned count = getVarint(at);
+
+    vector<unsigned> current(count);
+    for (unsigned m = 0; m < count; ++m) current[m] = grid[first + m][abs];
+    vector<unsigned> result(count, KImpossible);
+    vector<bool> covered(count, false);
+
+    for (unsigned k = 0; k < count; ) {
+        const uint64_t tag = getVarint(at);
+        const unsigned length = tag >> 1;
+        if (tag & 1) {
+            // Bonbons apparus : connus seulement dans le sens du coup
+            for (unsigned m = k; m < k + length; ++m, ++at)
+                if (forward) result[m] = *at;
+        }
+        else {
+            const long shift = unzigzag(getVarint(at));
+            for (unsigned m = k; m < k + length; ++m) {
+                if (forward) result[m] = current[m - shift];
+                else result[m - shift] = current[m];
+                covered[m - shift] = true;
+            }
+        }
+        k += length;
+    }
+
+    const unsigned nbCleared = getVarint(at);
+    if (!forward) {
+        for (unsigned m = 0; m < count; ++m)
+            if (!covered[m]) result[m] = *at++;
+    }
+    else {
+        at += nbCleared;
+    }
+    for (unsigned m = 0; m < count; ++m) grid[first + m][abs] = result[m];
+}
+
+} // namespace
+
+MoveHistory::MoveHistory () : myCursor(0), myScoreBefore(0), myPrevious(nullptr) {}
+
+MoveHistory::~MoveHistory () {
+    if (tlsHistory == this) tlsHistory = myPrevious;
+}
+
+void MoveHistory::beginMove (const mat & grid, uint64_t score) {
+    forgetTouched();
+    const unsigned size = grid.size();
+    if (myFirsts.size() != size) {
+        myFirsts.assign(size, 1);
+        myLasts.assign(size, 0);
+        myOldCells.assign(size, vector<unsigned>());
+    }
+    myScoreBefore = score;
+    if (tlsHistory != this) {
+        myPrevious = tlsHistory;
+        tlsHistory = this;
+    }
+}
+
+void MoveHistory::forgetTouched () {
+    for (unsigned abs : myTouched) {
+        myFirsts[abs] = 1;
+        myLasts[abs] = 0;
+    }
+    myTouched.clear();
+}
+
+void MoveHistory::touch (const mat & grid, unsigned abs, int first, int last) {
+    if (first > last || abs >= myFirsts.size()) return;
+    vector<unsigned> & old = myOldCells[abs];
+    int & known = myFirsts[abs];
+    int & knownLast = myLasts[abs];
+    if (known > knownLast) {
+        myTouched.push_back(abs);
+        old.clear();
+        for (int i = first; i <= last; ++i) old.push_back(grid[i][abs]);
+        known = first;
+        knownLast = last;
+        return;
+    }
+    // Les cases hors de la plage connue n'ont pas encore changé : leur valeur actuelle est l'ancienne
+    if (first < known) {
+        vector<unsigned> above;
+        for (int i = first; i < known; ++i) above.push_back(grid[i][abs]);
+        old.insert(old.begin(), above.begin(), above.end());
+        known = first;
+    }
+    for (int i = knownLast + 1; i <= last; ++i) old.push_back(grid[i][abs]);
+    knownLast = max(knownLast, last);
+}
+
+void MoveHistory::endMove (const mat & grid, uint64_t score) {
+    if (tlsHistory == this) tlsHistory = myPrevious;
+    myPrevious = nullptr;
+
+    // Un nouveau coup remplace les coups annulés
+    if (myCursor < myStarts.size()) {
+        myBytes.resize(myStarts[myCursor]);
+        myStarts.resize(myCursor);
+    }
+    myStarts.push_back(myBytes.size());
+    myCursor++;
+
+    putVarint(myBytes, zigzag(int64_t(score - myScoreBefore)));
+
+    // Plage touchée de chaque colonne, réduite aux lignes qui ont vraiment changé
+    // (échange sans match remis en place, mélange qui rend une colonne à l'identique)
+    sort(myTouched.begin(), myTouched.end());
+    vector<unsigned> columns, firsts, lasts;
+    for (unsigned abs : myTouched) {
+        const int base = myFirsts[abs];
+        const vector<unsigned> & old = myOldCells[abs];
+        int first = base, last = myLasts[abs];
+        while (first <= last && grid[first][abs] == old[first - base]) first++;
+        while (last >= first && grid[last][abs] == old[last - base]) last--;
+        if (first > last) continue;
+        columns.push_back(abs);
+        firsts.push_back(first);
+        lasts.push_back(last);
+    }
+
+    putVarint(myBytes, columns.size());
+    vector<unsigned> before, after;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const unsigned abs = columns[c];
+        const auto old = myOldCells[abs].begin() + (firsts[c] - myFirsts[abs]);
+        before.assign(old, old + (lasts[c] - firsts[c] + 1));
+        after.clear();
+        for (unsigned i = firsts[c]; i <= lasts[c]; ++i) after.push_back(grid[i][abs]);
+        encodeColumn(myBytes, abs, firsts[c], before, after);
+    }
+    forgetTouched();
+}
+
+bool MoveHistory::undo (mat & grid, uint64_t & score) {
+    if (myCursor == 0) return false;
+    myCursor--;
+    const uint8_t * at = myBytes.data() + myStarts[myCursor];
+    score -= unzigzag(getVarint(at));
+    const uint64_t nbColumns = getVarint(at);
+    for (uint64_t c = 0; c < nbColumns; ++c) applyColumn(at, grid, false);
+    return true;
+}
+
+bool MoveHistory::redo (mat & grid, uint64_t & score) {
+    if (myCursor == myStarts.size()) return false;
+    const uint8_t * at = myBytes.data() + myStarts[myCursor];
+    myCursor++;
+    score += unzigzag(getVarint(at));
+    const uint64_t nbColumns = getVarint(at);
+    for (uint64_t c = 0; c < nbColumns; ++c) applyColumn(at, grid, true);
+    return true;
+}
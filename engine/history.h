@@ -0,0 +1,130 @@
+/**
+ * @file history.h
+ * @brief Historique des coups pour annuler / rétablir sans limite, stocké en différences
+ *
+ * Un coup n'est pas gardé comme une copie de la grille mais comme ce qu'il a
+ * changé, colonne par colonne, sur la plage de lignes modifiée :
+ *   - les bonbons tombés : des suites « la case i reçoit la case i - d »
+ *     (décalage de chute d, le même pour toute une suite) ;
+ *   - les bonbons apparus : leurs valeurs ;
+ *   - les bonbons vidés : leurs valeurs, seules cases de l'ancienne colonne
+ *     qu'on ne retrouve pas dans la nouvelle.
+ * Rétablir rejoue les chutes et les apparitions sur la grille ; annuler
+ * remonte les bonbons tombés et remet les bonbons vidés. Un coup simple
+ * tient en quelques dizaines d'octets.
+ *
+ * Les entiers sont écrits en LEB128 (7 bits par octet) : petits décalages et
+ * petites longueurs sur un seul octet, quelle que soit la taille de la grille.
+ *
+ * Entre beginMove et endMove, l'historique est installé pour le fil courant :
+ * l'échange, la suppression et la gravité, la création de bonbons spéciaux,
+ * le mélange et BandResolver lui signalent les lignes de chaque colonne
+ * qu'ils vont modifier (aux mêmes endroits que hashColumn, voir zobrist.h).
+ * Il garde l'ancienne valeur de ces cases seulement : un coup coûte ce qu'il
+ * change, pas une copie de la grille.
+ */
+#ifndef CANDY_HISTORY_H
+#define CANDY_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+
+/**
+ * @brief Historique des coups d'une partie
+ */
+class MoveHistory {
+public:
+    MoveHistory ();
+    ~MoveHistory ();
+
+    MoveHistory (const MoveHistory &) = delete;
+    MoveHistory & operator= (const MoveHistory &) = delete;
+
+    /**
+     * @brief Commence un coup : l'historique suit les cases modifiées sur ce fil jusqu'à endMove
+     */
+    void beginMove (const mat & grid, std::uint64_t score);
+
+    /**
+     * @brief Enregistre les différences depuis beginMove ; les coups annulés ne peuvent plus être rétablis
+     */
+    void endMove (const mat & grid, std::uint64_t score);
+
+    /**
+     * @brief Garde l'ancienne valeur des lignes first à last de la colonne abs, qui vont changer
+     */
+    void touch (const mat & grid, unsigned abs, int first, int last);
+
+    /**
+     * @brief Annule le dernier coup
+     * @return false s'il n'y a plus de coup à annuler
+     */
+    bool undo (mat & grid, std::uint64_t & score);
+
+    /**
+     * @brief Rejoue le dernier coup annulé
+     * @return false s'il n'y a pas de coup à rétablir
+     */
+    bool redo (mat & grid, std::uint64_t & score);
+
+    /**
+     * @brief Coups joués (et non annulés)
+     */
+    std::size_t played () const { return myCursor; }
+
+    /**
+     * @brief Coups annulés qui peuvent être rétablis
+     */
+    std::size_t undone () const { return myStarts.size() - myCursor; }
+
+    /**
+     * @brief Mémoire occupée par les différences (octets)
+     */
+    std::size_t bytes () const { return myBytes.size() + myStarts.size() * sizeof(std::size_t); }
+
+private:
+    void forgetTouched ();
+
+    std::vector<std::uint8_t> myBytes;   // différences des coups, bout à bout
+    std::vector<std::size_t> myStarts;   // début de chaque coup dans myBytes
+    std::size_t myCursor;                // coups actifs : myStarts[0 .. myCursor - 1]
+    std::uint64_t myScoreBefore;
+    MoveHistory * myPrevious;            // historique installé avant beginMove
+
+    // Coup en cours : colonnes touchées, et pour chacune la plage de lignes et ses anciennes valeurs
+    std::vector<unsigned> myTouched;
+    std::vector<int> myFirsts;           // myFirsts[abs] > myLasts[abs] : colonne intacte
+    std::vector<int> myLasts;
+    std::vector<std::vector<unsigned> > myOldCells;
+};
+
+// Historique du coup en cours sur ce fil (nul : aucun)
+inline thread_local MoveHistory * tlsHistory = nullptr;
+
+/**
+ * @brief Suspend l'historique du fil courant le temps de sa portée (coups essayés sur des copies de la grille)
+ */
+class HistoryPause {
+public:
+    HistoryPause () : mySuspended(tlsHistory) { tlsHistory = nullptr; }
+    ~HistoryPause () { tlsHistory = mySuspended; }
+    HistoryPause (const HistoryPause &) = delete;
+    HistoryPause & operator= (const HistoryPause &) = delete;
+
+private:
+    MoveHistory * mySuspended;
+};
+
+/**
+ * @brief Signale à l'historique du fil courant que les lignes first à last de la colonne abs vont changer
+ *
+ * Appelée avant la modification. Sans historique, ne coûte qu'un test de pointeur.
+ */
+inline void historyColumn (const mat & grid, unsigned abs, int first, int last) {
+    if (tlsHistory) tlsHistory->touch(grid, abs, first, last);
+}
+
+#endif // CANDY_HISTORY_H
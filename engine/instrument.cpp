@@ -0,0 +1,201 @@
+#include "instrument.h"
+
+#ifdef CANDY_INSTRUMENT
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <streambuf>
+
+using namespace std;
+
+namespace {
+
+const char * const KPhaseNames[KNbPhases] = {
+    "saisie", "makeAMove", "detection", "gravite", "affichage", "fichier_scores"
+};
+
+const char * const KCounterNames[KNbCounters] = {
+    "coups", "detections", "cases_touchees", "pas_de_cascade", "allocations", "octets_terminal"
+};
+
+const chrono::steady_clock::time_point KProgramStart = chrono::steady_clock::now();
+
+/**
+ * @brief Registre des tampons de tous les threads (le verrou ne sert qu'à l'enregistrement et au bilan)
+ */
+mutex & registryMutex () {
+    static mutex m;
+    return m;
+}
+
+vector<unique_ptr<InstrBuffer> > & registry () {
+    static vector<unique_ptr<InstrBuffer> > buffers;
+    return buffers;
+}
+
+/**
+ * @brief Tampon de flux qui compte les octets puis les transmet au tampon d'origine
+ */
+class CountingStreambuf : public streambuf {
+public:
+    explicit CountingStreambuf (streambuf * target) : myTarget(target) {}
+protected:
+    int_type overflow (int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        CANDY_COUNT(CounterTerminalBytes, 1);
+        return myTarget->sputc(traits_type::to_char_type(c));
+    }
+    streamsize xsputn (const char * s, streamsize n) override {
+        CANDY_COUNT(CounterTerminalBytes, n);
+        return myTarget->sputn(s, n);
+    }
+    int sync () override { return myTarget->pubsync(); }
+private:
+    streambuf * myTarget;
+};
+
+/**
+ * @brief Totaux de tous les threads
+ */
+InstrBuffer aggregate () {
+    InstrBuffer total = {};
+    for (const unique_ptr<InstrBuffer> & buffer : registry()) {
+        for (unsigned c = 0; c < KNbCounters; ++c) total.counters[c] += buffer->counters[c];
+        for (unsigned p = 0; p < KNbPhases; ++p) {
+            total.phaseNs[p] += buffer->phaseNs[p];
+            total.phaseCalls[p] += buffer->phaseCalls[p];
+        }
+        for (unsigned d = 0; d < KNbDepthBuckets; ++d) total.depthHistogram[d] += buffer->depthHistogram[d];
+        if (buffer->maxCascadeDepth > total.maxCascadeDepth) total.maxCascadeDepth = buffer->maxCascadeDepth;
+        total.droppedSamples += buffer->droppedSamples;
+    }
+    return total;
+}
+
+} // namespace
+
+InstrBuffer & instrRegisterThread () {
+    unique_ptr<InstrBuffer> buffer(new InstrBuffer());
+    InstrBuffer * raw = buffer.get();
+    {
+        lock_guard<mutex> lock(registryMutex());
+        raw->threadIndex = registry().size();
+        registry().push_back(move(buffer));
+    }
+    tlsInstrBuffer = raw;
+    return *raw;
+}
+
+uint64_t instrNowNs () {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - KProgramStart).count();
+}
+
+void instrMoveDone (unsigned cascadeDepth) {
+    InstrBuffer & buffer = instrBuffer();
+    buffer.counters[CounterMoves]++;
+    buffer.depthHistogram[cascadeDepth < KNbDepthBuckets ? cascadeDepth : KNbDepthBuckets - 1]++;
+    if (cascadeDepth > buffer.maxCascadeDepth) buffer.maxCascadeDepth = cascadeDepth;
+
+    InstrSample sample = {instrNowNs(),
+                          buffer.counters[CounterScans] - buffer.scansAtLastMove,
+                          buffer.counters[CounterCellsTouched] - buffer.cellsAtLastMove,
+                          cascadeDepth};
+    buffer.scansAtLastMove = buffer.counters[CounterScans];
+    buffer.cellsAtLastMove = buffer.counters[CounterCellsTouched];
+    if (buffer.samples.size() < KMaxInstrSamples) buffer.samples.push_back(sample);
+    else buffer.droppedSamples++;
+}
+
+void instrAttachTerminal () {
+    static CountingStreambuf counting(cout.rdbuf());
+    if (cout.rdbuf() != &counting) cout.rdbuf(&counting);
+}
+
+void instrDumpSummary (ostream & out) {
+    lock_guard<mutex> lock(registryMutex());
+    InstrBuffer total = aggregate();
+    const uint64_t moves = total.counters[CounterMoves];
+
+    out << "\n--- Instrumentation (" << registry().size() << " thread(s)) ---" << endl;
+    out << left << setw(18) << "phase" << right << setw(12) << "appels" << setw(14) << "total ms"
+        << setw(14) << "moyenne us" << endl;
+    for (unsigned p = 0; p < KNbPhases; ++p) {
+        if (total.phaseCalls[p] == 0) continue;
+        out << left << setw(18) << KPhaseNames[p] << right << setw(12) << total.phaseCalls[p]
+            << setw(14) << fixed << setprecision(3) << total.phaseNs[p] / 1e6
+            << setw(14) << total.phaseNs[p] / 1e3 / total.phaseCalls[p] << endl;
+    }
+    out << defaultfloat;
+    for (unsigned c = 0; c < KNbCounters; ++c) {
+        out << left << setw(18) << KCounterNames[c] << right << setw(12) << total.counters[c];
+        if (moves > 0 && c != CounterMoves) out << "   (" << double(total.counters[c]) / moves << " par coup)";
+        out << endl;
+    }
+    out << "cascade max       " << setw(12) << total.maxCascadeDepth << endl;
+    out << "profondeurs       ";
+    for (unsigned d = 0; d < KNbDepthBuckets; ++d) {
+        if (total.depthHistogram[d] == 0) continue;
+        out << " " << d << (d + 1 == KNbDepthBuckets ? "+" : "") << ":" << total.depthHistogram[d];
+    }
+    out << endl;
+    if (total.droppedSamples > 0) out << "photos perdues    " << setw(12) << total.droppedSamples << endl;
+}
+
+bool instrDumpChromeTrace (const string & fileName) {
+    ofstream file(fileName);
+    if (!file.is_open()) return false;
+
+    lock_guard<mutex> lock(registryMutex());
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const unique_ptr<InstrBuffer> & buffer : registry()) {
+        for (const InstrSample & sample : buffer->samples) {
+            file << (first ? "" : ",\n")
+                 << "{\"name\": \"coup\", \"ph\": \"C\", \"pid\": 1, \"tid\": " << buffer->threadIndex
+                 << ", \"ts\": " << sample.timeNs / 1000.0
+                 << ", \"args\": {\"detections\": " << sample.scans << ", \"cases_touchees\": " << sample.cells
+                 << ", \"profondeur_cascade\": " << sample.cascadeDepth << "}}";
+            first = false;
+        }
+    }
+    file << "\n], \"otherData\": {";
+    InstrBuffer total = aggregate();
+    for (unsigned p = 0; p < KNbPhases; ++p) {
+        file << "\"" << KPhaseNames[p] << "_ns\": " << total.phaseNs[p] << ", ";
+    }
+    for (unsigned c = 0; c < KNbCounters; ++c) {
+        file << "\"" << KCounterNames[c] << "\": " << total.counters[c] << ", ";
+    }
+    file << "\"cascade_max\": " << total.maxCascadeDepth << "}}\n";
+    return true;
+}
+
+// --- Comptage des allocations ---
+// Remplace l'operator new global ; n'utilise que le pointeur de thread (trivial)
+// pour ne jamais allouer pendant le comptage.
+
+void * operator new (size_t size) {
+    if (tlsInstrBuffer) tlsInstrBuffer->counters[CounterAllocations]++;
+    if (size == 0) size = 1;
+    while (true) {
+        if (void * p = malloc(size)) return p;
+        new_handler handler = get_new_handler();
+        if (!handler) throw bad_alloc();
+        handler();
+    }
+}
+
+void operator delete (void * p) noexcept {
+    free(p);
+}
+
+void operator delete (void * p, size_t) noexcept {
+    free(p);
+}
+
+#endif // CANDY_INSTRUMENT
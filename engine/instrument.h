@@ -0,0 +1,164 @@
+/**
+ * @file instrument.h
+ * @brief Instrumentation du chemin critique : chronomètres par phase et compteurs
+ *
+ * Activée seulement si CANDY_INSTRUMENT est défini (option CMake du même nom).
+ * Sinon toutes les macros CANDY_* de ce fichier disparaissent à la compilation
+ * et leurs arguments ne sont même pas évalués : coût nul.
+ *
+ * Chaque thread écrit dans son propre tampon (aucun verrou sur le chemin
+ * critique). Les tampons sont agrégés par instrDumpSummary et
+ * instrDumpChromeTrace, à appeler en fin de partie quand les autres threads
+ * ne jouent plus.
+ */
+#ifndef CANDY_INSTRUMENT_H
+#define CANDY_INSTRUMENT_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Phases chronométrées d'une partie
+ */
+enum InstrPhase {
+    PhaseInput,      // saisie du joueur
+    PhaseMove,       // makeAMove
+    PhaseMatchScan,  // atLeastThreeInAColumn / atLeastThreeInARow
+    PhaseGravity,    // removalInColumn (chute + remplissage)
+    PhaseDisplay,    // affichage de la grille
+    PhaseScoreFile,  // lecture / réécriture des fichiers de scores
+    KNbPhases
+};
+
+/**
+ * @brief Compteurs cumulés
+ */
+enum InstrCounter {
+    CounterMoves,          // coups joués
+    CounterScans,          // appels aux fonctions de détection
+    CounterCellsTouched,   // cases lues par la détection ou déplacées par la gravité
+    CounterCascadeSteps,   // matchs supprimés
+    CounterAllocations,    // appels à operator new
+    CounterTerminalBytes,  // octets écrits sur cout
+    KNbCounters
+};
+
+#ifdef CANDY_INSTRUMENT
+
+#include <iostream>
+#include <vector>
+
+/**
+ * @struct InstrSample
+ * @brief Photo des compteurs à la fin d'un coup (pour la trace Chrome)
+ */
+struct InstrSample {
+    std::uint64_t timeNs;
+    std::uint64_t scans;        // détections pendant ce coup
+    std::uint64_t cells;        // cases touchées pendant ce coup
+    unsigned cascadeDepth;
+};
+
+// Profondeurs de cascade comptées une à une, la dernière case regroupe les plus longues
+const unsigned KNbDepthBuckets (16);
+// Nombre maximal de photos gardées par thread
+const std::size_t KMaxInstrSamples (1 << 20);
+
+/**
+ * @struct InstrBuffer
+ * @brief Tampon d'instrumentation d'un thread
+ */
+struct InstrBuffer {
+    unsigned threadIndex;
+    std::uint64_t counters[KNbCounters];
+    std::uint64_t phaseNs[KNbPhases];
+    std::uint64_t phaseCalls[KNbPhases];
+    std::uint64_t depthHistogram[KNbDepthBuckets];
+    unsigned maxCascadeDepth;
+    std::uint64_t scansAtLastMove;
+    std::uint64_t cellsAtLastMove;
+    std::vector<InstrSample> samples;
+    std::uint64_t droppedSamples;
+};
+
+inline thread_local InstrBuffer * tlsInstrBuffer = nullptr;
+
+/**
+ * @brief Crée et enregistre le tampon du thread courant
+ */
+InstrBuffer & instrRegisterThread ();
+
+/**
+ * @brief Tampon du thread courant (créé au premier appel)
+ */
+inline InstrBuffer & instrBuffer () {
+    return tlsInstrBuffer ? *tlsInstrBuffer : instrRegisterThread();
+}
+
+/**
+ * @brief Nanosecondes écoulées depuis le démarrage du programme
+ */
+std::uint64_t instrNowNs ();
+
+/**
+ * @brief Chronomètre une phase pendant toute la durée de vie de l'objet
+ */
+class InstrScopedTimer {
+public:
+    explicit InstrScopedTimer (InstrPhase phase) : myPhase(phase), myStart(instrNowNs()) {}
+    ~InstrScopedTimer () {
+        InstrBuffer & buffer = instrBuffer();
+        buffer.phaseNs[myPhase] += instrNowNs() - myStart;
+        buffer.phaseCalls[myPhase]++;
+    }
+    InstrScopedTimer (const InstrScopedTimer &) = delete;
+    InstrScopedTimer & operator= (const InstrScopedTimer &) = delete;
+private:
+    InstrPhase myPhase;
+    std::uint64_t myStart;
+};
+
+/**
+ * @brief Fin d'un coup : profondeur de cascade, histogramme et photo des compteurs
+ */
+void instrMoveDone (unsigned cascadeDepth);
+
+/**
+ * @brief Fait passer cout par un tampon qui compte les octets écrits
+ */
+void instrAttachTerminal ();
+
+/**
+ * @brief Ecrit le bilan agrégé de tous les threads
+ */
+void instrDumpSummary (std::ostream & out);
+
+/**
+ * @brief Ecrit les compteurs par coup au format Chrome trace (chrome://tracing, Perfetto)
+ * @return false si le fichier ne peut pas être ouvert
+ */
+bool instrDumpChromeTrace (const std::string & fileName);
+
+#define CANDY_INSTR_CONCAT2(a, b) a##b
+#define CANDY_INSTR_CONCAT(a, b) CANDY_INSTR_CONCAT2(a, b)
+
+#define CANDY_TIMER(phase) InstrScopedTimer CANDY_INSTR_CONCAT(candyTimer_, __LINE__) (phase)
+#define CANDY_COUNT(counter, n) (instrBuffer().counters[counter] += (n))
+#define CANDY_MOVE_DONE(depth) instrMoveDone(depth)
+#define CANDY_ATTACH_TERMINAL() instrAttachTerminal()
+// Bilan sur cerr et trace Chrome dans <name>.counters.json
+#define CANDY_INSTR_REPORT(name) \
+    do { instrDumpSummary(std::cerr); instrDumpChromeTrace(std::string(name) + ".counters.json"); } while (0)
+
+#else // CANDY_INSTRUMENT
+
+#define CANDY_TIMER(phase) do {} while (0)
+#define CANDY_COUNT(counter, n) do {} while (0)
+#define CANDY_MOVE_DONE(depth) do {} while (0)
+#define CANDY_ATTACH_TERMINAL() do {} while (0)
+#define CANDY_INSTR_REPORT(name) do {} while (0)
+
+#endif // CANDY_INSTRUMENT
+
+#endif // CANDY_INSTRUMENT_H
@@ -0,0 +1,273 @@
+#include "leaderboard.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Pas de feuille suivante
+const uint32_t KNoNode (UINT32_MAX);
+
+/**
+ * @brief Ajoute l'écriture décimale de value à la fin de text
+ */
+void appendValue (uint64_t value, string & text) {
+    char digits [20];
+    const to_chars_result written = to_chars(digits, digits + sizeof(digits), value);
+    text.append(digits, written.ptr);
+}
+
+/**
+ * @brief Premier caractère de [text, end) qui n'est pas un blanc
+ */
+const char * skipSpaces (const char * text, const char * end) {
+    while (text < end && isspace(static_cast<unsigned char>(*text))) ++text;
+    return text;
+}
+
+} // namespace
+
+Leaderboard::Leaderboard (RankOrder order) : myOrder(order) {
+    clear();
+}
+
+void Leaderboard::clear () {
+    myLeaves.assign(1, Leaf());
+    myLeaves[0].next = KNoNode;
+    myInners.clear();
+    myPlayers.clear();
+    myRoot = 0;
+    myHead = 0;
+    myHeight = 0;
+    mySize = 0;
+}
+
+// --- 1. LES FICHIERS DE SCORES ---
+
+bool Leaderboard::load (const string & fileName) {
+    CANDY_TIMER(PhaseScoreFile);
+    clear();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    // Fichier projeté et lu d'une traite : ni flux ni copie du texte, une seule chaîne réutilisée
+    void * data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    const char * text = static_cast<const char *>(data);
+    const char * const end = text + info.st_size;
+    string pseudo;
+    while (true) {
+        text = skipSpaces(text, end);
+        uint64_t value;
+        const from_chars_result read = from_chars(text, end, value);
+        if (read.ec != errc()) break;
+        text = skipSpaces(read.ptr, end);
+        const char * last = text;
+        while (last < end && !isspace(static_cast<unsigned char>(*last))) ++last;
+        if (last == text) break;
+        pseudo.assign(text, last);
+        insert(pseudo, value);
+        text = last;
+    }
+    munmap(data, info.st_size);
+    return true;
+}
+
+bool Leaderboard::save (const string & fileName) const {
+    CANDY_TIMER(PhaseScoreFile);
+    ofstream file(fileName);
+    if (!file.is_open()) return false;
+
+    // Une feuille à la fois dans un même tampon : aucune chaîne par ligne
+    string lines;
+    for (uint32_t node = myHead; node != KNoNode; node = myLeaves[node].next) {
+        const Leaf & leaf = myLeaves[node];
+        lines.clear();
+        for (unsigned k = 0; k < leaf.count; ++k) {
+            // keyOf est sa propre inverse : la clé redonne la valeur
+            appendValue(keyOf(leaf.keys[k]), lines);
+            lines += ' ';
+            myPlayers.appendPseudo(leaf.players[k], lines);
+            lines += '\n';
+        }
+        file.write(lines.data(), lines.size());
+    }
+    file.close();
+    return !file.fail();
+}
+
+// --- 2. L'INSERTION ---
+
+bool Leaderboard::insertLeaf (uint32_t node, uint64_t key, uint32_t player, size_t & rank, Split & split) {
+    Leaf & leaf = myLeaves[node];
+    const unsigned pos = upper_bound(leaf.keys, leaf.keys + leaf.count, key) - leaf.keys;
+    rank += pos;
+    move_backward(leaf.keys + pos, leaf.keys + leaf.count, leaf.keys + leaf.count + 1);
+    move_backward(leaf.players + pos, leaf.players + leaf.count, leaf.players + leaf.count + 1);
+    leaf.keys[pos] = key;
+    leaf.players[pos] = player;
+    if (++leaf.count <= KRankFanout) return false;
+
+    // Une entrée ajoutée en fin de feuille part seule : un fichier déjà trié donne des feuilles pleines
+    const unsigned keep = pos == KRankFanout ? KRankFanout : (KRankFanout + 1) / 2;
+    const uint32_t created = myLeaves.size();
+    myLeaves.emplace_back();
+    Leaf & left = myLeaves[node];
+    Leaf & right = myLeaves[created];
+    right.count = left.count - keep;
+    copy(left.keys + keep, left.keys + left.count, right.keys);
+    copy(left.players + keep, left.players + left.count, right.players);
+    right.next = left.next;
+    left.next = created;
+    left.count = keep;
+    split = Split {created, right.keys[0], right.count};
+    return true;
+}
+
+bool Leaderboard::insertInner (uint32_t node, unsigned height, uint64_t key, uint32_t player, size_t & rank,
+                               Split & split) {
+    unsigned i;
+    uint32_t child;
+    {
+        const Inner & inner = myInners[node];
+        i = upper_bound(inner.firsts + 1, inner.firsts + inner.count, key) - inner.firsts - 1;
+        for (unsigned k = 0; k < i; ++k) rank += inner.sizes[k];
+        child = inner.children[i];
+    }
+
+    // Le nœud est relu après la descente : un débordement plus bas peut avoir agrandi myInners
+    Split below;
+    const bool grown = height == 1 ? insertLeaf(child, key, player, rank, below)
+                                   : insertInner(child, height - 1, key, player, rank, below);
+    Inner & inner = myInners[node];
+    inner.sizes[i]++;
+    inner.firsts[i] = min(inner.firsts[i], key);
+    if (!grown) return false;
+
+    inner.sizes[i] -= below.size;
+    move_backward(inner.children + i + 1, inner.children + inner.count, inner.children + inner.count + 1);
+    move_backward(inner.firsts + i + 1, inner.firsts + inner.count, inner.firsts + inner.count + 1);
+    move_backward(inner.sizes + i + 1, inner.sizes + inner.count, inner.sizes + inner.count + 1);
+    inner.children[i + 1] = below.node;
+    inner.firsts[i + 1] = below.first;
+    inner.sizes[i + 1] = below.size;
+    if (++inner.count <= KRankFanout) return false;
+
+    const unsigned keep = i + 1 == KRankFanout ? KRankFanout : (KRankFanout + 1) / 2;
+    const uint32_t created = myInners.size();
+    myInners.emplace_back();
+    Inner & left = myInners[node];
+    Inner & right = myInners[created];
+    right.count = left.count - keep;
+    copy(left.children + keep, left.children + left.count, right.children);
+    copy(left.firsts + keep, left.firsts + left.count, right.firsts);
+    copy(left.sizes + keep, left.sizes + left.count, right.sizes);
+    left.count = keep;
+    uint64_t moved = 0;
+    for (unsigned k = 0; k < right.count; ++k) moved += right.sizes[k];
+    split = Split {created, right.firsts[0], moved};
+    return true;
+}
+
+size_t Leaderboard::insert (const string & pseudo, uint64_t value) {
+    const uint64_t key = keyOf(value);
+    const uint32_t player = myPlayers.intern(pseudo);
+
+    const uint64_t first = myHeight == 0 ? (mySize > 0 ? myLeaves[myRoot].keys[0] : key) : myInners[myRoot].firsts[0];
+    size_t rank = 0;
+    Split split;
+    const bool grown = myHeight == 0 ? insertLeaf(myRoot, key, player, rank, split)
+                                     : insertInner(myRoot, myHeight, key, player, rank, split);
+    mySize++;
+
+    // La racine a débordé : l'arbre gagne un niveau
+    if (grown) {
+        const uint32_t root = myInners.size();
+        myInners.emplace_back();
+        Inner & inner = myInners[root];
+        inner.count = 2;
+        inner.children[0] = myRoot;
+        inner.children[1] = split.node;
+        inner.firsts[0] = min(first, key);
+        inner.firsts[1] = split.first;
+        inner.sizes[0] = mySize - split.size;
+        inner.sizes[1] = split.size;
+        myRoot = root;
+        myHeight++;
+    }
+    return rank + 1;
+}
+
+// --- 3. LES RANGS ---
+
+size_t Leaderboard::rankOf (uint64_t value) const {
+    const uint64_t key = keyOf(value);
+    size_t rank = 0;
+    uint32_t node = myRoot;
+    for (unsigned height = myHeight; height > 0; --height) {
+        const Inner & inner = myInners[node];
+        const unsigned i = upper_bound(inner.firsts + 1, inner.firsts + inner.count, key) - inner.firsts - 1;
+        for (unsigned k = 0; k < i; ++k) rank += inner.sizes[k];
+        node = inner.children[i];
+    }
+    const Leaf & leaf = myLeaves[node];
+    rank += upper_bound(leaf.keys, leaf.keys + leaf.count, key) - leaf.keys;
+    return rank + 1;
+}
+
+uint32_t Leaderboard::findLeaf (size_t rank, unsigned & slot) const {
+    uint32_t node = myRoot;
+    for (unsigned height = myHeight; height > 0; --height) {
+        const Inner & inner = myInners[node];
+        unsigned i = 0;
+        while (rank >= inner.sizes[i]) rank -= inner.sizes[i++];
+        node = inner.children[i];
+    }
+    slot = rank;
+    return node;
+}
+
+bool Leaderboard::at (size_t rank, RankEntry & entry) const {
+    if (rank == 0 || rank > mySize) return false;
+    unsigned slot;
+    const Leaf & leaf = myLeaves[findLeaf(rank - 1, slot)];
+    entry.pseudo = myPlayers.pseudo(leaf.players[slot]);
+    entry.value = keyOf(leaf.keys[slot]);
+    return true;
+}
+
+void Leaderboard::page (size_t first, size_t count, vector<RankEntry> & entries) const {
+    entries.clear();
+    if (first == 0 || first > mySize) return;
+    unsigned slot;
+    uint32_t node = findLeaf(first - 1, slot);
+    while (entries.size() < count && node != KNoNode) {
+        const Leaf & leaf = myLeaves[node];
+        for (; slot < leaf.count && entries.size() < count; ++slot)
+            entries.push_back(RankEntry {myPlayers.pseudo(leaf.players[slot]), keyOf(leaf.keys[slot])});
+        node = leaf.next;
+        slot = 0;
+    }
+}
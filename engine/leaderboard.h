@@ -0,0 +1,143 @@
+/**
+ * @file leaderboard.h
+ * @brief Classement des scores : rang d'un score, score d'un rang et pages du classement en O(log n)
+ *
+ * Les fichiers de scores (une ligne "valeur pseudo" par partie) sont relus
+ * dans un arbre B compté : les feuilles gardent les entrées dans l'ordre du
+ * classement et chaque nœud interne le nombre d'entrées de chacun de ses
+ * sous-arbres. Le rang d'un score se lit en descendant l'arbre et en
+ * additionnant les sous-arbres laissés à gauche ; le score d'un rang, en
+ * descendant selon ces mêmes comptes. Les feuilles sont chaînées : une page
+ * du classement est une descente puis une lecture à la suite.
+ *
+ * Une entrée est une clé et un numéro de joueur (players.h) : les feuilles
+ * sont des tableaux de taille fixe, décalés sans copie de chaîne, et chaque
+ * pseudo n'est gardé qu'une fois quel que soit son nombre de parties.
+ *
+ * Le même classement sert aux modes à meilleur score (Classique et
+ * Contre-la-montre, RankHighFirst) et au mode Cible (moins de coups,
+ * RankLowFirst). A valeur égale, l'entrée la plus ancienne reste devant.
+ */
+#ifndef CANDY_LEADERBOARD_H
+#define CANDY_LEADERBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "players.h"
+
+// Entrées d'une feuille, sous-arbres d'un nœud interne
+const unsigned KRankFanout (64);
+
+/**
+ * @brief Sens du classement
+ */
+enum RankOrder {
+    RankHighFirst,  // la plus grande valeur en tête (points)
+    RankLowFirst    // la plus petite valeur en tête (coups)
+};
+
+/**
+ * @struct RankEntry
+ * @brief Une ligne du classement
+ */
+struct RankEntry {
+    std::string pseudo;
+    std::uint64_t value;
+};
+
+/**
+ * @brief Classement trié avec accès par rang
+ */
+class Leaderboard {
+public:
+    explicit Leaderboard (RankOrder order = RankHighFirst);
+
+    /**
+     * @brief Remplace le classement par celui du fichier, projeté en mémoire (lignes "valeur pseudo", dans n'importe quel ordre)
+     * @return false si le fichier ne peut pas être ouvert (le classement est alors vide)
+     */
+    bool load (const std::string & fileName);
+
+    /**
+     * @brief Réécrit le fichier dans l'ordre du classement
+     */
+    bool save (const std::string & fileName) const;
+
+    /**
+     * @brief Ajoute une entrée, derrière les entrées de même valeur
+     * @return Rang de l'entrée (1 : en tête)
+     */
+    std::size_t insert (const std::string & pseudo, std::uint64_t value);
+
+    /**
+     * @brief Rang qu'aurait une nouvelle entrée de cette valeur (1 : en tête, size() + 1 : dernière)
+     */
+    std::size_t rankOf (std::uint64_t value) const;
+
+    /**
+     * @brief Entrée du rang donné (1 : en tête)
+     * @return false si le rang est hors du classement
+     */
+    bool at (std::size_t rank, RankEntry & entry) const;
+
+    /**
+     * @brief Entrées des rangs first à first + count - 1 (moins en fin de classement)
+     */
+    void page (std::size_t first, std::size_t count, std::vector<RankEntry> & entries) const;
+
+    std::size_t size () const { return mySize; }
+    const PlayerRegistry & players () const { return myPlayers; }
+    RankOrder order () const { return myOrder; }
+    void clear ();
+
+private:
+    // Clé de tri : croissante dans l'ordre du classement quel que soit le sens
+    std::uint64_t keyOf (std::uint64_t value) const { return myOrder == RankHighFirst ? ~value : value; }
+
+    // Une place de plus que KRankFanout : un nœud déborde avant d'être coupé en deux
+    struct Leaf {
+        unsigned count;
+        std::uint32_t next;                        // feuille suivante du classement (KNoNode : dernière)
+        std::uint64_t keys [KRankFanout + 1];
+        std::uint32_t players [KRankFanout + 1];   // numéros dans myPlayers
+    };
+
+    struct Inner {
+        unsigned count;
+        std::uint32_t children [KRankFanout + 1];  // feuilles si le nœud est juste au-dessus d'elles
+        std::uint64_t firsts [KRankFanout + 1];    // plus petite clé de chaque sous-arbre
+        std::uint64_t sizes [KRankFanout + 1];     // entrées de chaque sous-arbre
+    };
+
+    /**
+     * @brief Nœud créé par le débordement d'un enfant, à placer juste après lui
+     */
+    struct Split {
+        std::uint32_t node;
+        std::uint64_t first;
+        std::uint64_t size;
+    };
+
+    bool insertLeaf (std::uint32_t node, std::uint64_t key, std::uint32_t player, std::size_t & rank, Split & split);
+    bool insertInner (std::uint32_t node, unsigned height, std::uint64_t key, std::uint32_t player,
+                      std::size_t & rank, Split & split);
+
+    /**
+     * @brief Feuille qui contient l'entrée de rang rank (0 : en tête), et sa place dans la feuille
+     */
+    std::uint32_t findLeaf (std::size_t rank, unsigned & slot) const;
+
+    RankOrder myOrder;
+    std::vector<Leaf> myLeaves;
+    std::vector<Inner> myInners;
+    PlayerRegistry myPlayers;
+    std::uint32_t myRoot;
+    std::uint32_t myHead;          // première feuille
+    unsigned myHeight;             // 0 : la racine est une feuille
+    std::size_t mySize;
+};
+
+#endif // CANDY_LEADERBOARD_H
@@ -0,0 +1,407 @@
+#include "level.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char KPackMagic[8] = {'C', 'A', 'N', 'D', 'Y', 'L', 'V', 'L'};
+const uint32_t KPackVersion (2);
+
+/**
+ * @struct PackHeader
+ * @brief En-tête d'un paquet, suivi de count positions (uint64) puis des niveaux
+ */
+struct PackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+};
+
+uint16_t readU16 (const uint8_t * data) {
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void appendU16 (vector<uint8_t> & out, uint16_t value) {
+    const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+/**
+ * @brief Vérifie le bloc d'apparition d'un niveau du paquet
+ * @param available Octets disponibles après les cases
+ * @return false si le bloc dépasse du fichier, vise une colonne absente ou une couleur inconnue
+ */
+bool checkSpawnBlock (const LevelRecord & record, const uint8_t * data, size_t available) {
+    auto colours = [&] (const uint8_t * first, size_t count) {
+        for (size_t k = 0; k < count; ++k)
+            if (first[k] < 1 || first[k] > record.nbCandies) return false;
+        return true;
+    };
+    if (available < 2) return false;
+    const size_t scriptLength = readU16(data);
+    size_t at = 2;
+    if (available - at < scriptLength + 2 || !colours(data + at, scriptLength)) return false;
+    at += scriptLength;
+    const size_t nbQueues = readU16(data + at);
+    at += 2;
+    for (size_t q = 0; q < nbQueues; ++q) {
+        if (available - at < 4) return false;
+        const unsigned column = readU16(data + at);
+        const size_t length = readU16(data + at + 2);
+        at += 4;
+        if (column >= record.size || available - at < length || !colours(data + at, length)) return false;
+        at += length;
+    }
+    return true;
+}
+
+bool parseMode (const string & word, uint8_t & mode) {
+    if (word == "classique") mode = ModeClassic;
+    else if (word == "contre-la-montre") mode = ModeTimeTrial;
+    else if (word == "cible") mode = ModeTarget;
+    else return false;
+    return true;
+}
+
+LevelData defaultLevel () {
+    LevelData level;
+    level.record.size = KGridSize;
+    level.record.nbCandies = KNbCandies;
+    level.record.mode = ModeClassic;
+    level.record.maxMoves = KMaxMoves;
+    level.record.timeLimit = KTimeLimit;
+    level.record.targetScore = KTargetScore;
+    for (unsigned c = 0; c < KMaxLevelCandies; ++c) level.record.spawnWeights[c] = 1;
+    return level;
+}
+
+} // namespace
+
+// --- 1. PAQUET PROJETE EN MEMOIRE ---
+
+LevelPack::~LevelPack () {
+    close();
+}
+
+bool LevelPack::open (const string & fileName) {
+    close();
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(PackHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void * data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+    // Accès au hasard d'un niveau à l'autre : pas de lecture anticipée du fichier entier
+    madvise(data, info.st_size, MADV_RANDOM);
+
+    myData = static_cast<const unsigned char *>(data);
+    myBytes = info.st_size;
+
+    const PackHeader * header = reinterpret_cast<const PackHeader *>(myData);
+    if (memcmp(header->magic, KPackMagic, sizeof(KPackMagic)) != 0 || header->version != KPackVersion
+        || sizeof(PackHeader) + size_t(header->count) * sizeof(uint64_t) > myBytes) {
+        close();
+        return false;
+    }
+    myCount = header->count;
+    myOffsets = reinterpret_cast<const uint64_t *>(myData + sizeof(PackHeader));
+    return true;
+}
+
+void LevelPack::close () {
+    if (myData) munmap(const_cast<unsigned char *>(myData), myBytes);
+    myData = nullptr;
+    myBytes = 0;
+    myCount = 0;
+    myOffsets = nullptr;
+}
+
+bool LevelPack::level (size_t index, LevelView & view) const {
+    if (index >= myCount) return false;
+    const uint64_t offset = myOffsets[index];
+    if (offset % alignof(LevelRecord) != 0 || offset > myBytes || myBytes - offset < sizeof(LevelRecord))
+        return false;
+
+    const LevelRecord * record = reinterpret_cast<const LevelRecord *>(myData + offset);
+    const uint64_t cells = uint64_t(record->size) * record->size;
+    const uint64_t available = myBytes - offset - sizeof(LevelRecord);
+    if (record->size < 3 || record->nbCandies < 3 || record->nbCandies > KMaxLevelCandies
+        || record->mode > ModeTarget || available < cells)
+        return false;
+    const uint8_t * spawn = myData + offset + sizeof(LevelRecord) + cells;
+    if (!checkSpawnBlock(*record, spawn, available - cells)) return false;
+
+    view.record = record;
+    view.cells = myData + offset + sizeof(LevelRecord);
+    view.spawn = spawn;
+    return true;
+}
+
+// --- 2. FORMAT TEXTE ET ECRITURE ---
+
+bool parseLevels (istream & in, vector<LevelData> & levels, string & error) {
+    string text;
+    unsigned lineNumber = 0;
+    bool inLevel = false;
+    bool inGrid = false;
+    LevelData level;
+    vector<uint8_t> script;
+    vector<vector<uint8_t> > queues;
+
+    auto fail = [&] (const string & message) {
+        error = "ligne " + to_string(lineNumber) + " : " + message;
+        return false;
+    };
+
+    while (getline(in, text)) {
+        lineNumber++;
+        if (!text.empty() && text.back() == '\r') text.pop_back();
+        // Dans la grille, # est un bloqueur : une rangée peut commencer par lui
+        if (text.empty() || (text[0] == '#' && !inGrid)) continue;
+
+        istringstream words(text);
+        string key;
+        words >> key;
+
+        if (!inLevel) {
+            if (key != "niveau") return fail("'niveau' attendu");
+            level = defaultLevel();
+            script.clear();
+            queues.clear();
+            inLevel = true;
+            continue;
+        }
+        if (inGrid && key != "fin") {
+            if (key.size() != level.record.size) return fail("la rangée doit avoir " + to_string(level.record.size) + " cases");
+            for (char c : key) {
+                if (c == '.') level.cells.push_back(KLevelCellCandy);
+                else if (c == 'X') level.cells.push_back(KLevelCellHole);
+                else if (c == '#') level.cells.push_back(KLevelCellBlocker);
+                else if (c >= '1' && c <= '9') level.cells.push_back(KLevelCellCandy | ((c - '0') << KLevelJellyShift));
+                else return fail(string("case inconnue '") + c + "'");
+            }
+            continue;
+        }
+
+        unsigned value = 0;
+        if (key == "taille") {
+            if (!(words >> value) || value < 3 || value > 1024) return fail("taille entre 3 et 1024 attendue");
+            level.record.size = value;
+        }
+        else if (key == "bonbons") {
+            if (!(words >> value) || value < 3 || value > KMaxLevelCandies) return fail("entre 3 et 8 bonbons attendus");
+            level.record.nbCandies = value;
+        }
+        else if (key == "mode") {
+            string word;
+            if (!(words >> word) || !parseMode(word, level.record.mode)) return fail("mode inconnu");
+        }
+        else if (key == "coups") {
+            if (!(words >> value) || value > 0xFFFF) return fail("nombre de coups invalide");
+            level.record.maxMoves = value;
+        }
+        else if (key == "temps") {
+            if (!(words >> value) || value > 0xFFFF) return fail("temps invalide");
+            level.record.timeLimit = value;
+        }
+        else if (key == "objectif") {
+            if (!(words >> value)) return fail("objectif invalide");
+            level.record.targetScore = value;
+        }
+        else if (key == "poids") {
+            for (unsigned c = 0; c < KMaxLevelCandies; ++c) level.record.spawnWeights[c] = 0;
+            for (unsigned c = 0; c < KMaxLevelCandies && words >> value; ++c) {
+                if (value > 255) return fail("poids entre 0 et 255 attendu");
+                level.record.spawnWeights[c] = value;
+            }
+        }
+        else if (key == "sequence") {
+            while (words >> value) {
+                if (value < 1 || value > KMaxLevelCandies) return fail("bonbon entre 1 et 8 attendu");
+                script.push_back(value);
+            }
+        }
+        else if (key == "colonne") {
+            unsigned column = 0;
+            if (!(words >> column) || column > 1023) return fail("numéro de colonne attendu");
+            if (column >= queues.size()) queues.resize(column + 1);
+            while (words >> value) {
+                if (value < 1 || value > KMaxLevelCandies) return fail("bonbon entre 1 et 8 attendu");
+                queues[column].push_back(value);
+            }
+        }
+        else if (key == "grille") {
+            level.cells.clear();
+            inGrid = true;
+        }
+        else if (key == "fin") {
+            if (!inGrid) level.cells.assign(size_t(level.record.size) * level.record.size, KLevelCellCandy);
+            if (level.cells.size() != size_t(level.record.size) * level.record.size)
+                return fail("la grille doit avoir " + to_string(level.record.size) + " rangées");
+            unsigned weightSum = 0;
+            for (unsigned c = 0; c < level.record.nbCandies; ++c) weightSum += level.record.spawnWeights[c];
+            if (weightSum == 0) return fail("au moins une couleur doit avoir un poids non nul");
+            if (queues.size() > level.record.size) return fail("colonne hors de la grille");
+            if (script.size() > 0xFFFF) return fail("séquence trop longue");
+            for (uint8_t colour : script)
+                if (colour > level.record.nbCandies) return fail("la séquence utilise une couleur absente du niveau");
+            for (const vector<uint8_t> & queue : queues) {
+                if (queue.size() > 0xFFFF) return fail("file de colonne trop longue");
+                for (uint8_t colour : queue)
+                    if (colour > level.record.nbCandies) return fail("une colonne utilise une couleur absente du niveau");
+            }
+            setLevelSpawn(level, script, queues);
+            levels.push_back(level);
+            inLevel = false;
+            inGrid = false;
+        }
+        else {
+            return fail("mot-clé inconnu '" + key + "'");
+        }
+    }
+    if (inLevel) return fail("'fin' manquant");
+    return true;
+}
+
+bool writeLevelPack (const string & fileName, const vector<LevelData> & levels) {
+    ofstream file(fileName, ios::binary | ios::trunc);
+    if (!file) return false;
+
+    PackHeader header;
+    memcpy(header.magic, KPackMagic, sizeof(KPackMagic));
+    header.version = KPackVersion;
+    header.count = levels.size();
+
+    // Positions des niveaux, alignées pour lire LevelRecord sur place
+    vector<uint64_t> offsets;
+    uint64_t offset = sizeof(PackHeader) + levels.size() * sizeof(uint64_t);
+    for (const LevelData & level : levels) {
+        offset = (offset + alignof(LevelRecord) - 1) / alignof(LevelRecord) * alignof(LevelRecord);
+        offsets.push_back(offset);
+        offset += sizeof(LevelRecord) + level.cells.size() + level.spawn.size();
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    uint64_t written = sizeof(PackHeader) + offsets.size() * sizeof(uint64_t);
+    const char padding[alignof(LevelRecord)] = {};
+    for (size_t i = 0; i < levels.size(); ++i) {
+        file.write(padding, offsets[i] - written);
+        file.write(reinterpret_cast<const char *>(&levels[i].record), sizeof(LevelRecord));
+        file.write(reinterpret_cast<const char *>(levels[i].cells.data()), levels[i].cells.size());
+        file.write(reinterpret_cast<const char *>(levels[i].spawn.data()), levels[i].spawn.size());
+        written = offsets[i] + sizeof(LevelRecord) + levels[i].cells.size() + levels[i].spawn.size();
+    }
+    return bool(file);
+}
+
+LevelView viewOf (const LevelData & level) {
+    return {&level.record, level.cells.data(), level.spawn.data()};
+}
+
+void setLevelSpawn (LevelData & level, const vector<uint8_t> & script, const vector<vector<uint8_t> > & queues) {
+    level.spawn.clear();
+    appendU16(level.spawn, script.size());
+    level.spawn.insert(level.spawn.end(), script.begin(), script.end());
+    unsigned nbQueues = 0;
+    for (const vector<uint8_t> & queue : queues) nbQueues += !queue.empty();
+    appendU16(level.spawn, nbQueues);
+    for (size_t column = 0; column < queues.size(); ++column) {
+        if (queues[column].empty()) continue;
+        appendU16(level.spawn, column);
+        appendU16(level.spawn, queues[column].size());
+        level.spawn.insert(level.spawn.end(), queues[column].begin(), queues[column].end());
+    }
+}
+
+void readLevelSpawn (const LevelView & level, vector<uint8_t> & script, vector<vector<uint8_t> > & queues) {
+    const uint8_t * at = level.spawn;
+    const unsigned scriptLength = readU16(at);
+    script.assign(at + 2, at + 2 + scriptLength);
+    at += 2 + scriptLength;
+    queues.assign(level.record->size, vector<uint8_t>());
+    const unsigned nbQueues = readU16(at);
+    at += 2;
+    for (unsigned q = 0; q < nbQueues; ++q) {
+        const unsigned column = readU16(at);
+        const unsigned length = readU16(at + 2);
+        queues[column].assign(at + 4, at + 4 + length);
+        at += 4 + length;
+    }
+}
+
+// --- 3. PARTIE SUR UN NIVEAU ---
+
+void initLevelGrid (const LevelView & level, mat & grid, mat & jelly) {
+    const unsigned size = level.record->size;
+    initGrid(grid, size, level.record->nbCandies);
+    jelly.assign(size, line(size, 0));
+
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            const uint8_t cell = level.cells[i * size + j];
+            switch (cell & KLevelCellKindMask) {
+            case KLevelCellHole: grid[i][j] = KHole; break;
+            case KLevelCellBlocker: grid[i][j] = KBlocker; break;
+            default: break;
+            }
+            jelly[i][j] = cell >> KLevelJellyShift;
+        }
+    }
+}
+
+void initLevelSpawn (const LevelView & level, SpawnPolicy & policy) {
+    const LevelRecord & record = *level.record;
+    unsigned weights[KMaxLevelCandies];
+    for (unsigned c = 0; c < record.nbCandies; ++c) weights[c] = record.spawnWeights[c];
+    policy = SpawnPolicy(record.nbCandies);
+    policy.setWeights(weights, record.nbCandies);
+
+    vector<uint8_t> script;
+    vector<vector<uint8_t> > queues;
+    readLevelSpawn(level, script, queues);
+    policy.setScript(script);
+    for (unsigned abs = 0; abs < queues.size(); ++abs)
+        if (!queues[abs].empty()) policy.setColumnQueue(abs, queues[abs]);
+}
+
+unsigned peelJelly (mat & jelly, const BoardMask & cleared) {
+    unsigned peeled = 0;
+    for (size_t w = 0; w < cleared.bits.size(); ++w) {
+        uint64_t bits = cleared.bits[w];
+        const unsigned ord = w / cleared.wordsPerRow;
+        const unsigned base = (w % cleared.wordsPerRow) * 64;
+        while (bits != 0) {
+            unsigned & layers = jelly[ord][base + __builtin_ctzll(bits)];
+            bits &= bits - 1;
+            if (layers > 0) {
+                layers--;
+                peeled++;
+            }
+        }
+    }
+    return peeled;
+}
+
+unsigned jellyLeft (const mat & jelly) {
+    unsigned total = 0;
+    for (const line & row : jelly)
+        for (unsigned layers : row) total += layers;
+    return total;
+}
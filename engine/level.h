@@ -0,0 +1,200 @@
+/**
+ * @file level.h
+ * @brief Niveaux : forme du plateau, bloqueurs, gelée, objectifs, et paquets de niveaux lus par mmap
+ *
+ * Format texte (un ou plusieurs niveaux, lignes commençant par # ignorées hors de la grille) :
+ *
+ *     niveau
+ *     taille 8
+ *     bonbons 4
+ *     mode classique          (classique, contre-la-montre ou cible)
+ *     coups 20
+ *     temps 60
+ *     objectif 1000
+ *     poids 1 1 1 1           (poids d'apparition de chaque couleur, optionnel)
+ *     sequence 1 2 3 1        (bonbons imposés au remplissage, dans l'ordre, optionnel)
+ *     colonne 3 2 2 4         (colonne 3 : bonbons qui y tombent en premier, optionnel)
+ *     grille
+ *     ..X..X..                (une ligne par rangée, un caractère par case)
+ *     ...
+ *     fin
+ *
+ * Cases : '.' bonbon, 'X' trou, '#' bloqueur, '1' à '9' bonbon sur autant de couches de gelée.
+ * Les lignes sequence et colonne peuvent être répétées, elles s'ajoutent
+ * (voir spawn.h pour l'ordre de priorité au remplissage).
+ *
+ * Paquet binaire (candy_levels build) : un en-tête, la table des positions
+ * de chaque niveau, puis les niveaux (LevelRecord, un octet par case, puis
+ * le bloc d'apparition : séquence et files des colonnes).
+ * LevelPack projette le fichier en mémoire et ne lit que l'en-tête :
+ * ouvrir un paquet de milliers de niveaux ne coûte rien, et un niveau n'est
+ * lu (et chargé par le système) qu'au moment où on le demande.
+ */
+#ifndef CANDY_LEVEL_H
+#define CANDY_LEVEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "grid.h"
+#include "spawn.h"
+#include "special.h"
+
+// Nombre maximal de couleurs d'un niveau (poids d'apparition)
+const unsigned KMaxLevelCandies (8);
+static_assert(KMaxLevelCandies <= KMaxSpawnColours, "les poids d'un niveau doivent tenir dans une table d'alias");
+
+// Octet d'une case dans un paquet : type sur les bits 0-1, couches de gelée sur les bits 4-7
+const std::uint8_t KLevelCellCandy (0);
+const std::uint8_t KLevelCellHole (1);
+const std::uint8_t KLevelCellBlocker (2);
+const std::uint8_t KLevelCellKindMask (0x3);
+const unsigned KLevelJellyShift (4);
+
+/**
+ * @struct LevelRecord
+ * @brief En-tête d'un niveau tel qu'il est stocké dans le paquet
+ */
+struct LevelRecord {
+    std::uint16_t size;                            // côté de la grille
+    std::uint8_t nbCandies;                        // types de bonbons (3 à KMaxLevelCandies)
+    std::uint8_t mode;                             // GameMode
+    std::uint16_t maxMoves;                        // limite de coups (Classique et Cible)
+    std::uint16_t timeLimit;                       // limite de temps en secondes (Contre-la-montre)
+    std::uint32_t targetScore;                     // score à atteindre
+    std::uint8_t spawnWeights[KMaxLevelCandies];   // poids d'apparition de chaque couleur
+};
+static_assert(sizeof(LevelRecord) == 20, "LevelRecord est lu tel quel depuis le paquet");
+
+/**
+ * @struct LevelView
+ * @brief Un niveau lu directement dans le paquet projeté (aucune copie)
+ *
+ * Reste valide tant que le LevelPack est ouvert.
+ */
+struct LevelView {
+    const LevelRecord * record;
+    const std::uint8_t * cells;   // size * size octets, ligne par ligne
+    const std::uint8_t * spawn;   // bloc d'apparition (voir LevelData::spawn)
+};
+
+/**
+ * @struct LevelData
+ * @brief Un niveau en mémoire, avant écriture dans un paquet
+ */
+struct LevelData {
+    LevelRecord record;
+    std::vector<std::uint8_t> cells;
+    // Bloc d'apparition tel qu'il est écrit dans le paquet (entiers de 16 bits non alignés) :
+    // longueur de la séquence, séquence, nombre de files, puis (colonne, longueur, bonbons) par file
+    std::vector<std::uint8_t> spawn;
+};
+
+/**
+ * @brief Paquet de niveaux projeté en mémoire (lecture seule)
+ */
+class LevelPack {
+public:
+    LevelPack () = default;
+    ~LevelPack ();
+    LevelPack (const LevelPack &) = delete;
+    LevelPack & operator= (const LevelPack &) = delete;
+
+    /**
+     * @brief Projette un paquet en mémoire et vérifie son en-tête
+     * @param fileName Fichier produit par writeLevelPack
+     * @return false si le fichier est absent ou n'est pas un paquet de niveaux
+     */
+    bool open (const std::string & fileName);
+
+    void close ();
+
+    /**
+     * @brief Nombre de niveaux du paquet
+     */
+    std::size_t size () const { return myCount; }
+
+    /**
+     * @brief Donne accès au niveau index sans le copier
+     * @return false si index est hors du paquet ou si le niveau est corrompu
+     */
+    bool level (std::size_t index, LevelView & view) const;
+
+private:
+    const unsigned char * myData = nullptr;
+    std::size_t myBytes = 0;
+    std::size_t myCount = 0;
+    const std::uint64_t * myOffsets = nullptr;
+};
+
+/**
+ * @brief Lit des niveaux au format texte
+ * @param in Flux à lire
+ * @param[out] levels Niveaux lus, ajoutés à la fin
+ * @param[out] error Message (avec numéro de ligne) si la lecture échoue
+ * @return false à la première erreur
+ */
+bool parseLevels (std::istream & in, std::vector<LevelData> & levels, std::string & error);
+
+/**
+ * @brief Ecrit un paquet binaire de niveaux
+ * @return false si le fichier ne peut pas être écrit
+ */
+bool writeLevelPack (const std::string & fileName, const std::vector<LevelData> & levels);
+
+/**
+ * @brief Vue sur un niveau en mémoire (pour le jouer sans passer par un paquet)
+ */
+LevelView viewOf (const LevelData & level);
+
+/**
+ * @brief Prépare la grille et la gelée d'un niveau
+ * @param level Niveau
+ * @param[out] grid Grille sans alignement de départ, avec trous et bloqueurs
+ * @param[out] jelly Couches de gelée de chaque case
+ */
+void initLevelGrid (const LevelView & level, mat & grid, mat & jelly);
+
+/**
+ * @brief Ecrit le bloc d'apparition d'un niveau
+ * @param[out] level Niveau (champ spawn)
+ * @param script Séquence imposée
+ * @param queues File de chaque colonne (vide si la colonne n'en a pas)
+ */
+void setLevelSpawn (LevelData & level, const std::vector<std::uint8_t> & script,
+                    const std::vector<std::vector<std::uint8_t> > & queues);
+
+/**
+ * @brief Relit le bloc d'apparition d'un niveau
+ * @param level Niveau (validé par LevelPack::level ou construit par setLevelSpawn)
+ * @param[out] script Séquence imposée
+ * @param[out] queues File de chaque colonne (size files, éventuellement vides)
+ */
+void readLevelSpawn (const LevelView & level, std::vector<std::uint8_t> & script,
+                     std::vector<std::vector<std::uint8_t> > & queues);
+
+/**
+ * @brief Prépare la politique d'apparition d'un niveau : poids, séquence et files des colonnes
+ * @param level Niveau
+ * @param[out] policy Politique à installer avec SpawnScope pendant la partie
+ */
+void initLevelSpawn (const LevelView & level, SpawnPolicy & policy);
+
+/**
+ * @brief Retire une couche de gelée sur chaque case vidée
+ * @param jelly Couches de gelée
+ * @param cleared Cases vidées (voir clearMatch)
+ * @return Nombre de couches retirées
+ */
+unsigned peelJelly (mat & jelly, const BoardMask & cleared);
+
+/**
+ * @brief Nombre total de couches de gelée restantes
+ */
+unsigned jellyLeft (const mat & jelly);
+
+#endif // CANDY_LEVEL_H
@@ -0,0 +1,281 @@
+#include "packed.h"
+#include "events.h"
+#include "instrument.h"
+#include "spawn.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+const uint64_t KLowNibbles (0x1111111111111111ULL);  // bit de poids faible de chaque quartet
+
+/**
+ * @brief Bit de poids faible allumé pour chaque quartet nul du mot
+ */
+inline uint64_t zeroNibbles (uint64_t x) {
+    x |= x >> 1;
+    x |= x >> 2;
+    return ~x & KLowNibbles;
+}
+
+/**
+ * @brief Cases où commence un alignement vertical : même couleur sur trois lignes, case non vide
+ */
+inline uint64_t verticalHits (uint64_t a, uint64_t b, uint64_t c) {
+    return zeroNibbles(a ^ b) & zeroNibbles(b ^ c) & ~zeroNibbles(a);
+}
+
+/**
+ * @brief Cases du mot w où commence un alignement horizontal (les deux voisins de droite peuvent être dans le mot suivant)
+ */
+inline uint64_t horizontalHits (const uint64_t * row, unsigned w, unsigned wordsPerRow) {
+    const uint64_t a = row[w];
+    const uint64_t next = w + 1 < wordsPerRow ? row[w + 1] : 0;
+    const uint64_t right1 = (a >> KPackedBits) | (next << (64 - KPackedBits));
+    const uint64_t right2 = (a >> (2 * KPackedBits)) | (next << (64 - 2 * KPackedBits));
+    return zeroNibbles(a ^ right1) & zeroNibbles(a ^ right2) & ~zeroNibbles(a);
+}
+
+inline unsigned firstLane (uint64_t hits) {
+    return __builtin_ctzll(hits) / KPackedBits;
+}
+
+/**
+ * @brief Masque des cases [lo, hi[ d'un mot
+ */
+inline uint64_t laneMask (unsigned lo, unsigned hi) {
+    const uint64_t upTo = hi == KPackedPerWord ? ~uint64_t(0) : (uint64_t(1) << (hi * KPackedBits)) - 1;
+    return upTo & ~((uint64_t(1) << (lo * KPackedBits)) - 1);
+}
+
+inline uint64_t * rowOf (PackedGrid & grid, unsigned ord) {
+    return &grid.words[size_t(ord) * grid.wordsPerRow];
+}
+
+inline const uint64_t * rowOf (const PackedGrid & grid, unsigned ord) {
+    return &grid.words[size_t(ord) * grid.wordsPerRow];
+}
+
+} // namespace
+
+// --- 1. LA GRILLE ---
+
+void packedReset (PackedGrid & grid, unsigned size) {
+    grid.size = size;
+    grid.wordsPerRow = (size + KPackedPerWord - 1) / KPackedPerWord;
+    grid.words.assign(size_t(size) * grid.wordsPerRow, 0);
+}
+
+bool packGrid (const mat & grid, PackedGrid & packed) {
+    const unsigned size = grid.size();
+    packedReset(packed, size);
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            if (grid[i][j] > KColourMask) {
+                packedReset(packed, 0);
+                return false;
+            }
+            packedSet(packed, i, j, grid[i][j]);
+        }
+    }
+    return true;
+}
+
+void unpackGrid (const PackedGrid & packed, mat & grid) {
+    grid.assign(packed.size, line(packed.size));
+    for (unsigned i = 0; i < packed.size; ++i) {
+        for (unsigned j = 0; j < packed.size; ++j) grid[i][j] = packedGet(packed, i, j);
+    }
+}
+
+// --- 2. LES MATCHS ---
+
+void initGrid (PackedGrid & grid, const size_t & matSize, unsigned nbCandies) {
+    packedReset(grid, matSize);
+
+    for (unsigned i = 0; i < matSize; ++i) {
+        for (unsigned j = 0; j < matSize; ++j) {
+            // Mêmes couleurs interdites et même tirage que initGrid sur une grille mat
+            unsigned forbidLeft = KImpossible;
+            unsigned forbidUp = KImpossible;
+            if (j >= 2 && packedGet(grid, i, j-1) == packedGet(grid, i, j-2)) forbidLeft = packedGet(grid, i, j-1);
+            if (i >= 2 && packedGet(grid, i-1, j) == packedGet(grid, i-2, j)) forbidUp = packedGet(grid, i-1, j);
+
+            unsigned nbForbidden = (forbidLeft != KImpossible) + (forbidUp != KImpossible && forbidUp != forbidLeft);
+            if (nbForbidden >= nbCandies) {
+                packedSet(grid, i, j, (spawnRandom() % nbCandies) + 1);
+                continue;
+            }
+
+            unsigned candy = (spawnRandom() % (nbCandies - nbForbidden)) + 1;
+            for (unsigned type = 1; type <= nbCandies; ++type) {
+                if (type == forbidLeft || type == forbidUp) continue;
+                if (--candy == 0) {
+                    packedSet(grid, i, j, type);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool checkInitialMatch (const PackedGrid & grid) {
+    const unsigned size = grid.size;
+    if (size < 3) return false;
+    for (unsigned i = 0; i < size; ++i) {
+        const uint64_t * row = rowOf(grid, i);
+        for (unsigned w = 0; w < grid.wordsPerRow; ++w) {
+            if (horizontalHits(row, w, grid.wordsPerRow)) return true;
+            if (i + 2 < size && verticalHits(row[w], row[w + grid.wordsPerRow], row[w + 2 * grid.wordsPerRow])) return true;
+        }
+    }
+    return false;
+}
+
+bool atLeastThreeInAColumn (const PackedGrid & grid, maPosition & pos, unsigned & howMany) {
+    CANDY_TIMER(PhaseMatchScan);
+    CANDY_COUNT(CounterScans, 1);
+    const unsigned size = grid.size;
+    if (size < 3) return false;
+    const unsigned wordsPerRow = grid.wordsPerRow;
+
+    // Colonne la plus à gauche trouvée, et sa première ligne : les mots plus à droite ne peuvent plus gagner
+    unsigned bestAbs = size;
+    unsigned bestOrd = 0;
+    for (unsigned i = 0; i <= size - 3 && bestAbs > 0; ++i) {
+        const uint64_t * row = rowOf(grid, i);
+        const unsigned lastWord = bestAbs == size ? wordsPerRow : bestAbs / KPackedPerWord + 1;
+        for (unsigned w = 0; w < lastWord; ++w) {
+            const uint64_t hits = verticalHits(row[w], row[w + wordsPerRow], row[w + 2 * wordsPerRow]);
+            if (!hits) continue;
+            const unsigned abs = w * KPackedPerWord + firstLane(hits);
+            if (abs < bestAbs) {
+                bestAbs = abs;
+                bestOrd = i;
+            }
+            break;
+        }
+    }
+    if (bestAbs == size) return false;
+
+    const unsigned type = packedGet(grid, bestOrd, bestAbs);
+    howMany = 3;
+    for (unsigned k = bestOrd + 3; k < size && packedGet(grid, k, bestAbs) == type; ++k) howMany++;
+    pos = {bestAbs, bestOrd};
+    return true;
+}
+
+bool atLeastThreeInARow (const PackedGrid & grid, maPosition & pos, unsigned & howMany) {
+    CANDY_TIMER(PhaseMatchScan);
+    CANDY_COUNT(CounterScans, 1);
+    const unsigned size = grid.size;
+    if (size < 3) return false;
+    for (unsigned i = 0; i < size; ++i) {
+        const uint64_t * row = rowOf(grid, i);
+        for (unsigned w = 0; w < grid.wordsPerRow; ++w) {
+            const uint64_t hits = horizontalHits(row, w, grid.wordsPerRow);
+            if (!hits) continue;
+            const unsigned abs = w * KPackedPerWord + firstLane(hits);
+            const unsigned type = packedGet(grid, i, abs);
+            howMany = 3;
+            for (unsigned k = abs + 3; k < size && packedGet(grid, i, k) == type; ++k) howMany++;
+            pos = {abs, i};
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- 3. LA GRAVITE ---
+
+void removalInColumn (PackedGrid & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies) {
+    CANDY_TIMER(PhaseGravity);
+    const unsigned size = grid.size;
+    const unsigned abs = pos.abs;
+    if (abs >= size || pos.ord >= size) return;
+    const unsigned end = min(size, pos.ord + howMany);
+    const unsigned removed = end - pos.ord;
+    if (removed == 0) return;
+    emitEvent(EventMatchFound, 'V', howMany, pos.ord, abs, 0);
+
+    // Les bonbons au-dessus du match descendent de removed lignes, le haut de la colonne se remplit
+    for (unsigned i = end - 1; i >= removed; --i) packedSet(grid, i, abs, packedGet(grid, i - removed, abs));
+    for (unsigned i = 0; i < removed; ++i) packedSet(grid, i, abs, (spawnRandom() % nbCandies) + 1);
+    emitEvent(EventSpawned, 0, removed, 0, abs, 0);
+}
+
+void removalInRow (PackedGrid & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies) {
+    CANDY_TIMER(PhaseGravity);
+    const unsigned size = grid.size;
+    const unsigned ord = pos.ord;
+    if (ord >= size || pos.abs >= size) return;
+    const unsigned end = min(size, pos.abs + howMany);
+    if (end == pos.abs) return;
+    emitEvent(EventMatchFound, 'H', howMany, ord, pos.abs, 0);
+
+    // Toutes les colonnes du match descendent d'un cran à la fois : un masque par mot touché
+    const unsigned firstWord = pos.abs / KPackedPerWord;
+    const unsigned lastWord = (end - 1) / KPackedPerWord;
+    uint64_t masks [2];
+    masks[0] = laneMask(pos.abs % KPackedPerWord, firstWord == lastWord ? (end - 1) % KPackedPerWord + 1 : KPackedPerWord);
+    masks[1] = laneMask(0, (end - 1) % KPackedPerWord + 1);
+    for (unsigned i = ord; i > 0; --i) {
+        uint64_t * below = rowOf(grid, i);
+        const uint64_t * above = rowOf(grid, i - 1);
+        for (unsigned w = firstWord; w <= lastWord; ++w) {
+            const uint64_t mask = w == firstWord ? masks[0] : (w == lastWord ? masks[1] : ~uint64_t(0));
+            below[w] = (below[w] & ~mask) | (above[w] & mask);
+        }
+    }
+
+    // Remplissage de la première ligne, colonne par colonne comme sur une grille mat
+    for (unsigned j = pos.abs; j < end; ++j) {
+        packedSet(grid, 0, j, (spawnRandom() % nbCandies) + 1);
+        emitEvent(EventSpawned, 0, 1, 0, j, 0);
+    }
+}
+
+void makeAMove (PackedGrid & grid, const maPosition & pos, const char & direction) {
+    CANDY_TIMER(PhaseMove);
+    const unsigned size = grid.size;
+    if (pos.ord >= size || pos.abs >= size) return;
+
+    unsigned r2 = pos.ord;
+    unsigned c2 = pos.abs;
+    switch (direction) {
+    case 'Q': if (pos.abs == 0) return; c2--; break;
+    case 'Z': if (pos.ord == 0) return; r2--; break;
+    case 'D': if (pos.abs == size - 1) return; c2++; break;
+    case 'S': if (pos.ord == size - 1) return; r2++; break;
+    default: return;
+    }
+
+    const unsigned first = packedGet(grid, pos.ord, pos.abs);
+    packedSet(grid, pos.ord, pos.abs, packedGet(grid, r2, c2));
+    packedSet(grid, r2, c2, first);
+    emitEvent(EventMoveApplied, direction, 0, pos.ord, pos.abs, 0);
+}
+
+unsigned resolveCascade (PackedGrid & grid, unsigned nbCandies) {
+    unsigned comboLevel = 0;
+    unsigned howMany = 0;
+    maPosition matchPos;
+
+    while (true) {
+        if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
+            removalInColumn(grid, matchPos, howMany, nbCandies);
+        }
+        else if (atLeastThreeInARow(grid, matchPos, howMany)) {
+            removalInRow(grid, matchPos, howMany, nbCandies);
+        }
+        else {
+            break;
+        }
+        comboLevel++;
+        CANDY_COUNT(CounterCascadeSteps, 1);
+        emitEvent(EventCascadeStep, 0, comboLevel, 0, 0, 0);
+    }
+    return comboLevel;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file packed.h
+ * @brief Grille compacte pour les très grandes grilles : un quartet par case, 16 cases par mot
+ *
+ * Une grille mat réserve un unsigned par case et une allocation par ligne :
+ * 20000x20000 demande 1,6 Go en 20000 morceaux. PackedGrid range les cases
+ * en quartets dans des mots de 64 bits, ligne après ligne, en une seule
+ * allocation (8 fois moins de mémoire). Chaque ligne commence sur un mot ;
+ * les quartets de fin de ligne restent à 0 (KImpossible).
+ *
+ * Les noyaux ont les mêmes noms et la même sémantique que ceux de grid.h et
+ * travaillent directement sur les mots : la détection compare 16 cases à la
+ * fois (égalité de quartets par XOR), la gravité d'un match horizontal
+ * décale les lignes mot par mot sous un masque de colonnes. Avec la même
+ * graine, une grille compacte et une grille mat évoluent de la même façon.
+ *
+ * Seuls les bonbons ordinaires tiennent dans un quartet : pas de bonbons
+ * spéciaux ni de cases fixes, et le remplissage reste le tirage uniforme
+ * historique (pas de SpawnPolicy). La grille est supposée pleine.
+ */
+#ifndef CANDY_PACKED_H
+#define CANDY_PACKED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+
+const unsigned KPackedBits (4);                        // bits par case
+const unsigned KPackedPerWord (64 / KPackedBits);      // cases par mot
+
+/**
+ * @struct PackedGrid
+ * @brief Grille size x size, un quartet par case, ligne par ligne
+ */
+struct PackedGrid {
+    unsigned size;                   // côté de la grille
+    unsigned wordsPerRow;            // mots de 64 bits par ligne
+    std::vector<std::uint64_t> words;
+};
+
+/**
+ * @brief Dimensionne la grille pour size x size et la vide (toutes les cases à KImpossible)
+ */
+void packedReset (PackedGrid & grid, unsigned size);
+
+inline unsigned packedGet (const PackedGrid & grid, unsigned ord, unsigned abs) {
+    return (grid.words[ord * grid.wordsPerRow + abs / KPackedPerWord] >> (abs % KPackedPerWord * KPackedBits)) & KColourMask;
+}
+
+inline void packedSet (PackedGrid & grid, unsigned ord, unsigned abs, unsigned colour) {
+    std::uint64_t & word = grid.words[ord * grid.wordsPerRow + abs / KPackedPerWord];
+    const unsigned shift = abs % KPackedPerWord * KPackedBits;
+    word = (word & ~(std::uint64_t(KColourMask) << shift)) | (std::uint64_t(colour) << shift);
+}
+
+/**
+ * @brief Octets occupés par les cases de la grille
+ */
+inline std::size_t packedBytes (const PackedGrid & grid) {
+    return grid.words.size() * sizeof(std::uint64_t);
+}
+
+/**
+ * @brief Copie une grille mat dans une grille compacte
+ * @return false si une case n'est pas un bonbon ordinaire (spécial, bloqueur, trou) : packed est alors vide
+ */
+bool packGrid (const mat & grid, PackedGrid & packed);
+
+/**
+ * @brief Copie une grille compacte dans une grille mat
+ */
+void unpackGrid (const PackedGrid & packed, mat & grid);
+
+// --- LES NOYAUX (mêmes règles que grid.h) ---
+
+/**
+ * @brief Initialise la grille sans alignement de départ (même tirage que initGrid sur une grille mat)
+ */
+void initGrid (PackedGrid & grid, const std::size_t & matSize, unsigned nbCandies = KNbCandies);
+
+bool checkInitialMatch (const PackedGrid & grid);
+
+/**
+ * @brief Premier match vertical, colonne par colonne (le même que sur une grille mat)
+ *
+ * Les lignes sont lues dans l'ordre de la mémoire ; la colonne la plus à
+ * gauche trouvée limite les mots lus sur les lignes suivantes.
+ */
+bool atLeastThreeInAColumn (const PackedGrid & grid, maPosition & pos, unsigned & howMany);
+
+/**
+ * @brief Premier match horizontal, ligne par ligne
+ */
+bool atLeastThreeInARow (const PackedGrid & grid, maPosition & pos, unsigned & howMany);
+
+/**
+ * @brief Vide howMany cases d'une colonne, fait tomber les bonbons du dessus et remplit le haut
+ */
+void removalInColumn (PackedGrid & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies = KNbCandies);
+
+/**
+ * @brief Vide howMany cases d'une ligne : les lignes du dessus descendent d'un cran, mot par mot
+ */
+void removalInRow (PackedGrid & grid, const maPosition & pos, unsigned howMany, unsigned nbCandies = KNbCandies);
+
+/**
+ * @brief Echange deux bonbons voisins (direction Q, Z, D ou S)
+ */
+void makeAMove (PackedGrid & grid, const maPosition & pos, const char & direction);
+
+/**
+ * @brief Résout toute la réaction en chaîne, colonnes puis lignes
+ * @return Nombre de matchs supprimés
+ */
+unsigned resolveCascade (PackedGrid & grid, unsigned nbCandies = KNbCandies);
+
+#endif // CANDY_PACKED_H
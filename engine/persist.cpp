@@ -0,0 +1,123 @@
+#include "persist.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <charconv>
+#include <map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// --- 1. L'ECRITURE D'UN LOT ---
+
+bool appendScores (const string & fileName, const vector<RankEntry> & entries) {
+    CANDY_TIMER(PhaseScoreFile);
+    string lines;
+    char digits [20];
+    for (const RankEntry & entry : entries) {
+        lines.append(digits, to_chars(digits, digits + sizeof(digits), entry.value).ptr);
+        lines += ' ';
+        lines += entry.pseudo;
+        lines += '\n';
+    }
+
+    int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+    bool written = ::write(fd, lines.data(), lines.size()) == ssize_t(lines.size());
+    written = fdatasync(fd) == 0 && written;
+    return ::close(fd) == 0 && written;
+}
+
+// --- 2. LE FIL D'ECRITURE ---
+
+ScoreWriter::ScoreWriter (size_t capacity)
+    : myCapacity(max<size_t>(1, capacity)), myQueued(0), myWritten(0), myCommits(0), myFailed(false),
+      myStop(false) {}
+
+ScoreWriter::~ScoreWriter () {
+    if (!myThread.joinable()) return;
+    {
+        lock_guard<mutex> lock(myMutex);
+        myStop = true;
+    }
+    myWake.notify_one();
+    myThread.join();
+}
+
+void ScoreWriter::append (const string & fileName, const string & pseudo, uint64_t value) {
+    {
+        unique_lock<mutex> lock(myMutex);
+        // Le fil ne part qu'avec la première ligne : une session sans partie terminée n'en crée pas
+        if (!myThread.joinable()) myThread = thread(&ScoreWriter::run, this);
+        myRoom.wait(lock, [&] () { return myQueue.size() < myCapacity; });
+        myQueue.push_back(ScoreRecord {fileName, pseudo, value});
+        myQueued++;
+    }
+    myWake.notify_one();
+}
+
+bool ScoreWriter::flush () {
+    unique_lock<mutex> lock(myMutex);
+    const uint64_t target = myQueued;
+    myDone.wait(lock, [&] () { return myWritten >= target; });
+    const bool ok = !myFailed;
+    myFailed = false;
+    return ok;
+}
+
+uint64_t ScoreWriter::written () const {
+    lock_guard<mutex> lock(myMutex);
+    return myWritten;
+}
+
+uint64_t ScoreWriter::commits () const {
+    lock_guard<mutex> lock(myMutex);
+    return myCommits;
+}
+
+void ScoreWriter::run () {
+    deque<ScoreRecord> batch;
+    while (true) {
+        {
+            unique_lock<mutex> lock(myMutex);
+            myWake.wait(lock, [&] () { return myStop || !myQueue.empty(); });
+            // A l'arrêt, la file est vidée avant de sortir
+            if (myQueue.empty()) return;
+            batch.swap(myQueue);
+        }
+        myRoom.notify_all();
+
+        // Un seul ajout par fichier pour tout le lot, dans l'ordre d'arrivée des lignes
+        map<string, vector<RankEntry> > files;
+        for (ScoreRecord & record : batch) files[record.fileName].push_back(RankEntry {move(record.pseudo), record.value});
+        bool ok = true;
+        for (const auto & file : files) ok = appendScores(file.first, file.second) && ok;
+
+        {
+            lock_guard<mutex> lock(myMutex);
+            myWritten += batch.size();
+            myCommits += files.size();
+            myFailed = myFailed || !ok;
+        }
+        myDone.notify_all();
+        batch.clear();
+    }
+}
+
+// --- 3. LE FIL COURANT ---
+
+ScoreWriterScope::ScoreWriterScope (ScoreWriter * writer) : myPrevious(tlsScoreWriter) {
+    tlsScoreWriter = writer;
+}
+
+ScoreWriterScope::~ScoreWriterScope () {
+    tlsScoreWriter = myPrevious;
+}
+
+bool persistScore (const string & fileName, const string & pseudo, uint64_t value) {
+    if (!tlsScoreWriter) return appendScores(fileName, vector<RankEntry> {RankEntry {pseudo, value}});
+    tlsScoreWriter->append(fileName, pseudo, value);
+    return true;
+}
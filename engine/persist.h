@@ -0,0 +1,118 @@
+/**
+ * @file persist.h
+ * @brief Ecriture des fichiers de scores sur un fil de fond, par lots
+ *
+ * Une fin de partie ne réécrit plus tout le fichier de scores : le résultat
+ * est ajouté à la fin du fichier (une ligne "valeur pseudo", voir
+ * leaderboard.h qui relit les lignes dans n'importe quel ordre).
+ *
+ * Avec un ScoreWriterScope, persistScore confie la ligne à un ScoreWriter et
+ * rend la main tout de suite. Le fil du ScoreWriter prend toutes les lignes
+ * en attente d'un coup et les écrit fichier par fichier, en une seule
+ * écriture suivie d'un seul fdatasync (écriture groupée) : pendant qu'un lot
+ * part sur le disque, le suivant se remplit. La file est bornée : quand
+ * elle est pleine, persistScore attend qu'une place se libère.
+ *
+ * Sans ScoreWriterScope, persistScore écrit la ligne elle-même.
+ */
+#ifndef CANDY_PERSIST_H
+#define CANDY_PERSIST_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "leaderboard.h"
+
+// Lignes en attente au plus
+const std::size_t KScoreQueueCapacity (256);
+
+/**
+ * @struct ScoreRecord
+ * @brief Ligne à ajouter à un fichier de scores
+ */
+struct ScoreRecord {
+    std::string fileName;
+    std::string pseudo;
+    std::uint64_t value;
+};
+
+/**
+ * @brief Ajoute des lignes "valeur pseudo" à la fin d'un fichier de scores (une écriture, un fdatasync)
+ * @return false si le fichier ne peut pas être ouvert ou écrit
+ */
+bool appendScores (const std::string & fileName, const std::vector<RankEntry> & entries);
+
+/**
+ * @brief Fil d'écriture des fichiers de scores
+ */
+class ScoreWriter {
+public:
+    explicit ScoreWriter (std::size_t capacity = KScoreQueueCapacity);
+
+    /**
+     * @brief Ecrit toutes les lignes en attente puis arrête le fil
+     */
+    ~ScoreWriter ();
+    ScoreWriter (const ScoreWriter &) = delete;
+    ScoreWriter & operator= (const ScoreWriter &) = delete;
+
+    /**
+     * @brief Confie une ligne au fil, lancé à la première ligne (attend seulement si la file est pleine)
+     */
+    void append (const std::string & fileName, const std::string & pseudo, std::uint64_t value);
+
+    /**
+     * @brief Attend que toutes les lignes confiées jusqu'ici soient sur le disque
+     * @return false si une écriture a échoué depuis le dernier flush
+     */
+    bool flush ();
+
+    std::uint64_t written () const;
+    std::uint64_t commits () const;
+
+private:
+    void run ();
+
+    mutable std::mutex myMutex;
+    std::condition_variable myWake;    // le fil : lignes en attente ou arrêt
+    std::condition_variable myRoom;    // append : place libre dans la file
+    std::condition_variable myDone;    // flush : lot écrit
+    std::deque<ScoreRecord> myQueue;
+    std::size_t myCapacity;
+    std::uint64_t myQueued;            // lignes confiées
+    std::uint64_t myWritten;           // lignes traitées par le fil (écrites ou en échec)
+    std::uint64_t myCommits;           // fdatasync
+    bool myFailed;
+    bool myStop;
+    std::thread myThread;              // lancé par le premier append
+};
+
+inline thread_local ScoreWriter * tlsScoreWriter = nullptr;
+
+/**
+ * @brief Installe un ScoreWriter pour le fil courant le temps de la portée (nullptr : écriture directe)
+ */
+class ScoreWriterScope {
+public:
+    explicit ScoreWriterScope (ScoreWriter * writer);
+    ~ScoreWriterScope ();
+    ScoreWriterScope (const ScoreWriterScope &) = delete;
+    ScoreWriterScope & operator= (const ScoreWriterScope &) = delete;
+
+private:
+    ScoreWriter * myPrevious;
+};
+
+/**
+ * @brief Ajoute le résultat d'une partie à un fichier de scores
+ * @return false si l'écriture directe a échoué (avec un ScoreWriter, voir ScoreWriter::flush)
+ */
+bool persistScore (const std::string & fileName, const std::string & pseudo, std::uint64_t value);
+
+#endif // CANDY_PERSIST_H
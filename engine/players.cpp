@@ -0,0 +1,78 @@
+#include "players.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+// Cases de l'index au départ (puissance de 2)
+const size_t KInitialSlots (64);
+
+/**
+ * @brief Hachage FNV-1a 64 bits
+ */
+uint64_t hashPseudo (const char * text, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t k = 0; k < length; ++k) {
+        hash ^= uint8_t(text[k]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+PlayerRegistry::PlayerRegistry () {
+    clear();
+}
+
+void PlayerRegistry::clear () {
+    myArena.clear();
+    myOffsets.assign(1, 0);
+    myHashes.clear();
+    mySlots.assign(KInitialSlots, KNoPlayer);
+}
+
+size_t PlayerRegistry::bytes () const {
+    return myArena.capacity() + myOffsets.capacity() * sizeof(uint32_t) + myHashes.capacity() * sizeof(uint64_t)
+         + mySlots.capacity() * sizeof(uint32_t);
+}
+
+uint32_t PlayerRegistry::slotOf (const char * text, size_t length, uint64_t hash) const {
+    const size_t mask = mySlots.size() - 1;
+    for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+        const uint32_t id = mySlots[slot];
+        if (id == KNoPlayer) return slot;
+        if (myHashes[id] == hash && myOffsets[id + 1] - myOffsets[id] == length
+            && memcmp(myArena.data() + myOffsets[id], text, length) == 0) return slot;
+    }
+}
+
+void PlayerRegistry::grow () {
+    mySlots.assign(mySlots.size() * 2, KNoPlayer);
+    const size_t mask = mySlots.size() - 1;
+    for (uint32_t id = 0; id < myHashes.size(); ++id) {
+        size_t slot = myHashes[id] & mask;
+        while (mySlots[slot] != KNoPlayer) slot = (slot + 1) & mask;
+        mySlots[slot] = id;
+    }
+}
+
+uint32_t PlayerRegistry::find (const string & pseudo) const {
+    return mySlots[slotOf(pseudo.data(), pseudo.size(), hashPseudo(pseudo.data(), pseudo.size()))];
+}
+
+uint32_t PlayerRegistry::intern (const string & pseudo) {
+    const uint64_t hash = hashPseudo(pseudo.data(), pseudo.size());
+    uint32_t slot = slotOf(pseudo.data(), pseudo.size(), hash);
+    if (mySlots[slot] != KNoPlayer) return mySlots[slot];
+
+    const uint32_t id = myHashes.size();
+    myArena.insert(myArena.end(), pseudo.begin(), pseudo.end());
+    myOffsets.push_back(myArena.size());
+    myHashes.push_back(hash);
+    mySlots[slot] = id;
+    if (2 * myHashes.size() > mySlots.size()) grow();
+    return id;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file players.h
+ * @brief Registre des joueurs : un numéro de 32 bits par pseudo
+ *
+ * Un même joueur revient des milliers de fois dans les fichiers de scores.
+ * Le registre garde chaque pseudo une seule fois, à la suite des autres
+ * dans une seule zone de caractères, et lui donne un numéro : les
+ * classements ne gardent que ce numéro (entrées de taille fixe, sans
+ * chaîne à copier). L'index est une table de hachage à adressage ouvert
+ * (sondage linéaire), agrandie quand elle est à moitié pleine.
+ */
+#ifndef CANDY_PLAYERS_H
+#define CANDY_PLAYERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Numéro d'un pseudo absent du registre
+const std::uint32_t KNoPlayer (UINT32_MAX);
+
+/**
+ * @brief Pseudos des joueurs rangés sous un numéro
+ */
+class PlayerRegistry {
+public:
+    PlayerRegistry ();
+
+    /**
+     * @brief Numéro du pseudo, ajouté au registre s'il n'y était pas (numéros 0, 1, 2... dans l'ordre d'arrivée)
+     */
+    std::uint32_t intern (const std::string & pseudo);
+
+    /**
+     * @brief Numéro du pseudo (KNoPlayer s'il est absent)
+     */
+    std::uint32_t find (const std::string & pseudo) const;
+
+    /**
+     * @brief Pseudo d'un numéro rendu par intern
+     */
+    std::string pseudo (std::uint32_t id) const {
+        return std::string(myArena.data() + myOffsets[id], myOffsets[id + 1] - myOffsets[id]);
+    }
+
+    /**
+     * @brief Ajoute le pseudo d'un numéro à la fin de text (sans chaîne intermédiaire)
+     */
+    void appendPseudo (std::uint32_t id, std::string & text) const {
+        text.append(myArena.data() + myOffsets[id], myOffsets[id + 1] - myOffsets[id]);
+    }
+
+    std::size_t size () const { return myOffsets.size() - 1; }
+
+    /**
+     * @brief Mémoire occupée par les pseudos et l'index
+     */
+    std::size_t bytes () const;
+
+    void clear ();
+
+private:
+    std::uint32_t slotOf (const char * text, std::size_t length, std::uint64_t hash) const;
+    void grow ();
+
+    std::vector<char> myArena;             // tous les pseudos, à la suite
+    std::vector<std::uint32_t> myOffsets;  // début de chaque pseudo dans myArena, puis la fin du dernier
+    std::vector<std::uint64_t> myHashes;   // hachage de chaque pseudo (agrandissement sans relire les pseudos)
+    std::vector<std::uint32_t> mySlots;    // numéros (KNoPlayer : case vide), taille puissance de 2
+};
+
+#endif // CANDY_PLAYERS_H
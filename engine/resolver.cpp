@@ -0,0 +1,218 @@
+#include "resolver.h"
+#include "events.h"
+#include "history.h"
+#include "spawn.h"
+#include "zobrist.h"
+
+#include <algorithm>
+
+using namespace std;
+
+BandResolver::BandResolver (unsigned nbThreads)
+    : myGeneration(0), myRunning(0), myStop(false), myPhase(PhaseDetect), myNbChunks(0), myNext(0),
+      myGrid(nullptr), myRule(RuleFibonacci), myNbCandies(KNbCandies), myComboLevel(0),
+      myLowest(0) {
+    if (nbThreads == 0) nbThreads = max(1u, thread::hardware_concurrency());
+    for (unsigned t = 0; t + 1 < nbThreads; ++t) myWorkers.emplace_back(&BandResolver::workerLoop, this);
+}
+
+BandResolver::~BandResolver () {
+    {
+        lock_guard<mutex> lock(myMutex);
+        myStop = true;
+    }
+    myWake.notify_all();
+    for (thread & worker : myWorkers) worker.join();
+}
+
+// --- 1. LES FILS ---
+
+void BandResolver::workerLoop () {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(myMutex);
+            myWake.wait(lock, [&] () { return myStop || myGeneration != seen; });
+            if (myStop) return;
+            seen = myGeneration;
+        }
+        runJob();
+        {
+            lock_guard<mutex> lock(myMutex);
+            if (--myRunning == 0) myDone.notify_one();
+        }
+    }
+}
+
+void BandResolver::runPhase (Phase phase, size_t nbChunks) {
+    myPhase = phase;
+    myNbChunks = nbChunks;
+    myNext.store(0, memory_order_relaxed);
+    if (!myWorkers.empty()) {
+        {
+            lock_guard<mutex> lock(myMutex);
+            myRunning = myWorkers.size();
+            myGeneration++;
+        }
+        myWake.notify_all();
+    }
+    runJob();
+    if (!myWorkers.empty()) {
+        unique_lock<mutex> lock(myMutex);
+        myDone.wait(lock, [&] () { return myRunning == 0; });
+    }
+}
+
+void BandResolver::runJob () {
+    // Remplissage uniforme dans le générateur de la colonne, sans hash, événements ni historique du fil appelant
+    // (resolve signale lui-même les colonnes qui tombent)
+    HashScope hashScope(nullptr);
+    EventScope eventScope(nullptr);
+    SpawnScope spawnScope(nullptr);
+    HistoryPause historyPause;
+
+    while (true) {
+        const size_t chunk = myNext.fetch_add(1, memory_order_relaxed);
+        if (chunk >= myNbChunks) break;
+        if (myPhase == PhaseDetect) detectBand(chunk);
+        else fallColumns(chunk);
+    }
+}
+
+// --- 2. LA DETECTION PAR BANDES ---
+
+void BandResolver::detectBand (size_t band) {
+    const mat & grid = *myGrid;
+    const unsigned size = grid.size();
+    const unsigned first = band * KBandRows;
+    const unsigned last = min<unsigned>(size, first + KBandRows);
+    uint64_t cells = 0;
+    uint64_t score = 0;
+    unsigned lowest = 0;
+
+    // Le masque est vide ici : la gravité du pas précédent l'a vidé derrière elle
+    for (unsigned i = first; i < last; ++i) {
+        const line & row = grid[i];
+        const uint64_t * bits = &myMask.bits[size_t(i) * myMask.wordsPerRow];
+
+        // Alignements horizontaux : une seule passe sur la ligne
+        for (unsigned j = 0; j < size; ) {
+            const unsigned type = candyColour(row[j]);
+            unsigned k = j + 1;
+            while (k < size && candyColour(row[k]) == type) k++;
+            if (type != KImpossible && k - j >= 3) {
+                for (unsigned c = j; c < k; ++c) maskSet(myMask, i, c);
+                score = scoreAdd(score, matchScore(myRule, k - j, myComboLevel));
+            }
+            j = k;
+        }
+
+        // Alignements verticaux : deux lignes de halo de chaque côté, seules les cases de la bande sont marquées
+        const line * up1 = i >= 1 ? &grid[i - 1] : nullptr;
+        const line * up2 = i >= 2 ? &grid[i - 2] : nullptr;
+        const line * down1 = i + 1 < size ? &grid[i + 1] : nullptr;
+        const line * down2 = i + 2 < size ? &grid[i + 2] : nullptr;
+        for (unsigned j = 0; j < size; ++j) {
+            const unsigned type = candyColour(row[j]);
+            if (type == KImpossible) continue;
+            const bool above1 = up1 && candyColour((*up1)[j]) == type;
+            const bool above2 = above1 && up2 && candyColour((*up2)[j]) == type;
+            const bool below1 = down1 && candyColour((*down1)[j]) == type;
+            const bool below2 = below1 && down2 && candyColour((*down2)[j]) == type;
+            if (above2 || (above1 && below1) || below2) maskSet(myMask, i, j);
+
+            // Le match est compté par la bande de sa première case, il peut descendre plus bas
+            if (!above1 && below2) {
+                unsigned length = 3;
+                while (i + length < size && candyColour(grid[i + length][j]) == type) length++;
+                score = scoreAdd(score, matchScore(myRule, length, myComboLevel));
+            }
+        }
+        const uint64_t before = cells;
+        for (unsigned w = 0; w < myMask.wordsPerRow; ++w) cells += __builtin_popcountll(bits[w]);
+        if (cells != before) lowest = i + 1;
+    }
+    myBands[band] = Band {cells, score, lowest};
+}
+
+// --- 3. LA GRAVITE PAR COLONNES ---
+
+void BandResolver::fallColumns (size_t chunk) {
+    mat & grid = *myGrid;
+    const unsigned base = chunk * KFallColumns;
+
+    // De bas en haut, depuis la ligne vidée la plus basse : chaque case descend du nombre de cases
+    // vidées au-dessous d'elle dans sa colonne. Le mot du masque est remis à zéro pour le pas suivant.
+    unsigned drop [KFallColumns] = {};
+    uint64_t active = 0;
+    for (int i = int(myLowest) - 1; i >= 0; --i) {
+        uint64_t & word = myMask.bits[size_t(i) * myMask.wordsPerRow + chunk];
+        const uint64_t cleared = word;
+        word = 0;
+        for (uint64_t moving = active & ~cleared; moving; moving &= moving - 1) {
+            const unsigned b = __builtin_ctzll(moving);
+            grid[i + drop[b]][base + b] = grid[i][base + b];
+        }
+        for (uint64_t hit = cleared; hit; hit &= hit - 1) drop[__builtin_ctzll(hit)]++;
+        active |= cleared;
+    }
+
+    for (; active; active &= active - 1) {
+        const unsigned b = __builtin_ctzll(active);
+        RandomScope randomScope(&myRandom[base + b]);
+        refillColumn(grid, base + b, 0, drop[b] - 1, myNbCandies);
+    }
+}
+
+// --- 4. LA REACTION EN CHAINE ---
+
+ResolveReport BandResolver::resolve (mat & grid, ScoreRule rule, unsigned nbCandies, uint64_t seed) {
+    const unsigned size = grid.size();
+    ResolveReport report = {0, 0, 0};
+    if (size < 3) return report;
+
+    myGrid = &grid;
+    myRule = rule;
+    myNbCandies = nbCandies;
+    maskReset(myMask, size);
+    myBands.resize((size + KBandRows - 1) / KBandRows);
+    myRandom.resize(size);
+    for (unsigned j = 0; j < size; ++j) myRandom[j] = forkSeed(seed, j);
+
+    // Lignes à relire : toute la grille au premier pas, puis seulement les lignes qui ont bougé
+    // (au-dessus de la case vidée la plus basse) et les deux lignes au-dessous qu'elles touchent
+    unsigned dirtyRows = size;
+    while (true) {
+        myComboLevel = report.steps + 1;
+        const size_t nbBands = (dirtyRows + KBandRows - 1) / KBandRows;
+        runPhase(PhaseDetect, nbBands);
+        uint64_t cells = 0;
+        uint64_t score = 0;
+        myLowest = 0;
+        for (size_t b = 0; b < nbBands; ++b) {
+            cells += myBands[b].cells;
+            score = scoreAdd(score, myBands[b].score);
+            myLowest = max(myLowest, myBands[b].lowest);
+        }
+        if (cells == 0) break;
+
+        // Les fils de calcul ne voient pas l'historique du fil appelant : les colonnes qui vont tomber lui sont signalées ici
+        if (tlsHistory) {
+            vector<uint64_t> falling(myMask.wordsPerRow, 0);
+            for (unsigned i = 0; i < myLowest; ++i)
+                for (unsigned w = 0; w < myMask.wordsPerRow; ++w) falling[w] |= myMask.bits[size_t(i) * myMask.wordsPerRow + w];
+            for (unsigned w = 0; w < myMask.wordsPerRow; ++w)
+                for (uint64_t bits = falling[w]; bits; bits &= bits - 1)
+                    historyColumn(grid, w * 64 + __builtin_ctzll(bits), 0, int(myLowest) - 1);
+        }
+        runPhase(PhaseFall, myMask.wordsPerRow);
+        report.steps++;
+        report.cleared += cells;
+        report.score = scoreAdd(report.score, score);
+        dirtyRows = min(size, myLowest + 2);
+        emitEvent(EventCascadeStep, 0, report.steps, 0, 0, 0);
+    }
+    if (tlsBoardHash) *tlsBoardHash = boardHash(grid);
+    myGrid = nullptr;
+    return report;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file resolver.h
+ * @brief Réaction en chaîne des très grandes grilles, détection et gravité réparties entre les fils
+ *
+ * Sur une grande grille, resolveCascade ne supprime qu'un match par pas et
+ * relit la grille sur un seul fil. BandResolver supprime à chaque pas tous
+ * les matchs de la grille à la fois, en deux phases séparées par une
+ * attente de tous les fils :
+ *   1. détection : la grille est découpée en bandes de KBandRows lignes.
+ *      Chaque bande lit deux lignes de plus au-dessus et au-dessous (le
+ *      halo) et marque ses propres cases alignées dans un masque partagé :
+ *      deux fils n'écrivent jamais le même mot ;
+ *   2. gravité et remplissage : par paquets de 64 colonnes (un mot du
+ *      masque). Chaque colonne tire ses bonbons dans son propre générateur
+ *      (forkSeed de la graine et de la colonne, voir spawn.h).
+ * Seules les lignes qui ont bougé peuvent former un nouveau match : après
+ * le premier pas, la détection ne relit que les lignes au-dessus de la case
+ * vidée la plus basse, plus deux.
+ * Pour une même grille et une même graine, le résultat est le même quel
+ * que soit le nombre de fils.
+ *
+ * Règles de la partie libre (main.cpp) : les bonbons spéciaux sont vidés
+ * comme des bonbons ordinaires et la grille ne doit pas avoir de cases
+ * fixes. Tous les matchs d'un pas ont le même niveau de combo.
+ */
+#ifndef CANDY_RESOLVER_H
+#define CANDY_RESOLVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "grid.h"
+#include "score.h"
+#include "special.h"
+
+// Lignes d'une bande de détection
+const unsigned KBandRows (16);
+
+// Colonnes d'un paquet de gravité (un mot du masque)
+const unsigned KFallColumns (64);
+
+/**
+ * @struct ResolveReport
+ * @brief Bilan d'une réaction en chaîne
+ */
+struct ResolveReport {
+    unsigned steps;             // pas (niveau de combo atteint)
+    std::uint64_t cleared;      // cases vidées
+    std::uint64_t score;        // points de tous les matchs (saturés)
+};
+
+/**
+ * @brief Résout les réactions en chaîne sur un groupe de fils
+ */
+class BandResolver {
+public:
+    /**
+     * @param nbThreads Fils de calcul, fil appelant compris (0 : un par cœur)
+     */
+    explicit BandResolver (unsigned nbThreads = 0);
+    ~BandResolver ();
+    BandResolver (const BandResolver &) = delete;
+    BandResolver & operator= (const BandResolver &) = delete;
+
+    /**
+     * @brief Résout toute la réaction en chaîne de la grille
+     * @param grid Grille (sans case fixe)
+     * @param rule Règle de score de chaque match
+     * @param nbCandies Nombre de types de bonbons pour le remplissage
+     * @param seed Graine des remplissages
+     *
+     * Chaque match (suite de 3 ou plus sur une ligne ou une colonne) rapporte
+     * ses points au niveau de combo du pas. Le hash d'un HashScope du fil
+     * appelant est recalculé à la fin ; un EventScope reçoit un pas de
+     * cascade par pas.
+     */
+    ResolveReport resolve (mat & grid, ScoreRule rule, unsigned nbCandies, std::uint64_t seed);
+
+    unsigned threads () const { return myWorkers.size() + 1; }
+
+private:
+    enum Phase {
+        PhaseDetect,
+        PhaseFall
+    };
+
+    /**
+     * @brief Résultat de la détection d'une bande
+     */
+    struct Band {
+        std::uint64_t cells;
+        std::uint64_t score;
+        unsigned lowest;               // ligne sous la case marquée la plus basse (0 : aucune)
+    };
+
+    void workerLoop ();
+    void runPhase (Phase phase, std::size_t nbChunks);
+    void runJob ();
+    void detectBand (std::size_t band);
+    void fallColumns (std::size_t chunk);
+
+    std::vector<std::thread> myWorkers;
+
+    std::mutex myMutex;
+    std::condition_variable myWake;
+    std::condition_variable myDone;
+    std::uint64_t myGeneration;        // numéro de la phase en cours
+    unsigned myRunning;                // fils encore au travail
+    bool myStop;
+
+    // Phase en cours
+    Phase myPhase;
+    std::size_t myNbChunks;
+    std::atomic<std::size_t> myNext;
+
+    // Réaction en chaîne en cours
+    mat * myGrid;
+    ScoreRule myRule;
+    unsigned myNbCandies;
+    unsigned myComboLevel;
+    unsigned myLowest;                 // lignes touchées par la gravité du pas en cours
+    BoardMask myMask;                  // cases alignées du pas en cours
+    std::vector<Band> myBands;
+    std::vector<std::uint64_t> myRandom;   // générateur de chaque colonne
+};
+
+#endif // CANDY_RESOLVER_H
@@ -0,0 +1,122 @@
+/**
+ * @file score.h
+ * @brief Calcul du score : une table constexpr par règle, arithmétique 64 bits saturante
+ *
+ * Les points d'un match ne dépendent que de la règle, de la longueur du match
+ * et du niveau de combo. Ils sont calculés une fois pour toutes à la
+ * compilation : en partie, un match coûte une seule lecture de table. Les
+ * matchs trop longs ou les combos trop profonds pour la table (rares, grandes
+ * grilles) passent par le même calcul qu'à la compilation.
+ *
+ * Les totaux saturent à KScoreMax au lieu de repasser par zéro.
+ */
+#ifndef CANDY_SCORE_H
+#define CANDY_SCORE_H
+
+#include <cstdint>
+
+/**
+ * @brief Règles de calcul des points d'un match
+ */
+enum ScoreRule {
+    RuleFibonacci,  // 100 * F(howMany) : partie libre (3 -> 200, 4 -> 300, 5 -> 500...)
+    RuleLinear,     // howMany * 2, sans bonus de combo
+    RuleCombo,      // howMany * 2 * comboLevel : modes du menu
+    KNbScoreRules
+};
+
+// Score maximal : les additions et multiplications saturent à cette valeur
+const std::uint64_t KScoreMax (UINT64_MAX);
+
+// Dimensions des tables : longueurs de match 0..63, niveaux de combo 0..15
+const unsigned KScoreTableLengths (64);
+const unsigned KScoreTableCombos (16);
+
+/**
+ * @brief Addition qui sature à KScoreMax
+ */
+constexpr std::uint64_t scoreAdd (std::uint64_t a, std::uint64_t b) {
+    return a > KScoreMax - b ? KScoreMax : a + b;
+}
+
+/**
+ * @brief Multiplication qui sature à KScoreMax
+ */
+constexpr std::uint64_t scoreMul (std::uint64_t a, std::uint64_t b) {
+    return (a != 0 && b > KScoreMax / a) ? KScoreMax : a * b;
+}
+
+/**
+ * @brief n-ième terme de la suite de Fibonacci (F(0) = 0, F(1) = 1), saturé
+ */
+constexpr std::uint64_t scoreFibonacci (unsigned n) {
+    std::uint64_t a = 0;
+    std::uint64_t b = 1;
+    for (unsigned i = 0; i < n; ++i) {
+        if (a == KScoreMax) break;
+        std::uint64_t c = scoreAdd(a, b);
+        a = b;
+        b = c;
+    }
+    return a;
+}
+
+/**
+ * @brief Points d'un match, calculés sans table
+ * @param rule Règle de calcul
+ * @param howMany Nombre de bonbons du match (moins de 3 : aucun point)
+ * @param comboLevel Niveau de combo (1 pour le premier match du coup)
+ * @return Points gagnés, saturés à KScoreMax
+ */
+constexpr std::uint64_t computeMatchScore (ScoreRule rule, unsigned howMany, unsigned comboLevel) {
+    if (howMany < 3) return 0;
+    switch (rule) {
+    case RuleFibonacci: return scoreMul(scoreFibonacci(howMany), 100);
+    case RuleLinear: return scoreMul(howMany, 2);
+    case RuleCombo: return scoreMul(scoreMul(howMany, 2), comboLevel);
+    default: return 0;
+    }
+}
+
+/**
+ * @struct ScoreTable
+ * @brief Points d'une règle pour chaque niveau de combo et chaque longueur de match
+ */
+struct ScoreTable {
+    std::uint64_t points[KScoreTableCombos][KScoreTableLengths];
+};
+
+constexpr ScoreTable makeScoreTable (ScoreRule rule) {
+    ScoreTable table {};
+    for (unsigned combo = 0; combo < KScoreTableCombos; ++combo)
+        for (unsigned length = 0; length < KScoreTableLengths; ++length)
+            table.points[combo][length] = computeMatchScore(rule, length, combo);
+    return table;
+}
+
+// Tables générées à la compilation, dans l'ordre de ScoreRule
+inline constexpr ScoreTable KScoreTables[KNbScoreRules] = {
+    makeScoreTable(RuleFibonacci),
+    makeScoreTable(RuleLinear),
+    makeScoreTable(RuleCombo),
+};
+
+/**
+ * @brief Points d'un match : une lecture de table
+ * @param rule Règle de calcul
+ * @param howMany Nombre de bonbons du match
+ * @param comboLevel Niveau de combo (1 pour le premier match du coup)
+ * @return Points gagnés, saturés à KScoreMax
+ */
+inline std::uint64_t matchScore (ScoreRule rule, unsigned howMany, unsigned comboLevel) {
+    if (howMany < KScoreTableLengths && comboLevel < KScoreTableCombos)
+        return KScoreTables[rule].points[comboLevel][howMany];
+    return computeMatchScore(rule, howMany, comboLevel);
+}
+
+static_assert(KScoreTables[RuleFibonacci].points[1][3] == 200, "3 bonbons : F(3) * 100");
+static_assert(KScoreTables[RuleFibonacci].points[1][5] == 500, "5 bonbons : F(5) * 100");
+static_assert(KScoreTables[RuleCombo].points[3][4] == 24, "4 bonbons au combo 3");
+static_assert(computeMatchScore(RuleFibonacci, 200, 1) == KScoreMax, "Fibonacci sature");
+
+#endif // CANDY_SCORE_H
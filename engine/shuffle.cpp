@@ -0,0 +1,206 @@
+#include "shuffle.h"
+#include "history.h"
+#include "zobrist.h"
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Une réserve de bonbons par couleur (0 : les bombes)
+const unsigned KNbColours (KColourMask + 1);
+
+// Rôle de chaque case pendant le mélange
+enum CellRole : unsigned char {
+    RoleFixed,   // trou, bloqueur ou case vide : ne bouge pas
+    RoleFill,    // remplie ligne par ligne
+    RoleSeed     // un des trois bonbons du coup garanti
+};
+
+/**
+ * @brief Couleur d'une case, KImpossible hors de la grille
+ */
+unsigned colourAt (const mat & grid, int ord, int abs) {
+    const int size = grid.size();
+    if (ord < 0 || abs < 0 || ord >= size || abs >= size) return KImpossible;
+    return candyColour(grid[ord][abs]);
+}
+
+/**
+ * @brief Couleurs qui complèteraient un alignement en (ord, abs) avec deux cases déjà posées (un bit par couleur)
+ *
+ * Six fenêtres de deux voisins, sur la ligne et sur la colonne de la case :
+ * les deux d'avant, un de chaque côté, les deux d'après.
+ */
+unsigned forbiddenColours (const mat & grid, int ord, int abs) {
+    const int KWindows [3][2] = {{-2, -1}, {-1, 1}, {1, 2}};
+    unsigned forbidden = 0;
+    for (const auto & w : KWindows) {
+        const unsigned row = colourAt(grid, ord, abs + w[0]);
+        if (row == colourAt(grid, ord, abs + w[1])) forbidden |= 1u << row;
+        const unsigned column = colourAt(grid, ord + w[0], abs);
+        if (column == colourAt(grid, ord + w[1], abs)) forbidden |= 1u << column;
+    }
+    // Deux cases vides (ou deux bombes) n'interdisent rien
+    return forbidden & ~(1u << KImpossible);
+}
+
+/**
+ * @brief Cherche trois cases à mélanger en « deux côte à côte et un en diagonale »
+ * @param[out] seed (a, b, m) : a et b côte à côte, m voisin de la case qui suit b ;
+ *                  échanger m avec cette case aligne a, b et m
+ * @return false si aucune fenêtre 2x3 (ou 3x2) n'a ses quatre cases à mélanger
+ */
+bool findSeed (const vector<CellRole> & roles, unsigned size, maPosition seed [3]) {
+    auto fill = [&] (unsigned i, unsigned j) { return roles[size_t(i) * size + j] == RoleFill; };
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            // Horizontal : (i, j) (i, j+1), m en (i+1, j+2) sous la case (i, j+2)
+            if (i + 1 < size && j + 2 < size && fill(i, j) && fill(i, j + 1) && fill(i, j + 2) && fill(i + 1, j + 2)) {
+                seed[0] = {j, i};
+                seed[1] = {j + 1, i};
+                seed[2] = {j + 2, i + 1};
+                return true;
+            }
+            // Vertical : (i, j) (i+1, j), m en (i+2, j+1) à droite de la case (i+2, j)
+            if (i + 2 < size && j + 1 < size && fill(i, j) && fill(i + 1, j) && fill(i + 2, j) && fill(i + 2, j + 1)) {
+                seed[0] = {j, i};
+                seed[1] = {j, i + 1};
+                seed[2] = {j + 1, i + 2};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Couleur la plus nombreuse dans les réserves (à égalité : la plus petite)
+ * @param forbidden Couleurs exclues (un bit par couleur)
+ * @return KNbColours si aucune couleur ne convient
+ */
+unsigned pickColour (const vector<unsigned> pools [], unsigned forbidden) {
+    unsigned best = KNbColours;
+    for (unsigned colour = 0; colour < KNbColours; ++colour) {
+        if (pools[colour].empty() || (forbidden >> colour) & 1) continue;
+        if (best == KNbColours || pools[colour].size() > pools[best].size()) best = colour;
+    }
+    return best;
+}
+
+unsigned takeCandy (vector<unsigned> pools [], unsigned colour) {
+    const unsigned cell = pools[colour].back();
+    pools[colour].pop_back();
+    return cell;
+}
+
+} // namespace
+
+bool hasLegalMove (mat & grid) {
+    const unsigned size = grid.size();
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            const maPosition here = {j, i};
+            if (isLegalMove(grid, here, 'D') || isLegalMove(grid, here, 'S')) return true;
+        }
+    }
+    return false;
+}
+
+bool reshuffleGrid (mat & grid) {
+    const unsigned size = grid.size();
+
+    // --- 1. Les bonbons à mélanger, rangés par couleur ---
+    vector<CellRole> roles (size_t(size) * size, RoleFixed);
+    vector<unsigned> original;
+    vector<unsigned> pools [KNbColours];
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            const unsigned cell = grid[i][j];
+            if (cell == KImpossible || isFixedCell(cell)) continue;
+            roles[size_t(i) * size + j] = RoleFill;
+            original.push_back(cell);
+            pools[candyColour(cell)].push_back(cell);
+        }
+    }
+
+    // Les cases vidées valent KImpossible : sans couleur, elles ne comptent dans aucun alignement
+    for (unsigned j = 0; j < size; ++j) {
+        hashColumn(grid, j, 0, int(size) - 1);
+        historyColumn(grid, j, 0, int(size) - 1);
+    }
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            if (roles[size_t(i) * size + j] == RoleFill) grid[i][j] = KImpossible;
+        }
+    }
+
+    // --- 2. Le coup garanti : trois bonbons de la couleur la plus nombreuse ---
+    unsigned seedColour = KImpossible;
+    for (unsigned colour = 1; colour < KNbColours; ++colour) {
+        if (pools[colour].size() >= 3 && pools[colour].size() > pools[seedColour].size()) seedColour = colour;
+    }
+    maPosition seed [3];
+    if (seedColour != KImpossible && findSeed(roles, size, seed)) {
+        for (const maPosition & p : seed) {
+            grid[p.ord][p.abs] = takeCandy(pools, seedColour);
+            roles[size_t(p.ord) * size + p.abs] = RoleSeed;
+        }
+    }
+
+    // --- 3. Les autres cases, ligne par ligne ---
+    // Les réparations cherchent une case d'échange parmi les cases déjà remplies
+    // à partir de repair, qui ne recule jamais : coût total linéaire
+    size_t repair = 0;
+    bool stuck = false;
+    for (unsigned i = 0; i < size && !stuck; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            const size_t here = size_t(i) * size + j;
+            if (roles[here] != RoleFill) continue;
+
+            const unsigned colour = pickColour(pools, forbiddenColours(grid, i, j));
+            if (colour != KNbColours) {
+                grid[i][j] = takeCandy(pools, colour);
+                continue;
+            }
+
+            // Toutes les couleurs restantes sont interdites ici : la case prend la
+            // couleur d'une case déjà remplie, qui reçoit à la place la plus nombreuse
+            const unsigned cell = takeCandy(pools, pickColour(pools, 0));
+            bool repaired = false;
+            for (; repair < here && !repaired; ++repair) {
+                if (roles[repair] != RoleFill) continue;
+                const unsigned ord = repair / size;
+                const unsigned abs = repair % size;
+                const unsigned old = grid[ord][abs];
+                if (candyColour(old) == candyColour(cell)) continue;
+                grid[ord][abs] = cell;
+                grid[i][j] = old;
+                repaired = !hasMatchAt(grid, ord, abs) && !hasMatchAt(grid, i, j);
+                if (!repaired) {
+                    grid[ord][abs] = old;
+                    grid[i][j] = KImpossible;
+                }
+            }
+            if (!repaired) {
+                stuck = true;
+                break;
+            }
+        }
+    }
+
+    // --- 4. Vérification : aucun match et au moins un coup, sinon la grille d'origine revient ---
+    const bool shuffled = !stuck && !checkInitialMatch(grid) && hasLegalMove(grid);
+    if (!shuffled) {
+        size_t k = 0;
+        for (unsigned i = 0; i < size; ++i) {
+            for (unsigned j = 0; j < size; ++j) {
+                if (roles[size_t(i) * size + j] != RoleFixed) grid[i][j] = original[k++];
+            }
+        }
+    }
+    for (unsigned j = 0; j < size; ++j) hashColumn(grid, j, 0, int(size) - 1);
+    return shuffled;
+}
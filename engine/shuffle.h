@@ -0,0 +1,42 @@
+/**
+ * @file shuffle.h
+ * @brief Grilles bloquées : détection de l'absence de coup et mélange des bonbons
+ *
+ * Après une réaction en chaîne, la grille peut ne plus offrir aucun échange
+ * qui crée un match. Les modes mélangent alors les bonbons en place : mêmes
+ * bonbons (couleurs et spéciaux), cases fixes inchangées, aucun match et au
+ * moins un coup dans la nouvelle disposition.
+ *
+ * Le mélange se fait en un seul passage, sans tirage au hasard ni nouvel
+ * essai en cas d'échec (contrairement à initGrid) :
+ *   1. trois bonbons de la couleur la plus nombreuse sont posés en « deux
+ *      côte à côte et un en diagonale » : un coup est garanti ;
+ *   2. les autres cases sont remplies ligne par ligne avec la couleur qui
+ *      reste en plus grand nombre parmi celles qui ne complètent aucun
+ *      alignement avec les cases déjà posées ;
+ *   3. si toutes les couleurs restantes sont interdites sur une case, elle
+ *      échange sa couleur avec une case déjà posée où les deux couleurs
+ *      passent ; les cases refusées ne sont plus jamais réexaminées.
+ * Le temps est donc linéaire en nombre de cases (le nombre de couleurs est
+ * borné par KColourMask).
+ */
+#ifndef CANDY_SHUFFLE_H
+#define CANDY_SHUFFLE_H
+
+#include "grid.h"
+
+/**
+ * @brief Regarde s'il reste au moins un échange légal (voir isLegalMove)
+ * @param grid Grille (les échanges essayés sont annulés)
+ */
+bool hasLegalMove (mat & grid);
+
+/**
+ * @brief Mélange les bonbons de la grille : aucun match et au moins un coup légal
+ * @param grid Grille sans case vide
+ * @return false si les bonbons ne le permettent pas (une ou deux couleurs seulement,
+ *         grille trop petite) : la grille est alors inchangée
+ */
+bool reshuffleGrid (mat & grid);
+
+#endif // CANDY_SHUFFLE_H
@@ -0,0 +1,200 @@
+#include "simulation.h"
+#include "events.h"
+#include "instrument.h"
+#include "level.h"
+#include "shuffle.h"
+#include "spawn.h"
+#include "special.h"
+#include "trace.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Tirage du robot : rand(), ou son générateur privé (partie à graine)
+ */
+unsigned botRandom (uint64_t * state) {
+    if (!state) return rand();
+    RandomScope randomScope(state);
+    return spawnRandom();
+}
+
+/**
+ * @brief Choisit au hasard un coup légal, ou un échange quelconque s'il n'y en a aucun
+ * @param bot Générateur du robot (nul : rand())
+ * @return true si le coup choisi est légal
+ */
+bool chooseMove (mat & grid, maPosition & pos, char & direction, uint64_t * bot) {
+    const unsigned size = grid.size();
+    vector<maPosition> candidates;
+    vector<char> directions;
+
+    // Chaque échange est testé une seule fois : vers la droite et vers le bas
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            maPosition here = {j, i};
+            if (isLegalMove(grid, here, 'D')) {
+                candidates.push_back(here);
+                directions.push_back('D');
+            }
+            if (isLegalMove(grid, here, 'S')) {
+                candidates.push_back(here);
+                directions.push_back('S');
+            }
+        }
+    }
+
+    if (candidates.empty()) {
+        pos = {botRandom(bot) % (size - 1), botRandom(bot) % size};
+        direction = 'D';
+        return false;
+    }
+    unsigned k = botRandom(bot) % candidates.size();
+    pos = candidates[k];
+    direction = directions[k];
+    return true;
+}
+
+/**
+ * @brief Robot glouton : le coup légal qui rapporte le plus, évalué avec les règles de la partie
+ * @return false s'il n'y a aucun coup légal (pos et direction ne changent pas)
+ */
+bool chooseBestMove (MoveEvaluator & robot, const mat & grid, const EvalConfig & config, maPosition & pos,
+                     char & direction) {
+    vector<MoveScore> best;
+    robot.evaluate(grid, config, best);
+    if (best.empty()) return false;
+    pos = best[0].pos;
+    direction = best[0].direction;
+    return true;
+}
+
+} // namespace
+
+SimResult simulateGame (const SimConfig & config) {
+    // Partie à graine : la grille et les remplissages viennent de la graine du jeu, le robot de la sienne
+    const bool seeded = config.boardSeed && !config.level;
+    uint64_t spawnState = 0;
+    uint64_t botState = seeded ? forkSeed(*config.boardSeed, config.seed) : 0;
+    uint64_t * bot = seeded ? &botState : nullptr;
+    if (!seeded) srand(config.seed);
+
+    mat grid;
+    mat jelly;
+    GameMode mode = config.mode;
+    unsigned nbCandies = config.nbCandies;
+    unsigned maxMoves = KMaxMoves;
+    unsigned timeLimit = KTimeLimit;
+    uint64_t targetScore = KTargetScore;
+    unsigned maxTargetMoves = KSimMaxTargetMoves;
+    if (config.level) {
+        const LevelRecord & level = *config.level->record;
+        initLevelGrid(*config.level, grid, jelly);
+        mode = GameMode(level.mode);
+        nbCandies = level.nbCandies;
+        maxMoves = maxTargetMoves = level.maxMoves;
+        timeLimit = level.timeLimit;
+        targetScore = level.targetScore;
+    }
+    else if (seeded) {
+        seedGame(*config.boardSeed, config.gridSize, nbCandies, grid, spawnState);
+    }
+    else {
+        initGrid(grid, config.gridSize, nbCandies);
+    }
+    RandomScope randomScope(seeded ? &spawnState : tlsSpawnRandom);
+    // Remplissage : politique du niveau, poids demandés, ou tirage uniforme historique
+    SpawnPolicy spawn(nbCandies);
+    SpawnPolicy * policy = nullptr;
+    if (config.level) {
+        initLevelSpawn(*config.level, spawn);
+        policy = &spawn;
+    }
+    else if (config.spawnWeights && spawn.setWeights(config.spawnWeights, nbCandies)) {
+        policy = &spawn;
+    }
+    SpawnScope spawnScope(policy);
+
+    BoardMask cleared;
+    BoardMask * clearedOut = config.level ? &cleared : nullptr;
+    unsigned jellyCount = config.level ? jellyLeft(jelly) : 0;
+
+    SimResult result = {0, 0, 0, 0, 0, 0, 0, 0, false};
+    const ScoreRule rule = scoreRuleFor(mode);
+    EvalConfig robotConfig = {rule, true, false, nbCandies, 1, 0, 0, policy};
+    unsigned elapsedTime = 0;
+
+    while (true) {
+        if (mode == ModeClassic && result.moves >= maxMoves) break;
+        if (mode == ModeTimeTrial && elapsedTime >= timeLimit) break;
+        if (mode == ModeTarget && ((result.score >= targetScore && jellyCount == 0) || result.moves >= maxTargetMoves)) break;
+
+        // Grille de départ ou réaction en chaîne sans coup légal : mélange, comme dans les modes
+        if (!hasLegalMove(grid)) {
+            if (result.firstBlocked == 0) result.firstBlocked = result.moves + 1;
+            if (reshuffleGrid(grid)) result.reshuffles++;
+        }
+
+        maPosition pos;
+        char direction;
+        if (config.robot) {
+            // Graine des essais du robot : propre à la partie et au coup, rand() n'avance pas
+            robotConfig.seed = forkSeed(config.seed, result.moves);
+            if (!chooseBestMove(*config.robot, grid, robotConfig, pos, direction) && !chooseMove(grid, pos, direction, bot))
+                result.deadMoves++;
+        }
+        else if (!chooseMove(grid, pos, direction, bot)) {
+            result.deadMoves++;
+        }
+        CANDY_TRACE_BEGIN("coup");
+        makeAMove(grid, pos, direction);
+        result.moves++;
+        elapsedTime += 2 + botRandom(bot) % 3;
+
+        // Bombe échangée : compte comme le premier pas de la réaction en chaîne
+        unsigned comboLevel = 0;
+        unsigned bombed = activateSwap(grid, pos, direction, nbCandies, clearedOut);
+        if (bombed > 0) {
+            if (clearedOut) jellyCount -= peelJelly(jelly, cleared);
+            comboLevel++;
+            result.matches++;
+            result.score = scoreAdd(result.score, matchScore(rule, bombed, comboLevel));
+            emitScoredStep(comboLevel, result.score);
+        }
+
+        // Boucle de réaction en chaîne (même ordre que les modes de jeu)
+        while (true) {
+            CANDY_TRACE_SCOPE_ARG("pas_de_cascade", comboLevel + 1);
+            unsigned howMany = 0;
+            maPosition matchPos;
+            if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
+                howMany = clearMatch(grid, matchPos, howMany, MatchVertical, nbCandies, clearedOut);
+            }
+            else if (atLeastThreeInARow(grid, matchPos, howMany)) {
+                howMany = clearMatch(grid, matchPos, howMany, MatchHorizontal, nbCandies, clearedOut);
+            }
+            else {
+                break;
+            }
+            if (clearedOut) jellyCount -= peelJelly(jelly, cleared);
+            comboLevel++;
+            CANDY_COUNT(CounterCascadeSteps, 1);
+            result.matches++;
+            result.score = scoreAdd(result.score, matchScore(rule, howMany, comboLevel));
+            emitScoredStep(comboLevel, result.score);
+        }
+        CANDY_MOVE_DONE(comboLevel);
+        CANDY_TRACE_END("coup");
+        if (comboLevel > result.maxCombo) result.maxCombo = comboLevel;
+    }
+
+    emitEvent(EventGameOver, 0, result.moves, 0, 0, result.score);
+    result.jellyRemaining = jellyCount;
+    if (config.level) result.reachedTarget = result.score >= targetScore && jellyCount == 0;
+    else result.reachedTarget = (mode == ModeTarget && result.score >= targetScore);
+    return result;
+}
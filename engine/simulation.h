@@ -0,0 +1,71 @@
+/**
+ * @file simulation.h
+ * @brief Parties jouées sans terminal par un robot, pour les mesures et le réglage du jeu
+ *
+ * Une partie simulée suit exactement les règles des modes de rafael/main.cpp
+ * (coups comptés même sans match, combos, objectifs) mais le joueur est
+ * remplacé par un robot qui tire un coup légal au hasard, ou qui joue le coup
+ * qui rapporte le plus (robot glouton, avec un MoveEvaluator). Comme dans
+ * les modes, une grille sans coup légal est mélangée avant le coup suivant.
+ * Avec la même graine, une partie est toujours identique.
+ *
+ * Une partie à graine (boardSeed, celle du défi du jour) a la grille et les
+ * remplissages de la graine, quelle que soit seed : seed ne change que les
+ * coups du robot, tirés dans son propre générateur. Ces parties ne touchent
+ * pas à rand() et peuvent être jouées en parallèle.
+ */
+#ifndef CANDY_SIMULATION_H
+#define CANDY_SIMULATION_H
+
+#include "evaluator.h"
+#include "game.h"
+#include "grid.h"
+#include "level.h"
+#include "spawn.h"
+
+/**
+ * @struct SimConfig
+ * @brief Paramètres d'une partie simulée
+ */
+struct SimConfig {
+    GameMode mode;
+    unsigned seed;
+    unsigned gridSize;
+    unsigned nbCandies;
+    const LevelView * level;  // si non nul : mode, grille, bonbons et objectifs du niveau
+    const unsigned * spawnWeights;  // si non nul (sans niveau) : poids d'apparition des nbCandies couleurs
+    MoveEvaluator * robot;          // si non nul : robot glouton (meilleur coup), sinon coup au hasard
+    const std::uint64_t * boardSeed;  // si non nul (sans niveau) : partie à graine (seedGame), seed ne tire que le robot
+};
+
+/**
+ * @struct SimResult
+ * @brief Bilan d'une partie simulée
+ */
+struct SimResult {
+    std::uint64_t score;
+    unsigned moves;          // coups joués
+    unsigned matches;        // matchs supprimés (tous pas de cascade confondus)
+    unsigned maxCombo;       // plus longue réaction en chaîne
+    unsigned deadMoves;      // coups joués faute de coup légal (le mélange n'a pas suffi)
+    unsigned reshuffles;     // grilles bloquées mélangées (voir shuffle.h)
+    unsigned firstBlocked;   // coup devant lequel la grille était bloquée pour la première fois (0 : jamais)
+    unsigned jellyRemaining; // couches de gelée restantes en fin de partie (niveaux)
+    bool reachedTarget;      // objectif atteint : score cible (et toute la gelée pour un niveau)
+};
+
+// Nombre maximal de coups en Mode Cible avant d'abandonner la partie
+const unsigned KSimMaxTargetMoves (500);
+
+/**
+ * @brief Joue une partie complète sans affichage
+ * @param config Mode, graine, taille de grille et nombre de bonbons, ou niveau
+ * @return Bilan de la partie
+ *
+ * En Contre-la-montre le temps est simulé : le robot met entre 2 et 4
+ * secondes par coup. Sur un niveau, les limites de coups et de temps et le
+ * score cible sont ceux du niveau, pour tous les modes.
+ */
+SimResult simulateGame (const SimConfig & config);
+
+#endif // CANDY_SIMULATION_H
@@ -0,0 +1,334 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const uint8_t KSnapshotVersion (1);
+const uint8_t KFlagJelly (1);
+const uint8_t KFlagSpawn (2);
+const size_t KSnapshotHeader (30);   // version à nombre d'exceptions
+const size_t KExceptionBytes (5);    // position (32 bits) et valeur de la case
+
+/**
+ * @struct RecordHeader
+ * @brief En-tête d'un enregistrement de la sauvegarde ou du journal, suivi de l'instantané
+ */
+struct RecordHeader {
+    uint32_t length;     // octets de l'instantané
+    uint32_t sequence;   // numéro du point de reprise (croissant)
+    uint32_t checksum;   // FNV-1a du numéro et de l'instantané
+};
+
+uint32_t fnv1a (const uint8_t * data, size_t bytes, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < bytes; ++i) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+uint32_t recordChecksum (uint32_t sequence, const uint8_t * data, size_t bytes) {
+    return fnv1a(data, bytes, fnv1a(reinterpret_cast<const uint8_t *>(&sequence), sizeof(sequence)));
+}
+
+/**
+ * @brief Ecriture d'un instantané dans un tampon déjà dimensionné
+ */
+struct Writer {
+    uint8_t * at;
+
+    template <class T>
+    void put (T value) {
+        memcpy(at, &value, sizeof(T));
+        at += sizeof(T);
+    }
+};
+
+/**
+ * @brief Lecture bornée d'un instantané
+ */
+struct Reader {
+    const uint8_t * data;
+    size_t bytes;
+    size_t at;
+
+    template <class T>
+    bool get (T & value) {
+        if (bytes - at < sizeof(T)) return false;
+        memcpy(&value, data + at, sizeof(T));
+        at += sizeof(T);
+        return true;
+    }
+};
+
+/**
+ * @brief Ecrit un quartet par case, ligne par ligne (deux cases par octet)
+ * @param nibble Quartet d'une valeur de la matrice
+ */
+template <class Nibble>
+void putNibbles (Writer & out, const mat & values, Nibble nibble) {
+    uint8_t pair = 0;
+    bool high = false;   // un quartet de la ligne précédente attend sa moitié haute
+    for (const line & row : values) {
+        size_t j = 0;
+        if (high && !row.empty()) {
+            *out.at++ = pair | (nibble(row[0]) << 4);
+            high = false;
+            j = 1;
+        }
+        for (; j + 1 < row.size(); j += 2) *out.at++ = nibble(row[j]) | (nibble(row[j+1]) << 4);
+        if (j < row.size()) {
+            pair = nibble(row[j]);
+            high = true;
+        }
+    }
+    if (high) *out.at++ = pair;
+}
+
+void getNibbles (const uint8_t * data, mat & values, unsigned size) {
+    values.assign(size, line(size));
+    size_t i = 0;
+    for (line & row : values) {
+        for (unsigned & value : row) {
+            value = (data[i / 2] >> (4 * (i % 2))) & 0xF;
+            ++i;
+        }
+    }
+}
+
+string journalName (const string & fileName) {
+    return fileName + ".journal";
+}
+
+bool readFile (const string & fileName, vector<uint8_t> & content) {
+    ifstream file(fileName, ios::binary);
+    if (!file) return false;
+    content.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * @brief Lit l'enregistrement à la position at
+ * @return Octets de l'enregistrement, 0 s'il est coupé ou corrompu
+ */
+size_t readRecord (const vector<uint8_t> & content, size_t at, uint32_t & sequence, const uint8_t * & payload,
+                   size_t & length) {
+    RecordHeader header;
+    if (content.size() - at < sizeof(header)) return 0;
+    memcpy(&header, content.data() + at, sizeof(header));
+    if (content.size() - at - sizeof(header) < header.length) return 0;
+    payload = content.data() + at + sizeof(header);
+    if (recordChecksum(header.sequence, payload, header.length) != header.checksum) return 0;
+    sequence = header.sequence;
+    length = header.length;
+    return sizeof(header) + header.length;
+}
+
+} // namespace
+
+// --- 1. INSTANTANE ---
+
+void packSnapshot (const GameSnapshot & snapshot, vector<uint8_t> & out) {
+    const size_t size = snapshot.grid.size();
+    const size_t nibbleBytes = (size * size + 1) / 2;
+    const bool spawn = !snapshot.queuePositions.empty() || snapshot.scriptPosition != 0;
+    const uint8_t flags = (snapshot.jelly.empty() ? 0 : KFlagJelly) | (spawn ? KFlagSpawn : 0);
+
+    // Bonbons ordinaires : leur couleur sur un quartet ; spéciaux et cases fixes : quartet nul et exception
+    uint32_t nbExceptions = 0;
+    for (const line & row : snapshot.grid)
+        for (unsigned cell : row) nbExceptions += cell > KColourMask;
+
+    out.resize(KSnapshotHeader + nibbleBytes + nbExceptions * KExceptionBytes
+               + (flags & KFlagJelly ? nibbleBytes : 0)
+               + (spawn ? 8 + 4 * snapshot.queuePositions.size() : 0));
+    Writer writer = {out.data()};
+    writer.put<uint8_t>(KSnapshotVersion);
+    writer.put<uint8_t>(snapshot.mode);
+    writer.put<uint8_t>(snapshot.nbCandies);
+    writer.put<uint8_t>(flags);
+    writer.put<uint16_t>(size);
+    writer.put<uint32_t>(snapshot.level);
+    writer.put<uint32_t>(snapshot.seed);
+    writer.put<uint32_t>(snapshot.moves);
+    writer.put<uint64_t>(snapshot.score);
+    writer.put<uint32_t>(nbExceptions);
+
+    putNibbles(writer, snapshot.grid, [] (unsigned cell) { return cell > KColourMask ? 0 : cell; });
+    if (nbExceptions > 0) {
+        for (size_t i = 0; i < size; ++i) {
+            for (size_t j = 0; j < size; ++j) {
+                const unsigned cell = snapshot.grid[i][j];
+                if (cell <= KColourMask) continue;
+                writer.put<uint32_t>(i * size + j);
+                writer.put<uint8_t>(cell);
+            }
+        }
+    }
+
+    if (flags & KFlagJelly) putNibbles(writer, snapshot.jelly, [] (unsigned layers) { return min(layers, 15u); });
+    if (spawn) {
+        writer.put<uint32_t>(snapshot.scriptPosition);
+        writer.put<uint32_t>(snapshot.queuePositions.size());
+        for (uint32_t position : snapshot.queuePositions) writer.put<uint32_t>(position);
+    }
+}
+
+bool unpackSnapshot (const uint8_t * data, size_t bytes, GameSnapshot & snapshot) {
+    Reader in = {data, bytes, 0};
+    uint8_t version, mode, nbCandies, flags;
+    uint16_t size;
+    if (!in.get(version) || version != KSnapshotVersion || !in.get(mode) || mode > ModeTarget
+        || !in.get(nbCandies) || nbCandies < 3 || nbCandies > KColourMask || !in.get(flags)
+        || !in.get(size) || size < 3 || size > 1024)
+        return false;
+    snapshot.mode = GameMode(mode);
+    snapshot.nbCandies = nbCandies;
+    uint32_t nbExceptions;
+    if (!in.get(snapshot.level) || !in.get(snapshot.seed) || !in.get(snapshot.moves) || !in.get(snapshot.score)
+        || !in.get(nbExceptions))
+        return false;
+
+    const size_t cells = size_t(size) * size;
+    const size_t nibbleBytes = (cells + 1) / 2;
+    if (in.bytes - in.at < nibbleBytes) return false;
+    getNibbles(in.data + in.at, snapshot.grid, size);
+    in.at += nibbleBytes;
+    for (uint32_t e = 0; e < nbExceptions; ++e) {
+        uint32_t index;
+        uint8_t cell;
+        if (!in.get(index) || !in.get(cell) || index >= cells || cell <= KColourMask) return false;
+        snapshot.grid[index / size][index % size] = cell;
+    }
+    for (const line & row : snapshot.grid)
+        for (unsigned cell : row)
+            if (cell == KImpossible) return false;
+
+    snapshot.jelly.clear();
+    if (flags & KFlagJelly) {
+        if (in.bytes - in.at < nibbleBytes) return false;
+        getNibbles(in.data + in.at, snapshot.jelly, size);
+        in.at += nibbleBytes;
+    }
+
+    snapshot.scriptPosition = 0;
+    snapshot.queuePositions.clear();
+    if (flags & KFlagSpawn) {
+        uint32_t nbQueues;
+        if (!in.get(snapshot.scriptPosition) || !in.get(nbQueues) || nbQueues > size) return false;
+        snapshot.queuePositions.resize(nbQueues);
+        for (uint32_t & position : snapshot.queuePositions)
+            if (!in.get(position)) return false;
+    }
+    return in.at == in.bytes;
+}
+
+uint32_t reseedForSnapshot () {
+    const uint32_t seed = rand();
+    srand(seed);
+    return seed;
+}
+
+// --- 2. SAUVEGARDE ET JOURNAL ---
+
+SaveJournal::SaveJournal (const string & fileName)
+    : myFile(fileName), myJournal(-1), mySequence(0), myPending(0), mySynced(false) {}
+
+SaveJournal::~SaveJournal () {
+    if (myJournal >= 0) ::close(myJournal);
+}
+
+bool SaveJournal::writeRecord (int fd, const vector<uint8_t> & snapshot) {
+    RecordHeader header = {uint32_t(snapshot.size()), ++mySequence, 0};
+    header.checksum = recordChecksum(header.sequence, snapshot.data(), snapshot.size());
+
+    // Un seul write : un enregistrement n'est jamais entrelacé, au pire coupé à la fin
+    vector<uint8_t> record(sizeof(header) + snapshot.size());
+    memcpy(record.data(), &header, sizeof(header));
+    memcpy(record.data() + sizeof(header), snapshot.data(), snapshot.size());
+    return ::write(fd, record.data(), record.size()) == ssize_t(record.size());
+}
+
+bool SaveJournal::syncSequence () {
+    if (mySynced) return true;
+    vector<uint8_t> ignored;
+    load(ignored);
+    return mySynced;
+}
+
+bool SaveJournal::checkpoint (const vector<uint8_t> & snapshot) {
+    if (!syncSequence()) return false;
+    if (myJournal < 0) myJournal = ::open(journalName(myFile).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (myJournal < 0 || !writeRecord(myJournal, snapshot)) return false;
+    if (++myPending >= KJournalCompact) return commit(snapshot);
+    return true;
+}
+
+bool SaveJournal::commit (const vector<uint8_t> & snapshot) {
+    if (!syncSequence()) return false;
+    const string temporary = myFile + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool written = writeRecord(fd, snapshot);
+    written = ::close(fd) == 0 && written;
+    // Le renommage remplace la sauvegarde d'un coup : elle est l'ancienne ou la nouvelle, jamais un mélange.
+    // Le journal n'est vidé qu'après : ses enregistrements plus anciens seraient de toute façon ignorés.
+    if (!written || rename(temporary.c_str(), myFile.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    myPending = 0;
+    if (myJournal >= 0) return ftruncate(myJournal, 0) == 0;
+    return ::truncate(journalName(myFile).c_str(), 0) == 0 || errno == ENOENT;
+}
+
+bool SaveJournal::load (vector<uint8_t> & snapshot) {
+    bool found = false;
+    uint32_t best = 0;
+    vector<uint8_t> content;
+    uint32_t sequence;
+    const uint8_t * payload;
+    size_t length;
+
+    if (readFile(myFile, content) && readRecord(content, 0, sequence, payload, length) > 0) {
+        snapshot.assign(payload, payload + length);
+        best = sequence;
+        found = true;
+    }
+
+    size_t at = 0;
+    if (readFile(journalName(myFile), content)) {
+        while (size_t used = readRecord(content, at, sequence, payload, length)) {
+            if (!found || sequence > best) {
+                snapshot.assign(payload, payload + length);
+                best = sequence;
+                found = true;
+            }
+            at += used;
+        }
+        // Fin coupée par un arrêt brutal : retirée pour que les prochains points de reprise restent lisibles
+        if (at < content.size() && ::truncate(journalName(myFile).c_str(), at) != 0) return false;
+    }
+    mySequence = best;
+    myPending = 0;
+    mySynced = true;
+    return found;
+}
+
+void SaveJournal::discard () {
+    if (myJournal >= 0) ::close(myJournal);
+    myJournal = -1;
+    ::unlink(myFile.c_str());
+    ::unlink(journalName(myFile).c_str());
+    mySequence = 0;
+    myPending = 0;
+    mySynced = true;
+}
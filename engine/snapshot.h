@@ -0,0 +1,121 @@
+/**
+ * @file snapshot.h
+ * @brief Sauvegarde d'une partie en cours : instantané compact et journal de points de reprise
+ *
+ * Un instantané tient la grille (un quartet par case, les bonbons spéciaux et
+ * les cases fixes à part), la gelée, le score, les coups joués, le niveau,
+ * l'avancement de la politique d'apparition et la graine de rand() : une
+ * partie reprise continue exactement comme elle aurait continué. Une grille
+ * 8x8 ordinaire tient en une soixantaine d'octets.
+ *
+ * SaveJournal enregistre un instantané après chaque coup sans fsync : il est
+ * ajouté au journal (fichier.journal) en une seule écriture. La sauvegarde
+ * (fichier) n'est remplacée que par renommage d'un fichier complet, elle est
+ * donc toujours entière. Chaque enregistrement porte un numéro et une somme
+ * de contrôle : à la reprise, le plus récent enregistrement intact gagne et
+ * une fin de journal coupée par un arrêt brutal est ignorée.
+ */
+#ifndef CANDY_SNAPSHOT_H
+#define CANDY_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "grid.h"
+
+// Niveau d'une partie normale
+const std::uint32_t KNoLevel (0xFFFFFFFF);
+
+// Points de reprise ajoutés au journal avant de le reporter dans la sauvegarde
+const unsigned KJournalCompact (256);
+
+/**
+ * @struct GameSnapshot
+ * @brief Etat complet d'une partie en cours
+ */
+struct GameSnapshot {
+    GameMode mode;
+    std::uint32_t level;         // numéro du niveau dans le paquet, KNoLevel sinon
+    std::uint32_t seed;          // graine de rand() à la reprise (voir reseedForSnapshot)
+    std::uint32_t moves;         // coups joués
+    std::uint64_t score;
+    unsigned nbCandies;
+    mat grid;
+    mat jelly;                   // vide hors niveau
+    std::uint32_t scriptPosition;                 // avancement de la politique d'apparition
+    std::vector<std::uint32_t> queuePositions;    // (vide sans politique)
+};
+
+/**
+ * @brief Encode un instantané
+ * @param snapshot Partie (grille sans case vide)
+ * @param[out] out Octets de l'instantané (remplacés)
+ */
+void packSnapshot (const GameSnapshot & snapshot, std::vector<std::uint8_t> & out);
+
+/**
+ * @brief Décode un instantané
+ * @return false si les octets ne sont pas un instantané valide
+ */
+bool unpackSnapshot (const std::uint8_t * data, std::size_t bytes, GameSnapshot & snapshot);
+
+/**
+ * @brief Tire une graine de rand() et la réinstalle : la suite des tirages ne dépend plus que d'elle
+ * @return Graine à mettre dans l'instantané
+ */
+std::uint32_t reseedForSnapshot ();
+
+/**
+ * @brief Sauvegarde d'une partie et journal de ses points de reprise
+ *
+ * Chaque enregistrement porte un numéro croissant : le plus grand gagne.
+ * Si ni load ni discard n'ont été appelés, le premier point de reprise relit
+ * d'abord le numéro des enregistrements déjà sur le disque, pour qu'une
+ * partie reprise ne perde pas ses nouveaux points face aux anciens.
+ */
+class SaveJournal {
+public:
+    explicit SaveJournal (const std::string & fileName);
+    ~SaveJournal ();
+    SaveJournal (const SaveJournal &) = delete;
+    SaveJournal & operator= (const SaveJournal &) = delete;
+
+    /**
+     * @brief Ajoute un point de reprise au journal (une écriture, pas de fsync)
+     *
+     * Tous les KJournalCompact points, le journal est reporté dans la sauvegarde.
+     */
+    bool checkpoint (const std::vector<std::uint8_t> & snapshot);
+
+    /**
+     * @brief Remplace la sauvegarde (fichier temporaire puis renommage) et vide le journal
+     */
+    bool commit (const std::vector<std::uint8_t> & snapshot);
+
+    /**
+     * @brief Relit le point de reprise le plus récent (sauvegarde puis journal)
+     * @param[out] snapshot Octets de l'instantané
+     * @return false s'il n'y a aucune partie sauvegardée intacte
+     */
+    bool load (std::vector<std::uint8_t> & snapshot);
+
+    /**
+     * @brief Efface la sauvegarde et le journal (nouvelle partie ou partie terminée)
+     */
+    void discard ();
+
+private:
+    bool writeRecord (int fd, const std::vector<std::uint8_t> & snapshot);
+    bool syncSequence ();
+
+    std::string myFile;
+    int myJournal;
+    std::uint32_t mySequence;
+    unsigned myPending;
+    bool mySynced;     // mySequence suit les enregistrements du disque (load ou discard appelé)
+};
+
+#endif // CANDY_SNAPSHOT_H
@@ -0,0 +1,492 @@
+#include "solver.h"
+#include "events.h"
+#include "game.h"
+#include "history.h"
+#include "score.h"
+#include "shuffle.h"
+#include "spawn.h"
+#include "special.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Flux de la clé de l'état du générateur dans la table (un par étape de la recherche)
+const uint64_t KStateStream (0);
+
+// Profondeur la plus forte de la table : un état atteint en moves coups y est rangé à KTableDepth - moves
+const unsigned KTableDepth (255);
+
+/**
+ * @struct Node
+ * @brief Etat d'une partie dans le faisceau
+ */
+struct Node {
+    mat grid;
+    uint64_t spawn;      // état du générateur des remplissages
+    uint64_t score;
+    uint32_t trail;      // pas de cet état dans la piste de sa couche
+};
+
+/**
+ * @struct Step
+ * @brief Dernier coup d'un état : la solution est retrouvée en remontant les couches
+ */
+struct Step {
+    uint32_t parent;     // pas du parent dans la couche précédente
+    SolveMove move;
+};
+
+/**
+ * @brief Etat commun à tous les fils de recherche
+ */
+struct Search {
+    const SolveConfig * config;
+    TranspositionTable * table;
+    vector<Node> roots;                 // premiers coups joués, du plus rentable au moins rentable
+    vector<SolveMove> rootMoves;
+    unsigned bound;                     // 0 : faisceau ; sinon longueur des suites essayées par la preuve
+    atomic<size_t> nextRoot;
+    atomic<unsigned> best;              // par trouvé (config.maxMoves + 1 : aucun)
+    atomic<uint64_t> rate;              // points du meilleur coup joué
+    atomic<uint64_t> nodes;
+    atomic<uint64_t> pruned;
+    atomic<uint64_t> proofNodes;        // coups joués par la preuve
+    atomic<bool> stop;                  // preuve terminée (solution trouvée ou budget épuisé)
+    atomic<bool> exhausted;             // budget de la preuve épuisé
+    mutex solutionMutex;
+    SolveResult * result;
+};
+
+/**
+ * @brief Joue un échange et toute sa réaction en chaîne avec les règles du mode Cible
+ * @return Points du coup
+ */
+uint64_t playTargetMove (mat & grid, const SolveMove & move, unsigned nbCandies) {
+    const ScoreRule rule = scoreRuleFor(ModeTarget);
+    uint64_t score = 0;
+    unsigned comboLevel = 0;
+    unsigned howMany = 0;
+    maPosition matchPos;
+    makeAMove(grid, move.pos, move.direction);
+
+    // Bombe échangée d'abord, puis un match par pas (colonne avant ligne)
+    const unsigned bombed = activateSwap(grid, move.pos, move.direction, nbCandies);
+    if (bombed > 0) {
+        comboLevel++;
+        score = scoreAdd(score, matchScore(rule, bombed, comboLevel));
+    }
+    while (true) {
+        if (atLeastThreeInAColumn(grid, matchPos, howMany))
+            howMany = clearMatch(grid, matchPos, howMany, MatchVertical, nbCandies);
+        else if (atLeastThreeInARow(grid, matchPos, howMany))
+            howMany = clearMatch(grid, matchPos, howMany, MatchHorizontal, nbCandies);
+        else
+            break;
+        comboLevel++;
+        score = scoreAdd(score, matchScore(rule, howMany, comboLevel));
+    }
+    return score;
+}
+
+/**
+ * @brief Vrai si l'échange déplace deux bonbons différents (sinon le coup est perdu sans rien changer)
+ */
+bool swapsCandies (const mat & grid, const maPosition & pos, char direction) {
+    const unsigned size = grid.size();
+    const unsigned r2 = pos.ord + (direction == 'S');
+    const unsigned c2 = pos.abs + (direction == 'D');
+    if (r2 >= size || c2 >= size) return false;
+    const unsigned first = grid[pos.ord][pos.abs];
+    const unsigned second = grid[r2][c2];
+    return first != second && first != KImpossible && second != KImpossible && !isFixedCell(first)
+           && !isFixedCell(second);
+}
+
+/**
+ * @brief Echanges d'une grille, chacun une seule fois (vers la droite et vers le bas)
+ * @param quiet Vrai : aussi les échanges sans match, qui coûtent un coup et laissent les bonbons échangés
+ */
+void swapMoves (mat & grid, vector<SolveMove> & moves, bool quiet) {
+    moves.clear();
+    const unsigned size = grid.size();
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            for (char direction : {'D', 'S'}) {
+                maPosition here = {j, i};
+                if (quiet ? swapsCandies(grid, here, direction) : isLegalMove(grid, here, direction))
+                    moves.push_back({here, direction});
+            }
+        }
+    }
+}
+
+/**
+ * @brief Clé d'un état dans la table : grille, remplissages à venir et étape de la recherche
+ *
+ * Une longueur de preuve plus grande explore plus loin depuis le même état :
+ * chaque étape a ses propres entrées, la table n'a pas à être vidée.
+ */
+uint64_t stateKey (const mat & grid, uint64_t spawn, unsigned bound) {
+    return boardHash(grid) ^ forkSeed(spawn, KStateStream + bound);
+}
+
+/**
+ * @brief Vrai si l'état a déjà été atteint en autant de coups ou moins avec au moins autant de points
+ *
+ * Sinon l'état est enregistré.
+ */
+bool dominated (Search & search, const Node & node, unsigned moves) {
+    const uint64_t key = stateKey(node.grid, node.spawn, search.bound);
+    const unsigned depth = KTableDepth - moves;
+    uint64_t storedScore;
+    unsigned storedDepth;
+    if (search.table->probe(key, depth, storedScore, storedDepth) && storedScore >= node.score) return true;
+    search.table->store(key, depth, node.score);
+    return false;
+}
+
+/**
+ * @brief Garde le meilleur rythme observé (points d'un seul coup)
+ */
+void raiseRate (Search & search, uint64_t gain) {
+    uint64_t rate = search.rate.load(memory_order_relaxed);
+    while (gain > rate && !search.rate.compare_exchange_weak(rate, gain, memory_order_relaxed)) {}
+}
+
+/**
+ * @brief Vrai si l'état ne peut plus battre le par : même au meilleur rythme, il lui faut trop de coups
+ * @param moves Coups déjà joués
+ */
+bool cannotBeatPar (const Search & search, unsigned moves, uint64_t score) {
+    const unsigned best = search.best.load(memory_order_relaxed);
+    if (moves + 1 >= best) return true;
+    const uint64_t rate = search.rate.load(memory_order_relaxed);
+    if (rate == 0) return false;
+    const uint64_t missing = search.config->targetScore - score;
+    const uint64_t needed = (missing + rate - 1) / rate;
+    return moves + needed >= best;
+}
+
+/**
+ * @brief Garde une solution si elle bat le par
+ */
+void keepSolution (Search & search, const vector<SolveMove> & moves, uint64_t score) {
+    lock_guard<mutex> lock(search.solutionMutex);
+    if (moves.size() >= search.best.load(memory_order_relaxed)) return;
+    search.best.store(moves.size(), memory_order_relaxed);
+    SolveResult & result = *search.result;
+    result.found = true;
+    result.par = moves.size();
+    result.score = score;
+    result.moves = moves;
+}
+
+/**
+ * @brief Solution du faisceau : les coups sont retrouvés en remontant les pistes des couches
+ * @param trail Pistes des couches, jusqu'à celle du parent du dernier coup
+ */
+void recordSolution (Search & search, const vector<vector<Step> > & trail, uint32_t parent, const SolveMove & last,
+                     uint64_t score) {
+    vector<SolveMove> moves (trail.size() + 1, last);
+    for (size_t layer = trail.size(); layer-- > 0;) {
+        const Step & step = trail[layer][parent];
+        moves[layer] = step.move;
+        parent = step.parent;
+    }
+    keepSolution(search, moves, score);
+}
+
+/**
+ * @brief Faisceau mené depuis une racine, couche par couche, jusqu'à la cible ou la borne du par
+ */
+void searchFromRoot (Search & search, size_t root) {
+    const SolveConfig & config = *search.config;
+    vector<vector<Step> > trail (1, vector<Step>(1, Step {0, search.rootMoves[root]}));
+    vector<Node> layer (1, search.roots[root]);
+    layer[0].trail = 0;
+    vector<Node> next;
+    vector<SolveMove> moves;
+
+    // layer : états après moves coups
+    for (unsigned played = 1; played < config.maxMoves && !layer.empty(); ++played) {
+        next.clear();
+        vector<Step> steps;
+        for (Node & node : layer) {
+            if (cannotBeatPar(search, played, node.score)) {
+                search.pruned.fetch_add(1, memory_order_relaxed);
+                continue;
+            }
+            swapMoves(node.grid, moves, false);
+            for (const SolveMove & candidate : moves) {
+                Node child;
+                child.grid = node.grid;
+                child.spawn = node.spawn;
+                uint64_t gain;
+                {
+                    RandomScope randomScope(&child.spawn);
+                    gain = playTargetMove(child.grid, candidate, config.nbCandies);
+                }
+                search.nodes.fetch_add(1, memory_order_relaxed);
+                raiseRate(search, gain);
+                child.score = scoreAdd(node.score, gain);
+
+                // Une couche par coup : la première solution de la couche est la plus courte de cette racine
+                if (child.score >= config.targetScore) {
+                    recordSolution(search, trail, node.trail, candidate, child.score);
+                    return;
+                }
+                if (!hasLegalMove(child.grid) && !reshuffleGrid(child.grid)) continue;
+                if (dominated(search, child, played + 1)) continue;
+
+                child.trail = steps.size();
+                steps.push_back(Step {node.trail, candidate});
+                next.push_back(move(child));
+            }
+        }
+
+        // Les beamWidth états de plus haut score (à égalité : l'ordre de la piste)
+        auto better = [] (const Node & a, const Node & b) {
+            return a.score != b.score ? a.score > b.score : a.trail < b.trail;
+        };
+        if (next.size() > config.beamWidth) {
+            nth_element(next.begin(), next.begin() + config.beamWidth, next.end(), better);
+            next.resize(config.beamWidth);
+        }
+        trail.push_back(move(steps));
+        layer.swap(next);
+    }
+}
+
+/**
+ * @brief Preuve : toutes les suites d'au plus search.bound coups qui prolongent path, en profondeur d'abord
+ * @param node Etat après path
+ * @param path Coups joués depuis le début (rendus tels quels)
+ */
+void deepen (Search & search, Node & node, vector<SolveMove> & path) {
+    const SolveConfig & config = *search.config;
+    const unsigned played = path.size();
+    vector<SolveMove> moves;
+    swapMoves(node.grid, moves, true);
+    for (const SolveMove & candidate : moves) {
+        if (search.stop.load(memory_order_relaxed)) return;
+        if (search.proofNodes.fetch_add(1, memory_order_relaxed) >= config.proofBudget) {
+            search.exhausted.store(true, memory_order_relaxed);
+            search.stop.store(true, memory_order_relaxed);
+            return;
+        }
+        Node child;
+        child.grid = node.grid;
+        child.spawn = node.spawn;
+        uint64_t gain;
+        {
+            RandomScope randomScope(&child.spawn);
+            gain = playTargetMove(child.grid, candidate, config.nbCandies);
+        }
+        search.nodes.fetch_add(1, memory_order_relaxed);
+        child.score = scoreAdd(node.score, gain);
+
+        path.push_back(candidate);
+        if (child.score >= config.targetScore) {
+            // Les suites plus courtes ont toutes été essayées : celle-ci est optimale
+            keepSolution(search, path, child.score);
+            search.stop.store(true, memory_order_relaxed);
+            return;
+        }
+        // Heuristique d'un coup : un état sous la cible demande encore au moins un coup
+        if (played + 1 < search.bound && (hasLegalMove(child.grid) || reshuffleGrid(child.grid))
+            && !dominated(search, child, played + 1))
+            deepen(search, child, path);
+        path.pop_back();
+    }
+}
+
+void runSearch (Search & search) {
+    // Le hash, le flux d'événements, la politique d'apparition et l'historique du fil appelant ne suivent pas la recherche
+    HashScope hashScope(nullptr);
+    EventScope eventScope(nullptr);
+    SpawnScope spawnScope(nullptr);
+    HistoryPause historyPause;
+    while (true) {
+        const size_t root = search.nextRoot.fetch_add(1, memory_order_relaxed);
+        if (root >= search.roots.size()) break;
+        if (search.bound == 0) {
+            searchFromRoot(search, root);
+            continue;
+        }
+        if (search.stop.load(memory_order_relaxed)) break;
+        vector<SolveMove> path (1, search.rootMoves[root]);
+        Node node = search.roots[root];
+        if (!dominated(search, node, 1)) deepen(search, node, path);
+    }
+}
+
+/**
+ * @brief Répartit les racines entre nbThreads fils (le fil appelant travaille aussi)
+ */
+void runThreads (Search & search, unsigned nbThreads) {
+    search.nextRoot.store(0, memory_order_relaxed);
+    vector<thread> workers;
+    for (unsigned t = 0; t + 1 < nbThreads; ++t) workers.emplace_back(runSearch, ref(search));
+    runSearch(search);
+    for (thread & worker : workers) worker.join();
+}
+
+} // namespace
+
+SolveResult solveTarget (const SolveConfig & config) {
+    SolveConfig bounded = config;
+    bounded.maxMoves = min(config.maxMoves, KSolveMaxMoves);
+    bounded.beamWidth = max(1u, config.beamWidth);
+
+    SolveResult result;
+    result.found = false;
+    result.par = 0;
+    result.proven = false;
+    result.score = 0;
+    result.nodes = 0;
+    result.pruned = 0;
+    result.table = TableStats {0, 0, 0, 0};
+    if (bounded.targetScore == 0) {
+        result.found = true;
+        result.proven = true;
+        return result;
+    }
+
+    TranspositionTable table (bounded.tableBytes);
+    Search search;
+    search.config = &bounded;
+    search.table = &table;
+    search.bound = 0;
+    search.nextRoot.store(0, memory_order_relaxed);
+    search.best.store(bounded.maxMoves + 1, memory_order_relaxed);
+    search.rate.store(0, memory_order_relaxed);
+    search.nodes.store(0, memory_order_relaxed);
+    search.pruned.store(0, memory_order_relaxed);
+    search.proofNodes.store(0, memory_order_relaxed);
+    search.stop.store(false, memory_order_relaxed);
+    search.exhausted.store(false, memory_order_relaxed);
+    search.result = &result;
+
+    // --- 1. Les racines : chaque premier coup légal, joué une fois ---
+    // Les premiers échanges sans match ne servent qu'à la preuve : ils sont mis de côté
+    vector<Node> quietRoots;
+    vector<SolveMove> quietMoves;
+    {
+        HashScope hashScope(nullptr);
+        EventScope eventScope(nullptr);
+        SpawnScope spawnScope(nullptr);
+        HistoryPause historyPause;
+        Node start;
+        seedGame(bounded.seed, bounded.gridSize, bounded.nbCandies, start.grid, start.spawn);
+        start.score = 0;
+        vector<SolveMove> moves;
+        swapMoves(start.grid, moves, true);
+        vector<pair<Node, SolveMove> > roots;
+        for (const SolveMove & candidate : moves) {
+            const bool legal = isLegalMove(start.grid, candidate.pos, candidate.direction);
+            Node child;
+            child.grid = start.grid;
+            child.spawn = start.spawn;
+            {
+                RandomScope randomScope(&child.spawn);
+                child.score = playTargetMove(child.grid, candidate, bounded.nbCandies);
+            }
+            search.nodes.fetch_add(1, memory_order_relaxed);
+            raiseRate(search, child.score);
+            if (child.score >= bounded.targetScore) {
+                // Un seul coup suffit : rien ne peut faire mieux
+                search.best.store(1, memory_order_relaxed);
+                result.found = true;
+                result.proven = true;
+                result.par = 1;
+                result.score = child.score;
+                result.moves.assign(1, candidate);
+                break;
+            }
+            if (!hasLegalMove(child.grid) && !reshuffleGrid(child.grid)) continue;
+            if (legal) {
+                roots.push_back(make_pair(move(child), candidate));
+                continue;
+            }
+            quietRoots.push_back(move(child));
+            quietMoves.push_back(candidate);
+        }
+        if (bounded.maxMoves <= 1 || result.found) {
+            roots.clear();
+            quietRoots.clear();
+        }
+
+        // Les racines les plus rentables d'abord : un premier par tôt élague les suivantes
+        stable_sort(roots.begin(), roots.end(), [] (const pair<Node, SolveMove> & a, const pair<Node, SolveMove> & b) {
+            return a.first.score > b.first.score;
+        });
+        for (pair<Node, SolveMove> & root : roots) {
+            search.roots.push_back(move(root.first));
+            search.rootMoves.push_back(root.second);
+        }
+    }
+
+    // --- 2. Le faisceau : un premier par ---
+    unsigned nbThreads = bounded.threads == 0 ? max(1u, thread::hardware_concurrency()) : bounded.threads;
+    nbThreads = max(1u, min<unsigned>(nbThreads, search.roots.size()));
+    runThreads(search, nbThreads);
+
+    // --- 3. La preuve : toutes les suites plus courtes que le par, une longueur après l'autre ---
+    // Sans par du faisceau (toutes ses suites bloquées), la preuve cherche seule jusqu'à maxMoves coups
+    const unsigned limit = result.found ? result.par : bounded.maxMoves;
+    if (limit > 1 && bounded.proofBudget > 0) {
+        // Le mode Cible accepte tout échange : un échange sans match peut préparer une plus longue réaction
+        for (size_t k = 0; k < quietRoots.size(); ++k) {
+            search.roots.push_back(move(quietRoots[k]));
+            search.rootMoves.push_back(quietMoves[k]);
+        }
+        nbThreads = bounded.threads == 0 ? max(1u, thread::hardware_concurrency()) : bounded.threads;
+        nbThreads = max(1u, min<unsigned>(nbThreads, search.roots.size()));
+        for (unsigned bound = 2; bound <= limit; ++bound) {
+            if (result.found && bound == result.par) {
+                // Aucune suite plus courte n'atteint la cible
+                result.proven = true;
+                break;
+            }
+            search.bound = bound;
+            runThreads(search, nbThreads);
+            if (search.exhausted.load(memory_order_relaxed)) break;
+            if (result.found && result.par == bound) {
+                result.proven = true;
+                break;
+            }
+        }
+    }
+
+    result.nodes = search.nodes.load(memory_order_relaxed);
+    result.pruned = search.pruned.load(memory_order_relaxed);
+    result.table = table.stats();
+    return result;
+}
+
+uint64_t replaySolution (const SolveConfig & config, const vector<SolveMove> & moves) {
+    HashScope hashScope(nullptr);
+    EventScope eventScope(nullptr);
+    SpawnScope spawnScope(nullptr);
+    HistoryPause historyPause;
+    mat grid;
+    uint64_t state;
+    seedGame(config.seed, config.gridSize, config.nbCandies, grid, state);
+    RandomScope randomScope(&state);
+
+    uint64_t score = 0;
+    for (SolveMove move : moves) {
+        // Comme le mode Cible : une grille bloquée est mélangée avant le coup
+        if (!hasLegalMove(grid)) reshuffleGrid(grid);
+        if (!swapsCandies(grid, move.pos, move.direction)) return 0;
+        score = scoreAdd(score, playTargetMove(grid, move, config.nbCandies));
+    }
+    return score;
+}
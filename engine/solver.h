@@ -0,0 +1,110 @@
+/**
+ * @file solver.h
+ * @brief Solveur du mode Cible : le plus petit nombre d'échanges pour atteindre le score cible d'une graine
+ *
+ * Une partie à graine (seedGame, spawn.h) est entièrement déterminée : la
+ * grille de départ et tous les bonbons qui tombent viennent de générateurs
+ * dérivés de la graine. Le solveur connaît donc toute la suite des
+ * remplissages et cherche la plus courte suite d'échanges qui atteint la
+ * cible : le « par » de la graine.
+ *
+ * La recherche se fait en deux temps :
+ *   1. un faisceau donne vite une solution, couche par couche (une couche
+ *      par coup). Chaque premier coup légal est une racine ; les fils se
+ *      partagent les racines, les plus rentables d'abord, et mènent chacun
+ *      son faisceau : d'une couche à l'autre, seuls les beamWidth états de
+ *      plus haut score sont gardés. Le meilleur par trouvé borne tous les
+ *      fils : un état à qui il manque plus de points que les coups restants
+ *      n'en rapportent au meilleur rythme observé (points du meilleur coup
+ *      déjà joué) est abandonné ;
+ *   2. un approfondissement itératif (IDA* avec une heuristique d'un coup
+ *      tant que la cible n'est pas atteinte) essaie ensuite toutes les
+ *      suites plus courtes que ce par, une longueur après l'autre, les
+ *      racines toujours réparties entre les fils. Le premier succès est
+ *      optimal ; si aucune suite plus courte n'existe, le par est prouvé.
+ *      Le nombre de coups joués par cette preuve est borné (proofBudget) :
+ *      au-delà, le par du faisceau est rendu sans être prouvé. Si le
+ *      faisceau ne trouve rien (toutes ses suites finissent bloquées), la
+ *      preuve cherche seule, jusqu'à maxMoves coups.
+ * Le rythme du faisceau est une estimation, pas une borne : un coup peut
+ * toujours déclencher une réaction en chaîne plus longue que toutes celles
+ * déjà vues. Seule la seconde étape sert donc à prouver le par.
+ *
+ * Dans les deux étapes, une table de transposition commune (clé : hash de
+ * Zobrist de la grille, état du générateur et étape) écarte un état déjà
+ * atteint en autant de coups ou moins avec un score au moins égal : même
+ * grille, mêmes remplissages à venir, donc même avenir.
+ *
+ * Le mode Cible accepte aussi un échange sans match : il coûte un coup, ne
+ * rapporte rien et laisse les bonbons échangés, ce qui peut préparer une
+ * réaction plus longue au coup suivant. Le faisceau n'essaie que les échanges
+ * légaux (il ne fait que borner le par) ; la preuve essaie tous les échanges
+ * de deux bonbons différents, sans quoi un par plus court passant par un tel
+ * échange lui échapperait. Comme dans le mode Cible, une grille sans coup
+ * légal est mélangée (reshuffleGrid) avant le coup suivant.
+ */
+#ifndef CANDY_SOLVER_H
+#define CANDY_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+#include "transposition.h"
+
+// Coups au-delà desquels une suite est abandonnée (profondeur codée sur 8 bits dans la table)
+const unsigned KSolveMaxMoves (250);
+
+/**
+ * @struct SolveConfig
+ * @brief Partie à résoudre et limites de la recherche
+ */
+struct SolveConfig {
+    std::uint64_t seed;          // graine de la partie (voir seedGame)
+    unsigned gridSize;
+    unsigned nbCandies;
+    std::uint64_t targetScore;
+    unsigned beamWidth;          // états gardés par couche, pour chaque racine
+    unsigned maxMoves;           // au plus KSolveMaxMoves
+    unsigned threads;            // fils de recherche, fil appelant compris (0 : un par cœur)
+    std::uint64_t proofBudget;   // coups joués au plus pour prouver le par (0 : pas de preuve)
+    std::size_t tableBytes;      // taille de la table de transposition
+};
+
+/**
+ * @struct SolveMove
+ * @brief Un échange de la solution
+ */
+struct SolveMove {
+    maPosition pos;
+    char direction;              // 'D' ou 'S'
+};
+
+/**
+ * @struct SolveResult
+ * @brief Bilan d'une recherche
+ */
+struct SolveResult {
+    bool found;                  // cible atteinte en au plus maxMoves coups
+    unsigned par;                // coups de la meilleure solution
+    bool proven;                 // aucune suite plus courte n'atteint la cible
+    std::uint64_t score;         // score à la fin de la solution
+    std::vector<SolveMove> moves;
+    std::uint64_t nodes;         // coups joués par la recherche
+    std::uint64_t pruned;        // états du faisceau écartés par la borne du par
+    TableStats table;
+};
+
+/**
+ * @brief Cherche le plus petit nombre d'échanges qui atteint la cible
+ */
+SolveResult solveTarget (const SolveConfig & config);
+
+/**
+ * @brief Rejoue une solution depuis le début de la partie, avec les règles du mode Cible
+ * @return Score à la fin des coups (0 si un coup n'échange pas deux bonbons différents)
+ */
+std::uint64_t replaySolution (const SolveConfig & config, const std::vector<SolveMove> & moves);
+
+#endif // CANDY_SOLVER_H
@@ -0,0 +1,167 @@
+#include "spawn.h"
+#include "events.h"
+#include "shuffle.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+// Politique du fil courant (nulle : tirage uniforme historique)
+thread_local SpawnPolicy * tlsPolicy = nullptr;
+thread_local vector<unsigned> tlsDrawn;
+
+// Flux d'une graine de partie (seedGame) : grille de départ, remplissages
+const uint64_t KBoardStream (0);
+const uint64_t KSpawnStream (1);
+
+} // namespace
+
+RandomScope::RandomScope (uint64_t * state) : myPrevious(tlsSpawnRandom) {
+    tlsSpawnRandom = state;
+}
+
+RandomScope::~RandomScope () {
+    tlsSpawnRandom = myPrevious;
+}
+
+void seedGame (uint64_t seed, unsigned gridSize, unsigned nbCandies, mat & grid, uint64_t & spawnState) {
+    uint64_t boardState = forkSeed(seed, KBoardStream);
+    {
+        RandomScope randomScope(&boardState);
+        initGrid(grid, gridSize, nbCandies);
+    }
+    if (!hasLegalMove(grid)) reshuffleGrid(grid);
+    spawnState = forkSeed(seed, KSpawnStream);
+}
+
+// --- 1. TABLE D'ALIAS ---
+
+bool buildAliasTable (AliasTable & table, const unsigned * weights, unsigned nbColours) {
+    if (nbColours == 0 || nbColours > KMaxSpawnColours) return false;
+    uint64_t total = 0;
+    for (unsigned c = 0; c < nbColours; ++c) total += weights[c];
+    if (total == 0) return false;
+
+    // Poids ramenés à une moyenne de total par case : une case "petite" est complétée par une "grande"
+    uint64_t scaled[KMaxSpawnColours];
+    unsigned small[KMaxSpawnColours];
+    unsigned large[KMaxSpawnColours];
+    unsigned nbSmall = 0;
+    unsigned nbLarge = 0;
+    for (unsigned c = 0; c < nbColours; ++c) {
+        scaled[c] = uint64_t(weights[c]) * nbColours;
+        if (scaled[c] < total) small[nbSmall++] = c;
+        else large[nbLarge++] = c;
+    }
+
+    table.size = nbColours;
+    while (nbSmall > 0 && nbLarge > 0) {
+        const unsigned s = small[--nbSmall];
+        const unsigned l = large[--nbLarge];
+        table.threshold[s] = scaled[s] * KAliasScale / total;
+        table.alias[s] = l;
+        scaled[l] -= total - scaled[s];
+        if (scaled[l] < total) small[nbSmall++] = l;
+        else large[nbLarge++] = l;
+    }
+    // Restes (arrondis compris) : la case garde toujours sa propre couleur
+    while (nbLarge > 0) {
+        const unsigned l = large[--nbLarge];
+        table.threshold[l] = KAliasScale;
+        table.alias[l] = l;
+    }
+    while (nbSmall > 0) {
+        const unsigned s = small[--nbSmall];
+        table.threshold[s] = KAliasScale;
+        table.alias[s] = s;
+    }
+    return true;
+}
+
+// --- 2. POLITIQUE D'APPARITION ---
+
+SpawnPolicy::SpawnPolicy (unsigned nbCandies) : myScriptHead(0) {
+    const unsigned uniform[KMaxSpawnColours] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+    if (!buildAliasTable(myTable, uniform, nbCandies)) buildAliasTable(myTable, uniform, KNbCandies);
+}
+
+bool SpawnPolicy::setWeights (const unsigned * weights, unsigned nbCandies) {
+    AliasTable table;
+    if (!buildAliasTable(table, weights, nbCandies)) return false;
+    myTable = table;
+    return true;
+}
+
+void SpawnPolicy::setColumnQueue (unsigned abs, const vector<uint8_t> & colours) {
+    if (abs >= myQueues.size()) {
+        myQueues.resize(abs + 1);
+        myQueueHeads.resize(abs + 1, 0);
+    }
+    myQueues[abs] = colours;
+    myQueueHeads[abs] = 0;
+}
+
+void SpawnPolicy::setScript (const vector<uint8_t> & colours) {
+    myScript = colours;
+    myScriptHead = 0;
+}
+
+void SpawnPolicy::rewind () {
+    myScriptHead = 0;
+    for (size_t & head : myQueueHeads) head = 0;
+}
+
+void SpawnPolicy::seek (size_t scriptPosition, const vector<size_t> & queuePositions) {
+    myScriptHead = min(scriptPosition, myScript.size());
+    for (size_t abs = 0; abs < myQueueHeads.size(); ++abs)
+        myQueueHeads[abs] = abs < queuePositions.size() ? min(queuePositions[abs], myQueues[abs].size()) : 0;
+}
+
+void SpawnPolicy::draw (unsigned abs, unsigned * out, unsigned count) {
+    unsigned k = 0;
+    if (abs < myQueues.size()) {
+        const vector<uint8_t> & queue = myQueues[abs];
+        size_t & head = myQueueHeads[abs];
+        while (k < count && head < queue.size()) out[k++] = queue[head++];
+    }
+    while (k < count && myScriptHead < myScript.size()) out[k++] = myScript[myScriptHead++];
+    for (; k < count; ++k) out[k] = aliasDraw(myTable, spawnRandom());
+}
+
+SpawnScope::SpawnScope (SpawnPolicy * policy) : myPrevious(tlsPolicy) {
+    tlsPolicy = policy;
+}
+
+SpawnScope::~SpawnScope () {
+    tlsPolicy = myPrevious;
+}
+
+// --- 3. REMPLISSAGE D'UNE COLONNE ---
+
+void refillColumn (mat & grid, unsigned abs, int first, int last, unsigned nbCandies) {
+    if (!tlsPolicy) {
+        unsigned count = 0;
+        for (int i = first; i <= last; ++i) {
+            if (grid[i][abs] == KHole) continue;
+            grid[i][abs] = (spawnRandom() % nbCandies) + 1;
+            count++;
+        }
+        if (count > 0) emitEvent(EventSpawned, 0, count, first, abs, 0);
+        return;
+    }
+
+    // Un seul tirage pour toute la colonne, le premier bonbon entré tombe le plus bas
+    vector<unsigned> & drawn = tlsDrawn;
+    unsigned count = 0;
+    for (int i = first; i <= last; ++i) count += grid[i][abs] != KHole;
+    if (count == 0) return;
+    emitEvent(EventSpawned, 0, count, first, abs, 0);
+    drawn.resize(count);
+    tlsPolicy->draw(abs, drawn.data(), count);
+    unsigned k = 0;
+    for (int i = last; i >= first; --i)
+        if (grid[i][abs] != KHole) grid[i][abs] = drawn[k++];
+}
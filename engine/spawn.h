@@ -0,0 +1,205 @@
+/**
+ * @file spawn.h
+ * @brief Apparition des bonbons au remplissage : couleurs pondérées, files par colonne et séquences imposées
+ *
+ * Sans politique active, le remplissage tire chaque couleur uniformément
+ * avec rand(), comme toujours (mêmes parties pour une même graine). Une
+ * SpawnPolicy installée par SpawnScope décide à la place, dans l'ordre :
+ *   1. la file de la colonne remplie (bonbons posés à l'avance par le niveau) ;
+ *   2. la séquence imposée du niveau (tutoriels), consommée d'un remplissage à l'autre ;
+ *   3. un tirage pondéré dans une table d'alias : un seul rand() et une
+ *      comparaison par bonbon, quel que soit le nombre de couleurs.
+ * Les cases vides d'une colonne sont remplies par un seul appel à draw.
+ *
+ * Les tirages viennent de rand(), sauf sous un RandomScope : le fil courant
+ * tire alors dans son propre générateur. Un calcul parallèle donne à chaque
+ * tâche un générateur dérivé de sa graine (forkSeed) et obtient les mêmes
+ * remplissages quel que soit l'ordre ou le fil d'exécution des tâches.
+ */
+#ifndef CANDY_SPAWN_H
+#define CANDY_SPAWN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "grid.h"
+
+// Nombre maximal de couleurs d'une table d'alias (une couleur tient sur KColourMask)
+const unsigned KMaxSpawnColours (KColourMask);
+
+// Précision des seuils de la table d'alias (probabilités en 1/65536)
+const unsigned KAliasScale (1 << 16);
+
+// Générateur du fil courant (nul : rand())
+inline thread_local std::uint64_t * tlsSpawnRandom = nullptr;
+
+/**
+ * @brief Tirage pour le remplissage : rand(), ou le générateur du fil courant (splitmix64)
+ * @return Valeur sur 31 bits, comme rand()
+ */
+inline unsigned spawnRandom () {
+    if (!tlsSpawnRandom) return rand();
+    std::uint64_t z = (*tlsSpawnRandom += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return unsigned((z ^ (z >> 31)) >> 33);
+}
+
+/**
+ * @brief Graine du générateur de la tâche stream d'un calcul lancé avec la graine seed
+ */
+inline std::uint64_t forkSeed (std::uint64_t seed, std::uint64_t stream) {
+    std::uint64_t z = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    z = (z ^ (z >> 32)) * 0xD6E8FEB86659FD93ULL;
+    return z ^ (z >> 32);
+}
+
+/**
+ * @brief Fait tirer le remplissage du fil courant dans un générateur privé, le temps de sa portée
+ *
+ * L'état du générateur (state) avance à chaque tirage. Les portées s'emboîtent.
+ */
+class RandomScope {
+public:
+    explicit RandomScope (std::uint64_t * state);
+    ~RandomScope ();
+    RandomScope (const RandomScope &) = delete;
+    RandomScope & operator= (const RandomScope &) = delete;
+
+private:
+    std::uint64_t * myPrevious;
+};
+
+/**
+ * @brief Partie à graine (défi du jour, solveur) : grille de départ et générateur des remplissages
+ *
+ * La grille est tirée dans un générateur dérivé de la graine, sans toucher
+ * à rand() : la même graine donne la même partie sur tous les fils et toutes
+ * les machines. Une grille de départ sans coup légal est mélangée.
+ *
+ * @param[out] grid Grille de départ
+ * @param[out] spawnState Etat du générateur des remplissages, à installer avec un RandomScope
+ */
+void seedGame (std::uint64_t seed, unsigned gridSize, unsigned nbCandies, mat & grid, std::uint64_t & spawnState);
+
+/**
+ * @struct AliasTable
+ * @brief Table d'alias de Walker/Vose pour tirer une couleur pondérée en temps constant
+ *
+ * Case i tirée uniformément, puis couleur i si le tirage est sous threshold[i],
+ * sinon alias[i].
+ */
+struct AliasTable {
+    unsigned size;                               // nombre de couleurs
+    std::uint32_t threshold[KMaxSpawnColours];   // seuil sur KAliasScale
+    std::uint8_t alias[KMaxSpawnColours];        // couleur de repli (0 à size - 1)
+};
+
+/**
+ * @brief Construit la table d'alias de poids donnés
+ * @param[out] table Table construite
+ * @param weights Poids de chaque couleur (au moins un non nul)
+ * @param nbColours Nombre de couleurs (1 à KMaxSpawnColours)
+ * @return false si les poids sont tous nuls ou le nombre de couleurs invalide
+ */
+bool buildAliasTable (AliasTable & table, const unsigned * weights, unsigned nbColours);
+
+/**
+ * @brief Tire une couleur (1 à table.size) à partir d'un nombre aléatoire
+ * @param random Valeur de spawnRandom()
+ */
+inline unsigned aliasDraw (const AliasTable & table, unsigned random) {
+    const unsigned i = random % table.size;
+    const unsigned coin = (random / table.size) % KAliasScale;
+    return (coin < table.threshold[i] ? i : table.alias[i]) + 1;
+}
+
+/**
+ * @brief Politique d'apparition des bonbons d'une partie
+ */
+class SpawnPolicy {
+public:
+    /**
+     * @brief Politique uniforme sur nbCandies couleurs
+     */
+    explicit SpawnPolicy (unsigned nbCandies = KNbCandies);
+
+    /**
+     * @brief Poids d'apparition de chaque couleur
+     * @return false si les poids sont invalides (la politique ne change pas)
+     */
+    bool setWeights (const unsigned * weights, unsigned nbCandies);
+
+    /**
+     * @brief Bonbons qui tombent en premier dans une colonne, dans l'ordre où ils entrent
+     */
+    void setColumnQueue (unsigned abs, const std::vector<std::uint8_t> & colours);
+
+    /**
+     * @brief Séquence imposée, utilisée (après les files des colonnes) jusqu'à épuisement
+     */
+    void setScript (const std::vector<std::uint8_t> & colours);
+
+    /**
+     * @brief Revient au début de la séquence et des files (nouvelle partie)
+     */
+    void rewind ();
+
+    /**
+     * @brief Tire les count bonbons qui entrent dans la colonne abs
+     * @param abs Colonne remplie
+     * @param[out] out out[0] est le premier bonbon entré (la case vide la plus basse)
+     * @param count Nombre de bonbons
+     */
+    void draw (unsigned abs, unsigned * out, unsigned count);
+
+    /**
+     * @brief Avancement dans la séquence et dans la file de chaque colonne (sauvegarde d'une partie)
+     */
+    std::size_t scriptPosition () const { return myScriptHead; }
+    const std::vector<std::size_t> & queuePositions () const { return myQueueHeads; }
+
+    /**
+     * @brief Reprend la séquence et les files là où une partie sauvegardée les avait laissées
+     */
+    void seek (std::size_t scriptPosition, const std::vector<std::size_t> & queuePositions);
+
+    unsigned nbCandies () const { return myTable.size; }
+
+private:
+    AliasTable myTable;
+    std::vector<std::vector<std::uint8_t> > myQueues;   // par colonne
+    std::vector<std::size_t> myQueueHeads;
+    std::vector<std::uint8_t> myScript;
+    std::size_t myScriptHead;
+};
+
+/**
+ * @brief Installe une politique d'apparition pour le fil courant, le temps de sa portée
+ *
+ * Les portées s'emboîtent : la politique précédente revient à la destruction.
+ */
+class SpawnScope {
+public:
+    explicit SpawnScope (SpawnPolicy * policy);
+    ~SpawnScope ();
+    SpawnScope (const SpawnScope &) = delete;
+    SpawnScope & operator= (const SpawnScope &) = delete;
+
+private:
+    SpawnPolicy * myPrevious;
+};
+
+/**
+ * @brief Remplit les cases (hors trous) des lignes first à last de la colonne abs
+ * @param grid Grille (le contenu des cases remplies est écrasé)
+ * @param abs Colonne
+ * @param first Première ligne (la plus haute)
+ * @param last Dernière ligne (la plus basse)
+ * @param nbCandies Nombre de types de bonbons, sans politique active
+ */
+void refillColumn (mat & grid, unsigned abs, int first, int last, unsigned nbCandies);
+
+#endif // CANDY_SPAWN_H
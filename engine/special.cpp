@@ -0,0 +1,294 @@
+#include "special.h"
+#include "events.h"
+#include "history.h"
+#include "instrument.h"
+#include "spawn.h"
+#include "trace.h"
+#include "zobrist.h"
+
+using namespace std;
+
+namespace {
+
+// Masques de travail réutilisés d'un appel à l'autre (pas d'allocation en partie)
+thread_local BoardMask tlsClear;
+thread_local BoardMask tlsSeen;
+thread_local vector<int> tlsLowest;
+
+uint64_t lastWordBits (const BoardMask & mask) {
+    return mask.size % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (mask.size % 64)) - 1;
+}
+
+void maskSetRow (BoardMask & mask, unsigned ord) {
+    uint64_t * row = &mask.bits[ord * mask.wordsPerRow];
+    for (unsigned w = 0; w + 1 < mask.wordsPerRow; ++w) row[w] = ~uint64_t(0);
+    row[mask.wordsPerRow - 1] |= lastWordBits(mask);
+}
+
+void maskSetColumn (BoardMask & mask, unsigned abs) {
+    const uint64_t bit = uint64_t(1) << (abs % 64);
+    for (unsigned i = 0; i < mask.size; ++i) mask.bits[i * mask.wordsPerRow + abs / 64] |= bit;
+}
+
+void maskSetBox (BoardMask & mask, unsigned ord, unsigned abs) {
+    for (unsigned i = (ord > 0 ? ord - 1 : 0); i <= ord + 1 && i < mask.size; ++i)
+        for (unsigned j = (abs > 0 ? abs - 1 : 0); j <= abs + 1 && j < mask.size; ++j)
+            maskSet(mask, i, j);
+}
+
+void maskSetColour (BoardMask & mask, const mat & grid, unsigned colour) {
+    for (unsigned i = 0; i < mask.size; ++i) {
+        uint64_t * row = &mask.bits[i * mask.wordsPerRow];
+        for (unsigned j = 0; j < mask.size; ++j)
+            row[j / 64] |= uint64_t(candyColour(grid[i][j]) == colour) << (j % 64);
+    }
+}
+
+/**
+ * @brief Déclenche tous les spéciaux touchés par le masque, jusqu'à ce que la chaîne s'arrête
+ *
+ * Chaque passe ne regarde que les cases ajoutées depuis la passe précédente.
+ */
+void fireChain (const mat & grid, BoardMask & clear, unsigned colour) {
+    CANDY_TRACE_SCOPE("effets_speciaux");
+    BoardMask & seen = tlsSeen;
+    maskReset(seen, clear.size);
+    bool colourDone[KColourMask + 1] = {};
+    if (colour == KImpossible) colour = 1;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t w = 0; w < clear.bits.size(); ++w) {
+            uint64_t fresh = clear.bits[w] & ~seen.bits[w];
+            if (fresh == 0) continue;
+            seen.bits[w] |= fresh;
+            changed = true;
+
+            const unsigned ord = w / clear.wordsPerRow;
+            const unsigned base = (w % clear.wordsPerRow) * 64;
+            while (fresh != 0) {
+                const unsigned abs = base + __builtin_ctzll(fresh);
+                fresh &= fresh - 1;
+                const SpecialKind kind = candyKind(grid[ord][abs]);
+                if (kind == SpecialNone) continue;
+
+                CANDY_TRACE_INSTANT("special", kind);
+                switch (kind) {
+                case SpecialStripedRow: maskSetRow(clear, ord); break;
+                case SpecialStripedColumn: maskSetColumn(clear, abs); break;
+                case SpecialWrapped: maskSetBox(clear, ord, abs); break;
+                case SpecialColourBomb:
+                    // Une seule passe sur la grille par couleur, même si plusieurs bombes la visent
+                    if (!colourDone[colour]) maskSetColour(clear, grid, colour);
+                    colourDone[colour] = true;
+                    break;
+                default: break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Vide les cases du masque, fait tomber les bonbons et remplit, colonne par colonne
+ * @return Nombre de cases vidées (les trous du masque sont ignorés)
+ *
+ * Mêmes règles que removalInColumn : les bonbons tombent à travers les trous,
+ * la partie d'une colonne sous un bloqueur se remplit sur place.
+ */
+unsigned removeMask (mat & grid, const BoardMask & clear, unsigned nbCandies) {
+    CANDY_TIMER(PhaseGravity);
+    CANDY_TRACE_SCOPE("gravite");
+    const unsigned size = clear.size;
+
+    // Colonnes touchées : OU de toutes les lignes
+    vector<uint64_t> pending(clear.wordsPerRow, 0);
+    for (unsigned i = 0; i < size; ++i)
+        for (unsigned w = 0; w < clear.wordsPerRow; ++w) pending[w] |= clear.bits[i * clear.wordsPerRow + w];
+
+    // Ligne vidée la plus basse de chaque colonne : les cases en dessous ne bougent pas
+    vector<int> & lowest = tlsLowest;
+    lowest.assign(size, -1);
+    unsigned remaining = 0;
+    for (uint64_t word : pending) remaining += __builtin_popcountll(word);
+    for (int i = size - 1; i >= 0 && remaining > 0; --i) {
+        for (unsigned w = 0; w < clear.wordsPerRow; ++w) {
+            uint64_t found = clear.bits[i * clear.wordsPerRow + w] & pending[w];
+            pending[w] &= ~found;
+            while (found != 0) {
+                lowest[w * 64 + __builtin_ctzll(found)] = i;
+                found &= found - 1;
+                remaining--;
+            }
+        }
+    }
+
+    unsigned removed = 0;
+    for (unsigned abs = 0; abs < size; ++abs) {
+        if (lowest[abs] < 0) continue;
+        CANDY_COUNT(CounterCellsTouched, lowest[abs] + 1);
+        hashColumn(grid, abs, 0, lowest[abs]);
+        historyColumn(grid, abs, 0, lowest[abs]);
+
+        int next_write_ord = lowest[abs];
+        while (next_write_ord >= 0 && grid[next_write_ord][abs] == KHole) next_write_ord--;
+        for (int i = lowest[abs]; i >= 0; --i) {
+            const unsigned cell = grid[i][abs];
+            if (cell == KHole) continue;
+            if (maskTest(clear, i, abs)) {
+                removed++;
+                continue;
+            }
+            if (cell == KBlocker) {
+                // Le segment sous le bloqueur se remplit sur place
+                refillColumn(grid, abs, i + 1, next_write_ord, nbCandies);
+                next_write_ord = i - 1;
+            }
+            else {
+                if (i != next_write_ord) grid[next_write_ord][abs] = cell;
+                next_write_ord--;
+            }
+            while (next_write_ord >= 0 && grid[next_write_ord][abs] == KHole) next_write_ord--;
+        }
+        refillColumn(grid, abs, 0, next_write_ord, nbCandies);
+        hashColumn(grid, abs, 0, lowest[abs]);
+    }
+    return removed;
+}
+
+/**
+ * @brief Longueur de l'alignement perpendiculaire au match qui passe par la case (ord, abs)
+ * @param[out] first Première case de cet alignement (ligne ou colonne selon le sens)
+ */
+unsigned crossRun (const mat & grid, unsigned ord, unsigned abs, MatchDirection direction, unsigned & first) {
+    const unsigned size = grid.size();
+    const unsigned colour = candyColour(grid[ord][abs]);
+    if (direction == MatchVertical) {
+        unsigned lo = abs, hi = abs;
+        while (lo > 0 && candyColour(grid[ord][lo-1]) == colour) --lo;
+        while (hi + 1 < size && candyColour(grid[ord][hi+1]) == colour) ++hi;
+        first = lo;
+        return hi - lo + 1;
+    }
+    unsigned lo = ord, hi = ord;
+    while (lo > 0 && candyColour(grid[lo-1][abs]) == colour) --lo;
+    while (hi + 1 < size && candyColour(grid[hi+1][abs]) == colour) ++hi;
+    first = lo;
+    return hi - lo + 1;
+}
+
+} // namespace
+
+void maskReset (BoardMask & mask, unsigned size) {
+    mask.size = size;
+    mask.wordsPerRow = (size + 63) / 64;
+    mask.bits.assign(size_t(size) * mask.wordsPerRow, 0);
+}
+
+unsigned maskCount (const BoardMask & mask) {
+    unsigned count = 0;
+    for (uint64_t word : mask.bits) count += __builtin_popcountll(word);
+    return count;
+}
+
+unsigned detonate (mat & grid, BoardMask & clear, unsigned colour, unsigned nbCandies) {
+    fireChain(grid, clear, colour);
+    return removeMask(grid, clear, nbCandies);
+}
+
+unsigned clearMatch (mat & grid, const maPosition & pos, unsigned howMany, MatchDirection direction,
+                     unsigned nbCandies, BoardMask * cleared) {
+    const unsigned size = grid.size();
+    if (pos.ord >= size || pos.abs >= size) return 0;
+    emitEvent(EventMatchFound, direction == MatchVertical ? 'V' : 'H', howMany, pos.ord, pos.abs, 0);
+    BoardMask & clear = tlsClear;
+    maskReset(clear, size);
+
+    const unsigned colour = candyColour(grid[pos.ord][pos.abs]);
+    for (unsigned k = 0; k < howMany; ++k) {
+        unsigned ord = direction == MatchVertical ? pos.ord + k : pos.ord;
+        unsigned abs = direction == MatchVertical ? pos.abs : pos.abs + k;
+        if (ord < size && abs < size) maskSet(clear, ord, abs);
+    }
+
+    // --- Bonbon spécial créé par le match ---
+    SpecialKind created = SpecialNone;
+    maPosition where = direction == MatchVertical ? maPosition {pos.abs, pos.ord + howMany / 2}
+                                                  : maPosition {pos.abs + howMany / 2, pos.ord};
+    if (howMany >= 5) {
+        created = SpecialColourBomb;
+    }
+    else {
+        // L ou T : un alignement perpendiculaire de 3 ou plus passe par une case du match
+        for (unsigned k = 0; k < howMany && created == SpecialNone; ++k) {
+            unsigned ord = direction == MatchVertical ? pos.ord + k : pos.ord;
+            unsigned abs = direction == MatchVertical ? pos.abs : pos.abs + k;
+            if (ord >= size || abs >= size) break;
+            unsigned first = 0;
+            unsigned length = crossRun(grid, ord, abs, direction, first);
+            if (length < 3) continue;
+            created = SpecialWrapped;
+            where = {abs, ord};
+            for (unsigned m = first; m < first + length; ++m) {
+                if (direction == MatchVertical) maskSet(clear, ord, m);
+                else maskSet(clear, m, abs);
+            }
+        }
+        if (created == SpecialNone && howMany == 4)
+            created = direction == MatchVertical ? SpecialStripedRow : SpecialStripedColumn;
+    }
+
+    fireChain(grid, clear, colour);
+
+    // Le bonbon transformé reste en place
+    if (isFixedCell(grid[where.ord][where.abs])) created = SpecialNone;
+    if (created != SpecialNone) {
+        maskClear(clear, where.ord, where.abs);
+        historyColumn(grid, where.abs, where.ord, where.ord);
+        hashCell(grid, where.ord, where.abs);
+        grid[where.ord][where.abs] = makeSpecial(created == SpecialColourBomb ? KImpossible : colour, created);
+        hashCell(grid, where.ord, where.abs);
+    }
+    if (cleared) *cleared = clear;
+    return removeMask(grid, clear, nbCandies) + (created != SpecialNone);
+}
+
+unsigned activateSwap (mat & grid, const maPosition & pos, char direction, unsigned nbCandies,
+                       BoardMask * cleared) {
+    const unsigned size = grid.size();
+    if (pos.ord >= size || pos.abs >= size) return 0;
+
+    unsigned r2 = pos.ord;
+    unsigned c2 = pos.abs;
+    switch (direction) {
+    case 'Q': if (pos.abs == 0) return 0; c2--; break;
+    case 'Z': if (pos.ord == 0) return 0; r2--; break;
+    case 'D': if (pos.abs == size - 1) return 0; c2++; break;
+    case 'S': if (pos.ord == size - 1) return 0; r2++; break;
+    default: return 0;
+    }
+
+    const unsigned first = grid[pos.ord][pos.abs];
+    const unsigned second = grid[r2][c2];
+    const bool firstIsBomb = candyKind(first) == SpecialColourBomb;
+    const bool secondIsBomb = candyKind(second) == SpecialColourBomb;
+    if (!firstIsBomb && !secondIsBomb) return 0;
+    if (isFixedCell(first) || isFixedCell(second)) return 0;
+
+    BoardMask & clear = tlsClear;
+    maskReset(clear, size);
+    unsigned colour = KImpossible;
+    if (firstIsBomb && secondIsBomb) {
+        for (unsigned i = 0; i < size; ++i) maskSetRow(clear, i);
+    }
+    else {
+        // La bombe se déclenche dans la chaîne avec la couleur de l'autre bonbon
+        maskSet(clear, pos.ord, pos.abs);
+        maskSet(clear, r2, c2);
+        colour = candyColour(firstIsBomb ? second : first);
+    }
+    fireChain(grid, clear, colour);
+    if (cleared) *cleared = clear;
+    return removeMask(grid, clear, nbCandies);
+}
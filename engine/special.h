@@ -0,0 +1,102 @@
+/**
+ * @file special.h
+ * @brief Bonbons spéciaux : création (4, 5, L/T) et effets en chaîne sur des masques de bits
+ *
+ * Un match de 4 crée un bonbon rayé, un match en L ou en T un bonbon emballé,
+ * un match de 5 ou plus une bombe. Les cases à vider sont accumulées dans un
+ * masque (un bit par case, 64 cases par mot) : une ligne ou une colonne
+ * rayée, un carré 3x3 ou toute une couleur s'ajoutent par des OU de mots, et
+ * chaque spécial touché par le masque se déclenche à son tour jusqu'à ce que
+ * la chaîne s'arrête. La gravité et le remplissage ne passent ensuite que
+ * sur les colonnes touchées.
+ */
+#ifndef CANDY_SPECIAL_H
+#define CANDY_SPECIAL_H
+
+#include <cstdint>
+#include <vector>
+
+#include "grid.h"
+
+/**
+ * @struct BoardMask
+ * @brief Un bit par case de la grille, ligne par ligne
+ */
+struct BoardMask {
+    unsigned size;                   // côté de la grille
+    unsigned wordsPerRow;            // mots de 64 bits par ligne
+    std::vector<std::uint64_t> bits;
+};
+
+/**
+ * @brief Dimensionne le masque pour une grille size x size et le vide
+ */
+void maskReset (BoardMask & mask, unsigned size);
+
+inline bool maskTest (const BoardMask & mask, unsigned ord, unsigned abs) {
+    return (mask.bits[ord * mask.wordsPerRow + abs / 64] >> (abs % 64)) & 1;
+}
+
+inline void maskSet (BoardMask & mask, unsigned ord, unsigned abs) {
+    mask.bits[ord * mask.wordsPerRow + abs / 64] |= std::uint64_t(1) << (abs % 64);
+}
+
+inline void maskClear (BoardMask & mask, unsigned ord, unsigned abs) {
+    mask.bits[ord * mask.wordsPerRow + abs / 64] &= ~(std::uint64_t(1) << (abs % 64));
+}
+
+/**
+ * @brief Nombre de cases du masque
+ */
+unsigned maskCount (const BoardMask & mask);
+
+/**
+ * @brief Sens d'un match trouvé par atLeastThreeInAColumn ou atLeastThreeInARow
+ */
+enum MatchDirection {
+    MatchVertical,
+    MatchHorizontal
+};
+
+/**
+ * @brief Vide un match, crée le bonbon spécial éventuel et déclenche la réaction en chaîne
+ * @param grid Grille
+ * @param pos Premier bonbon du match
+ * @param howMany Longueur du match
+ * @param direction Sens du match
+ * @param nbCandies Nombre de types de bonbons pour le remplissage
+ * @param[out] cleared Si non nul, reçoit les cases vidées (pour la gelée des niveaux)
+ * @return Nombre de bonbons consommés : le match, le bonbon transformé en spécial et les cases vidées par les effets
+ *
+ * Remplace removalInColumn / removalInRow dans les boucles de jeu. Sans
+ * bonbon spécial sur la grille, un match de 3 donne le même résultat.
+ */
+unsigned clearMatch (mat & grid, const maPosition & pos, unsigned howMany, MatchDirection direction,
+                     unsigned nbCandies = KNbCandies, BoardMask * cleared = nullptr);
+
+/**
+ * @brief Déclenche la bombe d'un échange qui vient d'être joué par makeAMove
+ * @param grid Grille (après l'échange)
+ * @param pos Position donnée à makeAMove
+ * @param direction Direction donnée à makeAMove
+ * @param nbCandies Nombre de types de bonbons pour le remplissage
+ * @param[out] cleared Si non nul, reçoit les cases vidées (pour la gelée des niveaux)
+ * @return Nombre de cases vidées, 0 si aucune des deux cases n'est une bombe
+ *
+ * La bombe vide toutes les cases de la couleur du bonbon échangé, deux
+ * bombes échangées vident toute la grille.
+ */
+unsigned activateSwap (mat & grid, const maPosition & pos, char direction, unsigned nbCandies = KNbCandies,
+                       BoardMask * cleared = nullptr);
+
+/**
+ * @brief Vide les cases du masque en déclenchant les spéciaux touchés, puis gravité et remplissage
+ * @param grid Grille
+ * @param clear Cases à vider, complété par les effets
+ * @param colour Couleur visée par une bombe touchée par la chaîne
+ * @param nbCandies Nombre de types de bonbons pour le remplissage
+ * @return Nombre de cases vidées (les trous ne sont jamais vidés, les bloqueurs touchés sont détruits)
+ */
+unsigned detonate (mat & grid, BoardMask & clear, unsigned colour, unsigned nbCandies = KNbCandies);
+
+#endif // CANDY_SPECIAL_H
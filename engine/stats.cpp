@@ -0,0 +1,360 @@
+#include "stats.h"
+#include "instrument.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char KColumnMagic [8] = {'C', 'A', 'N', 'D', 'Y', 'C', 'O', 'L'};
+const uint32_t KColumnVersion (1);
+
+/**
+ * @struct ColumnHeader
+ * @brief En-tête d'une colonne, suivi des valeurs ; 16 octets gardent les valeurs de 64 bits alignées
+ */
+struct ColumnHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;   // octets par valeur
+};
+
+enum StatColumn { ColumnPlayer, ColumnMode, ColumnScore, ColumnMoves, ColumnCombo, ColumnTime, KNbStatColumns };
+
+/**
+ * @brief Fichier d'une colonne : suffixe ajouté au nom de l'entrepôt et taille d'une valeur
+ */
+struct ColumnFile {
+    const char * suffix;
+    uint32_t width;
+};
+
+const ColumnFile KColumnFiles [KNbStatColumns] = {
+    {".joueur.col", sizeof(uint32_t)},
+    {".mode.col", sizeof(uint8_t)},
+    {".score.col", sizeof(uint64_t)},
+    {".coups.col", sizeof(uint32_t)},
+    {".combo.col", sizeof(uint32_t)},
+    {".date.col", sizeof(uint32_t)},
+};
+
+const char * const KPseudoSuffix (".pseudos");
+
+// Parties filtrées par tour de forEachGame (un bloc reste dans le cache L1)
+const size_t KStatBlock (4096);
+
+// Seaux de l'histogramme des centiles : 2^16 compteurs tiennent dans le cache L2
+
+const unsigned KHistogramBits (16);
+const uint32_t KNoBucket (UINT32_MAX);
+
+/**
+ * @brief Pseudos de l'entrepôt, un par ligne : la ligne donne le numéro
+ */
+void loadPseudos (const string & baseName, PlayerRegistry & players) {
+    players.clear();
+    ifstream file(baseName + KPseudoSuffix);
+    string pseudo;
+    while (getline(file, pseudo)) players.intern(pseudo);
+}
+
+/**
+ * @brief Recopie un champ des parties à la suite dans buffer
+ */
+template <typename T>
+void gatherField (const GameRecord * records, size_t count, T GameRecord::* field, vector<char> & buffer) {
+    buffer.resize(count * sizeof(T));
+    char * out = buffer.data();
+    for (size_t k = 0; k < count; ++k, out += sizeof(T)) memcpy(out, &(records[k].*field), sizeof(T));
+}
+
+/**
+ * @brief Appelle visit(i) pour chaque partie i du joueur (KNoPlayer : tous) dans le mode, bloc par bloc
+ *
+ * Le filtre compacte sans branchement les numéros des parties retenues d'un bloc ; visit ne voit
+ * que celles-ci, sans le test imprévisible d'une partie sur deux ou trois.
+ */
+template <typename Visit>
+void forEachGame (const StatColumns & columns, uint32_t player, uint8_t mode, Visit visit) {
+    const uint32_t everyone = player == KNoPlayer;
+    uint32_t hits [KStatBlock];
+    for (size_t first = 0; first < columns.count; first += KStatBlock) {
+        const size_t last = min(columns.count, first + KStatBlock);
+        size_t found = 0;
+        for (size_t i = first; i < last; ++i) {
+            hits[found] = i - first;
+            found += (everyone | (columns.players[i] == player)) & (columns.modes[i] == mode);
+        }
+        for (size_t k = 0; k < found; ++k) visit(first + hits[k]);
+    }
+}
+
+} // namespace
+
+// --- 1. LES REQUETES ---
+
+// Les boucles ne branchent pas sur le filtre : une partie retenue vaut 1 (masque de bits à 1), une autre 0
+
+StatSummary summarizeGames (const StatColumns & columns, uint32_t player, GameMode mode) {
+    const uint32_t everyone = player == KNoPlayer;
+    const uint8_t wanted = mode;
+    uint64_t games = 0, totalScore = 0, bestScore = 0, moves = 0, comboSteps = 0;
+    for (size_t i = 0; i < columns.count; ++i) {
+        const uint32_t hit = (everyone | (columns.players[i] == player)) & (columns.modes[i] == wanted);
+        const uint32_t mask = 0 - hit;
+        const uint64_t score = columns.scores[i] & (0 - uint64_t(hit));
+        games += hit;
+        totalScore += score;
+        bestScore = max(bestScore, score);
+        moves += columns.moves[i] & mask;
+        comboSteps += columns.comboSteps[i] & mask;
+    }
+    StatSummary summary;
+    summary.games = games;
+    summary.totalScore = totalScore;
+    summary.bestScore = bestScore;
+    summary.moves = moves;
+    summary.comboSteps = comboSteps;
+    return summary;
+}
+
+void countGamesPerMode (const StatColumns & columns, uint32_t player, uint64_t counts [KNbGameModes]) {
+    const uint32_t everyone = player == KNoPlayer;
+    uint64_t classic = 0, timeTrial = 0, target = 0;
+    for (size_t i = 0; i < columns.count; ++i) {
+        const uint32_t mine = everyone | (columns.players[i] == player);
+        const uint8_t mode = columns.modes[i];
+        classic += mine & (mode == ModeClassic);
+        timeTrial += mine & (mode == ModeTimeTrial);
+        target += mine & (mode == ModeTarget);
+    }
+    counts[ModeClassic] = classic;
+    counts[ModeTimeTrial] = timeTrial;
+    counts[ModeTarget] = target;
+}
+
+bool scorePercentiles (const StatColumns & columns, uint32_t player, GameMode mode, const vector<double> & percents,
+                       vector<uint64_t> & scores) {
+    scores.clear();
+
+    // Sélection par histogramme, sans recopier les scores retenus : les KHistogramBits bits de tête
+    // d'un score donnent son seau. Un score trop grand pour l'histogramme le fait replier (deux seaux
+    // voisins n'en font plus qu'un), ce qui n'arrive qu'une fois par bit de score.
+    vector<uint64_t> histogram (size_t(1) << KHistogramBits, 0);
+    unsigned shift = 0;
+    uint64_t matching = 0;
+    forEachGame(columns, player, mode, [&] (size_t i) {
+        while ((columns.scores[i] >> shift) >= histogram.size()) {
+            for (size_t bucket = 0; bucket < histogram.size() / 2; ++bucket)
+                histogram[bucket] = histogram[2 * bucket] + histogram[2 * bucket + 1];
+            fill(histogram.begin() + histogram.size() / 2, histogram.end(), 0);
+            shift++;
+        }
+        histogram[columns.scores[i] >> shift]++;
+        matching++;
+    });
+    if (matching == 0) return false;
+
+    // Seau de chaque centile (cumul des seaux) et rang du centile dans son seau
+    vector<uint32_t> bucketSlots (histogram.size(), KNoBucket);
+    vector<uint32_t> buckets;
+    vector<uint64_t> ranks (percents.size());
+    vector<uint32_t> slots (percents.size());
+    for (size_t k = 0; k < percents.size(); ++k) {
+        const double percent = min(100.0, max(0.0, percents[k]));
+        uint64_t rank = min(matching - 1, uint64_t(ceil(percent / 100.0 * matching)) - (percent > 0));
+        uint32_t bucket = 0;
+        while (rank >= histogram[bucket]) rank -= histogram[bucket++];
+        if (bucketSlots[bucket] == KNoBucket) {
+            bucketSlots[bucket] = buckets.size();
+            buckets.push_back(bucket);
+        }
+        ranks[k] = rank;
+        slots[k] = bucketSlots[bucket];
+    }
+
+    // Seuls les scores des seaux des centiles sont gardés, puis départagés dans leur seau
+    vector<vector<uint64_t> > members (buckets.size());
+    for (size_t slot = 0; slot < buckets.size(); ++slot) members[slot].reserve(histogram[buckets[slot]]);
+    forEachGame(columns, player, mode, [&] (size_t i) {
+        const uint32_t slot = bucketSlots[columns.scores[i] >> shift];
+        if (slot != KNoBucket) members[slot].push_back(columns.scores[i]);
+    });
+    scores.resize(percents.size());
+    for (size_t k = 0; k < percents.size(); ++k) {
+        vector<uint64_t> & bucket = members[slots[k]];
+        nth_element(bucket.begin(), bucket.begin() + ranks[k], bucket.end());
+        scores[k] = bucket[ranks[k]];
+    }
+    return true;
+}
+
+void movesOverTime (const StatColumns & columns, uint32_t player, uint32_t bucketSeconds, vector<TimeBucket> & buckets) {
+    buckets.clear();
+    const uint32_t width = max<uint32_t>(1, bucketSeconds);
+    map<uint32_t, TimeBucket> periods;
+    forEachGame(columns, player, ModeTarget, [&] (size_t i) {
+        const uint32_t start = columns.times[i] - columns.times[i] % width;
+        TimeBucket & bucket = periods.emplace(start, TimeBucket {start, 0, 0}).first->second;
+        bucket.games++;
+        bucket.moves += columns.moves[i];
+    });
+    for (const auto & period : periods) buckets.push_back(period.second);
+}
+
+// --- 2. LA LECTURE DE L'ENTREPOT ---
+
+StatsStore::~StatsStore () {
+    close();
+}
+
+const void * StatsStore::mapColumn (const string & fileName, unsigned width, size_t & count) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(ColumnHeader)) {
+        ::close(fd);
+        return nullptr;
+    }
+    void * data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    // Les requêtes lisent chaque colonne d'un bout à l'autre
+    madvise(data, info.st_size, MADV_WILLNEED);
+    myMappings.push_back(Mapping {data, size_t(info.st_size)});
+
+    const ColumnHeader * header = static_cast<const ColumnHeader *>(data);
+    if (memcmp(header->magic, KColumnMagic, sizeof(KColumnMagic)) != 0 || header->version != KColumnVersion
+        || header->width != width) return nullptr;
+    count = (info.st_size - sizeof(ColumnHeader)) / width;
+    return static_cast<const char *>(data) + sizeof(ColumnHeader);
+}
+
+bool StatsStore::open (const string & baseName) {
+    CANDY_TIMER(PhaseScoreFile);
+    close();
+    const void * data [KNbStatColumns];
+    size_t count = SIZE_MAX;
+    for (unsigned c = 0; c < KNbStatColumns; ++c) {
+        size_t rows;
+        data[c] = mapColumn(baseName + KColumnFiles[c].suffix, KColumnFiles[c].width, rows);
+        if (!data[c]) {
+            close();
+            return false;
+        }
+        // Une écriture interrompue peut laisser une colonne plus longue que les autres
+        count = min(count, rows);
+    }
+    myColumns.players = static_cast<const uint32_t *>(data[ColumnPlayer]);
+    myColumns.modes = static_cast<const uint8_t *>(data[ColumnMode]);
+    myColumns.scores = static_cast<const uint64_t *>(data[ColumnScore]);
+    myColumns.moves = static_cast<const uint32_t *>(data[ColumnMoves]);
+    myColumns.comboSteps = static_cast<const uint32_t *>(data[ColumnCombo]);
+    myColumns.times = static_cast<const uint32_t *>(data[ColumnTime]);
+    myColumns.count = count;
+    loadPseudos(baseName, myPlayers);
+    return true;
+}
+
+void StatsStore::close () {
+    for (const Mapping & mapping : myMappings) munmap(mapping.data, mapping.bytes);
+    myMappings.clear();
+    myColumns = StatColumns();
+    myPlayers.clear();
+}
+
+// --- 3. L'AJOUT DE PARTIES ---
+
+StatsWriter::StatsWriter (const string & baseName) : myBaseName(baseName), myFiles(KNbStatColumns, -1), myRows(0) {
+    loadPseudos(baseName, myPlayers);
+
+    size_t count = SIZE_MAX;
+    for (unsigned c = 0; c < KNbStatColumns; ++c) {
+        const int fd = ::open((baseName + KColumnFiles[c].suffix).c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        myFiles[c] = fd;
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            stop();
+            return;
+        }
+        if (info.st_size == 0) {
+            ColumnHeader header;
+            memcpy(header.magic, KColumnMagic, sizeof(KColumnMagic));
+            header.version = KColumnVersion;
+            header.width = KColumnFiles[c].width;
+            if (::write(fd, &header, sizeof(header)) != ssize_t(sizeof(header))) {
+                stop();
+                return;
+            }
+            info.st_size = sizeof(header);
+        }
+        count = min(count, size_t(info.st_size - sizeof(ColumnHeader)) / KColumnFiles[c].width);
+    }
+
+    // Colonnes ramenées à la même longueur : les parties suivantes restent alignées d'une colonne à l'autre
+    myRows = count;
+    if (!truncateColumns()) stop();
+}
+
+StatsWriter::~StatsWriter () {
+    for (int fd : myFiles) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+uint32_t StatsWriter::player (const string & pseudo) {
+    uint32_t id = myPlayers.find(pseudo);
+    if (id != KNoPlayer) return id;
+
+    id = myPlayers.intern(pseudo);
+    ofstream file(myBaseName + KPseudoSuffix, ios::app);
+    file << pseudo << '\n';
+    return id;
+}
+
+bool StatsWriter::append (const GameRecord * records, size_t count) {
+    CANDY_TIMER(PhaseScoreFile);
+    if (!ready()) return false;
+    for (unsigned c = 0; c < KNbStatColumns; ++c) {
+        switch (c) {
+            case ColumnPlayer: gatherField(records, count, &GameRecord::player, myBuffer); break;
+            case ColumnMode: gatherField(records, count, &GameRecord::mode, myBuffer); break;
+            case ColumnScore: gatherField(records, count, &GameRecord::score, myBuffer); break;
+            case ColumnMoves: gatherField(records, count, &GameRecord::moves, myBuffer); break;
+            case ColumnCombo: gatherField(records, count, &GameRecord::comboSteps, myBuffer); break;
+            case ColumnTime: gatherField(records, count, &GameRecord::time, myBuffer); break;
+        }
+        if (::write(myFiles[c], myBuffer.data(), myBuffer.size()) != ssize_t(myBuffer.size())) {
+            // Les colonnes déjà écrites (et celle-ci, peut-être en partie) reviennent à leur longueur d'avant
+            if (!truncateColumns()) stop();
+            return false;
+        }
+    }
+    myRows += count;
+    return true;
+}
+
+bool StatsWriter::truncateColumns () {
+    for (unsigned c = 0; c < KNbStatColumns; ++c) {
+        if (ftruncate(myFiles[c], sizeof(ColumnHeader) + myRows * KColumnFiles[c].width) != 0) return false;
+    }
+    return true;
+}
+
+void StatsWriter::stop () {
+    for (int & fd : myFiles) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+}
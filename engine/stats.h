@@ -0,0 +1,206 @@
+/**
+ * @file stats.h
+ * @brief Statistiques des parties par joueur : colonnes en ajout seul et agrégats parcourus d'une traite
+ *
+ * Chaque partie terminée des trois modes ajoute une ligne à un entrepôt de
+ * colonnes : un fichier par champ (joueur, mode, score, coups, pas de
+ * cascade, date), chacun un en-tête puis un tableau de valeurs de taille
+ * fixe. Une requête ne lit que les colonnes dont elle a besoin, à la suite,
+ * dans des fichiers projetés en mémoire ; les boucles de filtre sont sans
+ * branchement (masques) pour que le compilateur les vectorise.
+ *
+ * Les pseudos sont dans un fichier à part, un par ligne : le numéro d'un
+ * joueur (players.h) est sa ligne. Une écriture interrompue laisse des
+ * colonnes de longueurs différentes : seules les parties présentes dans
+ * toutes les colonnes sont lues.
+ */
+#ifndef CANDY_STATS_H
+#define CANDY_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "players.h"
+
+const unsigned KNbGameModes (ModeTarget + 1);
+
+/**
+ * @struct GameRecord
+ * @brief Une partie terminée
+ */
+struct GameRecord {
+    std::uint32_t player;      // numéro dans le registre de l'entrepôt
+    std::uint8_t mode;         // GameMode
+    std::uint64_t score;
+    std::uint32_t moves;       // coups joués
+    std::uint32_t comboSteps;  // somme des combos de chaque coup (pas de cascade)
+    std::uint32_t time;        // fin de la partie, secondes depuis 1970
+};
+
+/**
+ * @struct StatColumns
+ * @brief Vue sur les colonnes : fichiers projetés ou tableaux en mémoire
+ */
+struct StatColumns {
+    const std::uint32_t * players = nullptr;
+    const std::uint8_t * modes = nullptr;
+    const std::uint64_t * scores = nullptr;
+    const std::uint32_t * moves = nullptr;
+    const std::uint32_t * comboSteps = nullptr;
+    const std::uint32_t * times = nullptr;
+    std::size_t count = 0;
+};
+
+/**
+ * @struct StatSummary
+ * @brief Agrégats des parties d'un joueur dans un mode
+ */
+struct StatSummary {
+    std::uint64_t games = 0;
+    std::uint64_t totalScore = 0;
+    std::uint64_t bestScore = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t comboSteps = 0;
+
+    double averageScore () const { return games ? double(totalScore) / games : 0.0; }
+
+    /**
+     * @brief Profondeur moyenne des combos : pas de cascade par coup
+     */
+    double averageCombo () const { return moves ? double(comboSteps) / moves : 0.0; }
+};
+
+/**
+ * @struct TimeBucket
+ * @brief Parties du mode Cible d'une période
+ */
+struct TimeBucket {
+    std::uint32_t start;   // début de la période, secondes depuis 1970
+    std::uint64_t games;
+    std::uint64_t moves;
+
+    double averageMoves () const { return games ? double(moves) / games : 0.0; }
+};
+
+// --- 1. LES REQUETES ---
+
+/**
+ * @brief Agrégats des parties d'un joueur (KNoPlayer : tous) dans un mode
+ */
+StatSummary summarizeGames (const StatColumns & columns, std::uint32_t player, GameMode mode);
+
+/**
+ * @brief Nombre de parties du joueur (KNoPlayer : tous) dans chaque mode, rangé par GameMode
+ */
+void countGamesPerMode (const StatColumns & columns, std::uint32_t player, std::uint64_t counts [KNbGameModes]);
+
+/**
+ * @brief Scores aux centiles demandés (0 à 100) parmi les parties du joueur dans un mode
+ * @return false si le joueur n'a aucune partie dans ce mode
+ */
+bool scorePercentiles (const StatColumns & columns, std::uint32_t player, GameMode mode,
+                       const std::vector<double> & percents, std::vector<std::uint64_t> & scores);
+
+/**
+ * @brief Coups pour atteindre la cible, période par période (périodes sans partie omises)
+ */
+void movesOverTime (const StatColumns & columns, std::uint32_t player, std::uint32_t bucketSeconds,
+                    std::vector<TimeBucket> & buckets);
+
+// --- 2. L'ENTREPOT ---
+
+/**
+ * @brief Lecture d'un entrepôt : colonnes projetées en mémoire et registre des pseudos
+ */
+class StatsStore {
+public:
+    StatsStore () = default;
+    ~StatsStore ();
+    StatsStore (const StatsStore &) = delete;
+    StatsStore & operator= (const StatsStore &) = delete;
+
+    /**
+     * @brief Projette les colonnes de l'entrepôt baseName
+     * @return false si une colonne est absente ou n'est pas une colonne de l'entrepôt
+     */
+    bool open (const std::string & baseName);
+
+    void close ();
+
+    const StatColumns & columns () const { return myColumns; }
+    const PlayerRegistry & players () const { return myPlayers; }
+
+private:
+    const void * mapColumn (const std::string & fileName, unsigned width, std::size_t & count);
+
+    struct Mapping {
+        void * data;
+        std::size_t bytes;
+    };
+
+    std::vector<Mapping> myMappings;
+    StatColumns myColumns;
+    PlayerRegistry myPlayers;
+};
+
+/**
+ * @brief Ajout de parties à la fin des colonnes d'un entrepôt (créé au besoin)
+ *
+ * Les colonnes avancent ensemble : un ajout qui échoue sur une colonne
+ * ramène toutes les colonnes à leur longueur d'avant l'ajout, sans quoi les
+ * parties suivantes seraient décalées d'une colonne à l'autre. Si une
+ * colonne ne peut être ni ouverte ni ramenée à sa longueur, l'écrivain
+ * s'arrête : plus aucun ajout n'est écrit.
+ */
+class StatsWriter {
+public:
+    explicit StatsWriter (const std::string & baseName);
+    ~StatsWriter ();
+    StatsWriter (const StatsWriter &) = delete;
+    StatsWriter & operator= (const StatsWriter &) = delete;
+
+    /**
+     * @brief Numéro du joueur, ajouté au fichier des pseudos s'il est nouveau
+     */
+    std::uint32_t player (const std::string & pseudo);
+
+    /**
+     * @brief Ajoute les parties, une écriture par colonne
+     * @return false si une colonne n'a pas pu être écrite (aucune partie n'est alors ajoutée) ou si l'écrivain est arrêté
+     */
+    bool append (const GameRecord * records, std::size_t count);
+
+    bool append (const GameRecord & record) { return append(&record, 1); }
+
+    /**
+     * @brief Faux si l'écrivain est arrêté
+     */
+    bool ready () const { return myFiles[0] >= 0; }
+
+    /**
+     * @brief Parties présentes dans toutes les colonnes
+     */
+    std::size_t rows () const { return myRows; }
+
+private:
+    /**
+     * @brief Ramène chaque colonne à myRows parties
+     */
+    bool truncateColumns ();
+
+    /**
+     * @brief Ferme toutes les colonnes : les ajouts suivants échouent
+     */
+    void stop ();
+
+    std::string myBaseName;
+    std::vector<int> myFiles;      // une colonne par descripteur, toutes à -1 si l'écrivain est arrêté
+    std::size_t myRows;
+    PlayerRegistry myPlayers;
+    std::vector<char> myBuffer;
+};
+
+#endif // CANDY_STATS_H
@@ -0,0 +1,318 @@
+#include "tiled.h"
+#include "events.h"
+#include "grid.h"
+#include "spawn.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char KTiledMagic[8] = {'C', 'A', 'N', 'D', 'Y', 'T', 'I', 'L'};
+const uint32_t KTiledVersion (1);
+
+/**
+ * @struct TiledHeader
+ * @brief Début du fichier, suivi des tuiles à partir de KTiledHeaderBytes
+ */
+struct TiledHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint32_t nbCandies;
+};
+
+size_t tiledBytes (unsigned size) {
+    const size_t tiles = (size + KTileSide - 1) / KTileSide;
+    return KTiledHeaderBytes + tiles * tiles * KTileBytes;
+}
+
+/**
+ * @brief Regarde si la case du milieu de a b c d e est dans un alignement de 3 ou plus
+ */
+inline bool inRun (unsigned a, unsigned b, unsigned c, unsigned d, unsigned e) {
+    // Sans branche : le résultat dépend des couleurs tirées, un saut serait mal prédit une fois sur deux
+    const bool left = b == c, right = d == c;
+    return (left & (a == c)) | (left & right) | (right & (e == c));
+}
+
+} // namespace
+
+// --- 1. LE FICHIER ---
+
+TiledBoard::~TiledBoard () {
+    close();
+}
+
+bool TiledBoard::create (const string & fileName, unsigned size, unsigned nbCandies) {
+    close();
+    if (size < 3 || nbCandies < 3 || nbCandies > KColourMask) return false;
+    const size_t bytes = tiledBytes(size);
+    int fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    // Fichier creux : les tuiles ne prennent de la place qu'une fois écrites
+    if (ftruncate(fd, bytes) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void * data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+
+    myData = static_cast<uint8_t *>(data);
+    myBytes = bytes;
+    mySize = size;
+    myNbCandies = nbCandies;
+    myTiles = (size + KTileSide - 1) / KTileSide;
+
+    TiledHeader header;
+    memcpy(header.magic, KTiledMagic, sizeof(KTiledMagic));
+    header.version = KTiledVersion;
+    header.size = size;
+    header.nbCandies = nbCandies;
+    memcpy(myData, &header, sizeof(header));
+    return true;
+}
+
+bool TiledBoard::open (const string & fileName) {
+    close();
+    int fd = ::open(fileName.c_str(), O_RDWR);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < KTiledHeaderBytes) {
+        ::close(fd);
+        return false;
+    }
+    void * data = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+    myData = static_cast<uint8_t *>(data);
+    myBytes = info.st_size;
+
+    TiledHeader header;
+    memcpy(&header, myData, sizeof(header));
+    if (memcmp(header.magic, KTiledMagic, sizeof(KTiledMagic)) != 0 || header.version != KTiledVersion
+        || header.size < 3 || header.nbCandies < 3 || header.nbCandies > KColourMask
+        || tiledBytes(header.size) != myBytes) {
+        close();
+        return false;
+    }
+    mySize = header.size;
+    myNbCandies = header.nbCandies;
+    myTiles = (mySize + KTileSide - 1) / KTileSide;
+    return true;
+}
+
+void TiledBoard::close () {
+    if (myData) munmap(myData, myBytes);
+    myData = nullptr;
+    myBytes = 0;
+    mySize = 0;
+    myNbCandies = 0;
+    myTiles = 0;
+}
+
+void TiledBoard::releaseStrip (unsigned strip) {
+    madvise(myData + KTiledHeaderBytes + size_t(strip) * myTiles * KTileBytes, myTiles * KTileBytes, MADV_DONTNEED);
+}
+
+void TiledBoard::touchTile (unsigned ord, unsigned strip) {
+    const size_t tile = size_t(strip) * myTiles + ord / KTileSide;
+    if (!myStepTiles[tile]) {
+        myStepTiles[tile] = 1;
+        myStepVisits++;
+    }
+    myAllTiles[tile] = 1;
+}
+
+// --- 2. LE REMPLISSAGE ---
+
+void TiledBoard::fill (uint64_t seed) {
+    // Trois lignes de la bande, avec les deux cases de gauche prises dans la bande précédente
+    vector<uint8_t> rows (3 * (KTileSide + 2));
+    uint8_t * up2 = rows.data();
+    uint8_t * up1 = up2 + KTileSide + 2;
+    uint8_t * current = up1 + KTileSide + 2;
+
+    for (unsigned strip = 0; strip < myTiles; ++strip) {
+        const unsigned first = strip * KTileSide;
+        const unsigned width = min(KTileSide, mySize - first);
+        uint64_t state = forkSeed(seed, strip);
+        RandomScope randomScope(&state);
+        std::fill(rows.begin(), rows.end(), 0);
+
+        for (unsigned i = 0; i < mySize; ++i) {
+            current[0] = first >= 2 ? get(i, first - 2) : 0;
+            current[1] = first >= 1 ? get(i, first - 1) : 0;
+            for (unsigned x = 0; x < width; ++x) {
+                // Même règle que initGrid : les couleurs qui complèteraient un alignement à gauche ou en haut sont sautées
+                const unsigned forbidLeft = current[x] == current[x + 1] ? current[x + 1] : KImpossible;
+                const unsigned forbidUp = up1[x + 2] == up2[x + 2] ? up1[x + 2] : KImpossible;
+                const unsigned nbForbidden = (forbidLeft != KImpossible) + (forbidUp != KImpossible && forbidUp != forbidLeft);
+                unsigned candy = spawnRandom() % (myNbCandies - nbForbidden) + 1;
+                unsigned type = 1;
+                for (; type <= myNbCandies; ++type) {
+                    if (type == forbidLeft || type == forbidUp) continue;
+                    if (--candy == 0) break;
+                }
+                current[x + 2] = type;
+            }
+            uint8_t * segment = cellByte(i, first);
+            for (unsigned x = 0; x < width; x += 2)
+                segment[x / 2] = current[x + 2] | (x + 1 < width ? current[x + 3] << 4 : 0);
+            rotate(rows.begin(), rows.begin() + KTileSide + 2, rows.end());
+        }
+        if (strip > 0) releaseStrip(strip - 1);
+    }
+    if (myTiles > 0) releaseStrip(myTiles - 1);
+}
+
+// --- 3. LA REACTION EN CHAINE ---
+
+void TiledBoard::loadRow (unsigned strip, int ord, uint8_t * cells) {
+    const unsigned first = strip * KTileSide;
+    const unsigned width = min(KTileSide, mySize - first);
+    if (ord < 0 || ord >= int(mySize)) {
+        std::fill(cells, cells + width + 4, 0);
+        return;
+    }
+
+    // Halo de gauche : la bande précédente a déjà bougé, ses colonnes de bord d'origine ont été gardées
+    for (unsigned x = 0; x < 2; ++x) {
+        const int abs = int(first) - 2 + x;
+        if (abs < 0) cells[x] = 0;
+        else if (unsigned(ord) < myEdgeRows) cells[x] = myEdge[size_t(ord) * 2 + x];
+        else cells[x] = get(ord, abs);
+    }
+    if (first > 0 && unsigned(ord) >= myEdgeRows) touchTile(ord, strip - 1);
+
+    const uint8_t * segment = cellByte(ord, first);
+    for (unsigned x = 0; x < width; ++x) cells[x + 2] = x % 2 ? segment[x / 2] >> 4 : segment[x / 2] & 0xF;
+    touchTile(ord, strip);
+
+    // Halo de droite : la bande suivante n'a pas encore bougé
+    for (unsigned x = 0; x < 2; ++x) {
+        const unsigned abs = first + width + x;
+        cells[width + 2 + x] = abs < mySize ? get(ord, abs) : 0;
+    }
+    if (first + width < mySize) touchTile(ord, strip + 1);
+}
+
+uint64_t TiledBoard::resolveStrip (unsigned strip, unsigned rows, vector<uint64_t> & random, unsigned & lowest) {
+    const unsigned first = strip * KTileSide;
+    const unsigned width = min(KTileSide, mySize - first);
+    const unsigned stride = width + 4;
+
+    // Fenêtre des lignes d'origine : deux au-dessus, la ligne courante, deux au-dessous
+    vector<uint8_t> window (5 * stride);
+    uint8_t * up2 = &window[0];
+    uint8_t * up1 = &window[stride];
+    uint8_t * current = &window[2 * stride];
+    uint8_t * down1 = &window[3 * stride];
+    uint8_t * down2 = &window[4 * stride];
+    loadRow(strip, rows + 1, down2);
+    loadRow(strip, rows, down1);
+    loadRow(strip, rows - 1, current);
+    loadRow(strip, int(rows) - 2, up1);
+    loadRow(strip, int(rows) - 3, up2);
+
+    // De bas en haut : une case non alignée descend du nombre de cases vidées au-dessous d'elle
+    unsigned drop [KTileSide] = {};
+    uint64_t cleared = 0;
+    lowest = 0;
+    for (int i = rows - 1; i >= 0; --i) {
+        myNextEdge[size_t(i) * 2] = current[width];
+        myNextEdge[size_t(i) * 2 + 1] = current[width + 1];
+        unsigned rowCleared = 0;
+        for (unsigned x = 0; x < width; ++x) {
+            const unsigned type = current[x + 2];
+            const bool matched = (type != KImpossible)
+                & (inRun(current[x], current[x + 1], type, current[x + 3], current[x + 4])
+                   | inRun(up2[x + 2], up1[x + 2], type, down1[x + 2], down2[x + 2]));
+            if (matched) {
+                drop[x]++;
+                rowCleared++;
+            }
+            else if (drop[x] > 0) {
+                set(i + drop[x], first + x, type);
+            }
+        }
+        cleared += rowCleared;
+        if (rowCleared > 0 && lowest == 0) lowest = i + 1;
+
+        uint8_t * reused = down2;
+        down2 = down1;
+        down1 = current;
+        current = up1;
+        up1 = up2;
+        up2 = reused;
+        loadRow(strip, i - 3, up2);
+    }
+
+    // Remplissage du haut de chaque colonne, dans le générateur de la colonne
+    for (unsigned x = 0; x < width; ++x) {
+        if (drop[x] == 0) continue;
+        RandomScope randomScope(&random[first + x]);
+        for (unsigned i = 0; i < drop[x]; ++i) set(i, first + x, (spawnRandom() % myNbCandies) + 1);
+    }
+    return cleared;
+}
+
+TiledReport TiledBoard::resolve (uint64_t seed, unsigned maxSteps) {
+    TiledReport report = {0, 0, 0, 0, 0, 0};
+    if (!myData) return report;
+    struct rusage before;
+    getrusage(RUSAGE_SELF, &before);
+
+    vector<uint64_t> random (mySize);
+    for (unsigned j = 0; j < mySize; ++j) random[j] = forkSeed(seed, j);
+    myEdge.assign(size_t(mySize) * 2, 0);
+    myNextEdge.assign(size_t(mySize) * 2, 0);
+    myAllTiles.assign(size_t(myTiles) * myTiles, 0);
+    myStepTiles.assign(size_t(myTiles) * myTiles, 0);
+
+    // Lignes à relire : toute la grille au premier pas, puis seulement les lignes qui ont bougé
+    // (au-dessus de la case vidée la plus basse) et les deux lignes au-dessous qu'elles touchent.
+    // Le compte est le même pour toutes les bandes : un alignement horizontal peut les traverser.
+    unsigned dirtyRows = mySize;
+    while (maxSteps == 0 || report.steps < maxSteps) {
+        std::fill(myStepTiles.begin(), myStepTiles.end(), 0);
+        myStepVisits = 0;
+        myEdgeRows = 0;
+        uint64_t cleared = 0;
+        unsigned lowest = 0;
+
+        for (unsigned strip = 0; strip < myTiles; ++strip) {
+            unsigned stripLowest = 0;
+            cleared += resolveStrip(strip, dirtyRows, random, stripLowest);
+            lowest = max(lowest, stripLowest);
+            swap(myEdge, myNextEdge);
+            myEdgeRows = dirtyRows;
+            if (strip > 0) releaseStrip(strip - 1);
+        }
+        releaseStrip(myTiles - 1);
+        report.tileVisits += myStepVisits;
+        if (cleared == 0) break;
+
+        report.steps++;
+        report.cleared += cleared;
+        dirtyRows = min(mySize, lowest + 2);
+        emitEvent(EventCascadeStep, 0, report.steps, 0, 0, 0);
+    }
+
+    report.tilesTouched = count(myAllTiles.begin(), myAllTiles.end(), 1);
+    struct rusage after;
+    getrusage(RUSAGE_SELF, &after);
+    report.minorFaults = after.ru_minflt - before.ru_minflt;
+    report.majorFaults = after.ru_majflt - before.ru_majflt;
+    return report;
+}
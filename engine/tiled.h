@@ -0,0 +1,140 @@
+/**
+ * @file tiled.h
+ * @brief Grille projetée depuis un fichier, découpée en tuiles, pour les grilles plus grandes que la mémoire
+ *
+ * La grille vit dans un fichier projeté en mémoire (mmap partagé), découpé
+ * en tuiles de KTileSide x KTileSide cases d'un quartet chacune (32 Ko).
+ * Les tuiles sont rangées colonne de tuiles après colonne de tuiles : une
+ * bande verticale de KTileSide colonnes est un seul morceau du fichier.
+ * Seules les tuiles lues ou écrites sont chargées par le système ; une
+ * bande terminée est rendue (madvise), ce qui borne la mémoire occupée.
+ *
+ * La réaction en chaîne (resolve) supprime tous les matchs à chaque pas,
+ * comme BandResolver, en parcourant la grille bande par bande et de bas en
+ * haut : la détection et la gravité se font dans le même passage, sur une
+ * fenêtre de cinq lignes d'origine gardée en mémoire (la ligne courante et
+ * deux lignes de halo de chaque côté). Les deux colonnes de bord de la
+ * bande précédente sont gardées avant d'être modifiées. Après le premier
+ * pas, seules les lignes au-dessus de la case vidée la plus basse, plus
+ * deux, sont relues.
+ *
+ * Règles de la partie libre : bonbons ordinaires, aucune case fixe.
+ */
+#ifndef CANDY_TILED_H
+#define CANDY_TILED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const unsigned KTileSide (256);                                  // côté d'une tuile (cases)
+const unsigned KTileRowBytes (KTileSide / 2);                    // une ligne de tuile : deux cases par octet
+const std::size_t KTileBytes (std::size_t(KTileSide) * KTileRowBytes);
+const std::size_t KTiledHeaderBytes (4096);                      // en-tête : une page, les tuiles restent alignées
+
+/**
+ * @struct TiledReport
+ * @brief Bilan d'une réaction en chaîne sur une grille en tuiles
+ */
+struct TiledReport {
+    unsigned steps;                 // pas (tous les matchs d'un pas supprimés à la fois)
+    std::uint64_t cleared;          // cases vidées
+    std::uint64_t tileVisits;       // tuiles lues ou écrites, additionnées sur tous les pas
+    std::uint64_t tilesTouched;     // tuiles différentes touchées
+    long minorFaults;               // défauts de page sans lecture disque
+    long majorFaults;               // défauts de page avec lecture disque
+};
+
+/**
+ * @brief Grille carrée dans un fichier projeté, en tuiles de quartets
+ */
+class TiledBoard {
+public:
+    TiledBoard () = default;
+    ~TiledBoard ();
+    TiledBoard (const TiledBoard &) = delete;
+    TiledBoard & operator= (const TiledBoard &) = delete;
+
+    /**
+     * @brief Crée le fichier d'une grille size x size (cases vides) et le projette
+     * @return false si le fichier ne peut pas être créé ou projeté
+     */
+    bool create (const std::string & fileName, unsigned size, unsigned nbCandies);
+
+    /**
+     * @brief Projette une grille créée par create
+     * @return false si le fichier est absent ou n'est pas une grille en tuiles
+     */
+    bool open (const std::string & fileName);
+
+    void close ();
+
+    unsigned size () const { return mySize; }
+    unsigned nbCandies () const { return myNbCandies; }
+    std::size_t fileBytes () const { return myBytes; }
+
+    unsigned get (unsigned ord, unsigned abs) const {
+        const std::uint8_t byte = *cellByte(ord, abs);
+        return abs % 2 ? byte >> 4 : byte & 0xF;
+    }
+
+    void set (unsigned ord, unsigned abs, unsigned colour) {
+        std::uint8_t & byte = *cellByte(ord, abs);
+        byte = abs % 2 ? (byte & 0x0F) | (colour << 4) : (byte & 0xF0) | colour;
+    }
+
+    /**
+     * @brief Remplit la grille sans alignement de départ, bande par bande (même règle que initGrid)
+     * @param seed Graine : chaque bande tire dans son propre générateur
+     */
+    void fill (std::uint64_t seed);
+
+    /**
+     * @brief Résout toute la réaction en chaîne
+     * @param seed Graine des remplissages (un générateur par colonne)
+     * @param maxSteps Nombre maximal de pas (0 : jusqu'au bout)
+     */
+    TiledReport resolve (std::uint64_t seed, unsigned maxSteps = 0);
+
+private:
+    std::uint8_t * cellByte (unsigned ord, unsigned abs) const {
+        const std::size_t tile = std::size_t(abs / KTileSide) * myTiles + ord / KTileSide;
+        return myData + KTiledHeaderBytes + tile * KTileBytes + (ord % KTileSide) * KTileRowBytes + (abs % KTileSide) / 2;
+    }
+
+    /**
+     * @brief Rend au système les pages de la bande strip (elles restent dans le fichier)
+     */
+    void releaseStrip (unsigned strip);
+
+    /**
+     * @brief Un pas de la réaction en chaîne sur la bande strip
+     * @return Cases vidées
+     */
+    std::uint64_t resolveStrip (unsigned strip, unsigned rows, std::vector<std::uint64_t> & random,
+                                unsigned & lowest);
+
+    /**
+     * @brief Ligne ord de la bande et ses deux colonnes de halo de chaque côté, telle qu'avant le pas
+     */
+    void loadRow (unsigned strip, int ord, std::uint8_t * cells);
+
+    void touchTile (unsigned ord, unsigned strip);
+
+    std::uint8_t * myData = nullptr;
+    std::size_t myBytes = 0;
+    unsigned mySize = 0;
+    unsigned myNbCandies = 0;
+    unsigned myTiles = 0;                // tuiles par côté
+
+    // Pas en cours
+    std::vector<std::uint8_t> myEdge;        // colonnes de bord d'origine de la bande précédente (2 par ligne)
+    std::vector<std::uint8_t> myNextEdge;
+    unsigned myEdgeRows = 0;                 // lignes valides de myEdge (au-delà, la grille n'a pas changé)
+    std::vector<std::uint8_t> myStepTiles;   // tuiles touchées pendant le pas
+    std::vector<std::uint8_t> myAllTiles;    // tuiles touchées depuis le début de resolve
+    std::uint64_t myStepVisits = 0;
+};
+
+#endif // CANDY_TILED_H
@@ -0,0 +1,169 @@
+#include "trace.h"
+
+#ifdef CANDY_TRACE
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+atomic<bool> gTraceEnabled(false);
+
+namespace {
+
+/**
+ * @struct TraceEventRecord
+ * @brief Un événement tel qu'il est stocké dans l'anneau
+ */
+struct TraceEventRecord {
+    uint64_t timeNs;
+    const char * name;
+    int64_t arg;
+    char phase;
+};
+
+/**
+ * @brief Anneau à un producteur (le thread propriétaire) et un consommateur (le thread d'écriture)
+ */
+struct TraceRing {
+    static const uint64_t KCapacity = 1 << 16;   // puissance de 2
+    static const uint64_t KMask = KCapacity - 1;
+
+    TraceEventRecord events[KCapacity];
+    alignas(64) atomic<uint64_t> head {0};       // écrit par le producteur
+    alignas(64) atomic<uint64_t> tail {0};       // écrit par le consommateur
+    atomic<uint64_t> dropped {0};
+    unsigned threadIndex = 0;
+
+    /**
+     * @brief Ajoute un événement sans jamais bloquer : perdu si l'anneau est plein
+     */
+    void push (const TraceEventRecord & event) {
+        uint64_t h = head.load(memory_order_relaxed);
+        if (h - tail.load(memory_order_acquire) >= KCapacity) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        events[h & KMask] = event;
+        head.store(h + 1, memory_order_release);
+    }
+};
+
+thread_local TraceRing * tlsRing = nullptr;
+
+chrono::steady_clock::time_point gTraceStart;
+mutex gRingsMutex;
+vector<unique_ptr<TraceRing> > gRings;
+
+// Etat du thread d'écriture
+mutex gWriterMutex;
+condition_variable gWriterWake;
+bool gWriterStop = false;
+thread gWriter;
+ofstream gTraceFile;
+bool gFirstEvent = true;
+
+const chrono::milliseconds KFlushPeriod (20);
+
+TraceRing & localRing () {
+    if (tlsRing) return *tlsRing;
+    unique_ptr<TraceRing> ring(new TraceRing());
+    lock_guard<mutex> lock(gRingsMutex);
+    ring->threadIndex = gRings.size();
+    tlsRing = ring.get();
+    gRings.push_back(move(ring));
+    return *tlsRing;
+}
+
+void writeEvent (const TraceEventRecord & event, unsigned threadIndex) {
+    gTraceFile << (gFirstEvent ? "" : ",\n")
+               << "{\"name\": \"" << event.name << "\", \"ph\": \"" << event.phase
+               << "\", \"pid\": 1, \"tid\": " << threadIndex << ", \"ts\": " << event.timeNs / 1000.0;
+    if (event.phase == 'i') gTraceFile << ", \"s\": \"t\"";
+    if (event.arg >= 0) gTraceFile << ", \"args\": {\"n\": " << event.arg << "}";
+    gTraceFile << "}";
+    gFirstEvent = false;
+}
+
+/**
+ * @brief Vide tous les anneaux dans le fichier (seul le thread d'écriture appelle cette fonction)
+ */
+void drainRings () {
+    vector<TraceRing *> rings;
+    {
+        lock_guard<mutex> lock(gRingsMutex);
+        for (const unique_ptr<TraceRing> & ring : gRings) rings.push_back(ring.get());
+    }
+    for (TraceRing * ring : rings) {
+        uint64_t t = ring->tail.load(memory_order_relaxed);
+        uint64_t h = ring->head.load(memory_order_acquire);
+        for (; t != h; ++t) writeEvent(ring->events[t & TraceRing::KMask], ring->threadIndex);
+        ring->tail.store(t, memory_order_release);
+    }
+    gTraceFile.flush();
+}
+
+void writerLoop () {
+    unique_lock<mutex> lock(gWriterMutex);
+    while (!gWriterStop) {
+        gWriterWake.wait_for(lock, KFlushPeriod);
+        lock.unlock();
+        drainRings();
+        lock.lock();
+    }
+}
+
+} // namespace
+
+bool traceStart (const string & fileName) {
+    if (gTraceEnabled.load()) return false;
+    gTraceFile.open(fileName);
+    if (!gTraceFile.is_open()) return false;
+
+    // Les événements restés d'une trace précédente sont oubliés
+    {
+        lock_guard<mutex> lock(gRingsMutex);
+        for (const unique_ptr<TraceRing> & ring : gRings) {
+            ring->tail.store(ring->head.load());
+            ring->dropped.store(0);
+        }
+    }
+    gTraceFile << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    gFirstEvent = true;
+    gWriterStop = false;
+    gTraceStart = chrono::steady_clock::now();
+    gWriter = thread(writerLoop);
+    gTraceEnabled.store(true);
+    return true;
+}
+
+void traceStop () {
+    if (!gTraceEnabled.exchange(false)) return;
+    {
+        lock_guard<mutex> lock(gWriterMutex);
+        gWriterStop = true;
+    }
+    gWriterWake.notify_one();
+    gWriter.join();
+    drainRings();
+
+    uint64_t dropped = 0;
+    {
+        lock_guard<mutex> lock(gRingsMutex);
+        for (const unique_ptr<TraceRing> & ring : gRings) dropped += ring->dropped.load();
+    }
+    gTraceFile << "\n], \"otherData\": {\"events_dropped\": " << dropped << "}}\n";
+    gTraceFile.close();
+}
+
+void traceRecord (char phase, const char * name, int64_t arg) {
+    uint64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - gTraceStart).count();
+    localRing().push({now, name, arg, phase});
+}
+
+#endif // CANDY_TRACE
@@ -0,0 +1,88 @@
+/**
+ * @file trace.h
+ * @brief Chronologie d'une partie au format Chrome trace (chrome://tracing, Perfetto)
+ *
+ * Compilée seulement si CANDY_TRACE est défini (option CMake du même nom),
+ * sinon les macros CANDY_TRACE_* disparaissent. Même compilée, la trace ne
+ * coûte qu'un test de booléen tant que traceStart n'a pas été appelé.
+ *
+ * Chaque thread écrit ses événements (début, fin, instantané) dans son propre
+ * anneau sans verrou. Un thread d'écriture vide les anneaux en tâche de fond
+ * et écrit le JSON : la boucle de jeu n'attend jamais le disque. Si un anneau
+ * est plein, l'événement est perdu et compté.
+ *
+ * Les noms d'événements doivent être des chaînes littérales (durée de vie statique).
+ */
+#ifndef CANDY_TRACE_H
+#define CANDY_TRACE_H
+
+#include <cstdint>
+#include <string>
+
+#ifdef CANDY_TRACE
+
+#include <atomic>
+
+extern std::atomic<bool> gTraceEnabled;
+
+/**
+ * @brief Démarre la trace et le thread d'écriture
+ * @param fileName Fichier JSON produit
+ * @return false si la trace est déjà démarrée ou si le fichier ne peut pas être ouvert
+ */
+bool traceStart (const std::string & fileName);
+
+/**
+ * @brief Arrête la trace : vide les anneaux, termine le JSON et attend le thread d'écriture
+ */
+void traceStop ();
+
+/**
+ * @brief Enregistre un événement dans l'anneau du thread courant
+ * @param phase 'B' (début), 'E' (fin) ou 'i' (instantané)
+ * @param name Nom de l'événement (chaîne littérale)
+ * @param arg Argument affiché dans Perfetto (ignoré si négatif)
+ */
+void traceRecord (char phase, const char * name, std::int64_t arg);
+
+inline void traceEvent (char phase, const char * name, std::int64_t arg) {
+    if (gTraceEnabled.load(std::memory_order_relaxed)) traceRecord(phase, name, arg);
+}
+
+/**
+ * @brief Evénement de début à la construction, de fin à la destruction
+ */
+class TraceScope {
+public:
+    TraceScope (const char * name, std::int64_t arg) : myName(name) { traceEvent('B', name, arg); }
+    ~TraceScope () { traceEvent('E', myName, -1); }
+    TraceScope (const TraceScope &) = delete;
+    TraceScope & operator= (const TraceScope &) = delete;
+private:
+    const char * myName;
+};
+
+#define CANDY_TRACE_CONCAT2(a, b) a##b
+#define CANDY_TRACE_CONCAT(a, b) CANDY_TRACE_CONCAT2(a, b)
+
+#define CANDY_TRACE_SCOPE(name) TraceScope CANDY_TRACE_CONCAT(candyTrace_, __LINE__) (name, -1)
+#define CANDY_TRACE_SCOPE_ARG(name, arg) TraceScope CANDY_TRACE_CONCAT(candyTrace_, __LINE__) (name, (arg))
+#define CANDY_TRACE_BEGIN(name) traceEvent('B', name, -1)
+#define CANDY_TRACE_END(name) traceEvent('E', name, -1)
+#define CANDY_TRACE_INSTANT(name, arg) traceEvent('i', name, (arg))
+#define CANDY_TRACE_START(fileName) traceStart(fileName)
+#define CANDY_TRACE_STOP() traceStop()
+
+#else // CANDY_TRACE
+
+#define CANDY_TRACE_SCOPE(name) do {} while (0)
+#define CANDY_TRACE_SCOPE_ARG(name, arg) do {} while (0)
+#define CANDY_TRACE_BEGIN(name) do {} while (0)
+#define CANDY_TRACE_END(name) do {} while (0)
+#define CANDY_TRACE_INSTANT(name, arg) do {} while (0)
+#define CANDY_TRACE_START(fileName) do {} while (0)
+#define CANDY_TRACE_STOP() do {} while (0)
+
+#endif // CANDY_TRACE
+
+#endif // CANDY_TRACE_H
@@ -0,0 +1,122 @@
+#include "transposition.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Case de statistiques de chaque fil (attribuées à tour de rôle)
+atomic<unsigned> gNextStatSlot(0);
+thread_local unsigned tlsStatSlot = gNextStatSlot.fetch_add(1, memory_order_relaxed) % KStatSlots;
+
+const unsigned KDepthBits (8);
+const unsigned KMaxDepth ((1 << KDepthBits) - 1);
+
+uint64_t packEntry (unsigned depth, uint64_t score) {
+    return (min(score, KMaxTableScore) << KDepthBits) | min(depth, KMaxDepth);
+}
+
+/**
+ * @brief Clé gardée pour un hash : bit 0 forcé, une entrée vide (deux mots nuls) ne donne jamais une clé
+ *
+ * Dès qu'il y a deux paquets, le bit 0 du hash choisit déjà le paquet : les
+ * hashs h et h | 1 n'ont la même clé que dans des paquets différents.
+ */
+uint64_t entryKey (uint64_t hash) {
+    return hash | 1;
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable (size_t bytes) : myStats(KStatSlots) {
+    size_t nbBuckets = 1;
+    while (nbBuckets * 2 * sizeof(Bucket) <= bytes) nbBuckets *= 2;
+    myBuckets = vector<Bucket>(nbBuckets);
+    myMask = nbBuckets - 1;
+    clear();
+}
+
+TranspositionTable::StatSlot & TranspositionTable::statSlot () {
+    return myStats[tlsStatSlot];
+}
+
+bool TranspositionTable::probe (uint64_t hash, unsigned depth, uint64_t & score, unsigned & storedDepth) {
+    StatSlot & slot = statSlot();
+    slot.probes.fetch_add(1, memory_order_relaxed);
+    const Bucket & bucket = myBuckets[hash & myMask];
+    const uint64_t key = entryKey(hash);
+    for (const Entry & entry : bucket.entries) {
+        const uint64_t data = entry.data.load(memory_order_relaxed);
+        if ((entry.check.load(memory_order_relaxed) ^ data) != key) continue;
+        storedDepth = data & KMaxDepth;
+        if (storedDepth < min(depth, KMaxDepth)) return false;
+        score = data >> KDepthBits;
+        slot.hits.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store (uint64_t hash, unsigned depth, uint64_t score) {
+    Bucket & bucket = myBuckets[hash & myMask];
+    const uint64_t key = entryKey(hash);
+    const uint64_t data = packEntry(depth, score);
+
+    // Même position : gardée si la nouvelle recherche est moins profonde.
+    // Sinon la première entrée vide, ou à défaut la moins profonde, est remplacée
+    Entry * victim = &bucket.entries[0];
+    unsigned victimDepth = KMaxDepth + 1;
+    bool evicting = true;
+    for (Entry & entry : bucket.entries) {
+        const uint64_t old = entry.data.load(memory_order_relaxed);
+        const uint64_t check = entry.check.load(memory_order_relaxed);
+        if ((check ^ old) == key) {
+            if ((old & KMaxDepth) > (data & KMaxDepth)) return;
+            victim = &entry;
+            evicting = false;
+            break;
+        }
+        if (!evicting) continue;
+        if (old == 0 && check == 0) {
+            victim = &entry;
+            evicting = false;
+        }
+        else if ((old & KMaxDepth) < victimDepth) {
+            victim = &entry;
+            victimDepth = old & KMaxDepth;
+        }
+    }
+
+    victim->data.store(data, memory_order_relaxed);
+    victim->check.store(key ^ data, memory_order_relaxed);
+    StatSlot & slot = statSlot();
+    slot.stores.fetch_add(1, memory_order_relaxed);
+    if (evicting) slot.evictions.fetch_add(1, memory_order_relaxed);
+}
+
+void TranspositionTable::clear () {
+    for (Bucket & bucket : myBuckets) {
+        for (Entry & entry : bucket.entries) {
+            entry.check.store(0, memory_order_relaxed);
+            entry.data.store(0, memory_order_relaxed);
+        }
+    }
+    for (StatSlot & slot : myStats) {
+        slot.probes.store(0, memory_order_relaxed);
+        slot.hits.store(0, memory_order_relaxed);
+        slot.stores.store(0, memory_order_relaxed);
+        slot.evictions.store(0, memory_order_relaxed);
+    }
+}
+
+TableStats TranspositionTable::stats () const {
+    TableStats total = {0, 0, 0, 0};
+    for (const StatSlot & slot : myStats) {
+        total.probes += slot.probes.load(memory_order_relaxed);
+        total.hits += slot.hits.load(memory_order_relaxed);
+        total.stores += slot.stores.load(memory_order_relaxed);
+        total.evictions += slot.evictions.load(memory_order_relaxed);
+    }
+    return total;
+}
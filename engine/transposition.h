@@ -0,0 +1,115 @@
+/**
+ * @file transposition.h
+ * @brief Table de transposition : positions déjà évaluées par les recherches de coups
+ *
+ * Une recherche qui essaie des suites d'échanges retombe souvent sur la même
+ * grille par des chemins différents. La table garde, pour le hash de Zobrist
+ * d'une grille (zobrist.h), le meilleur score trouvé depuis cette grille et
+ * la profondeur de recherche qui l'a donné.
+ *
+ * Taille fixe, choisie à la construction : des paquets de KBucketEntries
+ * entrées qui tiennent dans une ligne de cache. Quand un paquet est plein,
+ * l'entrée de plus faible profondeur est remplacée.
+ *
+ * Partagée sans verrou par tous les fils de recherche : une entrée est faite
+ * de deux mots atomiques, la donnée et (hash XOR donnée). Une lecture qui
+ * croise une écriture concurrente voit un couple incohérent, le XOR ne
+ * redonne pas le hash et l'entrée est simplement ignorée. Le bit 0 du hash
+ * gardé est toujours à 1 : une entrée vide, deux mots nuls, ne correspond à
+ * aucune position (pas même à une grille de hash nul).
+ */
+#ifndef CANDY_TRANSPOSITION_H
+#define CANDY_TRANSPOSITION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Entrées par paquet (4 x 16 octets : une ligne de cache)
+const unsigned KBucketEntries (4);
+
+// Score maximal gardé (56 bits, les plus grands scores sont plafonnés)
+const std::uint64_t KMaxTableScore ((std::uint64_t(1) << 56) - 1);
+
+// Fils qui comptent les statistiques sur des lignes de cache séparées
+const unsigned KStatSlots (64);
+
+/**
+ * @struct TableStats
+ * @brief Statistiques d'utilisation de la table
+ */
+struct TableStats {
+    std::uint64_t probes;      // recherches
+    std::uint64_t hits;        // recherches qui ont trouvé la position à une profondeur suffisante
+    std::uint64_t stores;      // écritures
+    std::uint64_t evictions;   // écritures qui ont remplacé une autre position
+
+    double hitRate () const { return probes == 0 ? 0.0 : double(hits) / probes; }
+};
+
+/**
+ * @brief Table de transposition partagée par les fils de recherche
+ */
+class TranspositionTable {
+public:
+    /**
+     * @brief Table d'au plus bytes octets (au moins un paquet, nombre de paquets puissance de 2)
+     */
+    explicit TranspositionTable (std::size_t bytes);
+    TranspositionTable (const TranspositionTable &) = delete;
+    TranspositionTable & operator= (const TranspositionTable &) = delete;
+
+    /**
+     * @brief Cherche une position
+     * @param hash Hash de Zobrist de la grille
+     * @param depth Profondeur demandée : une entrée moins profonde ne compte pas
+     * @param[out] score Meilleur score trouvé depuis cette position
+     * @param[out] storedDepth Profondeur de l'entrée trouvée
+     * @return true si la position est dans la table à une profondeur au moins depth
+     */
+    bool probe (std::uint64_t hash, unsigned depth, std::uint64_t & score, unsigned & storedDepth);
+
+    /**
+     * @brief Enregistre le résultat d'une évaluation
+     *
+     * Une entrée déjà présente pour ce hash n'est remplacée que par une recherche au moins aussi profonde.
+     */
+    void store (std::uint64_t hash, unsigned depth, std::uint64_t score);
+
+    /**
+     * @brief Vide la table et ses statistiques (aucune recherche ne doit être en cours)
+     */
+    void clear ();
+
+    /**
+     * @brief Somme des statistiques de tous les fils
+     */
+    TableStats stats () const;
+
+    std::size_t entries () const { return myBuckets.size() * KBucketEntries; }
+    std::size_t bytes () const { return myBuckets.size() * sizeof(Bucket); }
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> check;   // (hash | 1) XOR data
+        std::atomic<std::uint64_t> data;    // score << 8 | profondeur
+    };
+    struct alignas(64) Bucket {
+        Entry entries[KBucketEntries];
+    };
+    struct alignas(64) StatSlot {
+        std::atomic<std::uint64_t> probes;
+        std::atomic<std::uint64_t> hits;
+        std::atomic<std::uint64_t> stores;
+        std::atomic<std::uint64_t> evictions;
+    };
+
+    StatSlot & statSlot ();
+
+    std::vector<Bucket> myBuckets;
+    std::uint64_t myMask;                 // nombre de paquets - 1
+    std::vector<StatSlot> myStats;
+};
+
+#endif // CANDY_TRANSPOSITION_H
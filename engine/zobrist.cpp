@@ -0,0 +1,19 @@
+#include "zobrist.h"
+
+using namespace std;
+
+uint64_t boardHash (const mat & grid) {
+    const uint64_t size = grid.size();
+    uint64_t hash = 0;
+    for (uint64_t i = 0; i < size; ++i)
+        for (uint64_t j = 0; j < size; ++j) hash ^= zobristKey(i * size + j, grid[i][j]);
+    return hash;
+}
+
+HashScope::HashScope (uint64_t * hash) : myPrevious(tlsBoardHash) {
+    tlsBoardHash = hash;
+}
+
+HashScope::~HashScope () {
+    tlsBoardHash = myPrevious;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file zobrist.h
+ * @brief Hachage de Zobrist des grilles, tenu à jour pendant les coups
+ *
+ * Le hash d'une grille est le XOR d'une clé aléatoire par (case, valeur de la
+ * case) : deux grilles identiques ont le même hash, et changer une case ne
+ * coûte que deux XOR (ancienne clé, nouvelle clé). Les clés ne sont pas
+ * rangées dans une table (une grille 1024x1024 en demanderait un Go) : chaque
+ * clé est tirée de son couple (case, valeur) par le mélangeur de splitmix64,
+ * qui donne la même suite d'apparence aléatoire à chaque appel.
+ *
+ * Un HashScope installe un hash pour le fil courant : l'échange (makeAMove),
+ * la suppression et la gravité (removalInColumn, removalInRow, removeMask),
+ * la création de bonbons spéciaux et le remplissage le mettent à jour au fur
+ * et à mesure, sans relire la grille entière. Sans HashScope, ces fonctions
+ * ne font qu'un test de pointeur en plus.
+ */
+#ifndef CANDY_ZOBRIST_H
+#define CANDY_ZOBRIST_H
+
+#include <cstdint>
+
+#include "grid.h"
+
+// Hash tenu à jour pour le fil courant (nul : aucun). Défini dans l'en-tête et initialisé par une
+// constante : l'accès est une lecture directe, sans la fonction d'enveloppe des thread_local externes.
+inline thread_local std::uint64_t * tlsBoardHash = nullptr;
+
+/**
+ * @brief Clé de la valeur cell dans la case index (ord * taille + abs)
+ */
+inline std::uint64_t zobristKey (std::uint64_t index, unsigned cell) {
+    // Finaliseur de splitmix64 : bijectif, deux couples différents n'ont jamais la même clé
+    std::uint64_t z = ((index << 8) | (cell & 0xFF)) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Hash de toute la grille (point de départ d'un HashScope)
+ */
+std::uint64_t boardHash (const mat & grid);
+
+/**
+ * @brief Tient le hash d'une grille à jour pour le fil courant, le temps de sa portée
+ *
+ * Le hash doit être celui de la grille au moment où la portée commence.
+ * Les portées s'emboîtent : le hash précédent revient à la destruction.
+ */
+class HashScope {
+public:
+    explicit HashScope (std::uint64_t * hash);
+    ~HashScope ();
+    HashScope (const HashScope &) = delete;
+    HashScope & operator= (const HashScope &) = delete;
+
+private:
+    std::uint64_t * myPrevious;
+};
+
+/**
+ * @brief Retire (ou remet) la clé d'une case du hash du fil courant
+ *
+ * Appelée avant et après chaque modification de la case : le premier appel
+ * retire l'ancienne valeur, le second ajoute la nouvelle.
+ */
+inline void hashCell (const mat & grid, unsigned ord, unsigned abs) {
+    if (tlsBoardHash) *tlsBoardHash ^= zobristKey(std::uint64_t(ord) * grid.size() + abs, grid[ord][abs]);
+}
+
+/**
+ * @brief Même chose pour les lignes first à last de la colonne abs (chute et remplissage)
+ */
+inline void hashColumn (const mat & grid, unsigned abs, int first, int last) {
+    if (!tlsBoardHash) return;
+    std::uint64_t hash = *tlsBoardHash;
+    for (int i = first; i <= last; ++i) hash ^= zobristKey(std::uint64_t(i) * grid.size() + abs, grid[i][abs]);
+    *tlsBoardHash = hash;
+}
+
+#endif // CANDY_ZOBRIST_H
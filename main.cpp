@@ -7,35 +7,26 @@
  * @date 03/01/2026
  */
 #include <iostream>
+#include <string>
 #include <vector>
 #include <iomanip>
-using namespace std;
-/**
- * @typedef CVLine
- * @brief Type représentant une ligne de la grille
- * 
- * Un CVLine est un vecteur d'entiers naturel où chaque élément représente
- * un type (couleur) de bonbon.
- */
-typedef vector <unsigned> CVLine; // un type représentant une ligne de la grille
-
-/**
- * @typedef CMat
- * @brief Type représentant la grille entière de ce jeu
- * 
- * CMat est un vecteur de CVLine (matrice 2D).
- */
-typedef vector <CVLine> CMat; // un type représentant la grille
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+
+#include "engine/evaluator.h"
+#include "engine/events.h"
+#include "engine/grid.h"
+#include "engine/history.h"
+#include "engine/instrument.h"
+#include "engine/resolver.h"
+#include "engine/score.h"
+#include "engine/shuffle.h"
+#include "engine/trace.h"
+#include "engine/zobrist.h"
 
-/**
- * @struct CPosition
- * @brief Structure qui représente une position dans la grille du jeu
- * Crée et type les variables abs et ord
- */
-struct CPosition {
-    unsigned abs;
-    unsigned ord;
-}; // une position dans la grille
+using namespace std;
 const unsigned KReset   (0);
 const unsigned KNoir    (30);
 const unsigned KRouge   (31);
@@ -44,7 +35,10 @@ const unsigned KJaune   (33);
 const unsigned KBleu    (34);
 const unsigned KMAgenta (35);
 const unsigned KCyan    (36);
-const unsigned KImpossible (0);
+
+const unsigned KNbHints      (3);    // coups proposés par le conseil
+const unsigned KHintBudgetMs (200);  // temps maximal de calcul d'un conseil
+const unsigned KParallelSize (256);  // taille à partir de laquelle la réaction en chaîne est répartie entre les cœurs
 
 /**
  * @brief Effacer l'écran du terminal
@@ -65,61 +59,26 @@ void couleur (const unsigned & coul) {
     cout << "\033[" << coul <<"m";
 }
 
-/**
- * @brief Fonction de pour sortir le n-ième nombre de la suite de Fibonacci
- * @param[in] n le n-ième nombre de la suite de Fibonacci
- * 
- * @note source : https://www.delftstack.com/fr/howto/cpp/fibonacci-sequence-in-cpp/
- */
-unsigned long long generateFibonacci(unsigned long long n) {
-    if (n == 1) {
-        return 0;
-    } else if (n == 2 || n == 3) {
-        return 1;
-    }
-
-    unsigned long long a = 1;
-    unsigned long long b = 1;
-    unsigned long long c;
-
-    for (unsigned long long i = 3; i < n; ++i) {
-        c = a + b;
-        a = b;
-        b = c;
-    }
-
-    return c;
-}
-
-/**
- * @brief Fonction permettant de calculer le score
- * @param[in] howMany nombre de bonbons consécutifs
- * 
- * @note Si howMany < 3, renvoie 0
- * @note source : https://www.delftstack.com/fr/howto/cpp/fibonacci-sequence-in-cpp/
- * 
- */
-int calculateScore(unsigned howMany) {
-    if (howMany < 3)
-    {
-        return 0;
-    }
-    const int multiplicateur = 100;
-    unsigned long long fib_term = generateFibonacci(howMany + 1);
-    return (fib_term * multiplicateur);
-}
 /**
  * @brief Fonction qui gère la saisie d'un coup du joueur
  * @param[in] N Taille de la grille
- * @param[out] CPosition récupère la position du bonbon à déplacer
- * @param[out] direction Direction du déplacement
+ * @param[out] pos récupère la position du bonbon à déplacer
+ * @param[out] direction Direction du déplacement, ou 'U' (annuler) / 'R' (rétablir) / 'H' (conseil) sans position
  * 
  * @return true si saisie valide, sinon false
  * @note source : https://www.delftstack.com/fr/howto/cpp/fibonacci-sequence-in-cpp/
  */
-bool inputMove(unsigned N, CPosition & pos, char & direction) {
-    cout << "\nMenu : Z, S, Q, D (Direction)\n";
+bool inputMove(unsigned N, maPosition & pos, char & direction) {
+    CANDY_TIMER(PhaseInput);
+    cout << "\nMenu : Z, S, Q, D (Direction), U (annuler le coup), R (retablir le coup), H (conseil)\n";
     cout << "Entrez Ligne (ord) et Colonne (abs) du bonbon a deplacer: ";
+    if (!(cin >> ws)) return false;
+    const char command = toupper(cin.peek());
+    if (command == 'U' || command == 'R' || command == 'H') {
+        cin.get();
+        direction = command;
+        return true;
+    }
     if (!(cin >> pos.ord >> pos.abs)) return false;
 
     cout << "Entrez la direction (Z/S/Q/D) : ";
@@ -130,27 +89,6 @@ bool inputMove(unsigned N, CPosition & pos, char & direction) {
     return true;
 }
 
-/**
- * @brief Initialisation grille de jeu avec bonbons aléatoires
- * @param[out] Grid Grille
- * @param[in] Size Taille de la grille (Size x Size)
- * @param[in] KNbCandies Nombre de types de bonbons différents
- * 
- * La fonction crée une grille carrée de taille Size (Size est un entier naturel)
- * 
- */
-void InitGrid(CMat & Grid, unsigned Size, const unsigned KNbCandies)
-{
-    Grid.resize(Size, CVLine(Size));
-    for (unsigned i = 0; i < Size; ++i)
-    {
-        for (unsigned j = 0; j < Size; ++j)
-        {
-            Grid[i][j] = 1 + rand() % KNbCandies;
-        }
-    }
-}
-
 /**
  * @brief Affiche la grille de jeu dans le terminal
  * @param[in] Grid Grille
@@ -159,9 +97,11 @@ void InitGrid(CMat & Grid, unsigned Size, const unsigned KNbCandies)
  * Chaque bonbon est affiché avec une largeur de 3 caractères.
  * Les valeurs impossibles (0 ou > KNbCandies) sont considérés comme des espaces.
  */
-void  DisplayGrid (const CMat & Grid)
+void  DisplayGrid (const mat & Grid)
 {
-    for (const CVLine & uneLigne : Grid)
+    CANDY_TIMER(PhaseDisplay);
+    CANDY_TRACE_SCOPE("affichage");
+    for (const line & uneLigne : Grid)
     {
         for (const unsigned & uneCel : uneLigne)
         {
@@ -177,43 +117,6 @@ void  DisplayGrid (const CMat & Grid)
         cout << endl;
     }
 }
-/**
- * @brief Fonction qui permet de déplacer un bonbon dans la grille
- * @param[in,out] Grid Grille de jeu
- * @param[in] Pos Position bonbon à déplacer
- * @param[in] Direction Direction du déplacement
- * 
- * @details
- * Les touches ZQSD (touches du clavier AZERTY) :
- * - 'Z' ou 'z' : déplacement vers le haut
- * - 'S' ou 's' : déplacement vers le bas  
- * - 'Q' ou 'q' : déplacement vers la gauche
- * - 'D' ou 'd' : déplacement vers la droite
- */
-void MakeAMove (CMat & Grid, const CPosition & Pos, const char & Direction)
-{
-    unsigned i = Pos.ord;
-    unsigned j = Pos.abs;
-    unsigned n = Grid.size();
-    if (i >= n || j >= n) return;
-    if ((Direction == 'Z' || Direction == 'z') && i > 0)
-    {
-        swap(Grid[i][j], Grid[i-1][j]);
-    }
-    else if ((Direction == 'S' || Direction == 's') && i < n-1)
-    {
-        swap(Grid[i][j], Grid[i+1][j]);
-    }
-    else if ((Direction == 'Q' || Direction == 'q') && j > 0)
-    {
-        swap(Grid[i][j], Grid[i][j-1]);
-    }
-    else if ((Direction == 'D' || Direction == 'd') && j < n-1)
-    {
-        swap(Grid[i][j], Grid[i][j+1]);
-    }
-}
-
 /**
  * @brief Fonction qui permet de récuperer la direction inverse d'une direction
  * @param[in] Direction Direction 
@@ -235,168 +138,12 @@ char getInverseDirection(char Direction)
     return Direction;
 }
 
-/**
- * @brief Fonction booléene qui détecte si il y a 3 bonbons alignés sur une collone (verticale donc)
- * @param[in] grid Grille de jeu
- * @param[out] pos Position premier bonbon
- * @param[out] howMany Nombre de bonbon consécutifs
- * 
- * 
- * @return true si 3 bonbons alignés, sinon false
- */
-bool atLeastThreeInAColumn (const CMat & grid, CPosition & pos, unsigned & howMany) {
-    const unsigned N = grid.size();
-    for (unsigned col = 0; col < N; ++col)
-    {
-        unsigned count = 1;
-        unsigned start_row = 0;
-        for (unsigned row = 0; row < N - 1; ++row)
-        {
-            if (grid[row][col] == KImpossible)
-            {
-                count = 1;
-                start_row = row + 1;
-                continue;
-            }
-
-            if (grid[row][col] == grid[row + 1][col]) {
-                count++;
-            }
-            else
-            {
-                if (count >= 3)
-                {
-                    pos.ord = start_row;
-                    pos.abs = col;
-                    howMany = count;
-                    return true;
-                }
-                count = 1;
-                start_row = row + 1;
-            }
-        }
-        if (count >= 3)
-        {
-            pos.ord = start_row;
-            pos.abs = col;
-            howMany = count;
-            return true;
-        }
-    }
-    return false;
-}
-
-/**
- * @brief Fonction booléene qui détecte si il y a 3 bonbons alignés sur une ligne (horizontale donc)
- * @param[in] grid Grille de jeu
- * @param[out] pos Position premier bonbon
- * @param[out] howMany Nombre de bonbon consécutifs
- * 
- * 
- * @return true si 3 bonbons alignés, sinon false
- */
-bool atLeastThreeInARow (const CMat & grid, CPosition & pos, unsigned & howMany) {
-    const unsigned N = grid.size();
-    for (unsigned row = 0; row < N; ++row)
-    {
-        unsigned count = 1;
-        unsigned start_col = 0;
-        for (unsigned col = 0; col < N - 1; ++col)
-        {
-            if (grid[row][col] == KImpossible)
-            {
-                count = 1;
-                start_col = col + 1;
-                continue;
-            }
-            if (grid[row][col] == grid[row][col + 1])
-            {
-                count++;
-            }
-            else
-            {
-                if (count >= 3)
-                {
-                    pos.ord = row;
-                    pos.abs = start_col;
-                    howMany = count;
-                    return true;
-                }
-                count = 1;
-                start_col = col + 1;
-            }
-        }
-        if (count >= 3)
-        {
-            pos.ord = row;
-            pos.abs = start_col;
-            howMany = count;
-            return true;
-        }
-    }
-    return false;
-}
-
-/**
- * @brief Fonction qui supprime les bonbons consécutifs en collone (verticale) et deplacer les bonbons pour pas avoir d'espace vide
- * 
- * @param[in] grid Grille de jeu
- * @param[out] pos Position premier bonbon
- * @param[out] howMany Nombre de bonbon consécutifs
- */
-void removalInColumn (CMat & grid, const CPosition & pos, unsigned howMany)
-{
-    const unsigned N = grid.size();
-    if (pos.ord >= N || pos.abs >= N)
-    {
-        return;
-    }
-    const unsigned col = pos.abs;
-    const unsigned start_row = pos.ord;
-    const unsigned end_row = start_row + howMany;
-    for (unsigned i = end_row; i < N; ++i)
-    {
-        unsigned target_row = i - howMany;
-        grid[target_row][col] = grid[i][col];
-    }
-    for (unsigned i = N - howMany; i < N; ++i)
-    {
-        grid[i][col] = KImpossible;
-    }
-}
-
-/**
- * @brief Fonction qui supprime les bonbons consécutifs en lignes (horizontale) et deplacer les bonbons pour pas avoir d'espace vide
- * 
- * @param[in] grid Grille de jeu
- * @param[out] pos Position premier bonbon
- * @param[out] howMany Nombre de bonbon consécutifs
- */
-void removalInRow (CMat & grid, const CPosition & pos, unsigned howMany)
-{
-    const unsigned N = grid.size();
-    if (pos.abs >= N || pos.ord >= N)
-    {
-        return;
-    }
-    const unsigned row = pos.ord;
-    const unsigned start_col = pos.abs;
-    const unsigned end_col = start_col + howMany;
-    for (unsigned i = end_col; i < N; ++i)
-    {
-        unsigned target_col = i - howMany;
-        grid[row][target_col] = grid[row][i];
-    }
-    for (unsigned i = N - howMany; i < N; ++i)
-    {
-        grid[row][i] = KImpossible;
-    }
-}
-
 int main()
 {
     // Initialisation
     srand(time(0));
+    CANDY_ATTACH_TERMINAL();
+    CANDY_TRACE_START("candycrush_libre.trace.json");
     cout << "\033[30m\033[47m";
     clearScreen();
 
@@ -408,17 +155,23 @@ int main()
     cout << "Entrer la taille de votre tableau : ";
     cin >> Size;
 
-    CMat Grid;
-    InitGrid(Grid, Size, KNbCandies);
+    mat Grid;
+    initGrid(Grid, Size, KNbCandies);
+    if (!hasLegalMove(Grid)) reshuffleGrid(Grid);
 
     // Variables de jeu
     const int MAX_COUPS (20);
     int coups_restants (MAX_COUPS);
-    unsigned long long score (0);
-
-    CPosition pos_saisie;
+    uint64_t score (0);
+    MoveHistory history;   // coups joués, pour annuler / rétablir
+    MoveEvaluator evaluator;   // conseils : tous les coups évalués en parallèle
+    unique_ptr<BandResolver> resolver;   // grandes grilles : réaction en chaîne sur tous les cœurs
+    if (Size >= KParallelSize) resolver.reset(new BandResolver());
+    string conseil;
+
+    maPosition pos_saisie;
     char direction_saisie;
-    CPosition pos_match;
+    maPosition pos_match;
     unsigned howMany_match;
 
     // Boucle de jeu (Tant qu'on n'a pas atteint le nombre maximal de coups)
@@ -430,6 +183,11 @@ int main()
         cout << "--- COUPS RESTANTS : " << coups_restants << " | SCORE : " << score << " ---\n";
 
         DisplayGrid(Grid);
+        if (!conseil.empty())
+        {
+            cout << conseil;
+            conseil.clear();
+        }
 
         // Menu et Saisie (Rafael : je vais l'implmenter)
         // La fonction inputMove affiche le menu et lit les entrées
@@ -440,69 +198,121 @@ int main()
             continue;
         }
 
+        // Annuler / rétablir : la grille, le score et les coups restants reviennent avec le coup
+        if (direction_saisie == 'U' || direction_saisie == 'R')
+        {
+            if (direction_saisie == 'U' ? history.undo(Grid, score) : history.redo(Grid, score))
+                coups_restants = MAX_COUPS - history.played();
+            continue;
+        }
+
+        // Conseil : les meilleurs coups, même règles que la partie, remplissages tirés d'après la grille
+        if (direction_saisie == 'H')
+        {
+            // Mêmes règles que la partie : sur une grande grille, la réaction en chaîne de BandResolver
+            const EvalConfig config = {RuleFibonacci, false, bool(resolver), KNbCandies, KNbHints, KHintBudgetMs,
+                                       boardHash(Grid), nullptr};
+            vector<MoveScore> best;
+            evaluator.evaluate(Grid, config, best);
+            if (best.empty()) conseil = "Conseil : aucun coup ne crée de match.\n";
+            for (const MoveScore & move : best)
+                conseil += "Conseil : ligne " + to_string(move.pos.ord) + " colonne " + to_string(move.pos.abs)
+                         + " direction " + move.direction + " (environ " + to_string(move.score) + " points)\n";
+            continue;
+        }
+
         // 1. Faire un coup
-        MakeAMove(Grid, pos_saisie, direction_saisie);
+        CANDY_TRACE_BEGIN("coup");
+        history.beginMove(Grid, score);
+        makeAMove(Grid, pos_saisie, toupper(direction_saisie));
 
         bool match_trouve = false;
+        unsigned nb_matchs = 0; // profondeur de la réaction en chaîne
 //unsigned combo = 1;
 
         // 2. Détection et Suppression
-        do
+        if (resolver)
         {
-            match_trouve = false;
-
-            // a) Test en Colonne
-            if (atLeastThreeInAColumn(Grid, pos_match, howMany_match))
+            // Grande grille : tous les matchs d'un pas à la fois, détection et gravité sur tous les cœurs
+            const ResolveReport report = resolver->resolve(Grid, RuleFibonacci, KNbCandies, unsigned(rand()));
+            nb_matchs = report.steps;
+            score = scoreAdd(score, report.score);
+            CANDY_COUNT(CounterCascadeSteps, nb_matchs);
+            if (nb_matchs > 0) emitEvent(EventScoreChanged, 0, 0, 0, 0, score);
+        }
+        else
+        {
+            do
             {
+                CANDY_TRACE_SCOPE_ARG("pas_de_cascade", nb_matchs + 1);
+                match_trouve = false;
+
+                // a) Test en Colonne
+                if (atLeastThreeInAColumn(Grid, pos_match, howMany_match))
+                {
 //unsigned points = calculateScore(howMany_match) * combo;
 //score += points;
-                removalInColumn(Grid, pos_match, howMany_match);
-                score += calculateScore(howMany_match); 
+                    removalInColumn(Grid, pos_match, howMany_match, KNbCandies);
+                    score = scoreAdd(score, matchScore(RuleFibonacci, howMany_match, nb_matchs + 1));
 
-                match_trouve = true;
+                    match_trouve = true;
 //combo++
-            }
+                }
 
-            // b) Test en Ligne
-            if (atLeastThreeInARow(Grid, pos_match, howMany_match))
-            {
-                removalInRow(Grid, pos_match, howMany_match);
-                score += calculateScore(howMany_match);
-                match_trouve = true;
-            }
+                // b) Test en Ligne
+                if (atLeastThreeInARow(Grid, pos_match, howMany_match))
+                {
+                    removalInRow(Grid, pos_match, howMany_match, KNbCandies);
+                    score = scoreAdd(score, matchScore(RuleFibonacci, howMany_match, nb_matchs + 1));
+                    match_trouve = true;
+                }
 
-            // Si un match a été fait, on l'affiche et on continue la boucle pour voir si les nouvelles positions (KImpossible) ont créé de nouveaux matches
-            if (match_trouve)
-            {
+                // Si un match a été fait, on l'affiche et on continue la boucle pour voir si les nouvelles positions (KImpossible) ont créé de nouveaux matches
+                if (match_trouve)
+                {
+                    nb_matchs++;
+                    CANDY_COUNT(CounterCascadeSteps, 1);
+                    emitScoredStep(nb_matchs, score);
 // cout << "\n COMBO x" << combo - 1 << " !";
 //cout << "  Score : " << score << "\n";
-                cout << "\nMatch trouve ! Score mis a jour : " << score << "\n";
-                DisplayGrid(Grid);
-                // Pause pour que l'utilisateur voie la suppression
-                cout << "Jeu mis en pause. Appuyer sur entrée pour continuer.";
-                cin.get();
-            }
-        } while (match_trouve); // Tant qu'il y a des réactions en chaîne
+                    cout << "\nMatch trouve ! Score mis a jour : " << score << "\n";
+                    DisplayGrid(Grid);
+                    // Pause pour que l'utilisateur voie la suppression
+                    cout << "Jeu mis en pause. Appuyer sur entrée pour continuer.";
+                    cin.get();
+                }
+            } while (match_trouve); // Tant qu'il y a des réactions en chaîne
+        }
+        CANDY_MOVE_DONE(nb_matchs);
+        CANDY_TRACE_END("coup");
 
         // 3. Mise à jour du nombre de coups
         coups_restants--;
         // Gestion des cas où le coup n'a produit aucun match
-        if (!match_trouve)
+        if (nb_matchs == 0)
         {
             // a) Déterminer la direction inverse
             char direction_inverse = getInverseDirection(direction_saisie);
             // b) Annuler le déplacement (Remettre les éléments en place)
-            MakeAMove(Grid, pos_saisie, direction_inverse);
+            makeAMove(Grid, pos_saisie, direction_inverse);
             cout << "ÉCHEC : Pas de Match créé. Annulation du déplacement.\n";
         }
+        // Plus aucun coup possible : les bonbons sont mélangés (annuler le coup annule aussi le mélange)
+        if (!hasLegalMove(Grid) && reshuffleGrid(Grid))
+            conseil = "Plus aucun coup possible : les bonbons ont ete melanges.\n";
+        history.endMove(Grid, score);
     }
 
+    emitEvent(EventGameOver, 0, MAX_COUPS - coups_restants, 0, 0, score);
+
     // Affichage du score final
     clearScreen();
     cout << "\n##########################################\n";
     cout << "# FIN DE PARTIE ! Le nombre de coups est atteint.\n";
     cout << "# Votre Score Final est : " << score << "\n";
     cout << "##########################################\n";
+    CANDY_TRACE_STOP();
+    CANDY_INSTR_REPORT("candycrush_libre");
 
     return 0;
 }
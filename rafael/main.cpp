@@ -6,6 +6,25 @@
 #include <limits>
 #include <string>
 #include <fstream>
+#include <map>
+#include <memory>
+
+#include <unistd.h>
+
+#include "../engine/grid.h"
+#include "../engine/daily.h"
+#include "../engine/events.h"
+#include "../engine/game.h"
+#include "../engine/instrument.h"
+#include "../engine/leaderboard.h"
+#include "../engine/level.h"
+#include "../engine/persist.h"
+#include "../engine/shuffle.h"
+#include "../engine/snapshot.h"
+#include "../engine/spawn.h"
+#include "../engine/special.h"
+#include "../engine/stats.h"
+#include "../engine/trace.h"
 
 using namespace std;
 
@@ -18,54 +37,81 @@ const unsigned KRouge (31);
 const unsigned KRVert (32);
 const unsigned KJaune (33);
 const unsigned KBleu (34);
+const unsigned KMagenta (35);
+const unsigned KCyan (36);
+const unsigned KGris (90);
 
 // Constantes pour le fond et le texte par défaut (Noir sur Fond Blanc)
 const unsigned KBG_White (47);
 const unsigned KTEXT_Black (30);
 
-// Constantes de Jeu
-const unsigned KNbCandies (4);  // Types de bonbons (limité à 4)
-const unsigned KGridSize (8);   // Taille de la grille N x N (8x8)
-const unsigned KImpossible (0); // Valeur pour les cases vides/supprimées
-
-// Objectifs des modes
-const unsigned KMaxMoves (20);      // Nombre maximal de coups (Mode Classique)
-const unsigned KTimeLimit (60);     // Limite de temps pour le Mode Contre-la-montre (secondes)
-const unsigned KTargetScore (1000); // Score à atteindre (Mode Cible)
-
 // Save file names
 const string KFileScoresClassic = "scores_classique.txt";
 const string KFileScoresTimeTrial = "scores_clm.txt";
 const string KFileScoresTarget = "scores_cible.txt";
+const string KFileLevels = "niveaux.pack";   // construit par candy_levels (voir levels/niveaux.txt)
+const string KFileSave = "partie.sav";       // partie en cours (Classique et Cible), voir engine/snapshot.h
+const string KFileStats = "statistiques";    // colonnes statistiques.*.col des parties terminées, voir engine/stats.h
+const string KFileDaily = "defis.cal";       // graines du défi du jour, construit par candy_daily (voir engine/daily.h)
+
+// Ligne saisie pour sauvegarder la partie et revenir au menu
+const int KSaveCommand (-1);
 
 // absors and symbols
-const unsigned CANDY_absORS[] = {KReset, KRouge, KRVert, KBleu, KJaune};
-const char CANDY_SYMBOLS[] = {' ', '1', '2', '3', '4', '5', '6', '7'};
-
-// Type aliases
-typedef vector <unsigned> line; // un type représentant une ligne de la grille
-typedef vector <line> mat; // un type représentant la grille
-struct maPosition {
-    unsigned abs;
-    unsigned ord;
-}; // une position dans la girlle
-
-// Structure pour les modes Classique et Contre-la-montre (Score élevé = meilleur)
-struct ScoreEntry {
-    string pseudo;
-    unsigned score;
-};
+const unsigned CANDY_absORS[] = {KReset, KRouge, KRVert, KBleu, KJaune, KMagenta, KCyan, KGris, KNoir};
+const char CANDY_SYMBOLS[] = {' ', '1', '2', '3', '4', '5', '6', '7', '8'};
+// Marque affichée après la couleur d'un bonbon spécial (dans l'ordre de SpecialKind)
+const char SPECIAL_MARKS[] = {' ', '-', '|', '#', '*'};
+
+// Entrées affichées en tête du classement
+const size_t KShownScores (10);
+
 
-// Structure pour le mode Cible (Coups faibles = meilleur)
-struct TargetScoreEntry { // NOUVEAU
-    string pseudo;
-    unsigned moves;
+/**
+ * @struct DailyChallenge
+ * @brief Défi du jour joué : le jour et sa graine
+ */
+struct DailyChallenge {
+    std::uint32_t day;        // voir dailyDay
+    DailyRecord record;
 };
 
+/**
+ * @struct GameSetup
+ * @brief Grille et objectifs d'une partie : ceux du mode, ou ceux d'un niveau
+ */
+struct GameSetup {
+    const LevelView * level;  // nul pour une partie normale
+    const DailyChallenge * daily; // nul hors du défi du jour
+    std::uint32_t levelIndex; // numéro du niveau dans KFileLevels, KNoLevel sinon
+    SpawnPolicy spawn;        // apparition des bonbons du niveau
+    mat grid;
+    mat jelly;                // couches de gelée (niveaux)
+    unsigned jellyCount;      // couches restantes
+    unsigned nbCandies;
+    unsigned maxMoves;
+    unsigned timeLimit;
+    uint64_t targetScore;
+    BoardMask cleared;        // cases vidées par le dernier match
+    std::uint64_t spawnState; // générateur des remplissages du défi du jour
+};
 
 // --- 2. LES FONCTIONS POUR LE TERMINAL ---
 
+/**
+ * @brief Le terminal comprend-il les séquences ANSI ? Décidé une seule fois, au premier affichage :
+ *        sortie vers un terminal, TERM autre que "dumb" et pas de NO_COLOR.
+ */
+bool terminalHasColours () {
+    static const bool colours = [] () {
+        const char * term = getenv("TERM");
+        return isatty(STDOUT_FILENO) && !getenv("NO_COLOR") && !(term && string(term) == "dumb");
+    }();
+    return colours;
+}
+
 void couleur (const unsigned & coul) {
+    if (!terminalHasColours()) return;
     cout << "\033[" << coul <<"m";
 }
 
@@ -76,31 +122,48 @@ void initializeBackground() {
 
 void clearScreen () {
     initializeBackground();
-    cout << "\033[H\033[2J";
+    if (terminalHasColours()) cout << "\033[H\033[2J";
 }
 
 /**
  * @brief Affiche la grille dans le terminal.
  */
-void displayGrid (const mat & grid, unsigned score) {
+void displayGrid (const GameSetup & game, uint64_t score) {
+    CANDY_TIMER(PhaseDisplay);
+    CANDY_TRACE_SCOPE("affichage");
+    const mat & grid = game.grid;
     clearScreen();
 
     couleur(KTEXT_Black);
-    cout << "   SCORE: " << score << endl;
-    cout << "     0 1 2 3 4 5 6 7" << endl;
-    cout << "    -----------------" << endl;
-
-    for (unsigned i = 0; i < KGridSize; ++i) {
-        cout << " " << i << " | ";
-        for (unsigned j = 0; j < KGridSize; ++j) {
-            unsigned value = grid[i][j];
-
-            if (value == KImpossible) {
+    cout << "   SCORE: " << score;
+    if (game.level) cout << "   GELEE: " << game.jellyCount;
+    cout << endl;
+    cout << "     ";
+    for (unsigned j = 0; j < grid.size(); ++j) cout << j % 10 << " ";
+    // Bordure du haut et du bas : deux caractères par colonne, quelle que soit la taille
+    const string border = "    -" + string(2 * grid.size(), '-');
+    cout << endl << border << endl;
+
+    for (unsigned i = 0; i < grid.size(); ++i) {
+        cout << (i < 10 ? " " : "") << i << " | ";
+        for (unsigned j = 0; j < grid.size(); ++j) {
+            unsigned value = candyColour(grid[i][j]);
+            SpecialKind kind = candyKind(grid[i][j]);
+
+            if (grid[i][j] == KHole) {
+                cout << "  ";
+            } else if (grid[i][j] == KBlocker) {
+                couleur(KTEXT_Black);
+                cout << "XX";
+            } else if (kind == SpecialColourBomb) {
+                couleur(KTEXT_Black);
+                cout << "**";
+            } else if (value == KImpossible) {
                 couleur(KTEXT_Black);
                 cout << ". ";
-            } else if (value <= KNbCandies) {
+            } else if (value <= KMaxLevelCandies && kind <= SpecialColourBomb) {
                 couleur(CANDY_absORS[value]);
-                cout << CANDY_SYMBOLS[value] << " ";
+                cout << CANDY_SYMBOLS[value] << SPECIAL_MARKS[kind];
             } else {
                 couleur(KTEXT_Black);
                 cout << "? ";
@@ -109,311 +172,297 @@ void displayGrid (const mat & grid, unsigned score) {
         couleur(KTEXT_Black);
         cout << endl;
     }
-    cout << "    -----------------" << endl;
+    cout << border << endl;
 }
 
 
 // --- 3. LES SCORES ---
 
 /**
- * @brief Lit les entrées de score (ScoreEntry) depuis un fichier.
+ * @brief Classement d'un fichier de scores, relu à son premier affichage (rien n'est lu au démarrage)
+ *        puis tenu à jour en mémoire.
  */
-vector<ScoreEntry> loadScores(const string & fileName) {
-    vector<ScoreEntry> scores;
-    ifstream file(fileName);
-
-    if (file.is_open()) {
-        ScoreEntry entry;
-        while (file >> entry.score >> entry.pseudo) {
-            scores.push_back(entry);
-        }
-        file.close();
+Leaderboard & scoreBoard(const string & fileName, RankOrder order) {
+    static map<string, Leaderboard> boards;
+    map<string, Leaderboard>::iterator found = boards.find(fileName);
+    if (found == boards.end()) {
+        found = boards.emplace(fileName, Leaderboard(order)).first;
+        found->second.load(fileName);
     }
-    return scores;
+    return found->second;
 }
 
 /**
- * @brief Lit les entrées de score du Mode Cible (TargetScoreEntry) depuis un fichier.
+ * @brief Ajoute le résultat de la partie au classement du mode ; la ligne est écrite par le fil de fond.
+ * @return Rang de la partie dans le classement (1 : en tête)
  */
-vector<TargetScoreEntry> loadTargetScores(const string & fileName) {
-    vector<TargetScoreEntry> scores;
-    ifstream file(fileName);
-
-    if (file.is_open()) {
-        TargetScoreEntry entry;
-        while (file >> entry.moves >> entry.pseudo) {
-            scores.push_back(entry);
-        }
-        file.close();
+size_t recordScore(const string & fileName, Leaderboard & scores, const string & userPseudo, uint64_t value) {
+    const size_t rank = scores.insert(userPseudo, value);
+    if (!persistScore(fileName, userPseudo, value)) {
+        cout << "Error: Cannot open save file " << fileName << endl;
     }
-    return scores;
+    return rank;
 }
 
 /**
- * @brief Sauvegarde le vecteur d'entrées de score (ScoreEntry) dans un fichier.
+ * @brief Fichier de scores d'un mode : celui du mode, ou celui du mode pour le défi du jour (un classement par jour)
  */
-void saveScores(const string & fileName, const vector<ScoreEntry> & scores) {
-    ofstream file(fileName);
-
-    if (file.is_open()) {
-        for (const ScoreEntry & entry : scores) {
-            file << entry.score << " " << entry.pseudo << endl;
-        }
-        file.close();
-    } else {
-        cout << "Error: Cannot open save file " << fileName << endl;
-    }
+string scoreFile(const string & fileName, const DailyChallenge * daily) {
+    return daily ? "defi_" + dailyDate(daily->day) + "_" + fileName : fileName;
 }
 
 /**
- * @brief Sauvegarde le vecteur d'entrées de score du Mode Cible (TargetScoreEntry) dans un fichier.
+ * @brief Ajoute la partie terminée à l'entrepôt des statistiques (une valeur par colonne).
  */
-void saveTargetScores(const string & fileName, const vector<TargetScoreEntry>& scores) {
-    ofstream file(fileName);
-
-    if (file.is_open()) {
-        for (const TargetScoreEntry & entry : scores) {
-            file << entry.moves << " " << entry.pseudo << endl;
-        }
-        file.close();
-    } else {
-        cout << "Error: Cannot open save file " << fileName << endl;
+void recordGame(const string & userPseudo, GameMode mode, uint64_t score, unsigned moves, unsigned comboSteps) {
+    static StatsWriter stats(KFileStats);
+    GameRecord game;
+    game.player = stats.player(userPseudo);
+    game.mode = mode;
+    game.score = score;
+    game.moves = moves;
+    game.comboSteps = comboSteps;
+    game.time = time(nullptr);
+    if (!stats.append(game)) {
+        cout << "Attention : impossible d'ecrire les statistiques " << KFileStats << endl;
     }
 }
 
 /**
- * @brief Affiche les meilleurs scores pour un mode donné.
+ * @brief Affiche les meilleurs scores pour un mode donné, et le rang de la partie.
  */
-void displayBestScores(const string & modeName, const vector<ScoreEntry> & scores) {
+void displayBestScores(const string & modeName, const Leaderboard & scores, size_t rank) {
     couleur(KTEXT_Black);
     cout << "\n--- Meilleurs scores (" << modeName << ") ---" << endl;
-    if (scores.empty()) {
+    if (scores.size() == 0) {
         cout << "Aucun score enregistre pour l'instant." << endl;
     } else {
-        // Affiche max 10 scores
-        for (size_t i = 0; i < min((size_t)10, scores.size()); ++i) {
-            cout << i + 1 << ". " << scores[i].pseudo << " : " << scores[i].score << " points" << endl;
+        vector<RankEntry> best;
+        scores.page(1, KShownScores, best);
+        for (size_t i = 0; i < best.size(); ++i) {
+            cout << i + 1 << ". " << best[i].pseudo << " : " << best[i].value << " points" << endl;
         }
+        cout << "Votre rang : " << rank << " sur " << scores.size() << endl;
     }
     cout << "--------------------------------------" << endl;
 }
 
 /**
- * @brief Affiche les meilleurs scores pour le Mode Cible (basé sur les coups).
+ * @brief Affiche les meilleurs scores pour le Mode Cible (basé sur les coups), et le rang de la partie.
  */
-void displayBestTargetScores(const string & modeName, const vector<TargetScoreEntry> & scores) {
+void displayBestTargetScores(const string & modeName, const Leaderboard & scores, size_t rank) {
     couleur(KTEXT_Black);
     cout << "\n--- Classement (" << modeName << ") ---" << endl;
     cout << "Objectif : " << KTargetScore << " points" << endl;
     cout << "--------------------------------------" << endl;
-    if (scores.empty()) {
+    if (scores.size() == 0) {
         cout << "Aucun score enregistre pour l'instant." << endl;
     } else {
-        // Affiche max 10 scores
-        for (size_t i = 0; i < min((size_t)10, scores.size()); ++i) {
-            cout << i + 1 << ". " << scores[i].pseudo << " : " << scores[i].moves << " coups" << endl;
+        vector<RankEntry> best;
+        scores.page(1, KShownScores, best);
+        for (size_t i = 0; i < best.size(); ++i) {
+            cout << i + 1 << ". " << best[i].pseudo << " : " << best[i].value << " coups" << endl;
         }
+        cout << "Votre rang : " << rank << " sur " << scores.size() << endl;
     }
     cout << "--------------------------------------" << endl;
 }
 
 
-// --- 4. LES MATCHS ET LES MOUVEMENT ---
+// --- 4. LES MODES DE JEUX ---
 
 /**
- * @brief Regarde si il y a 3 ou plus de chiffres identiques après l'initialisation.
+ * @brief Lit la ligne et la colonne saisies par le joueur.
  */
-bool checkInitialMatch(const mat & grid) {
-    for (unsigned i = 0; i < KGridSize; ++i) {
-        for (unsigned j = 0; j <= KGridSize - 3; ++j) {
-            unsigned type = grid[i][j];
-            if (type != KImpossible && type == grid[i][j+1] && type == grid[i][j+2]) return true;
-        }
-    }
-    for (unsigned j = 0; j < KGridSize; ++j) {
-        for (unsigned i = 0; i <= KGridSize - 3; ++i) {
-            unsigned type = grid[i][j];
-            if (type != KImpossible && type == grid[i+1][j] && type == grid[i+2][j]) return true;
-        }
-    }
-    return false;
+bool readPosition (int & r1, int & c1) {
+    CANDY_TIMER(PhaseInput);
+    if (!(cin >> r1)) return false;
+    if (r1 == KSaveCommand) return true;
+    return bool(cin >> c1);
 }
 
 /**
- * @brief Initialise toutes les cellules de la grille avec des chiffres aléatoires, en recommençant si checkInitialMatch n'est pas respecté.
+ * @brief Lit la direction saisie par le joueur.
  */
-void initGrid (mat & grid, const size_t & matSize) {
-    grid.resize(matSize, line(matSize));
-
-    do {
-        for (unsigned i = 0; i < matSize; ++i) {
-            for (unsigned j = 0; j < matSize; ++j) {
-                // Génère un nombre entre 1 et KNbCandies (4 max)
-                grid[i][j] = (rand() % KNbCandies) + 1;
-            }
-        }
-    } while (checkInitialMatch(grid));
+bool readDirection (char & direction) {
+    CANDY_TIMER(PhaseInput);
+    return bool(cin >> direction);
 }
 
 /**
- * @brief Enlève tout les bonbons sur les positions données, applique la gravtié et remplit avec de nouveaux bonbons.
+ * @brief Prépare la grille et les objectifs : ceux du mode, ou ceux du niveau s'il est donné ;
+ *        le défi du jour tire la grille et les remplissages de sa graine
  */
-void removalInColumn (mat & grid, const maPosition & pos, unsigned howMany) {
-    unsigned abs = pos.abs;
-    unsigned startord = pos.ord;
-
-    for (unsigned i = startord; i < startord + howMany; ++i) {
-        if (i < KGridSize && grid[i][abs] != KImpossible) {
-            grid[i][abs] = KImpossible;
-        }
+void setupGame (GameSetup & game, const LevelView * level, std::uint32_t levelIndex = KNoLevel,
+                const DailyChallenge * daily = nullptr) {
+    game.level = level;
+    game.daily = daily;
+    game.levelIndex = levelIndex;
+    game.nbCandies = KNbCandies;
+    game.maxMoves = KMaxMoves;
+    game.timeLimit = KTimeLimit;
+    game.targetScore = KTargetScore;
+    if (level) {
+        initLevelGrid(*level, game.grid, game.jelly);
+        game.nbCandies = level->record->nbCandies;
+        game.maxMoves = level->record->maxMoves;
+        game.timeLimit = level->record->timeLimit;
+        game.targetScore = level->record->targetScore;
+        initLevelSpawn(*level, game.spawn);
     }
-
-    int next_write_ord = KGridSize - 1;
-
-    for (int i = KGridSize - 1; i >= 0; --i) {
-        if (grid[i][abs] != KImpossible) {
-            if (i != next_write_ord) {
-                grid[next_write_ord][abs] = grid[i][abs];
-                grid[i][abs] = KImpossible;
-            }
-            next_write_ord--;
-        }
+    else if (daily) {
+        seedGame(daily->record.seed, KGridSize, KNbCandies, game.grid, game.spawnState);
+        game.jelly.clear();
     }
-
-    for (unsigned i = 0; i < KGridSize; ++i) {
-        if (grid[i][abs] == KImpossible) {
-            grid[i][abs] = (rand() % KNbCandies) + 1;
-        }
+    else {
+        initGrid(game.grid, KGridSize);
+        game.jelly.clear();
     }
+    game.jellyCount = level ? jellyLeft(game.jelly) : 0;
 }
 
 /**
- * @brief Enlève tout les bonbons sur les positions données et appelle removalInColumn pour qu'il s'occupe de la gravité et du remplissage de nouveaux bonbons.
+ * @brief Reprend une partie sauvegardée : grille, gelée, graine et apparition des bonbons
+ * @return Coups déjà joués
  */
-void removalInRow (mat & grid, const maPosition & pos, unsigned howMany) {
-    unsigned ord = pos.ord;
-    unsigned startabs = pos.abs;
-
-    for (unsigned j = startabs; j < startabs + howMany; ++j) {
-        if (j < KGridSize) {
-            grid[ord][j] = KImpossible;
-        }
-    }
-
-    for (unsigned j = startabs; j < startabs + howMany; ++j) {
-        if (j < KGridSize) {
-            maPosition tmpPos = {j, 0};
-            removalInColumn(grid, tmpPos, 0);
-        }
+unsigned restoreGame (GameSetup & game, const GameSnapshot & saved, uint64_t & score) {
+    game.grid = saved.grid;
+    if (game.level) {
+        game.jelly = saved.jelly;
+        if (game.jelly.size() != game.grid.size()) game.jelly.assign(game.grid.size(), line(game.grid.size(), 0));
+        game.jellyCount = jellyLeft(game.jelly);
+        game.spawn.seek(saved.scriptPosition, vector<size_t>(saved.queuePositions.begin(), saved.queuePositions.end()));
     }
+    srand(saved.seed);
+    score = saved.score;
+    return saved.moves;
 }
 
 /**
- * @brief Cherche pour un match vertical de 3 ou plus bonbons.
+ * @brief Point de reprise après un coup (ou sauvegarde demandée par le joueur)
+ * @param commit true pour remplacer la sauvegarde, false pour l'ajouter au journal
  */
-bool atLeastThreeInAColumn (const mat & grid, maPosition & pos, unsigned & howMany) {
-    for (unsigned j = 0; j < KGridSize; ++j) {
-        for (unsigned i = 0; i <= KGridSize - 3; ++i) {
-            unsigned type = grid[i][j];
-            if (type == KImpossible) continue;
-
-            if (type == grid[i+1][j] && type == grid[i+2][j]) {
-                howMany = 3;
-                unsigned k = i + 3;
-                while (k < KGridSize && grid[k][j] == type) {
-                    howMany++;
-                    k++;
-                }
-                pos = {j, i};
-                return true;
-            }
-        }
+void checkpointGame (SaveJournal & journal, GameMode mode, const GameSetup & game, uint64_t score,
+                     unsigned moves, bool commit) {
+    GameSnapshot snapshot;
+    snapshot.mode = mode;
+    snapshot.level = game.levelIndex;
+    snapshot.seed = reseedForSnapshot();
+    snapshot.moves = moves;
+    snapshot.score = score;
+    snapshot.nbCandies = game.nbCandies;
+    snapshot.grid = game.grid;
+    snapshot.scriptPosition = 0;
+    if (game.level) {
+        snapshot.jelly = game.jelly;
+        snapshot.scriptPosition = game.spawn.scriptPosition();
+        snapshot.queuePositions.assign(game.spawn.queuePositions().begin(), game.spawn.queuePositions().end());
     }
-    return false;
+    vector<uint8_t> bytes;
+    packSnapshot(snapshot, bytes);
+    if (commit ? !journal.commit(bytes) : !journal.checkpoint(bytes))
+        cout << "Attention : impossible d'ecrire " << KFileSave << endl;
 }
 
 /**
- * @brief Cherche pour un match horizontal de 3 ou plus bonbons.
+ * @brief Vide un match et ses effets ; sur un niveau, retire la gelée des cases vidées
+ * @return Nombre de bonbons consommés (voir clearMatch)
  */
-bool atLeastThreeInARow (const mat & grid, maPosition & pos, unsigned & howMany) {
-    for (unsigned i = 0; i < KGridSize; ++i) {
-        for (unsigned j = 0; j <= KGridSize - 3; ++j) {
-            unsigned type = grid[i][j];
-            if (type == KImpossible) continue;
-
-            if (type == grid[i][j+1] && type == grid[i][j+2]) {
-                howMany = 3;
-                unsigned k = j + 3;
-                while (k < KGridSize && grid[i][k] == type) {
-                    howMany++;
-                    k++;
-                }
-                pos = {j, i};
-                return true;
-            }
-        }
-    }
-    return false;
+unsigned playMatch (GameSetup & game, const maPosition & pos, unsigned howMany, MatchDirection direction) {
+    BoardMask * cleared = game.level ? &game.cleared : nullptr;
+    unsigned consumed = clearMatch(game.grid, pos, howMany, direction, game.nbCandies, cleared);
+    if (cleared) game.jellyCount -= peelJelly(game.jelly, game.cleared);
+    return consumed;
 }
 
 /**
- * @brief Echange les bonbons à une position donnée avec la direction donnée.
+ * @brief Déclenche la bombe d'un échange ; sur un niveau, retire la gelée des cases vidées
+ * @return Nombre de cases vidées, 0 sans bombe
  */
-void makeAMove (mat & grid, const maPosition & pos, const char & direction) {
-    unsigned r2 = pos.ord;
-    unsigned c2 = pos.abs;
-
-    switch (direction) {
-    case 'Q': // Gauche
-        if (pos.abs == 0) return;
-        c2 = pos.abs - 1;
-        break;
-    case 'Z': // Haut
-        if (pos.ord == 0) return;
-        r2 = pos.ord - 1;
-        break;
-    case 'D': // Droit
-        if (pos.abs == KGridSize - 1) return;
-        c2 = pos.abs + 1;
-        break;
-    case 'S': // Bas
-        if (pos.ord == KGridSize - 1) return;
-        r2 = pos.ord + 1;
-        break;
-    default:
-        return;
-    }
+unsigned playBomb (GameSetup & game, const maPosition & pos, char direction) {
+    BoardMask * cleared = game.level ? &game.cleared : nullptr;
+    unsigned bombed = activateSwap(game.grid, pos, direction, game.nbCandies, cleared);
+    if (cleared && bombed > 0) game.jellyCount -= peelJelly(game.jelly, game.cleared);
+    return bombed;
+}
 
-    swap(grid[pos.ord][pos.abs], grid[r2][c2]);
+/**
+ * @brief Mélange la grille quand plus aucun échange n'est possible (grille de départ ou après une réaction en chaîne)
+ * @param[out] shuffled true si les bonbons ont été mélangés
+ * @return false si aucun mélange ne redonne de coup : la partie ne peut pas continuer
+ */
+bool keepPlayable (GameSetup & game, bool & shuffled) {
+    shuffled = !hasLegalMove(game.grid);
+    return !shuffled || reshuffleGrid(game.grid);
 }
 
+/**
+ * @brief Fin d'une partie sur un niveau : objectif de score et gelée (pas de tableau des scores)
+ */
+void showLevelResult (const GameSetup & game, uint64_t score) {
+    bool won = score >= game.targetScore && game.jellyCount == 0;
+    clearScreen();
+    cout << "\n========================================" << endl;
+    cout << (won ? "           NIVEAU REUSSI !           " : "           NIVEAU ECHOUE...           ") << endl;
+    cout << "   Score : " << score << " / " << game.targetScore << " points" << endl;
+    cout << "   Gelee restante : " << game.jellyCount << endl;
+    cout << "========================================" << endl;
 
-// --- 5. LES MODES DE JEUX ---
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
+    cout << "Appuyez sur ENTREE pour continuer...";
+    cin.get();
+}
 
 /**
  * @brief Boucle principale pour le Mode Classique (Coups limités, Meilleur score).
  */
-void runClassicMode(const string & userPseudo) {
-    mat grid;
-    initGrid(grid, KGridSize);
-
-    unsigned score = 0;
+void runClassicMode(const string & userPseudo, const LevelView * level = nullptr, std::uint32_t levelIndex = KNoLevel,
+                   const GameSnapshot * saved = nullptr, const DailyChallenge * daily = nullptr) {
+    GameSetup game;
+    setupGame(game, level, levelIndex, daily);
+    mat & grid = game.grid;
+    SpawnScope spawnScope(level ? &game.spawn : nullptr);
+    RandomScope randomScope(daily ? &game.spawnState : tlsSpawnRandom);
+
+    uint64_t score = 0;
+    const ScoreRule rule = scoreRuleFor(ModeClassic);
     unsigned currentMoves = 0;
+    unsigned comboSteps = 0;   // pas de cascade de tous les coups (statistiques)
+
+    // Une seule partie sauvegardée : une nouvelle partie remplace l'ancienne (sauf le défi du jour, jamais sauvegardé)
+    SaveJournal journal(KFileSave);
+    if (saved) currentMoves = restoreGame(game, *saved, score);
+    else if (!daily) journal.discard();
     int r1, c1;
     char direction;
 
-    cout << "--- Mode Classique: Meilleur score en " << KMaxMoves << " coups ---" << endl;
+    cout << "--- Mode Classique: Meilleur score en " << game.maxMoves << " coups ---" << endl;
 
-    while (currentMoves < KMaxMoves) {
-        displayGrid(grid, score);
+    while (currentMoves < game.maxMoves) {
+        bool shuffled;
+        if (!keepPlayable(game, shuffled)) break;
+        displayGrid(game, score);
         couleur(KTEXT_Black);
-        cout << "COUPS RESTANTS : " << KMaxMoves - currentMoves << " / " << KMaxMoves << endl;
+        if (shuffled) cout << "Plus aucun coup possible : les bonbons ont ete melanges." << endl;
+        cout << "COUPS RESTANTS : " << game.maxMoves - currentMoves << " / " << game.maxMoves << endl;
 
         // --- Saisie ---
-        cout << "\nEntrez la Ligne et la absonne du nombre a deplacer (ex: 0 0) : ";
-        if (!(cin >> r1 >> c1)) break;
+        cout << "\nEntrez la Ligne et la absonne du nombre a deplacer (ex: 0 0, -1 pour sauvegarder) : ";
+        if (!readPosition(r1, c1)) return;   // saisie interrompue : la partie reste dans le journal
+        if (r1 == KSaveCommand && daily) {
+            cout << "Le defi du jour ne se sauvegarde pas." << endl;
+            continue;
+        }
+        if (r1 == KSaveCommand) {
+            checkpointGame(journal, ModeClassic, game, score, currentMoves, true);
+            cout << "Partie sauvegardee : reprenez-la depuis le menu." << endl;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
+            cout << "Appuyez sur ENTREE pour continuer...";
+            cin.get();
+            return;
+        }
 
-        if (r1 < 0 || r1 >= (int)KGridSize || c1 < 0 || c1 >= (int)KGridSize || grid[r1][c1] == KImpossible) {
+        if (r1 < 0 || r1 >= (int)grid.size() || c1 < 0 || c1 >= (int)grid.size() || grid[r1][c1] == KImpossible || isFixedCell(grid[r1][c1])) {
             std::cin.clear(); // Effacer les indicateurs d'erreur
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
             std::cout << "Entrée invalide. Veuillez réessayer.\n"; //source : https://labex.io/fr/tutorials/cpp-how-to-handle-cin-input-validation-427285
@@ -421,7 +470,7 @@ void runClassicMode(const string & userPseudo) {
         }
 
         cout << "Entrez la Direction (Q:gauche, Z:haut, D:droit, S:bas) : ";
-        if (!(cin >> direction)) break;
+        if (!readDirection(direction)) return;
         direction = toupper(direction);
 
         if (direction != 'Q' && direction != 'Z' && direction != 'D' && direction != 'S') {
@@ -431,14 +480,27 @@ void runClassicMode(const string & userPseudo) {
 
         // --- Déplacement et Scoring ---
         maPosition pos = {(unsigned)c1, (unsigned)r1};
+        CANDY_TRACE_BEGIN("coup");
         makeAMove(grid, pos, direction);
         currentMoves++;
 
         bool moved = true;
         unsigned comboLevel = 0;
 
+        // Bombe échangée : toute une couleur disparaît avant la réaction en chaîne
+        unsigned bombed = playBomb(game, pos, direction);
+        if (bombed > 0) {
+            comboLevel++;
+            uint64_t bombBonus = matchScore(rule, bombed, comboLevel);
+            score = scoreAdd(score, bombBonus);
+            emitScoredStep(comboLevel, score);
+            cout << "\n> BOMBE ! " << bombed << " bonbons ! Score: +" << bombBonus << endl;
+            displayGrid(game, score);
+        }
+
         // Boucle de réaction en chaîne
         while (moved) {
+            CANDY_TRACE_SCOPE_ARG("pas_de_cascade", comboLevel + 1);
             moved = false;
             unsigned howMany = 0;
             maPosition matchPos;
@@ -446,29 +508,43 @@ void runClassicMode(const string & userPseudo) {
 
             // Détection du match
             if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
-                removalInColumn(grid, matchPos, howMany);
+                howMany = playMatch(game, matchPos, howMany, MatchVertical);
                 matchFound = true;
             }
             else if (atLeastThreeInARow(grid, matchPos, howMany)) {
-                removalInRow(grid, matchPos, howMany);
+                howMany = playMatch(game, matchPos, howMany, MatchHorizontal);
                 matchFound = true;
             }
 
             // Mise à jour du score si un match a eu lieu
             if (matchFound) {
                 comboLevel++;
-                unsigned baseScore = howMany * 2;
-                unsigned comboBonus = baseScore * comboLevel;
+                CANDY_COUNT(CounterCascadeSteps, 1);
+                uint64_t baseScore = matchScore(rule, howMany, 1);
+                uint64_t comboBonus = matchScore(rule, howMany, comboLevel);
 
-                score += comboBonus;
+                score = scoreAdd(score, comboBonus);
+                emitScoredStep(comboLevel, score);
                 moved = true;
 
                 cout << "\n> match de " << howMany << "! COMBO x" << comboLevel
                      << " ! Score: +" << comboBonus << " (Base: " << baseScore << ")" << endl;
-                displayGrid(grid, score);
+                displayGrid(game, score);
             }
         }
+        CANDY_MOVE_DONE(comboLevel);
+        comboSteps += comboLevel;
+        CANDY_TRACE_END("coup");
+        if (!daily) checkpointGame(journal, ModeClassic, game, score, currentMoves, false);
+    }
+    emitEvent(EventGameOver, 0, currentMoves, 0, 0, score);
+
+    if (level) {
+        journal.discard();
+        showLevelResult(game, score);
+        return;
     }
+    if (!daily) journal.discard();
 
     // Condition de fin
     clearScreen();
@@ -478,24 +554,11 @@ void runClassicMode(const string & userPseudo) {
     cout << "========================================" << endl;
 
     // LOGIQUE DE SAUVEGARDE DE SCORE
-    vector<ScoreEntry> scores = loadScores(KFileScoresClassic);
-    ScoreEntry newEntry = {userPseudo, score};
-    scores.push_back(newEntry);
-
-    // Tri par insertion
-    for (size_t i = 1; i < scores.size(); ++i) {
-        ScoreEntry x = scores[i];
-        int j = i;
-        while (j > 0 && scores[j - 1].score < x.score) {
-            scores[j] = scores[j - 1];
-            j = j - 1;
-        }
-
-        scores[j] = x;
-    }
-
-    saveScores(KFileScoresClassic, scores);
-    displayBestScores("Classique", scores);
+    recordGame(userPseudo, ModeClassic, score, currentMoves, comboSteps);
+    const string scoresFile = scoreFile(KFileScoresClassic, daily);
+    Leaderboard & scores = scoreBoard(scoresFile, RankHighFirst);
+    const size_t rank = recordScore(scoresFile, scores, userPseudo, score);
+    displayBestScores(daily ? "Classique, defi du " + dailyDate(daily->day) : "Classique", scores, rank);
 
     // Attendre l'entrée utilisateur
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
@@ -506,29 +569,39 @@ void runClassicMode(const string & userPseudo) {
 /**
  * @brief Boucle principale pour le Mode Contre-la-montre (Temps limité, Meilleur score).
  */
-void runTimeTrialMode(const string& userPseudo) {
-    mat grid;
-    initGrid(grid, KGridSize);
-
-    unsigned score = 0;
+void runTimeTrialMode(const string & userPseudo, const LevelView * level = nullptr,
+                      const DailyChallenge * daily = nullptr) {
+    GameSetup game;
+    setupGame(game, level, KNoLevel, daily);
+    mat & grid = game.grid;
+    SpawnScope spawnScope(level ? &game.spawn : nullptr);
+    RandomScope randomScope(daily ? &game.spawnState : tlsSpawnRandom);
+
+    uint64_t score = 0;
+    const ScoreRule rule = scoreRuleFor(ModeTimeTrial);
     int r1, c1;
     char direction;
 
+    unsigned currentMoves = 0;
+    unsigned comboSteps = 0;   // pas de cascade de tous les coups (statistiques)
     time_t startTime = time(NULL);
     double elapsedTime; // Temps écoulé en français
 
-    cout << "--- Mode Contre-la-montre: 4 types de bonbons - " << KTimeLimit << " secondes ---" << endl;
+    cout << "--- Mode Contre-la-montre: 4 types de bonbons - " << game.timeLimit << " secondes ---" << endl;
 
     while (true) {
         elapsedTime = difftime(time(NULL), startTime); // source : https://en.cppreference.com/w/cpp/chrono/c/difftime
-        double timeRemaining = KTimeLimit - elapsedTime;
+        double timeRemaining = game.timeLimit - elapsedTime;
 
         if (timeRemaining <= 0) {
             break;
         }
 
-        displayGrid(grid, score);
+        bool shuffled;
+        if (!keepPlayable(game, shuffled)) break;
+        displayGrid(game, score);
         couleur(KTEXT_Black);
+        if (shuffled) cout << "Plus aucun coup possible : les bonbons ont ete melanges." << endl;
         cout << "TEMPS RESTANT : ";
         // Affiche la couleur du temps en fonction de l'urgence
         if (timeRemaining <= 10) couleur(KRouge);
@@ -540,9 +613,9 @@ void runTimeTrialMode(const string& userPseudo) {
 
         // --- Saisie ---
         cout << "\nEntrez la Ligne et la absonne du nombre a deplacer (ex: 0 0) : ";
-        if (!(cin >> r1 >> c1)) break;
+        if (!readPosition(r1, c1)) break;
 
-        if (r1 < 0 || r1 >= (int)KGridSize || c1 < 0 || c1 >= (int)KGridSize || grid[r1][c1] == KImpossible) {
+        if (r1 < 0 || r1 >= (int)grid.size() || c1 < 0 || c1 >= (int)grid.size() || grid[r1][c1] == KImpossible || isFixedCell(grid[r1][c1])) {
             std::cin.clear(); // Effacer les indicateurs d'erreur
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
             std::cout << "Entrée invalide. Veuillez réessayer.\n"; //source : https://labex.io/fr/tutorials/cpp-how-to-handle-cin-input-validation-427285
@@ -550,7 +623,7 @@ void runTimeTrialMode(const string& userPseudo) {
         }
 
         cout << "Entrez la Direction (Q:gauche, Z:haut, D:droit, S:bas) : ";
-        if (!(cin >> direction)) break;
+        if (!readDirection(direction)) break;
         direction = toupper(direction);
 
         if (direction != 'Q' && direction != 'Z' && direction != 'D' && direction != 'S') {
@@ -560,40 +633,65 @@ void runTimeTrialMode(const string& userPseudo) {
 
         // --- Déplacement et Scoring ---
         maPosition pos = {(unsigned)c1, (unsigned)r1};
+        CANDY_TRACE_BEGIN("coup");
         makeAMove(grid, pos, direction);
+        currentMoves++;
 
         bool moved = true;
         unsigned comboLevel = 0;
 
+        // Bombe échangée : toute une couleur disparaît avant la réaction en chaîne
+        unsigned bombed = playBomb(game, pos, direction);
+        if (bombed > 0) {
+            comboLevel++;
+            uint64_t bombBonus = matchScore(rule, bombed, comboLevel);
+            score = scoreAdd(score, bombBonus);
+            emitScoredStep(comboLevel, score);
+            cout << "\n> BOMBE ! " << bombed << " bonbons ! Score: +" << bombBonus << endl;
+            displayGrid(game, score);
+        }
+
         // Boucle de réaction en chaîne
         while (moved) {
+            CANDY_TRACE_SCOPE_ARG("pas_de_cascade", comboLevel + 1);
             moved = false;
             unsigned howMany = 0;
             maPosition matchPos;
             bool matchFound = false;
 
             if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
-                removalInColumn(grid, matchPos, howMany);
+                howMany = playMatch(game, matchPos, howMany, MatchVertical);
                 matchFound = true;
             }
             else if (atLeastThreeInARow(grid, matchPos, howMany)) {
-                removalInRow(grid, matchPos, howMany);
+                howMany = playMatch(game, matchPos, howMany, MatchHorizontal);
                 matchFound = true;
             }
 
             if (matchFound) {
                 comboLevel++;
-                unsigned baseScore = howMany * 2;
-                unsigned comboBonus = baseScore * comboLevel;
+                CANDY_COUNT(CounterCascadeSteps, 1);
+                uint64_t baseScore = matchScore(rule, howMany, 1);
+                uint64_t comboBonus = matchScore(rule, howMany, comboLevel);
 
-                score += comboBonus;
+                score = scoreAdd(score, comboBonus);
+                emitScoredStep(comboLevel, score);
                 moved = true;
 
                 cout << "\n> match de " << howMany << "! COMBO x" << comboLevel
                      << " ! Score: +" << comboBonus << " (Base: " << baseScore << ")" << endl;
-                displayGrid(grid, score);
+                displayGrid(game, score);
             }
         }
+        CANDY_MOVE_DONE(comboLevel);
+        comboSteps += comboLevel;
+        CANDY_TRACE_END("coup");
+    }
+    emitEvent(EventGameOver, 0, currentMoves, 0, 0, score);
+
+    if (level) {
+        showLevelResult(game, score);
+        return;
     }
 
     // --- Fin du jeu ---
@@ -604,24 +702,11 @@ void runTimeTrialMode(const string& userPseudo) {
     cout << "========================================" << endl;
 
     // LOGIQUE DE SAUVEGARDE DE SCORE
-    vector<ScoreEntry> scores = loadScores(KFileScoresTimeTrial);
-    ScoreEntry newEntry = {userPseudo, score};
-    scores.push_back(newEntry);
-
-    // Tri par insertion
-    for (size_t i = 1; i < scores.size(); ++i) {
-        ScoreEntry x = scores[i];
-        int j = i;
-        while (j > 0 && scores[j - 1].score < x.score) {
-            scores[j] = scores[j - 1];
-            j = j - 1;
-        }
-
-        scores[j] = x;
-    }
-
-    saveScores(KFileScoresTimeTrial, scores);
-    displayBestScores("Contre-la-montre", scores);
+    recordGame(userPseudo, ModeTimeTrial, score, currentMoves, comboSteps);
+    const string scoresFile = scoreFile(KFileScoresTimeTrial, daily);
+    Leaderboard & scores = scoreBoard(scoresFile, RankHighFirst);
+    const size_t rank = recordScore(scoresFile, scores, userPseudo, score);
+    displayBestScores(daily ? "Contre-la-montre, defi du " + dailyDate(daily->day) : "Contre-la-montre", scores, rank);
 
     // Attendre l'entrée utilisateur
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
@@ -632,28 +717,72 @@ void runTimeTrialMode(const string& userPseudo) {
 /**
  * @brief Boucle principale pour le Mode Cible (Atteindre 1000 de score avec le moins de coups).
  */
-void runTargetMode(const string& userPseudo) {
-    mat grid;
-    initGrid(grid, KGridSize);
-
-    unsigned score = 0;
+void runTargetMode(const string & userPseudo, const LevelView * level = nullptr, std::uint32_t levelIndex = KNoLevel,
+                   const GameSnapshot * saved = nullptr, const DailyChallenge * daily = nullptr) {
+    GameSetup game;
+    setupGame(game, level, levelIndex, daily);
+    mat & grid = game.grid;
+    SpawnScope spawnScope(level ? &game.spawn : nullptr);
+    RandomScope randomScope(daily ? &game.spawnState : tlsSpawnRandom);
+
+    uint64_t score = 0;
+    const ScoreRule rule = scoreRuleFor(ModeTarget);
     unsigned currentMoves = 0;
+    unsigned comboSteps = 0;   // pas de cascade de tous les coups (statistiques)
+
+    // Une seule partie sauvegardée : une nouvelle partie remplace l'ancienne (sauf le défi du jour, jamais sauvegardé)
+    SaveJournal journal(KFileSave);
+    if (saved) currentMoves = restoreGame(game, *saved, score);
+    else if (!daily) journal.discard();
     int r1, c1;
     char direction;
 
-    cout << "--- Mode Cible: Atteindre " << KTargetScore << " points (Coups minimum) ---" << endl;
-
-    while (score < KTargetScore) {
-        displayGrid(grid, score);
+    cout << "--- Mode Cible: Atteindre " << game.targetScore << " points (Coups minimum) ---" << endl;
+
+    while ((score < game.targetScore || game.jellyCount > 0) && (!level || currentMoves < game.maxMoves)) {
+        bool shuffled;
+        if (!keepPlayable(game, shuffled)) {
+            // Objectif jamais atteint : pas de score à enregistrer
+            emitEvent(EventGameOver, 0, currentMoves, 0, 0, score);
+            if (!daily) journal.discard();
+            if (level) {
+                showLevelResult(game, score);
+                return;
+            }
+            clearScreen();
+            cout << "\n========================================" << endl;
+            cout << "        PLUS AUCUN COUP POSSIBLE        " << endl;
+            cout << "   Score : " << score << " / " << game.targetScore << " points" << endl;
+            cout << "========================================" << endl;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
+            cout << "Appuyez sur ENTREE pour continuer...";
+            cin.get();
+            return;
+        }
+        displayGrid(game, score);
         couleur(KTEXT_Black);
+        if (shuffled) cout << "Plus aucun coup possible : les bonbons ont ete melanges." << endl;
         cout << "COUPS UTILISES : " << currentMoves << endl;
-        cout << "OBJECTIF : " << KTargetScore << " points" << endl;
+        cout << "OBJECTIF : " << game.targetScore << " points" << endl;
+        if (daily && daily->record.par) cout << "PAR DU JOUR : " << daily->record.par << " coups" << endl;
 
         // --- Saisie ---
-        cout << "\nEntrez la Ligne et la absonne du nombre a deplacer (ex: 0 0) : ";
-        if (!(cin >> r1 >> c1)) break;
+        cout << "\nEntrez la Ligne et la absonne du nombre a deplacer (ex: 0 0, -1 pour sauvegarder) : ";
+        if (!readPosition(r1, c1)) return;   // saisie interrompue : la partie reste dans le journal
+        if (r1 == KSaveCommand && daily) {
+            cout << "Le defi du jour ne se sauvegarde pas." << endl;
+            continue;
+        }
+        if (r1 == KSaveCommand) {
+            checkpointGame(journal, ModeTarget, game, score, currentMoves, true);
+            cout << "Partie sauvegardee : reprenez-la depuis le menu." << endl;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
+            cout << "Appuyez sur ENTREE pour continuer...";
+            cin.get();
+            return;
+        }
 
-        if (r1 < 0 || r1 >= (int)KGridSize || c1 < 0 || c1 >= (int)KGridSize || grid[r1][c1] == KImpossible) {
+        if (r1 < 0 || r1 >= (int)grid.size() || c1 < 0 || c1 >= (int)grid.size() || grid[r1][c1] == KImpossible || isFixedCell(grid[r1][c1])) {
             std::cin.clear(); // Effacer les indicateurs d'erreur
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
             std::cout << "Entrée invalide. Veuillez réessayer.\n"; //source : https://labex.io/fr/tutorials/cpp-how-to-handle-cin-input-validation-427285
@@ -661,7 +790,7 @@ void runTargetMode(const string& userPseudo) {
         }
 
         cout << "Entrez la Direction (Q:gauche, Z:haut, D:droit, S:bas) : ";
-        if (!(cin >> direction)) break;
+        if (!readDirection(direction)) return;
         direction = toupper(direction);
 
         if (direction != 'Q' && direction != 'Z' && direction != 'D' && direction != 'S') {
@@ -671,14 +800,27 @@ void runTargetMode(const string& userPseudo) {
 
         // --- Déplacement et Scoring ---
         maPosition pos = {(unsigned)c1, (unsigned)r1};
+        CANDY_TRACE_BEGIN("coup");
         makeAMove(grid, pos, direction);
         currentMoves++;
 
         bool moved = true;
         unsigned comboLevel = 0;
 
+        // Bombe échangée : toute une couleur disparaît avant la réaction en chaîne
+        unsigned bombed = playBomb(game, pos, direction);
+        if (bombed > 0) {
+            comboLevel++;
+            uint64_t bombBonus = matchScore(rule, bombed, comboLevel);
+            score = scoreAdd(score, bombBonus);
+            emitScoredStep(comboLevel, score);
+            cout << "\n> BOMBE ! " << bombed << " bonbons ! Score: +" << bombBonus << endl;
+            displayGrid(game, score);
+        }
+
         // Boucle de réaction en chaîne
         while (moved) {
+            CANDY_TRACE_SCOPE_ARG("pas_de_cascade", comboLevel + 1);
             moved = false;
             unsigned howMany = 0;
             maPosition matchPos;
@@ -686,29 +828,43 @@ void runTargetMode(const string& userPseudo) {
 
             // Détection du match
             if (atLeastThreeInAColumn(grid, matchPos, howMany)) {
-                removalInColumn(grid, matchPos, howMany);
+                howMany = playMatch(game, matchPos, howMany, MatchVertical);
                 matchFound = true;
             }
             else if (atLeastThreeInARow(grid, matchPos, howMany)) {
-                removalInRow(grid, matchPos, howMany);
+                howMany = playMatch(game, matchPos, howMany, MatchHorizontal);
                 matchFound = true;
             }
 
             // Mise à jour du score si un match a eu lieu
             if (matchFound) {
                 comboLevel++;
-                unsigned baseScore = howMany * 2;
-                unsigned comboBonus = baseScore * comboLevel;
+                CANDY_COUNT(CounterCascadeSteps, 1);
+                uint64_t baseScore = matchScore(rule, howMany, 1);
+                uint64_t comboBonus = matchScore(rule, howMany, comboLevel);
 
-                score += comboBonus;
+                score = scoreAdd(score, comboBonus);
+                emitScoredStep(comboLevel, score);
                 moved = true;
 
                 cout << "\n> match de " << howMany << "! COMBO x" << comboLevel
                      << " ! Score: +" << comboBonus << " (Base: " << baseScore << ")" << endl;
-                displayGrid(grid, score);
+                displayGrid(game, score);
             }
         }
+        CANDY_MOVE_DONE(comboLevel);
+        comboSteps += comboLevel;
+        CANDY_TRACE_END("coup");
+        if (!daily) checkpointGame(journal, ModeTarget, game, score, currentMoves, false);
+    }
+    emitEvent(EventGameOver, 0, currentMoves, 0, 0, score);
+
+    if (level) {
+        journal.discard();
+        showLevelResult(game, score);
+        return;
     }
+    if (!daily) journal.discard();
 
     // Condition de fin (Objectif atteint)
     clearScreen();
@@ -716,27 +872,15 @@ void runTargetMode(const string& userPseudo) {
     cout << "           OBJECTIF ATTEINT !           " << endl;
     cout << "   Score : " << score << " points" << endl;
     cout << "   Coups utilises : " << currentMoves << endl;
+    if (daily && daily->record.par) cout << "   Par du jour : " << daily->record.par << " coups" << endl;
     cout << "========================================" << endl;
 
     // LOGIQUE DE SAUVEGARDE DE SCORE (Coups minimum)
-    vector<TargetScoreEntry> scores = loadTargetScores(KFileScoresTarget);
-    TargetScoreEntry newEntry = {userPseudo, currentMoves};
-    scores.push_back(newEntry);
-
-    // Tri par insertion
-    for (size_t i = 1; i < scores.size(); ++i) {
-        TargetScoreEntry x = scores[i];
-        int j = i;
-        while (j > 0 && scores[j - 1].moves < x.moves) {
-            scores[j] = scores[j - 1];
-            j = j - 1;
-        }
-
-        scores[j] = x;
-    }
-
-    saveTargetScores(KFileScoresTarget, scores);
-    displayBestTargetScores("Mode Cible", scores);
+    recordGame(userPseudo, ModeTarget, score, currentMoves, comboSteps);
+    const string scoresFile = scoreFile(KFileScoresTarget, daily);
+    Leaderboard & scores = scoreBoard(scoresFile, RankLowFirst);
+    const size_t rank = recordScore(scoresFile, scores, userPseudo, currentMoves);
+    displayBestTargetScores(daily ? "Mode Cible, defi du " + dailyDate(daily->day) : "Mode Cible", scores, rank);
 
     // Attendre l'entrée utilisateur
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
@@ -745,7 +889,121 @@ void runTargetMode(const string& userPseudo) {
 }
 
 
-// --- 6. MAIN ALGORITHM (Menu) ---
+/**
+ * @brief Joue un niveau du paquet KFileLevels, dans le mode prévu par le niveau.
+ */
+void runLevel (const string & userPseudo) {
+    LevelPack pack;
+    if (!pack.open(KFileLevels) || pack.size() == 0) {
+        cout << "Paquet de niveaux introuvable : " << KFileLevels << endl;
+        cout << "Appuyez sur ENTREE pour continuer...";
+        cin.get();
+        return;
+    }
+
+    unsigned number;
+    LevelView level;
+    cout << "Niveau (1 a " << pack.size() << ") : ";
+    if (!(cin >> number) || number == 0 || !pack.level(number - 1, level)) {
+        cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
+        cout << "Niveau invalide." << endl;
+        return;
+    }
+
+    switch (level.record->mode) {
+    case ModeClassic:
+        runClassicMode(userPseudo, &level, number - 1);
+        break;
+    case ModeTimeTrial:
+        runTimeTrialMode(userPseudo, &level);
+        break;
+    default:
+        runTargetMode(userPseudo, &level, number - 1);
+        break;
+    }
+}
+
+/**
+ * @brief Défi du jour : la graine d'aujourd'hui dans KFileDaily, jouée dans le mode choisi.
+ */
+void runDaily (const string & userPseudo) {
+    DailyCalendar calendar;
+    DailyChallenge daily;
+    daily.day = dailyDay(time(nullptr));
+    if (!calendar.open(KFileDaily) || calendar.gridSize() != KGridSize || calendar.nbCandies() != KNbCandies
+        || !calendar.record(daily.day, daily.record)) {
+        cout << "Pas de defi du jour pour le " << dailyDate(daily.day) << " dans " << KFileDaily << endl;
+        cout << "Appuyez sur ENTREE pour continuer...";
+        cin.get();
+        return;
+    }
+
+    unsigned mode;
+    cout << "Defi du " << dailyDate(daily.day) << " : la meme partie pour tous les joueurs" << endl;
+    cout << "1. Classique  2. Contre-la-montre  3. Cible";
+    if (daily.record.par) cout << " (par : " << daily.record.par << " coups)";
+    cout << endl << "Mode (1 a 3) : ";
+    if (!(cin >> mode) || mode == 0 || mode > 3) {
+        cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
+        cout << "Mode invalide." << endl;
+        return;
+    }
+
+    switch (mode) {
+    case 1:
+        runClassicMode(userPseudo, nullptr, KNoLevel, nullptr, &daily);
+        break;
+    case 2:
+        runTimeTrialMode(userPseudo, nullptr, &daily);
+        break;
+    default:
+        runTargetMode(userPseudo, nullptr, KNoLevel, nullptr, &daily);
+        break;
+    }
+}
+
+/**
+ * @brief Reprend la partie sauvegardée dans KFileSave (mode normal ou niveau).
+ */
+void resumeGame (const string & userPseudo) {
+    SaveJournal journal(KFileSave);
+    vector<uint8_t> bytes;
+    GameSnapshot saved;
+    if (!journal.load(bytes) || !unpackSnapshot(bytes.data(), bytes.size(), saved) || saved.mode == ModeTimeTrial) {
+        cout << "Aucune partie sauvegardee." << endl;
+        cout << "Appuyez sur ENTREE pour continuer...";
+        cin.get();
+        return;
+    }
+
+    LevelPack pack;
+    LevelView level;
+    const LevelView * played = nullptr;
+    if (saved.level != KNoLevel) {
+        // Le niveau doit toujours exister dans le paquet, avec la même grille
+        if (!pack.open(KFileLevels) || !pack.level(saved.level, level) || level.record->size != saved.grid.size()
+            || level.record->nbCandies != saved.nbCandies || level.record->mode != saved.mode) {
+            cout << "Le niveau de la partie sauvegardee n'est plus dans " << KFileLevels << "." << endl;
+            cout << "Appuyez sur ENTREE pour continuer...";
+            cin.get();
+            return;
+        }
+        played = &level;
+    }
+    else if (saved.grid.size() != KGridSize || saved.nbCandies != KNbCandies) {
+        cout << "Partie sauvegardee illisible." << endl;
+        cout << "Appuyez sur ENTREE pour continuer...";
+        cin.get();
+        return;
+    }
+
+    if (saved.mode == ModeClassic) runClassicMode(userPseudo, played, saved.level, &saved);
+    else runTargetMode(userPseudo, played, saved.level, &saved);
+}
+
+// --- 5. MAIN ALGORITHM (Menu) ---
 
 void displayMenu() {
     clearScreen();
@@ -756,23 +1014,46 @@ void displayMenu() {
     cout << "1. Mode Classique (Meilleur score en " << KMaxMoves << " coups)" << endl;
     cout << "2. Mode Contre-la-montre (Meilleur score en " << KTimeLimit << " secondes)" << endl;
     cout << "3. Mode Cible (Atteindre " << KTargetScore << " points, coups minimum)" << endl;
-    cout << "4. Quitter" << endl;
+    cout << "4. Niveaux (" << KFileLevels << ")" << endl;
+    cout << "5. Reprendre la partie sauvegardee" << endl;
+    cout << "6. Defi du jour (" << KFileDaily << ")" << endl;
+    cout << "7. Quitter" << endl;
     cout << "----------------------------------------" << endl;
     cout << "Entrez votre choix : ";
 }
 
 int main() {
     srand(time(0));
+    CANDY_ATTACH_TERMINAL();
+    CANDY_TRACE_START("candycrush.trace.json");
+
+    // CANDY_EVENTS=fichier : les événements des parties y sont écrits par un abonné, sur son propre fil
+    ofstream eventsOut;
+    unique_ptr<EventStream> events;
+    unique_ptr<EventSubscriber> eventWriter;
+    if (const char * eventsFile = getenv("CANDY_EVENTS")) {
+        eventsOut.open(eventsFile);
+        if (eventsOut) {
+            events.reset(new EventStream());
+            eventWriter.reset(new EventSubscriber(*events, [&] (const GameEvent & event) { writeEvent(eventsOut, event); }));
+        }
+    }
+    EventScope eventScope(events.get());
+
+    // Les fichiers de scores sont écrits sur un fil de fond : la fin de partie revient tout de suite au menu
+    ScoreWriter scoreWriter;
+    ScoreWriterScope scoreScope(&scoreWriter);
     string userPseudo;
     int choice;
 
     // Saisie du pseudo
     clearScreen();
     couleur(KTEXT_Black);
-    cout << "======================================" << endl;
-    cout << "     BIENVENUE DANS CANDY CRUSH !     " << endl;
-    cout << "======================================" << endl;
-    cout << "Entrez votre pseudo: ";
+    // Premier écran en une seule écriture : cin vide la sortie juste avant de lire le pseudo
+    cout << "======================================\n"
+         << "     BIENVENUE DANS CANDY CRUSH !     \n"
+         << "======================================\n"
+         << "Entrez votre pseudo: ";
     if (!(cin >> userPseudo)) {
         couleur(KReset);
         return 0;
@@ -798,6 +1079,15 @@ int main() {
             runTargetMode(userPseudo);
             break;
         case 4:
+            runLevel(userPseudo);
+            break;
+        case 5:
+            resumeGame(userPseudo);
+            break;
+        case 6:
+            runDaily(userPseudo);
+            break;
+        case 7:
             cout << "Au revoir!" << endl;
             break;
         default:
@@ -805,10 +1095,16 @@ int main() {
             cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Ignorer l'entrée invalide
         }
-    } while (choice != 4);
+    } while (choice != 7);
+
+    if (!scoreWriter.flush()) {
+        cout << "Error: Cannot write the score files" << endl;
+    }
 
     // Réinitialisation de la couleur du terminal avant de quitter
     couleur(KReset);
+    CANDY_TRACE_STOP();
+    CANDY_INSTR_REPORT("candycrush");
 
     return 0;
 }
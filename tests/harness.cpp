@@ -0,0 +1,57 @@
+#include "harness.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct TestEntry {
+    string name;
+    TestFunction fn;
+};
+
+vector<TestEntry> & registry () {
+    static vector<TestEntry> tests;
+    return tests;
+}
+
+unsigned gFailures = 0;   // échecs du test en cours
+
+bool selected (const string & name, int argc, char ** argv) {
+    if (argc < 2) return true;
+    for (int i = 1; i < argc; ++i)
+        if (name.find(argv[i]) != string::npos) return true;
+    return false;
+}
+
+} // namespace
+
+void registerTest (const string & name, TestFunction fn) {
+    registry().push_back({name, fn});
+}
+
+void reportFailure (const char * file, int line, const string & message) {
+    cout << "  " << file << ":" << line << " : " << message << endl;
+    gFailures++;
+}
+
+int main (int argc, char ** argv) {
+    if (argc == 2 && string(argv[1]) == "--list") {
+        for (const TestEntry & test : registry()) cout << test.name << endl;
+        return 0;
+    }
+
+    unsigned run = 0, failed = 0;
+    for (const TestEntry & test : registry()) {
+        if (!selected(test.name, argc, argv)) continue;
+        gFailures = 0;
+        test.fn();
+        run++;
+        if (gFailures) failed++;
+        cout << (gFailures ? "[ ECHEC ] " : "[  OK   ] ") << test.name << endl;
+    }
+    cout << run << " tests, " << failed << " en échec" << endl;
+    return failed || run == 0 ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file harness.h
+ * @brief Petit moteur de tests autonome, sur le modèle du moteur de benchmark (bench/harness.h)
+ *
+ * Chaque test est une fonction sans argument enregistrée par TEST(suite, nom).
+ * CHECK et CHECK_EQ notent un échec (fichier, ligne, valeurs) et le test
+ * continue : un seul passage montre toutes les vérifications qui échouent.
+ * candy_tests lance les tests dont le nom « suite/nom » contient l'un des
+ * textes donnés en argument (tous sans argument) ; CTest lance une suite
+ * par test (voir CMakeLists.txt).
+ */
+#ifndef CANDY_TESTS_HARNESS_H
+#define CANDY_TESTS_HARNESS_H
+
+#include <sstream>
+#include <string>
+
+typedef void (*TestFunction) ();
+
+/**
+ * @brief Enregistre un test
+ * @param name Nom complet (suite/nom)
+ */
+void registerTest (const std::string & name, TestFunction fn);
+
+/**
+ * @brief Note un échec du test en cours
+ */
+void reportFailure (const char * file, int line, const std::string & message);
+
+/**
+ * @brief Vérifie expected == actual et note les deux valeurs sinon
+ */
+template <class A, class B>
+inline void checkEqual (const A & actual, const B & expected, const char * file, int line, const char * text) {
+    if (actual == expected) return;
+    std::ostringstream message;
+    message << text << " : " << actual << " au lieu de " << expected;
+    reportFailure(file, line, message.str());
+}
+
+/**
+ * @brief Objet statique qui enregistre un test au chargement du programme
+ */
+struct TestRegistrar {
+    TestRegistrar (const std::string & name, TestFunction fn) {
+        registerTest(name, fn);
+    }
+};
+
+#define TEST(suite, name) \
+    static void suite##_##name (); \
+    static TestRegistrar suite##_##name##_registrar (#suite "/" #name, suite##_##name); \
+    static void suite##_##name ()
+
+#define CHECK(condition) \
+    do { if (!(condition)) reportFailure(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    checkEqual((actual), (expected), __FILE__, __LINE__, #actual " == " #expected)
+
+#endif // CANDY_TESTS_HARNESS_H
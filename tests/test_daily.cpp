@@ -0,0 +1,131 @@
+/**
+ * @file test_daily.cpp
+ * @brief Défi du jour (daily.h) : dates, calendrier écrit puis relu, choix des graines quel que soit le nombre de fils
+ */
+#include "harness.h"
+#include "../engine/daily.h"
+#include "../engine/grid.h"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const char * KCalendarFile = "candy_tests_daily.cal";
+const uint64_t KTestSeed (50);
+
+/**
+ * @brief Peu de parties par candidate et une petite preuve : quelques jours se choisissent en une seconde
+ */
+DailyCriteria smallCriteria () {
+    return DailyCriteria {KGridSize, KNbCandies, 60, 3, 150, 5, 100, 6, 8, 20000};
+}
+
+bool sameRecord (const DailyRecord & a, const DailyRecord & b) {
+    return a.seed == b.seed && a.par == b.par && a.parProven == b.parProven && a.attempts == b.attempts
+           && a.easyPerMille == b.easyPerMille && a.blockedPerMille == b.blockedPerMille;
+}
+
+} // namespace
+
+TEST(daily, datesRoundTrip) {
+    uint32_t day = 1;
+    CHECK(parseDailyDate("1970-01-01", day));
+    CHECK_EQ(day, 0u);
+    CHECK(parseDailyDate("2027-03-14", day));
+    CHECK_EQ(dailyDate(day), string("2027-03-14"));
+    CHECK_EQ(dailyDay(time_t(day) * 86400 + 86399), day);
+
+    // Jours bissextils : tous les 4 ans, sauf les siècles non multiples de 400
+    CHECK(parseDailyDate("2024-02-29", day));
+    CHECK_EQ(dailyDate(day + 1), string("2024-03-01"));
+    CHECK(parseDailyDate("2000-02-29", day));
+    CHECK(!parseDailyDate("2023-02-29", day));
+    CHECK(!parseDailyDate("2100-02-29", day));
+
+    // Dates impossibles, mal écrites ou suivies d'autre chose
+    for (const char * text : {"2027-04-31", "2027-13-01", "2027-00-10", "2027-01-00", "1969-12-31", "2027-1-01",
+                              "2027-01-01x", "2027-01-01 ", "27-01-01", "", "aaaa-mm-jj"})
+        CHECK(!parseDailyDate(text, day));
+
+    // Chaque jour d'un siècle redonne sa date
+    unsigned wrong = 0;
+    for (uint32_t d = 0; d < 36525; d += 7) {
+        uint32_t back = 0;
+        wrong += !parseDailyDate(dailyDate(d), back) || back != d;
+    }
+    CHECK_EQ(wrong, 0u);
+}
+
+TEST(daily, calendarRoundTrip) {
+    vector<DailyRecord> records;
+    for (unsigned k = 0; k < 40; ++k)
+        records.push_back(DailyRecord {KTestSeed * 1000 + k, uint16_t(k % 7), uint8_t(k % 2), uint8_t(1 + k % 5),
+                                       uint16_t(k * 3), uint16_t(k)});
+    const uint32_t firstDay = 20000;
+    CHECK(writeDailyCalendar(KCalendarFile, firstDay, 9, 6, records));
+
+    DailyCalendar calendar;
+    CHECK(calendar.open(KCalendarFile));
+    CHECK_EQ(calendar.firstDay(), firstDay);
+    CHECK_EQ(calendar.size(), records.size());
+    CHECK_EQ(calendar.gridSize(), 9u);
+    CHECK_EQ(calendar.nbCandies(), 6u);
+    DailyRecord record;
+    for (unsigned k = 0; k < records.size(); ++k) {
+        CHECK(calendar.record(firstDay + k, record));
+        CHECK(sameRecord(record, records[k]));
+    }
+    CHECK(!calendar.record(firstDay - 1, record));
+    CHECK(!calendar.record(firstDay + records.size(), record));
+    calendar.close();
+    CHECK(!calendar.record(firstDay, record));
+
+    // Un fichier qui n'est pas un calendrier est refusé
+    FILE * file = fopen(KCalendarFile, "wb");
+    fputs("CANDYCOL pas un calendrier", file);
+    fclose(file);
+    CHECK(!calendar.open(KCalendarFile));
+    remove(KCalendarFile);
+    CHECK(!calendar.open(KCalendarFile));
+}
+
+TEST(daily, sameSeedsForAnyThreadCount) {
+    const DailyCriteria criteria = smallCriteria();
+    const unsigned days = 5;
+    vector<DailyRecord> expected;
+    const DailyReport reference = generateDailySeeds(KTestSeed, 20000, days, criteria, 1, expected);
+    CHECK_EQ(expected.size(), size_t(days));
+    CHECK(reference.candidates >= days);
+    for (unsigned threads : {2u, 3u, 8u}) {
+        vector<DailyRecord> records;
+        const DailyReport report = generateDailySeeds(KTestSeed, 20000, days, criteria, threads, records);
+        CHECK_EQ(report.candidates, reference.candidates);
+        CHECK_EQ(report.rejectedEasy, reference.rejectedEasy);
+        CHECK_EQ(report.rejectedBlocked, reference.rejectedBlocked);
+        CHECK_EQ(report.unresolved, reference.unresolved);
+        CHECK_EQ(report.games, reference.games);
+        for (unsigned k = 0; k < days && k < records.size(); ++k) CHECK(sameRecord(records[k], expected[k]));
+    }
+}
+
+TEST(daily, unresolvedDayKeepsCompleteFigures) {
+    // Aucune partie facile admise : chaque candidate est refusée à sa première partie facile
+    DailyCriteria criteria = smallCriteria();
+    criteria.easyMoves = 10;
+    criteria.maxEasyPerMille = 0;
+    criteria.maxAttempts = 4;
+    vector<DailyRecord> records;
+    const DailyReport report = generateDailySeeds(KTestSeed, 20000, 2, criteria, 1, records);
+    CHECK_EQ(report.unresolved, 2u);
+    for (const DailyRecord & record : records) {
+        CHECK_EQ(record.attempts, 4u);
+        // Les proportions gardées sont celles de toutes les parties, pas celles du jugement arrêté au refus
+        const SeedVerdict verdict = judgeSeed(record.seed, criteria, true);
+        CHECK(!verdict.partial);
+        CHECK_EQ(verdict.games, criteria.games);
+        CHECK_EQ(record.easyPerMille, verdict.easyPerMille());
+        CHECK_EQ(record.blockedPerMille, verdict.blockedPerMille());
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file test_events.cpp
+ * @brief Flux d'événements (events.h) : un abonné dépassé voit les événements dans l'ordre et compte ceux qu'il a perdus
+ *
+ * Chaque événement porte son rang de publication dans value : un abonné
+ * ne doit jamais le voir reculer ni le voir deux fois, et les événements
+ * vus plus les événements perdus doivent faire tous ceux publiés.
+ */
+#include "harness.h"
+#include "../engine/events.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+GameEvent rankedEvent (uint64_t rank) {
+    return GameEvent {EventScoreChanged, 0, uint32_t(rank % 7), uint32_t(rank), uint32_t(rank >> 32), rank};
+}
+
+/**
+ * @brief Vérifie un lot lu : rangs croissants, champs intacts ; met à jour le dernier rang vu
+ * @return Nombre d'événements fautifs
+ */
+unsigned checkBatch (const GameEvent * events, size_t count, uint64_t & nextRank) {
+    unsigned wrong = 0;
+    for (size_t k = 0; k < count; ++k) {
+        const GameEvent & event = events[k];
+        const GameEvent expected = rankedEvent(event.value);
+        wrong += event.value < nextRank || event.kind != expected.kind || event.length != expected.length
+                 || event.ord != expected.ord || event.abs != expected.abs;
+        nextRank = event.value + 1;
+    }
+    return wrong;
+}
+
+} // namespace
+
+TEST(events, cursorCountsOverrun) {
+    EventStream stream (16);
+    CHECK_EQ(stream.capacity(), size_t(16));
+    EventCursor cursor (stream);
+    GameEvent events [KEventBatch];
+    uint64_t nextRank = 0, seen = 0;
+    unsigned wrong = 0;
+    uint64_t published = 0;
+
+    // Tours où le producteur publie plus que l'anneau n'en garde, d'autres où l'abonné suit
+    for (unsigned round = 0; round < 50; ++round) {
+        const unsigned burst = round % 3 == 0 ? 100 : 5 + round % 11;
+        for (unsigned k = 0; k < burst; ++k) stream.publish(rankedEvent(published++));
+        size_t count;
+        while ((count = cursor.poll(events, round % 2 ? 4 : KEventBatch)) > 0) {
+            wrong += checkBatch(events, count, nextRank);
+            seen += count;
+        }
+        CHECK_EQ(seen + cursor.dropped(), published);
+        // Rattrapé : le dernier événement publié a toujours été lu
+        CHECK_EQ(nextRank, published);
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK(cursor.dropped() > 0);
+    CHECK_EQ(stream.published(), published);
+
+    // Un curseur créé maintenant ne lit que la suite
+    EventCursor late (stream);
+    CHECK_EQ(late.poll(events, KEventBatch), size_t(0));
+    stream.publish(rankedEvent(published));
+    CHECK_EQ(late.poll(events, KEventBatch), size_t(1));
+    CHECK_EQ(events[0].value, published);
+    CHECK_EQ(late.dropped(), uint64_t(0));
+}
+
+TEST(events, slowSubscriberIsOverrun) {
+    const uint64_t emitted = 200000;
+    EventStream stream (64);
+    uint64_t nextRank = 0, seen = 0;
+    unsigned wrong = 0;
+    {
+        // Abonné lent : il dort de temps en temps pendant que le producteur continue
+        EventSubscriber subscriber (stream, [&] (const GameEvent & event) {
+            wrong += checkBatch(&event, 1, nextRank);
+            if (++seen % 64 == 0) this_thread::sleep_for(chrono::microseconds(50));
+        });
+        for (uint64_t rank = 0; rank < emitted; ++rank) stream.publish(rankedEvent(rank));
+        subscriber.stop();
+        CHECK_EQ(subscriber.received(), seen);
+        CHECK(subscriber.dropped() > 0);
+        CHECK_EQ(subscriber.received() + subscriber.dropped(), emitted);
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK_EQ(stream.published(), emitted);
+    // Le dernier événement, publié avant l'arrêt, a été lu
+    CHECK_EQ(nextRank, emitted);
+}
@@ -0,0 +1,162 @@
+/**
+ * @file test_history.cpp
+ * @brief Historique des coups (history.h) : annuler puis rétablir redonne chaque grille, quel que soit le noyau
+ *
+ * L'historique ne voit que les cases que les noyaux lui signalent avant de
+ * les modifier : chaque test joue des coups avec un noyau différent (réaction
+ * en série, bonbons spéciaux, mélange, BandResolver), garde la grille après
+ * chaque coup, puis annule et rétablit toute la partie.
+ */
+#include "harness.h"
+#include "../engine/history.h"
+#include "../engine/resolver.h"
+#include "../engine/shuffle.h"
+#include "../engine/spawn.h"
+#include "../engine/special.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (99);
+const char KDirections[] = {'Q', 'Z', 'D', 'S'};
+
+/**
+ * @brief Coup joué sur la grille : échange et réaction en chaîne
+ */
+typedef uint64_t (*PlayFunction)(mat & grid, const maPosition & pos, char direction, unsigned nbCandies);
+
+uint64_t playSerial (mat & grid, const maPosition & pos, char direction, unsigned nbCandies) {
+    makeAMove(grid, pos, direction);
+    const unsigned steps = resolveCascade(grid, nbCandies);
+    // Coup sans match : le même échange remet les bonbons en place
+    if (steps == 0) makeAMove(grid, pos, direction);
+    if (!hasLegalMove(grid)) reshuffleGrid(grid);
+    return steps;
+}
+
+uint64_t playSpecials (mat & grid, const maPosition & pos, char direction, unsigned nbCandies) {
+    makeAMove(grid, pos, direction);
+    uint64_t cleared = activateSwap(grid, pos, direction, nbCandies);
+    maPosition match = {0, 0};
+    unsigned howMany = 0;
+    for (bool found = true; found; ) {
+        found = false;
+        if (atLeastThreeInAColumn(grid, match, howMany)) {
+            cleared += clearMatch(grid, match, howMany, MatchVertical, nbCandies);
+            found = true;
+        }
+        if (atLeastThreeInARow(grid, match, howMany)) {
+            cleared += clearMatch(grid, match, howMany, MatchHorizontal, nbCandies);
+            found = true;
+        }
+    }
+    return cleared;
+}
+
+uint64_t playBatch (mat & grid, const maPosition & pos, char direction, unsigned nbCandies) {
+    static BandResolver resolver(3);
+    makeAMove(grid, pos, direction);
+    return resolver.resolve(grid, RuleFibonacci, nbCandies, pos.ord * 1000 + pos.abs).score;
+}
+
+/**
+ * @brief Joue moves coups au hasard, puis vérifie annuler et rétablir sur toute la partie
+ */
+void checkUndoRedo (mat grid, unsigned nbCandies, unsigned moves, PlayFunction play) {
+    uint64_t state = KTestSeed;
+    RandomScope randomScope(&state);
+    const unsigned size = grid.size();
+    MoveHistory history;
+    vector<mat> grids(1, grid);
+    vector<uint64_t> scores(1, 0);
+    uint64_t score = 0;
+    for (unsigned move = 0; move < moves; ++move) {
+        const unsigned draw = spawnRandom();
+        const maPosition pos = {draw % size, (draw / size) % size};
+        history.beginMove(grid, score);
+        score += play(grid, pos, KDirections[(draw >> 20) % 4], nbCandies);
+        history.endMove(grid, score);
+        grids.push_back(grid);
+        scores.push_back(score);
+    }
+    CHECK_EQ(history.played(), size_t(moves));
+
+    for (unsigned move = moves; move > 0; --move) {
+        CHECK(history.undo(grid, score));
+        if (grid != grids[move - 1]) {
+            CHECK(grid == grids[move - 1]);
+            return;
+        }
+        CHECK_EQ(score, scores[move - 1]);
+    }
+    CHECK(!history.undo(grid, score));
+    for (unsigned move = 1; move <= moves; ++move) {
+        CHECK(history.redo(grid, score));
+        if (grid != grids[move]) {
+            CHECK(grid == grids[move]);
+            return;
+        }
+        CHECK_EQ(score, scores[move]);
+    }
+    CHECK(!history.redo(grid, score));
+}
+
+/**
+ * @brief Grille de départ tirée de la graine seed
+ */
+mat startGrid (unsigned size, unsigned nbCandies, uint64_t seed) {
+    RandomScope randomScope(&seed);
+    mat grid;
+    initGrid(grid, size, nbCandies);
+    return grid;
+}
+
+} // namespace
+
+TEST(history, serialCascades) {
+    for (unsigned size : {5u, 8u, 24u})
+        checkUndoRedo(startGrid(size, 4, KTestSeed + size), 4, 150, playSerial);
+}
+
+TEST(history, specialsAndFixedCells) {
+    for (unsigned size : {8u, 16u}) {
+        mat grid = startGrid(size, 5, KTestSeed * size);
+        // Bloqueurs et trous : segments remplis sur place ; spéciaux : effets en croix et bombes
+        for (unsigned k = 0; k < size; ++k) {
+            const unsigned i = (k * 7) % size, j = (k * 3 + 1) % size;
+            if (k % 4 == 0) grid[i][j] = KBlocker;
+            else if (k % 4 == 1) grid[i][j] = KHole;
+            else grid[i][j] = makeSpecial(1 + k % 5, SpecialKind(1 + k % 4));
+        }
+        checkUndoRedo(grid, 5, 150, playSpecials);
+    }
+}
+
+TEST(history, batchResolver) {
+    checkUndoRedo(startGrid(300, 4, KTestSeed), 4, 40, playBatch);
+}
+
+TEST(history, onlyChangedColumnsAreStored) {
+    mat grid = startGrid(64, 5, KTestSeed);
+    MoveHistory history;
+    // Echange sans match remis en place : rien n'a changé, le coup ne garde aucune colonne
+    const maPosition pos = {5, 7};
+    const mat before = grid;
+    history.beginMove(grid, 0);
+    makeAMove(grid, pos, 'S');
+    makeAMove(grid, pos, 'S');
+    history.endMove(grid, 0);
+    CHECK(grid == before);
+    const size_t emptyMove = history.bytes();
+    CHECK(emptyMove <= 2 + sizeof(size_t));
+
+    // Un échange vertical ne touche qu'une colonne : quelques octets, pas une copie de la grille
+    history.beginMove(grid, 0);
+    makeAMove(grid, maPosition {10, 20}, 'S');
+    history.endMove(grid, 0);
+    CHECK(history.bytes() - emptyMove < 32);
+    uint64_t score = 0;
+    CHECK(history.undo(grid, score));
+    CHECK(grid == before);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file test_kernels.cpp
+ * @brief Noyaux de la grille : mat (grid.h) et grille compacte (packed.h) donnent les mêmes parties
+ *
+ * Les deux représentations tirent leurs bonbons dans le même générateur
+ * (RandomScope) : même graine, même grille de départ, mêmes matchs et mêmes
+ * réactions en chaîne après chaque échange.
+ */
+#include "harness.h"
+#include "../engine/grid.h"
+#include "../engine/packed.h"
+#include "../engine/spawn.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (20261019);
+const char KDirections[] = {'Q', 'Z', 'D', 'S'};
+
+bool sameGrid (const PackedGrid & packed, const mat & grid) {
+    mat unpacked;
+    unpackGrid(packed, unpacked);
+    return unpacked == grid;
+}
+
+} // namespace
+
+TEST(kernels, packRoundTrip) {
+    uint64_t state = KTestSeed;
+    RandomScope randomScope(&state);
+    for (unsigned size : {3u, 8u, 16u, 17u, 65u}) {
+        mat grid;
+        initGrid(grid, size, 7);
+        PackedGrid packed;
+        CHECK(packGrid(grid, packed));
+        CHECK_EQ(packed.size, size);
+        CHECK(sameGrid(packed, grid));
+    }
+}
+
+TEST(kernels, initGridMatchesMat) {
+    for (unsigned size : {3u, 8u, 17u, 64u}) {
+        for (unsigned nbCandies : {3u, 4u, 5u, 7u}) {
+            uint64_t matState = forkSeed(KTestSeed, size * 16 + nbCandies), packedState = matState;
+            mat grid;
+            PackedGrid packed;
+            {
+                RandomScope randomScope(&matState);
+                initGrid(grid, size, nbCandies);
+            }
+            {
+                RandomScope randomScope(&packedState);
+                initGrid(packed, size, nbCandies);
+            }
+            CHECK(sameGrid(packed, grid));
+            CHECK(!checkInitialMatch(grid));
+            CHECK(!checkInitialMatch(packed));
+        }
+    }
+}
+
+TEST(kernels, movesAndCascadesMatchMat) {
+    // Au-delà de quelques cases de côté, trois couleurs donnent des réactions de milliers de pas
+    for (unsigned size : {5u, 8u, 24u}) {
+        for (unsigned nbCandies : {4u, 5u, 6u}) {
+            uint64_t matState = forkSeed(KTestSeed, size * 16 + nbCandies), packedState = matState;
+            uint64_t moveState = matState ^ 0x5EED;
+            mat grid;
+            PackedGrid packed;
+            {
+                RandomScope randomScope(&matState);
+                initGrid(grid, size, nbCandies);
+            }
+            {
+                RandomScope randomScope(&packedState);
+                initGrid(packed, size, nbCandies);
+            }
+            for (unsigned move = 0; move < 200; ++move) {
+                unsigned draw;
+                {
+                    RandomScope randomScope(&moveState);
+                    draw = spawnRandom();
+                }
+                const maPosition pos = {draw % size, (draw / size) % size};
+                const char direction = KDirections[(draw >> 20) % 4];
+                makeAMove(grid, pos, direction);
+                makeAMove(packed, pos, direction);
+
+                maPosition matPos = {0, 0}, packedPos = {0, 0};
+                unsigned matHowMany = 0, packedHowMany = 0;
+                CHECK_EQ(atLeastThreeInAColumn(packed, packedPos, packedHowMany),
+                         atLeastThreeInAColumn(grid, matPos, matHowMany));
+                CHECK_EQ(packedPos.abs, matPos.abs);
+                CHECK_EQ(packedPos.ord, matPos.ord);
+                CHECK_EQ(packedHowMany, matHowMany);
+                CHECK_EQ(atLeastThreeInARow(packed, packedPos, packedHowMany),
+                         atLeastThreeInARow(grid, matPos, matHowMany));
+                CHECK_EQ(packedPos.abs, matPos.abs);
+                CHECK_EQ(packedPos.ord, matPos.ord);
+                CHECK_EQ(packedHowMany, matHowMany);
+
+                unsigned matSteps, packedSteps;
+                {
+                    RandomScope randomScope(&matState);
+                    matSteps = resolveCascade(grid, nbCandies);
+                }
+                {
+                    RandomScope randomScope(&packedState);
+                    packedSteps = resolveCascade(packed, nbCandies);
+                }
+                CHECK_EQ(packedSteps, matSteps);
+                if (!sameGrid(packed, grid)) {
+                    CHECK(sameGrid(packed, grid));
+                    return;
+                }
+                CHECK(!checkInitialMatch(grid));
+            }
+        }
+    }
+}
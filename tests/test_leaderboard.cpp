@@ -0,0 +1,144 @@
+/**
+ * @file test_leaderboard.cpp
+ * @brief Classement (leaderboard.h) : l'arbre B compté donne les rangs d'un tableau trié de façon stable
+ *
+ * Chaque test insère des entrées aux valeurs très répétées, assez pour
+ * couper des feuilles et des nœuds internes sur plusieurs niveaux, et compare
+ * chaque rang rendu, chaque entrée, chaque page et le fichier réécrit à un
+ * tableau trié par stable_sort (à valeur égale, l'entrée la plus ancienne
+ * devant).
+ */
+#include "harness.h"
+#include "../engine/leaderboard.h"
+#include "../engine/spawn.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (44);
+const unsigned KTestEntries (100000);
+const unsigned KTestValues (700);       // valeurs distinctes : environ 140 entrées par valeur
+const char * KBoardFile = "candy_tests_leaderboard.txt";
+
+/**
+ * @brief Valeur du tirage : quelques valeurs extrêmes (0, la plus grande) parmi les valeurs répétées
+ */
+uint64_t drawValue (unsigned draw) {
+    const unsigned value = draw % KTestValues;
+    if (value == 0) return 0;
+    if (value == 1) return UINT64_MAX;
+    return uint64_t(value) * 1000;
+}
+
+/**
+ * @brief Rangs des insertions, entrées par rang, pages et fichier réécrit, comparés au tableau trié
+ */
+void checkAgainstSorted (RankOrder order) {
+    uint64_t state = KTestSeed + order;
+    RandomScope randomScope(&state);
+    Leaderboard board (order);
+    vector<RankEntry> reference;   // dans l'ordre des insertions
+    vector<uint64_t> values;       // valeurs distinctes déjà insérées et leur nombre d'entrées
+    vector<size_t> counts;
+
+    for (unsigned k = 0; k < KTestEntries; ++k) {
+        const uint64_t value = drawValue(spawnRandom());
+        const string pseudo = "joueur" + to_string(spawnRandom() % 977);
+
+        // Nouvelle entrée derrière toutes celles de même valeur
+        const size_t at = lower_bound(values.begin(), values.end(), value) - values.begin();
+        if (at == values.size() || values[at] != value) {
+            values.insert(values.begin() + at, value);
+            counts.insert(counts.begin() + at, 0);
+        }
+        counts[at]++;
+        size_t expected = 0;
+        for (size_t v = 0; v < values.size(); ++v) {
+            if (order == RankHighFirst ? values[v] >= value : values[v] <= value) expected += counts[v];
+        }
+        const size_t rank = board.insert(pseudo, value);
+        if (rank != expected) {
+            CHECK_EQ(rank, expected);
+            return;
+        }
+        reference.push_back(RankEntry {pseudo, value});
+    }
+    CHECK_EQ(board.size(), size_t(KTestEntries));
+
+    stable_sort(reference.begin(), reference.end(), [order] (const RankEntry & a, const RankEntry & b) {
+        return order == RankHighFirst ? a.value > b.value : a.value < b.value;
+    });
+    RankEntry entry;
+    unsigned wrong = 0;
+    for (size_t rank = 1; rank <= reference.size(); ++rank) {
+        if (!board.at(rank, entry) || entry.value != reference[rank - 1].value
+            || entry.pseudo != reference[rank - 1].pseudo) wrong++;
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK(!board.at(0, entry));
+    CHECK(!board.at(reference.size() + 1, entry));
+
+    // Rang d'une nouvelle valeur : derrière toutes les entrées classées devant ou à égalité
+    for (uint64_t value : {uint64_t(0), uint64_t(1500), uint64_t(42000), uint64_t(42001), UINT64_MAX}) {
+        size_t expected = 1;
+        for (const RankEntry & other : reference)
+            expected += order == RankHighFirst ? other.value >= value : other.value <= value;
+        CHECK_EQ(board.rankOf(value), expected);
+    }
+
+    // Pages à cheval sur des feuilles, et la dernière, incomplète
+    vector<RankEntry> page;
+    for (size_t first : {size_t(1), size_t(60), size_t(4097), reference.size() - 10}) {
+        board.page(first, 100, page);
+        CHECK_EQ(page.size(), min<size_t>(100, reference.size() - first + 1));
+        for (size_t k = 0; k < page.size(); ++k) {
+            if (page[k].value != reference[first - 1 + k].value || page[k].pseudo != reference[first - 1 + k].pseudo) {
+                CHECK(page[k].pseudo == reference[first - 1 + k].pseudo);
+                break;
+            }
+        }
+    }
+    board.page(reference.size() + 1, 10, page);
+    CHECK(page.empty());
+
+    // Fichier réécrit dans l'ordre du classement puis relu : même classement
+    CHECK(board.save(KBoardFile));
+    Leaderboard reloaded (order);
+    CHECK(reloaded.load(KBoardFile));
+    CHECK_EQ(reloaded.size(), reference.size());
+    CHECK_EQ(reloaded.players().size(), board.players().size());
+    wrong = 0;
+    for (size_t rank = 1; rank <= reference.size(); ++rank) {
+        if (!reloaded.at(rank, entry) || entry.value != reference[rank - 1].value
+            || entry.pseudo != reference[rank - 1].pseudo) wrong++;
+    }
+    CHECK_EQ(wrong, 0u);
+    remove(KBoardFile);
+}
+
+} // namespace
+
+TEST(leaderboard, highFirstMatchesStableSort) {
+    checkAgainstSorted(RankHighFirst);
+}
+
+TEST(leaderboard, lowFirstMatchesStableSort) {
+    checkAgainstSorted(RankLowFirst);
+}
+
+TEST(leaderboard, emptyBoard) {
+    Leaderboard board;
+    RankEntry entry;
+    vector<RankEntry> page;
+    CHECK_EQ(board.size(), size_t(0));
+    CHECK_EQ(board.rankOf(100), size_t(1));
+    CHECK(!board.at(1, entry));
+    board.page(1, 10, page);
+    CHECK(page.empty());
+    CHECK(!board.load("candy_tests_absent.txt"));
+    CHECK_EQ(board.size(), size_t(0));
+}
@@ -0,0 +1,167 @@
+/**
+ * @file test_level.cpp
+ * @brief Niveaux (level.h) : lecture du format texte, erreurs, paquet binaire relu par mmap
+ */
+#include "harness.h"
+#include "../engine/level.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+const char * KPackFile = "candy_tests_niveaux.pack";
+
+const char * KSampleLevel =
+    "# un commentaire avant le niveau\n"
+    "niveau\n"
+    "taille 4\n"
+    "bonbons 5\n"
+    "mode cible\n"
+    "coups 12\n"
+    "temps 45\n"
+    "objectif 700\n"
+    "poids 1 2 0 4 5\n"
+    "sequence 1 2 3\n"
+    "sequence 4\n"
+    "colonne 2 5 5\n"
+    "grille\n"
+    "X..X\n"
+    ".12.\n"
+    ".#9.\n"
+    "....\n"
+    "fin\n";
+
+/**
+ * @brief Lit un texte ; renvoie le message d'erreur, vide si la lecture réussit
+ */
+string parseText (const string & text, vector<LevelData> & levels) {
+    istringstream in(text);
+    string error;
+    if (!parseLevels(in, levels, error)) return error.empty() ? "?" : error;
+    return "";
+}
+
+} // namespace
+
+TEST(level, parsesAllFields) {
+    vector<LevelData> levels;
+    CHECK_EQ(parseText(KSampleLevel, levels), string());
+    if (levels.size() != 1) return;
+    const LevelData & level = levels[0];
+    CHECK_EQ(level.record.size, 4u);
+    CHECK_EQ(unsigned(level.record.nbCandies), 5u);
+    CHECK_EQ(unsigned(level.record.mode), unsigned(ModeTarget));
+    CHECK_EQ(level.record.maxMoves, 12u);
+    CHECK_EQ(level.record.timeLimit, 45u);
+    CHECK_EQ(level.record.targetScore, 700u);
+    const unsigned weights[KMaxLevelCandies] = {1, 2, 0, 4, 5, 0, 0, 0};
+    for (unsigned c = 0; c < KMaxLevelCandies; ++c) CHECK_EQ(unsigned(level.record.spawnWeights[c]), weights[c]);
+
+    const vector<uint8_t> cells = {
+        KLevelCellHole, KLevelCellCandy, KLevelCellCandy, KLevelCellHole,
+        KLevelCellCandy, uint8_t(KLevelCellCandy | 1 << KLevelJellyShift), uint8_t(KLevelCellCandy | 2 << KLevelJellyShift), KLevelCellCandy,
+        KLevelCellCandy, KLevelCellBlocker, uint8_t(KLevelCellCandy | 9 << KLevelJellyShift), KLevelCellCandy,
+        KLevelCellCandy, KLevelCellCandy, KLevelCellCandy, KLevelCellCandy};
+    CHECK(level.cells == cells);
+
+    vector<uint8_t> script;
+    vector<vector<uint8_t> > queues;
+    readLevelSpawn(viewOf(level), script, queues);
+    CHECK(script == vector<uint8_t>({1, 2, 3, 4}));
+    CHECK_EQ(queues.size(), 4u);
+    if (queues.size() == 4) CHECK(queues[2] == vector<uint8_t>({5, 5}));
+}
+
+TEST(level, gridAndJellyFromLevel) {
+    vector<LevelData> levels;
+    CHECK_EQ(parseText(KSampleLevel, levels), string());
+    if (levels.size() != 1) return;
+    mat grid, jelly;
+    initLevelGrid(viewOf(levels[0]), grid, jelly);
+    CHECK_EQ(grid[0][0], KHole);
+    CHECK_EQ(grid[0][3], KHole);
+    CHECK_EQ(grid[2][1], KBlocker);
+    CHECK_EQ(jelly[1][1], 1u);
+    CHECK_EQ(jelly[2][2], 9u);
+    CHECK_EQ(jellyLeft(jelly), 12u);
+    CHECK(!checkInitialMatch(grid));
+    for (const line & row : grid)
+        for (unsigned cell : row) CHECK(isFixedCell(cell) || (cell >= 1 && cell <= 5));
+}
+
+TEST(level, gridRowMayStartWithBlocker) {
+    vector<LevelData> levels;
+    CHECK_EQ(parseText("# commentaire\nniveau\ntaille 3\ngrille\n#..\n.#.\n##.\nfin\n# fin du fichier\n", levels), string());
+    if (levels.size() != 1) return;
+    const vector<uint8_t> cells = {
+        KLevelCellBlocker, KLevelCellCandy, KLevelCellCandy,
+        KLevelCellCandy, KLevelCellBlocker, KLevelCellCandy,
+        KLevelCellBlocker, KLevelCellBlocker, KLevelCellCandy};
+    CHECK(levels[0].cells == cells);
+}
+
+TEST(level, reportsErrorsWithLineNumbers) {
+    const struct {
+        const char * text;
+        const char * error;
+    } cases[] = {
+        {"taille 8\n", "ligne 1 : 'niveau' attendu"},
+        {"niveau\ntaille 2\nfin\n", "ligne 2 : taille entre 3 et 1024 attendue"},
+        {"niveau\nmode arcade\nfin\n", "ligne 2 : mode inconnu"},
+        {"niveau\ntaille 3\ngrille\n...\n..\n", "ligne 5 : la rangée doit avoir 3 cases"},
+        {"niveau\ntaille 3\ngrille\n...\n.?.\n", "ligne 5 : case inconnue '?'"},
+        {"niveau\ntaille 3\ngrille\n...\n...\nfin\n", "ligne 6 : la grille doit avoir 3 rangées"},
+        {"niveau\nbonbons 3\nsequence 4\nfin\n", "ligne 4 : la séquence utilise une couleur absente du niveau"},
+        {"niveau\ntaille 3\ncolonne 5 1\nfin\n", "ligne 4 : colonne hors de la grille"},
+        {"niveau\nbonbons 3\npoids 0 0 0 9\nfin\n", "ligne 4 : au moins une couleur doit avoir un poids non nul"},
+        {"niveau\ntaille 3\n", "ligne 2 : 'fin' manquant"},
+        {"niveau\nvitesse 3\nfin\n", "ligne 2 : mot-clé inconnu 'vitesse'"},
+    };
+    for (const auto & error : cases) {
+        vector<LevelData> levels;
+        CHECK_EQ(parseText(error.text, levels), string(error.error));
+    }
+}
+
+TEST(level, packRoundTrip) {
+    vector<LevelData> levels;
+    CHECK_EQ(parseText(string(KSampleLevel) + "niveau\ntaille 6\nmode classique\nfin\n", levels), string());
+    CHECK_EQ(levels.size(), 2u);
+    CHECK(writeLevelPack(KPackFile, levels));
+
+    LevelPack pack;
+    CHECK(pack.open(KPackFile));
+    CHECK_EQ(pack.size(), levels.size());
+    for (size_t k = 0; k < pack.size() && k < levels.size(); ++k) {
+        LevelView view;
+        CHECK(pack.level(k, view));
+        if (!view.record) continue;
+        CHECK_EQ(view.record->size, levels[k].record.size);
+        CHECK_EQ(view.record->targetScore, levels[k].record.targetScore);
+        CHECK(vector<uint8_t>(view.cells, view.cells + levels[k].cells.size()) == levels[k].cells);
+        vector<uint8_t> script, expectedScript;
+        vector<vector<uint8_t> > queues, expectedQueues;
+        readLevelSpawn(view, script, queues);
+        readLevelSpawn(viewOf(levels[k]), expectedScript, expectedQueues);
+        CHECK(script == expectedScript);
+        CHECK(queues == expectedQueues);
+    }
+    LevelView view;
+    CHECK(!pack.level(levels.size(), view));
+    pack.close();
+    remove(KPackFile);
+}
+
+TEST(level, shippedLevelsParse) {
+    ifstream in(string(CANDY_SOURCE_DIR) + "/levels/niveaux.txt");
+    CHECK(bool(in));
+    vector<LevelData> levels;
+    string error;
+    CHECK(parseLevels(in, levels, error));
+    CHECK_EQ(error, string());
+    CHECK(!levels.empty());
+}
@@ -0,0 +1,86 @@
+/**
+ * @file test_persist.cpp
+ * @brief Fichiers de scores (persist.h) : chaque ligne confiée au fil d'écriture est écrite une et une seule fois
+ */
+#include "harness.h"
+#include "../engine/persist.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const char * const KScoreFiles[] = {"candy_tests_scores_a.txt", "candy_tests_scores_b.txt"};
+const unsigned KTestThreads (4);
+const unsigned KTestLines (300);   // lignes par fil
+
+/**
+ * @brief Lignes d'un fichier de scores, triées
+ */
+vector<string> sortedLines (const string & fileName) {
+    vector<string> lines;
+    ifstream file(fileName);
+    string text;
+    while (getline(file, text)) lines.push_back(text);
+    sort(lines.begin(), lines.end());
+    return lines;
+}
+
+} // namespace
+
+TEST(persist, everyLineWrittenOnce) {
+    for (const char * fileName : KScoreFiles) remove(fileName);
+    vector<string> expected[2];
+    for (unsigned t = 0; t < KTestThreads; ++t) {
+        for (unsigned k = 0; k < KTestLines; ++k)
+            expected[k % 2].push_back(to_string(t * 100000 + k) + " fil" + to_string(t) + "_" + to_string(k));
+    }
+    {
+        // Petite file : les fils attendent souvent qu'une place se libère
+        ScoreWriter writer (8);
+        vector<thread> producers;
+        for (unsigned t = 0; t < KTestThreads; ++t) {
+            producers.emplace_back([&writer, t] () {
+                // La moitié des fils passe par persistScore et un ScoreWriterScope, l'autre par append
+                ScoreWriterScope scope(t % 2 ? &writer : nullptr);
+                for (unsigned k = 0; k < KTestLines; ++k) {
+                    const string pseudo = "fil" + to_string(t) + "_" + to_string(k);
+                    if (t % 2) persistScore(KScoreFiles[k % 2], pseudo, t * 100000 + k);
+                    else writer.append(KScoreFiles[k % 2], pseudo, t * 100000 + k);
+                }
+            });
+        }
+        for (thread & producer : producers) producer.join();
+        CHECK(writer.flush());
+        CHECK_EQ(writer.written(), uint64_t(KTestThreads * KTestLines));
+        CHECK(writer.commits() >= 1);
+        CHECK(writer.commits() <= writer.written());
+
+        // Lignes confiées après le flush : écrites par le destructeur
+        writer.append(KScoreFiles[0], "dernier", 7);
+        writer.append(KScoreFiles[1], "dernier", 8);
+        expected[0].push_back("7 dernier");
+        expected[1].push_back("8 dernier");
+    }
+    for (unsigned f = 0; f < 2; ++f) {
+        sort(expected[f].begin(), expected[f].end());
+        const vector<string> lines = sortedLines(KScoreFiles[f]);
+        CHECK_EQ(lines.size(), expected[f].size());
+        CHECK(lines == expected[f]);
+        remove(KScoreFiles[f]);
+    }
+}
+
+TEST(persist, directWriteWithoutScope) {
+    remove(KScoreFiles[0]);
+    CHECK(persistScore(KScoreFiles[0], "seul", 42));
+    CHECK(persistScore(KScoreFiles[0], "seul", 43));
+    const vector<string> lines = sortedLines(KScoreFiles[0]);
+    CHECK(lines == vector<string>({"42 seul", "43 seul"}));
+    CHECK(!persistScore("candy_tests_absent/scores.txt", "seul", 1));
+    remove(KScoreFiles[0]);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file test_players.cpp
+ * @brief Registre des joueurs (players.h) : numéros dans l'ordre d'arrivée, stables après agrandissement et relecture
+ */
+#include "harness.h"
+#include "../engine/players.h"
+#include "../engine/stats.h"
+
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const char * KStatsBase = "candy_tests_players";
+const char * const KStatsFiles[] = {".joueur.col", ".mode.col", ".score.col", ".coups.col", ".combo.col",
+                                    ".date.col", ".pseudos"};
+
+void removeStore () {
+    for (const char * suffix : KStatsFiles) remove((string(KStatsBase) + suffix).c_str());
+}
+
+} // namespace
+
+TEST(players, internKeepsArrivalOrder) {
+    PlayerRegistry registry;
+    CHECK_EQ(registry.size(), size_t(0));
+    CHECK_EQ(registry.find("alice"), KNoPlayer);
+    // Préfixes communs et pseudo vide : des pseudos différents
+    const vector<string> pseudos = {"alice", "bob", "", "al", "alice2", "Alice"};
+    for (uint32_t id = 0; id < pseudos.size(); ++id) CHECK_EQ(registry.intern(pseudos[id]), id);
+    for (uint32_t id = 0; id < pseudos.size(); ++id) {
+        CHECK_EQ(registry.intern(pseudos[id]), id);
+        CHECK_EQ(registry.find(pseudos[id]), id);
+        CHECK_EQ(registry.pseudo(id), pseudos[id]);
+    }
+    CHECK_EQ(registry.size(), pseudos.size());
+    string text = "> ";
+    registry.appendPseudo(1, text);
+    CHECK_EQ(text, string("> bob"));
+
+    // Des milliers de pseudos : l'index est agrandi plusieurs fois, les numéros ne bougent pas
+    for (uint32_t k = 0; k < 50000; ++k)
+        CHECK_EQ(registry.intern("joueur" + to_string(k)), uint32_t(pseudos.size() + k));
+    unsigned wrong = 0;
+    for (uint32_t k = 0; k < 50000; ++k) {
+        const string pseudo = "joueur" + to_string(k);
+        wrong += registry.find(pseudo) != pseudos.size() + k || registry.pseudo(pseudos.size() + k) != pseudo;
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK_EQ(registry.find("alice"), 0u);
+    CHECK_EQ(registry.find("joueur50000"), KNoPlayer);
+
+    registry.clear();
+    CHECK_EQ(registry.size(), size_t(0));
+    CHECK_EQ(registry.find("alice"), KNoPlayer);
+    CHECK_EQ(registry.intern("bob"), 0u);
+}
+
+TEST(players, idsSurviveReload) {
+    removeStore();
+    vector<uint32_t> ids;
+    {
+        StatsWriter writer (KStatsBase);
+        for (const char * pseudo : {"alice", "bob", "carole", "bob", "alice"}) ids.push_back(writer.player(pseudo));
+    }
+    CHECK(ids == vector<uint32_t>({0, 1, 2, 1, 0}));
+
+    // Un nouvel écrivain relit les pseudos : mêmes numéros, les nouveaux prennent la suite
+    {
+        StatsWriter writer (KStatsBase);
+        CHECK_EQ(writer.player("carole"), 2u);
+        CHECK_EQ(writer.player("david"), 3u);
+        CHECK_EQ(writer.player("alice"), 0u);
+    }
+    StatsStore store;
+    CHECK(store.open(KStatsBase));
+    const PlayerRegistry & players = store.players();
+    CHECK_EQ(players.size(), size_t(4));
+    const char * const expected[] = {"alice", "bob", "carole", "david"};
+    for (uint32_t id = 0; id < 4; ++id) {
+        CHECK_EQ(players.pseudo(id), string(expected[id]));
+        CHECK_EQ(players.find(expected[id]), id);
+    }
+    store.close();
+    removeStore();
+}
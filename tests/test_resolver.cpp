@@ -0,0 +1,188 @@
+/**
+ * @file test_resolver.cpp
+ * @brief Réactions en chaîne : série (resolveCascade), répartie entre les fils (BandResolver), en tuiles (TiledBoard)
+ *
+ * BandResolver et TiledBoard suppriment tous les matchs d'un pas à la fois
+ * et tirent chaque colonne dans le générateur forkSeed(graine, colonne) :
+ * pour une même grille et une même graine, ils donnent la même grille, quel
+ * que soit le nombre de fils. La réaction en série supprime un match par pas
+ * et ne tire pas les mêmes bonbons : seul son résultat final est comparable
+ * (plus aucun match, couleurs valides). L'évaluateur des coups (MoveEvaluator)
+ * tire chaque coup dans son propre générateur : ses meilleurs coups non plus
+ * ne dépendent pas du nombre de fils.
+ */
+#include "harness.h"
+#include "../engine/evaluator.h"
+#include "../engine/grid.h"
+#include "../engine/resolver.h"
+#include "../engine/spawn.h"
+#include "../engine/tiled.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (42);
+const char * KTiledFile = "candy_tests_resolver.til";
+
+/**
+ * @brief Grille sans match puis count alignements verticaux de 3 posés au hasard (graine seed)
+ */
+mat forcedGrid (unsigned size, unsigned nbCandies, unsigned count, uint64_t seed) {
+    uint64_t state = seed;
+    RandomScope randomScope(&state);
+    mat grid;
+    initGrid(grid, size, nbCandies);
+    for (unsigned k = 0; k < count; ++k) {
+        const unsigned col = spawnRandom() % size;
+        const unsigned row = spawnRandom() % (size - 2);
+        grid[row][col] = grid[row + 1][col] = grid[row + 2][col] = 1 + spawnRandom() % nbCandies;
+    }
+    return grid;
+}
+
+bool sameMoves (const vector<MoveScore> & a, const vector<MoveScore> & b) {
+    if (a.size() != b.size()) return false;
+    for (size_t k = 0; k < a.size(); ++k) {
+        if (a[k].pos.ord != b[k].pos.ord || a[k].pos.abs != b[k].pos.abs || a[k].direction != b[k].direction
+            || a[k].score != b[k].score || a[k].combo != b[k].combo)
+            return false;
+    }
+    return true;
+}
+
+bool coloursInRange (const mat & grid, unsigned nbCandies) {
+    for (const line & row : grid)
+        for (unsigned cell : row)
+            if (cell < 1 || cell > nbCandies) return false;
+    return true;
+}
+
+} // namespace
+
+TEST(resolver, stableGridIsUntouched) {
+    uint64_t state = KTestSeed;
+    mat grid;
+    {
+        RandomScope randomScope(&state);
+        initGrid(grid, 64, 5);
+    }
+    const mat before = grid;
+    BandResolver resolver(2);
+    const ResolveReport report = resolver.resolve(grid, RuleFibonacci, 5, KTestSeed);
+    CHECK_EQ(report.steps, 0u);
+    CHECK_EQ(report.cleared, 0u);
+    CHECK(grid == before);
+    CHECK_EQ(resolveCascade(grid, 5), 0u);
+    CHECK(grid == before);
+}
+
+TEST(resolver, sameResultForAnyThreadCount) {
+    for (unsigned size : {16u, 100u, 300u}) {
+        const mat start = forcedGrid(size, 4, size / 2, KTestSeed + size);
+        mat reference = start;
+        BandResolver single(1);
+        const ResolveReport expected = single.resolve(reference, RuleFibonacci, 4, KTestSeed);
+        CHECK(expected.steps > 0);
+        CHECK(!checkInitialMatch(reference));
+        CHECK(coloursInRange(reference, 4));
+        for (unsigned threads : {2u, 3u, 8u}) {
+            mat grid = start;
+            BandResolver resolver(threads);
+            const ResolveReport report = resolver.resolve(grid, RuleFibonacci, 4, KTestSeed);
+            CHECK_EQ(report.steps, expected.steps);
+            CHECK_EQ(report.cleared, expected.cleared);
+            CHECK_EQ(report.score, expected.score);
+            CHECK(grid == reference);
+        }
+    }
+}
+
+TEST(resolver, sameBestMovesForAnyThreadCount) {
+    // Partie libre un match par pas, partie libre des grandes grilles, modes du menu (sur leur grille)
+    const EvalConfig configs[] = {{RuleFibonacci, false, false, 4, 5, 0, KTestSeed, nullptr},
+                                  {RuleFibonacci, false, true, 4, 5, 0, KTestSeed, nullptr},
+                                  {RuleFibonacci, true, false, 4, 5, 0, KTestSeed, nullptr}};
+    for (const EvalConfig & topConfig : configs) {
+        mat start;
+        {
+            uint64_t state = KTestSeed;
+            RandomScope randomScope(&state);
+            initGrid(start, topConfig.specials ? KGridSize : 24, 4);
+        }
+        for (unsigned topK : {topConfig.topK, 10000u}) {
+            EvalConfig config = topConfig;
+            config.topK = topK;
+            vector<MoveScore> expected;
+            MoveEvaluator single(1);
+            const EvalReport reference = single.evaluate(start, config, expected);
+            CHECK(reference.complete);
+            CHECK(reference.candidates > topConfig.topK);
+            CHECK_EQ(expected.size(), min<size_t>(topK, reference.candidates));
+            for (size_t k = 1; k < expected.size(); ++k) CHECK(expected[k - 1].score >= expected[k].score);
+            for (unsigned threads : {2u, 3u, 8u}) {
+                vector<MoveScore> best;
+                MoveEvaluator evaluator(threads);
+                const EvalReport report = evaluator.evaluate(start, config, best);
+                CHECK(report.complete);
+                CHECK_EQ(report.candidates, reference.candidates);
+                CHECK_EQ(report.evaluated, reference.evaluated);
+                CHECK(sameMoves(best, expected));
+            }
+        }
+    }
+}
+
+TEST(resolver, tiledMatchesBand) {
+    // Deux bandes de tuiles, la seconde incomplète : les alignements traversent la frontière
+    const unsigned size = KTileSide + 44;
+    const unsigned nbCandies = 4;
+    const mat start = forcedGrid(size, nbCandies, 400, KTestSeed);
+
+    TiledBoard board;
+    CHECK(board.create(KTiledFile, size, nbCandies));
+    if (board.size() != size) return;
+    for (unsigned i = 0; i < size; ++i)
+        for (unsigned j = 0; j < size; ++j) board.set(i, j, start[i][j]);
+
+    mat grid = start;
+    BandResolver resolver(2);
+    const ResolveReport expected = resolver.resolve(grid, RuleFibonacci, nbCandies, KTestSeed);
+    const TiledReport report = board.resolve(KTestSeed);
+    CHECK_EQ(report.steps, expected.steps);
+    CHECK_EQ(report.cleared, expected.cleared);
+    unsigned differences = 0;
+    for (unsigned i = 0; i < size; ++i)
+        for (unsigned j = 0; j < size; ++j) differences += board.get(i, j) != grid[i][j];
+    CHECK_EQ(differences, 0u);
+    board.close();
+    remove(KTiledFile);
+}
+
+TEST(resolver, serialAndBatchBothSettle) {
+    for (unsigned nbCandies : {4u, 5u, 6u}) {
+        const mat start = forcedGrid(48, nbCandies, 40, KTestSeed * nbCandies);
+        mat serial = start;
+        uint64_t state = KTestSeed;
+        unsigned steps;
+        {
+            RandomScope randomScope(&state);
+            steps = resolveCascade(serial, nbCandies);
+        }
+        mat batch = start;
+        BandResolver resolver(2);
+        const ResolveReport report = resolver.resolve(batch, RuleFibonacci, nbCandies, KTestSeed);
+
+        // Les tirages diffèrent : le nombre de pas n'est pas comparable, seul l'état final l'est
+        CHECK(steps > 0);
+        CHECK(report.steps > 0);
+        CHECK(report.cleared >= 3 * report.steps);
+        CHECK(!checkInitialMatch(serial));
+        CHECK(!checkInitialMatch(batch));
+        CHECK(coloursInRange(serial, nbCandies));
+        CHECK(coloursInRange(batch, nbCandies));
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_shuffle.cpp
+ * @brief Mélange des grilles bloquées (shuffle.h) : mêmes bonbons, cases fixes en place, aucun match, un coup
+ */
+#include "harness.h"
+#include "../engine/grid.h"
+#include "../engine/shuffle.h"
+#include "../engine/spawn.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (7);
+
+/**
+ * @brief Bonbons de la grille (hors cases fixes), triés
+ */
+vector<unsigned> candies (const mat & grid) {
+    vector<unsigned> cells;
+    for (const line & row : grid)
+        for (unsigned cell : row)
+            if (!isFixedCell(cell)) cells.push_back(cell);
+    sort(cells.begin(), cells.end());
+    return cells;
+}
+
+bool sameFixedCells (const mat & a, const mat & b) {
+    for (unsigned i = 0; i < a.size(); ++i)
+        for (unsigned j = 0; j < a.size(); ++j)
+            if ((isFixedCell(a[i][j]) || isFixedCell(b[i][j])) && a[i][j] != b[i][j]) return false;
+    return true;
+}
+
+/**
+ * @brief Grille au hasard, avec des matchs, quelques spéciaux et (si fixed) des bloqueurs et des trous
+ */
+mat randomGrid (unsigned size, unsigned nbCandies, bool fixed, uint64_t & state) {
+    RandomScope randomScope(&state);
+    mat grid (size, line(size));
+    for (line & row : grid) {
+        for (unsigned & cell : row) {
+            const unsigned draw = spawnRandom();
+            cell = 1 + draw % nbCandies;
+            if (draw % 29 == 0) cell = makeSpecial(cell, SpecialKind(1 + (draw >> 8) % 4));
+            if (fixed && draw % 17 == 0) cell = (draw >> 12) % 2 ? KBlocker : KHole;
+        }
+    }
+    return grid;
+}
+
+} // namespace
+
+TEST(shuffle, invariants) {
+    uint64_t state = KTestSeed;
+    unsigned shuffled = 0;
+    for (unsigned size : {4u, 5u, 8u, 13u, 32u}) {
+        for (unsigned nbCandies : {3u, 4u, 5u, 7u}) {
+            for (bool fixed : {false, true}) {
+                for (unsigned round = 0; round < 8; ++round) {
+                    mat grid = randomGrid(size, nbCandies, fixed, state);
+                    const mat before = grid;
+                    if (!reshuffleGrid(grid)) {
+                        CHECK(grid == before);
+                        continue;
+                    }
+                    shuffled++;
+                    CHECK(candies(grid) == candies(before));
+                    CHECK(sameFixedCells(grid, before));
+                    CHECK(!checkInitialMatch(grid));
+                    CHECK(hasLegalMove(grid));
+                }
+            }
+        }
+    }
+    // Les grilles sans case fixe de 3 couleurs ou plus se mélangent toujours
+    CHECK(shuffled >= 5 * 4 * 8);
+}
+
+TEST(shuffle, refusesImpossibleGrids) {
+    // Une seule couleur : tout placement aligne trois bonbons
+    mat grid (6, line(6, 2));
+    mat before = grid;
+    CHECK(!reshuffleGrid(grid));
+    CHECK(grid == before);
+
+    // Grille trop petite pour qu'un échange aligne trois bonbons
+    grid = {{1, 2}, {3, 1}};
+    before = grid;
+    CHECK(!reshuffleGrid(grid));
+    CHECK(grid == before);
+}
+
+TEST(shuffle, hasLegalMoveLeavesGridUnchanged) {
+    uint64_t state = KTestSeed;
+    mat grid;
+    {
+        RandomScope randomScope(&state);
+        initGrid(grid, 8, 4);
+    }
+    const mat before = grid;
+    hasLegalMove(grid);
+    CHECK(grid == before);
+
+    // Diagonales de trois couleurs : aucun échange n'aligne trois bonbons
+    mat blocked (4, line(4));
+    for (unsigned i = 0; i < 4; ++i)
+        for (unsigned j = 0; j < 4; ++j) blocked[i][j] = 1 + (i + j) % 3;
+    CHECK(!checkInitialMatch(blocked));
+    CHECK(!hasLegalMove(blocked));
+}
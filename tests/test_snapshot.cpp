@@ -0,0 +1,186 @@
+/**
+ * @file test_snapshot.cpp
+ * @brief Sauvegarde (snapshot.h) : instantanés encodés puis relus, journal des points de reprise
+ */
+#include "harness.h"
+#include "../engine/snapshot.h"
+#include "../engine/spawn.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char * KSaveFile = "candy_tests_partie.sav";
+
+bool sameSnapshot (const GameSnapshot & a, const GameSnapshot & b) {
+    return a.mode == b.mode && a.level == b.level && a.seed == b.seed && a.moves == b.moves && a.score == b.score
+        && a.nbCandies == b.nbCandies && a.grid == b.grid && a.jelly == b.jelly
+        && a.scriptPosition == b.scriptPosition && a.queuePositions == b.queuePositions;
+}
+
+GameSnapshot sampleSnapshot (unsigned size, uint32_t moves) {
+    GameSnapshot snapshot;
+    snapshot.mode = ModeTarget;
+    snapshot.level = KNoLevel;
+    snapshot.seed = 12345;
+    snapshot.moves = moves;
+    snapshot.score = 1000 + 37 * moves;
+    snapshot.nbCandies = 5;
+    snapshot.scriptPosition = 0;
+    uint64_t state = moves + 1;
+    RandomScope randomScope(&state);
+    initGrid(snapshot.grid, size, snapshot.nbCandies);
+    return snapshot;
+}
+
+/**
+ * @brief Instantané relu depuis le journal (moves, ou 0 si rien n'est relu)
+ */
+uint32_t loadedMoves (SaveJournal & journal) {
+    vector<uint8_t> bytes;
+    GameSnapshot snapshot;
+    if (!journal.load(bytes) || !unpackSnapshot(bytes.data(), bytes.size(), snapshot)) return 0;
+    return snapshot.moves;
+}
+
+void removeSave () {
+    remove(KSaveFile);
+    remove((string(KSaveFile) + ".journal").c_str());
+}
+
+} // namespace
+
+TEST(snapshot, plainRoundTrip) {
+    for (unsigned size : {3u, 8u, 9u, 64u}) {
+        const GameSnapshot snapshot = sampleSnapshot(size, size);
+        vector<uint8_t> bytes;
+        packSnapshot(snapshot, bytes);
+        GameSnapshot read;
+        CHECK(unpackSnapshot(bytes.data(), bytes.size(), read));
+        CHECK(sameSnapshot(read, snapshot));
+    }
+}
+
+TEST(snapshot, levelRoundTrip) {
+    GameSnapshot snapshot = sampleSnapshot(9, 4);
+    snapshot.mode = ModeClassic;
+    snapshot.level = 3;
+    snapshot.grid[0][0] = KHole;
+    snapshot.grid[4][4] = KBlocker;
+    snapshot.grid[2][7] = makeSpecial(3, SpecialStripedRow);
+    snapshot.grid[8][1] = makeSpecial(1, SpecialWrapped);
+    snapshot.grid[5][5] = makeSpecial(2, SpecialColourBomb);
+    snapshot.jelly.assign(9, line(9, 0));
+    snapshot.jelly[1][1] = 2;
+    snapshot.jelly[8][8] = 9;
+    snapshot.scriptPosition = 17;
+    snapshot.queuePositions = {0, 3, 0, 0, 1, 0, 0, 0, 2};
+
+    vector<uint8_t> bytes;
+    packSnapshot(snapshot, bytes);
+    GameSnapshot read;
+    CHECK(unpackSnapshot(bytes.data(), bytes.size(), read));
+    CHECK(sameSnapshot(read, snapshot));
+
+    // Octets coupés ou abîmés : refusés
+    CHECK(!unpackSnapshot(bytes.data(), bytes.size() - 1, read));
+    CHECK(!unpackSnapshot(bytes.data(), 0, read));
+}
+
+TEST(snapshot, journalKeepsLatest) {
+    removeSave();
+    {
+        SaveJournal journal(KSaveFile);
+        vector<uint8_t> bytes;
+        CHECK(!journal.load(bytes));
+        for (uint32_t moves = 1; moves <= 5; ++moves) {
+            packSnapshot(sampleSnapshot(8, moves), bytes);
+            CHECK(journal.checkpoint(bytes));
+        }
+    }
+    SaveJournal reader(KSaveFile);
+    CHECK_EQ(loadedMoves(reader), 5u);
+
+    // Sauvegarde remplacée puis nouveaux points de reprise : le plus récent gagne
+    vector<uint8_t> bytes;
+    packSnapshot(sampleSnapshot(8, 6), bytes);
+    CHECK(reader.commit(bytes));
+    CHECK_EQ(loadedMoves(reader), 6u);
+    packSnapshot(sampleSnapshot(8, 7), bytes);
+    CHECK(reader.checkpoint(bytes));
+    SaveJournal again(KSaveFile);
+    CHECK_EQ(loadedMoves(again), 7u);
+
+    again.discard();
+    CHECK_EQ(loadedMoves(again), 0u);
+    removeSave();
+}
+
+TEST(snapshot, resumedGameKeepsSequence) {
+    removeSave();
+    {
+        SaveJournal journal(KSaveFile);
+        vector<uint8_t> bytes;
+        packSnapshot(sampleSnapshot(8, 1), bytes);
+        CHECK(journal.commit(bytes));
+        for (uint32_t moves = 2; moves <= 4; ++moves) {
+            packSnapshot(sampleSnapshot(8, moves), bytes);
+            CHECK(journal.checkpoint(bytes));
+        }
+    }
+    // Partie reprise : le jeu a relu la sauvegarde avec un autre journal, celui-ci n'a rien relu
+    {
+        SaveJournal journal(KSaveFile);
+        vector<uint8_t> bytes;
+        packSnapshot(sampleSnapshot(8, 5), bytes);
+        CHECK(journal.checkpoint(bytes));
+    }
+    SaveJournal reader(KSaveFile);
+    CHECK_EQ(loadedMoves(reader), 5u);
+
+    // Même chose quand le premier enregistrement de la partie reprise remplace la sauvegarde
+    {
+        SaveJournal journal(KSaveFile);
+        vector<uint8_t> bytes;
+        packSnapshot(sampleSnapshot(8, 6), bytes);
+        CHECK(journal.commit(bytes));
+        packSnapshot(sampleSnapshot(8, 7), bytes);
+        CHECK(journal.checkpoint(bytes));
+    }
+    SaveJournal again(KSaveFile);
+    CHECK_EQ(loadedMoves(again), 7u);
+    removeSave();
+}
+
+TEST(snapshot, tornTailIsIgnored) {
+    removeSave();
+    {
+        SaveJournal journal(KSaveFile);
+        vector<uint8_t> bytes;
+        for (uint32_t moves = 1; moves <= 3; ++moves) {
+            packSnapshot(sampleSnapshot(8, moves), bytes);
+            CHECK(journal.checkpoint(bytes));
+        }
+    }
+    // Arrêt brutal au milieu du dernier enregistrement
+    const string journalFile = string(KSaveFile) + ".journal";
+    ifstream in(journalFile, ios::binary | ios::ate);
+    const long bytes = in.tellg();
+    in.close();
+    CHECK(truncate(journalFile.c_str(), bytes - 5) == 0);
+
+    SaveJournal journal(KSaveFile);
+    CHECK_EQ(loadedMoves(journal), 2u);
+    // La fin coupée est retirée : un nouveau point de reprise reste lisible
+    vector<uint8_t> snapshot;
+    packSnapshot(sampleSnapshot(8, 4), snapshot);
+    CHECK(journal.checkpoint(snapshot));
+    SaveJournal again(KSaveFile);
+    CHECK_EQ(loadedMoves(again), 4u);
+    removeSave();
+}
@@ -0,0 +1,156 @@
+/**
+ * @file test_solver.cpp
+ * @brief Solveur du mode Cible (solver.h) : le par prouvé est celui d'une recherche exhaustive
+ *
+ * Sur de toutes petites grilles, toutes les suites d'échanges sont essayées
+ * longueur par longueur, sans table ni élagage, avec les règles du mode
+ * Cible : tout échange de deux bonbons différents coûte un coup, avec ou
+ * sans match, et une grille sans coup légal est mélangée avant le coup
+ * suivant. Un par prouvé doit être le plus court trouvé ainsi ; un par non
+ * prouvé ne peut pas être plus court. Suite « par » : « solver/ » désignerait
+ * aussi les tests de resolver.
+ */
+#include "harness.h"
+#include "../engine/game.h"
+#include "../engine/score.h"
+#include "../engine/shuffle.h"
+#include "../engine/solver.h"
+#include "../engine/spawn.h"
+#include "../engine/special.h"
+#include "../engine/zobrist.h"
+
+using namespace std;
+
+namespace {
+
+// Longueur au-delà de laquelle la recherche exhaustive abandonne (24^4 suites sur une grille de 4)
+const unsigned KBruteMaxMoves (4);
+
+/**
+ * @brief Joue un échange et sa réaction en chaîne, comme le mode Cible
+ * @return Points du coup
+ */
+uint64_t playSwap (mat & grid, const maPosition & pos, char direction, unsigned nbCandies) {
+    const ScoreRule rule = scoreRuleFor(ModeTarget);
+    makeAMove(grid, pos, direction);
+    unsigned comboLevel = 0;
+    uint64_t score = 0;
+    const unsigned bombed = activateSwap(grid, pos, direction, nbCandies);
+    if (bombed > 0) score = scoreAdd(score, matchScore(rule, bombed, ++comboLevel));
+    maPosition match;
+    unsigned howMany;
+    while (true) {
+        if (atLeastThreeInAColumn(grid, match, howMany))
+            howMany = clearMatch(grid, match, howMany, MatchVertical, nbCandies);
+        else if (atLeastThreeInARow(grid, match, howMany))
+            howMany = clearMatch(grid, match, howMany, MatchHorizontal, nbCandies);
+        else
+            break;
+        score = scoreAdd(score, matchScore(rule, howMany, ++comboLevel));
+    }
+    return score;
+}
+
+/**
+ * @brief Vrai si une suite d'au plus movesLeft échanges mène de cet état à la cible
+ * @param quiet Faux : seulement les échanges légaux (ce que le solveur essayait avant)
+ */
+bool reachable (const mat & grid, uint64_t spawn, uint64_t score, uint64_t target, unsigned nbCandies,
+                unsigned movesLeft, bool quiet) {
+    if (movesLeft == 0) return false;
+    const unsigned size = grid.size();
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size; ++j) {
+            for (char direction : {'D', 'S'}) {
+                const unsigned i2 = i + (direction == 'S'), j2 = j + (direction == 'D');
+                if (i2 >= size || j2 >= size || grid[i][j] == grid[i2][j2]) continue;
+                if (isFixedCell(grid[i][j]) || isFixedCell(grid[i2][j2])) continue;
+                mat child = grid;
+                const maPosition pos = {j, i};
+                if (!quiet && !isLegalMove(child, pos, direction)) continue;
+                uint64_t state = spawn;
+                RandomScope randomScope(&state);
+                const uint64_t reached = scoreAdd(score, playSwap(child, pos, direction, nbCandies));
+                if (reached >= target) return true;
+                if (!hasLegalMove(child) && !reshuffleGrid(child)) continue;
+                if (reachable(child, state, reached, target, nbCandies, movesLeft - 1, quiet)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Plus court par par recherche exhaustive (0 : pas de solution en KBruteMaxMoves coups)
+ */
+unsigned brutePar (const SolveConfig & config, bool quiet) {
+    HashScope hashScope(nullptr);
+    mat grid;
+    uint64_t spawn;
+    seedGame(config.seed, config.gridSize, config.nbCandies, grid, spawn);
+    for (unsigned moves = 1; moves <= KBruteMaxMoves; ++moves) {
+        if (reachable(grid, spawn, 0, config.targetScore, config.nbCandies, moves, quiet)) return moves;
+    }
+    return 0;
+}
+
+SolveConfig tinyGame (uint64_t seed, unsigned size, uint64_t target) {
+    SolveConfig config;
+    config.seed = seed;
+    config.gridSize = size;
+    config.nbCandies = 4;
+    config.targetScore = target;
+    config.beamWidth = 8;
+    config.maxMoves = 12;
+    config.threads = 2;
+    config.proofBudget = 2000000;
+    config.tableBytes = size_t(1) << 20;
+    return config;
+}
+
+} // namespace
+
+TEST(par, provenParMatchesBruteForce) {
+    unsigned proven = 0;
+    for (uint64_t seed = 1; seed <= 12; ++seed) {
+        const SolveConfig config = tinyGame(seed, 5, 600);
+        const SolveResult result = solveTarget(config);
+        const unsigned par = brutePar(config, true);
+        CHECK(par > 0);
+        CHECK(result.found);
+        if (!result.found || par == 0) continue;
+        CHECK_EQ(result.moves.size(), size_t(result.par));
+        CHECK(replaySolution(config, result.moves) >= config.targetScore);
+        CHECK(result.par >= par);
+        if (result.proven) {
+            CHECK_EQ(result.par, par);
+            proven++;
+        }
+    }
+    // Pars de 2 à 4 coups : la preuve tient dans le budget
+    CHECK_EQ(proven, 12u);
+}
+
+TEST(par, quietSwapShortensThePar) {
+    // Graines où un échange sans match prépare la réaction : les échanges légaux seuls demandent un coup de plus
+    for (uint64_t seed : {5u, 7u, 11u}) {
+        const SolveConfig config = tinyGame(seed, 5, 600);
+        const SolveResult result = solveTarget(config);
+        CHECK(result.found && result.proven);
+        CHECK_EQ(result.par, brutePar(config, true));
+        CHECK(result.par < brutePar(config, false));
+        CHECK(replaySolution(config, result.moves) >= config.targetScore);
+    }
+}
+
+TEST(par, stuckBeamStillFindsThePar) {
+    // Grilles de 4 : toutes les suites d'échanges légaux finissent bloquées, seule la preuve trouve la cible
+    for (uint64_t seed : {5u, 6u, 10u}) {
+        const SolveConfig config = tinyGame(seed, 4, 600);
+        const SolveResult result = solveTarget(config);
+        CHECK_EQ(brutePar(config, false), 0u);
+        CHECK(result.found && result.proven);
+        CHECK_EQ(result.par, brutePar(config, true));
+        CHECK(replaySolution(config, result.moves) >= config.targetScore);
+    }
+}
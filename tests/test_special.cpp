@@ -0,0 +1,112 @@
+/**
+ * @file test_special.cpp
+ * @brief Bonbons spéciaux (special.h) : pires chaînes sur des grilles construites à la main
+ *
+ * Le nombre de cases vidées ne dépend pas des bonbons tirés au remplissage :
+ * chaque test le connaît d'avance, ainsi que les points du coup (premier pas,
+ * règle Fibonacci, comme dans les boucles de jeu). Chaque grille est essayée
+ * sur une taille qui tient dans un mot du masque et sur une taille qui en
+ * demande deux, les effets traversant la frontière entre les mots.
+ */
+#include "harness.h"
+#include "../engine/score.h"
+#include "../engine/spawn.h"
+#include "../engine/special.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (32);
+const unsigned KTestCandies (4);
+
+/**
+ * @brief Grille sans match ni spécial : 1 + (ligne + 2 x colonne) % 4
+ */
+mat plainGrid (unsigned size) {
+    mat grid (size, line(size));
+    for (unsigned i = 0; i < size; ++i)
+        for (unsigned j = 0; j < size; ++j) grid[i][j] = 1 + (i + 2 * j) % KTestCandies;
+    return grid;
+}
+
+/**
+ * @brief Après une chaîne : tout est rempli, les trous restent, les bloqueurs touchés ont disparu
+ */
+bool settledAfterBlast (const mat & grid, const mat & before) {
+    for (unsigned i = 0; i < grid.size(); ++i) {
+        for (unsigned j = 0; j < grid.size(); ++j) {
+            if (before[i][j] == KHole) {
+                if (grid[i][j] != KHole) return false;
+                continue;
+            }
+            if (grid[i][j] == KImpossible || grid[i][j] == KHole || grid[i][j] == KBlocker) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(special, bombPlusBombClearsTheBoard) {
+    for (unsigned size : {8u, 70u}) {
+        mat grid = plainGrid(size);
+        grid[3][3] = KHole;
+        grid[5][6] = KHole;
+        grid[6][1] = KBlocker;
+        grid[2][5] = makeSpecial(2, SpecialStripedRow);
+        grid[size - 1][size - 2] = makeSpecial(3, SpecialWrapped);
+        grid[4][4] = makeSpecial(KImpossible, SpecialColourBomb);
+        grid[4][5] = makeSpecial(KImpossible, SpecialColourBomb);
+        const mat before = grid;
+
+        uint64_t state = KTestSeed;
+        RandomScope randomScope(&state);
+        BoardMask cleared;
+        const unsigned count = activateSwap(grid, maPosition {4, 4}, 'D', KTestCandies, &cleared);
+        // Toute la grille sauf les deux trous ; le bloqueur est détruit, les spéciaux ne comptent qu'une fois
+        CHECK_EQ(count, size * size - 2);
+        CHECK_EQ(maskCount(cleared), size * size);
+        CHECK(settledAfterBlast(grid, before));
+        if (size == 8) CHECK_EQ(matchScore(RuleFibonacci, count, 1), uint64_t(405273953788100ULL));
+        else CHECK_EQ(matchScore(RuleFibonacci, count, 1), KScoreMax);
+    }
+}
+
+TEST(special, stripedWrappedStripedChain) {
+    for (unsigned size : {9u, 70u}) {
+        // Match vertical de trois bonbons de couleur 5 en colonne 0, celui du milieu rayé (ligne 1).
+        // La ligne 1 touche un emballé en colonne w, dont le carré touche un rayé vertical en colonne w - 1.
+        const unsigned w = size == 9 ? 4 : 64;
+        mat grid = plainGrid(size);
+        grid[0][0] = 5;
+        grid[1][0] = makeSpecial(5, SpecialStripedRow);
+        grid[2][0] = 5;
+        grid[1][w] = makeSpecial(1, SpecialWrapped);
+        grid[0][w - 1] = makeSpecial(2, SpecialStripedColumn);
+
+        BoardMask expected;
+        maskReset(expected, size);
+        for (unsigned i = 0; i < 3; ++i) maskSet(expected, i, 0);
+        for (unsigned j = 0; j < size; ++j) maskSet(expected, 1, j);
+        for (unsigned i = 0; i < 3; ++i)
+            for (unsigned j = w - 1; j <= w + 1; ++j) maskSet(expected, i, j);
+        for (unsigned i = 0; i < size; ++i) maskSet(expected, i, w - 1);
+
+        uint64_t state = KTestSeed;
+        RandomScope randomScope(&state);
+        BoardMask cleared;
+        const unsigned count = clearMatch(grid, maPosition {0, 0}, 3, MatchVertical, 5, &cleared);
+        // Ligne 1, colonne w - 1, deux cases de plus en colonne 0 et six dans le carré : 2 x taille + 5
+        CHECK_EQ(count, 2 * size + 5);
+        CHECK(cleared.bits == expected.bits);
+        if (size == 9) CHECK_EQ(matchScore(RuleFibonacci, count, 1), uint64_t(2865700));
+        else CHECK_EQ(matchScore(RuleFibonacci, count, 1), KScoreMax);
+
+        // Hors des lignes 0 à 2 et de la colonne w - 1, rien n'a bougé
+        const mat reference = plainGrid(size);
+        for (unsigned i = 3; i < size; ++i)
+            for (unsigned j = 0; j < size; ++j)
+                if (j != w - 1) CHECK_EQ(grid[i][j], reference[i][j]);
+    }
+}
@@ -0,0 +1,244 @@
+/**
+ * @file test_stats.cpp
+ * @brief Statistiques des parties (stats.h) : colonnes écrites, relues et interrogées comme un tableau de parties
+ *
+ * Les parties sont tirées au hasard, gardées dans un tableau et ajoutées
+ * à l'entrepôt ; chaque requête sur les colonnes relues est comparée au
+ * même calcul fait partie par partie sur le tableau. Les colonnes de
+ * longueurs différentes (écriture interrompue) et un ajout qui échoue au
+ * milieu des colonnes ne doivent jamais décaler les parties.
+ */
+#include "harness.h"
+#include "../engine/spawn.h"
+#include "../engine/stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const uint64_t KTestSeed (47);
+const char * KStatsBase = "candy_tests_stats";
+const char * const KStatsFiles[] = {".joueur.col", ".mode.col", ".score.col", ".coups.col", ".combo.col",
+                                    ".date.col", ".pseudos"};
+
+void removeStore () {
+    for (const char * suffix : KStatsFiles) remove((string(KStatsBase) + suffix).c_str());
+}
+
+/**
+ * @brief Parties au hasard : scores jusqu'à 2^40 (l'histogramme des centiles se replie), dates sur un mois
+ */
+vector<GameRecord> drawGames (StatsWriter & writer, size_t count) {
+    vector<GameRecord> games;
+    for (size_t k = 0; k < count; ++k) {
+        GameRecord record;
+        record.player = writer.player("joueur" + to_string(spawnRandom() % 7));
+        record.mode = spawnRandom() % KNbGameModes;
+        record.score = (uint64_t(spawnRandom()) << (spawnRandom() % 9)) % (uint64_t(1) << 40);
+        record.moves = 1 + spawnRandom() % 60;
+        record.comboSteps = record.moves + spawnRandom() % 100;
+        record.time = 1800000000 + spawnRandom() % (31 * 86400);
+        games.push_back(record);
+    }
+    return games;
+}
+
+/**
+ * @brief Toutes les requêtes de l'entrepôt relu, comparées au tableau des parties
+ */
+void checkQueries (const StatsStore & store, const vector<GameRecord> & games) {
+    const StatColumns & columns = store.columns();
+    CHECK_EQ(columns.count, games.size());
+    size_t shifted = 0;
+    for (size_t i = 0; i < min(columns.count, games.size()); ++i) {
+        shifted += columns.players[i] != games[i].player || columns.modes[i] != games[i].mode
+                   || columns.scores[i] != games[i].score || columns.moves[i] != games[i].moves
+                   || columns.comboSteps[i] != games[i].comboSteps || columns.times[i] != games[i].time;
+    }
+    CHECK_EQ(shifted, size_t(0));
+    if (columns.count != games.size() || shifted > 0) return;
+
+    const uint32_t someone = store.players().find("joueur3");
+    CHECK(someone != KNoPlayer);
+    for (uint32_t player : {KNoPlayer, someone}) {
+        uint64_t counts [KNbGameModes];
+        countGamesPerMode(columns, player, counts);
+        for (unsigned mode = 0; mode < KNbGameModes; ++mode) {
+            StatSummary expected;
+            vector<uint64_t> scores;
+            for (const GameRecord & game : games) {
+                if ((player != KNoPlayer && game.player != player) || game.mode != mode) continue;
+                expected.games++;
+                expected.totalScore += game.score;
+                expected.bestScore = max(expected.bestScore, game.score);
+                expected.moves += game.moves;
+                expected.comboSteps += game.comboSteps;
+                scores.push_back(game.score);
+            }
+            const StatSummary summary = summarizeGames(columns, player, GameMode(mode));
+            CHECK_EQ(summary.games, expected.games);
+            CHECK_EQ(summary.totalScore, expected.totalScore);
+            CHECK_EQ(summary.bestScore, expected.bestScore);
+            CHECK_EQ(summary.moves, expected.moves);
+            CHECK_EQ(summary.comboSteps, expected.comboSteps);
+            CHECK_EQ(counts[mode], expected.games);
+
+            // Centile p : le score de rang ceil(p % de n) dans l'ordre croissant (le plus petit pour 0)
+            const vector<double> percents = {0, 10, 50, 90, 99, 100};
+            vector<uint64_t> found;
+            CHECK(scorePercentiles(columns, player, GameMode(mode), percents, found));
+            sort(scores.begin(), scores.end());
+            for (size_t k = 0; k < percents.size() && found.size() == percents.size(); ++k) {
+                const size_t rank = min(scores.size() - 1,
+                                        size_t(ceil(percents[k] / 100.0 * scores.size())) - (percents[k] > 0));
+                CHECK_EQ(found[k], scores[rank]);
+            }
+        }
+
+        // Coups du mode Cible, jour par jour
+        map<uint32_t, pair<uint64_t, uint64_t> > days;
+        for (const GameRecord & game : games) {
+            if ((player != KNoPlayer && game.player != player) || game.mode != ModeTarget) continue;
+            pair<uint64_t, uint64_t> & day = days[game.time - game.time % 86400];
+            day.first++;
+            day.second += game.moves;
+        }
+        vector<TimeBucket> buckets;
+        movesOverTime(columns, player, 86400, buckets);
+        CHECK_EQ(buckets.size(), days.size());
+        size_t k = 0;
+        for (const auto & day : days) {
+            if (k >= buckets.size()) break;
+            CHECK_EQ(buckets[k].start, day.first);
+            CHECK_EQ(buckets[k].games, day.second.first);
+            CHECK_EQ(buckets[k].moves, day.second.second);
+            k++;
+        }
+    }
+    vector<uint64_t> none;
+    CHECK(!scorePercentiles(columns, uint32_t(store.players().size() + 5), ModeClassic, {50}, none));
+}
+
+/**
+ * @brief Ajoute quelques octets à la fin d'une colonne, comme une écriture interrompue
+ */
+void appendGarbage (const char * suffix, size_t bytes) {
+    FILE * file = fopen((string(KStatsBase) + suffix).c_str(), "ab");
+    const string garbage (bytes, '\x5A');
+    fwrite(garbage.data(), 1, garbage.size(), file);
+    fclose(file);
+}
+
+} // namespace
+
+TEST(stats, writeReopenAndQuery) {
+    removeStore();
+    uint64_t state = KTestSeed;
+    RandomScope randomScope(&state);
+    vector<GameRecord> games;
+    {
+        StatsWriter writer (KStatsBase);
+        CHECK(writer.ready());
+        games = drawGames(writer, 20000);
+        // Un lot, puis des parties une à une
+        CHECK(writer.append(games.data(), 19990));
+        for (size_t k = 19990; k < games.size(); ++k) CHECK(writer.append(games[k]));
+        CHECK_EQ(writer.rows(), games.size());
+    }
+    StatsStore store;
+    CHECK(store.open(KStatsBase));
+    CHECK_EQ(store.players().size(), size_t(7));
+    checkQueries(store, games);
+
+    // Un second écrivain reprend à la suite, avec les mêmes numéros de joueurs
+    {
+        StatsWriter writer (KStatsBase);
+        CHECK_EQ(writer.rows(), games.size());
+        const vector<GameRecord> more = drawGames(writer, 3000);
+        CHECK(writer.append(more.data(), more.size()));
+        games.insert(games.end(), more.begin(), more.end());
+    }
+    CHECK(store.open(KStatsBase));
+    CHECK_EQ(store.players().size(), size_t(7));
+    checkQueries(store, games);
+    store.close();
+    removeStore();
+}
+
+TEST(stats, unequalColumnsAreRealigned) {
+    removeStore();
+    uint64_t state = KTestSeed + 1;
+    RandomScope randomScope(&state);
+    vector<GameRecord> games;
+    {
+        StatsWriter writer (KStatsBase);
+        games = drawGames(writer, 500);
+        CHECK(writer.append(games.data(), games.size()));
+    }
+    // Ecriture interrompue : trois parties de plus dans une colonne, une demi-valeur dans une autre
+    appendGarbage(".score.col", 3 * sizeof(uint64_t));
+    appendGarbage(".date.col", 2);
+
+    StatsStore store;
+    CHECK(store.open(KStatsBase));
+    checkQueries(store, games);
+
+    // L'écrivain ramène les colonnes à la même longueur avant d'ajouter
+    {
+        StatsWriter writer (KStatsBase);
+        CHECK_EQ(writer.rows(), games.size());
+        const vector<GameRecord> more = drawGames(writer, 200);
+        CHECK(writer.append(more.data(), more.size()));
+        games.insert(games.end(), more.begin(), more.end());
+    }
+    CHECK(store.open(KStatsBase));
+    checkQueries(store, games);
+    store.close();
+    removeStore();
+}
+
+TEST(stats, failedAppendLeavesColumnsAligned) {
+    removeStore();
+    uint64_t state = KTestSeed + 2;
+    RandomScope randomScope(&state);
+    vector<GameRecord> games;
+    StatsWriter writer (KStatsBase);
+    games = drawGames(writer, 1000);
+    CHECK(writer.append(games.data(), games.size()));
+
+    // Fichiers limités juste au-delà de la colonne des scores : les colonnes de 1 et 4 octets
+    // par partie reçoivent le lot, celle des scores (8 octets) n'en reçoit qu'une partie
+    const vector<GameRecord> lost = drawGames(writer, 1000);
+    struct rlimit saved;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    struct rlimit limited = saved;
+    limited.rlim_cur = 16 + 8 * 1500;
+    void (*previous)(int) = signal(SIGXFSZ, SIG_IGN);
+    CHECK_EQ(setrlimit(RLIMIT_FSIZE, &limited), 0);
+    const bool written = writer.append(lost.data(), lost.size());
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, previous);
+    CHECK(!written);
+    CHECK(writer.ready());
+    CHECK_EQ(writer.rows(), games.size());
+
+    // Les parties suivantes restent alignées
+    const vector<GameRecord> more = drawGames(writer, 300);
+    CHECK(writer.append(more.data(), more.size()));
+    games.insert(games.end(), more.begin(), more.end());
+    StatsStore store;
+    CHECK(store.open(KStatsBase));
+    checkQueries(store, games);
+    store.close();
+    removeStore();
+}
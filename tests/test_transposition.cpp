@@ -0,0 +1,59 @@
+/**
+ * @file test_transposition.cpp
+ * @brief Table de transposition (transposition.h) : entrées vides, profondeur, remplacement
+ */
+#include "harness.h"
+#include "../engine/transposition.h"
+
+using namespace std;
+
+TEST(transposition, emptyTableFindsNothing) {
+    TranspositionTable table(1 << 12);
+    uint64_t score = 7;
+    unsigned depth = 7;
+    // Entrée vide : deux mots nuls, qui ne doivent pas passer pour le hash 0 à la profondeur 0
+    for (uint64_t hash : {uint64_t(0), uint64_t(1), uint64_t(64), ~uint64_t(0)})
+        CHECK(!table.probe(hash, 0, score, depth));
+    CHECK_EQ(score, 7u);
+    CHECK_EQ(table.stats().hits, 0u);
+}
+
+TEST(transposition, zeroHashIsAPosition) {
+    for (size_t bytes : {size_t(64), size_t(1) << 12}) {
+        TranspositionTable table(bytes);
+        table.store(0, 3, 1200);
+        uint64_t score = 0;
+        unsigned depth = 0;
+        CHECK(table.probe(0, 3, score, depth));
+        CHECK_EQ(score, 1200u);
+        CHECK_EQ(depth, 3u);
+        // Le hash 0 occupe une seule entrée de son paquet : les autres restent libres
+        table.store(uint64_t(1) << 40, 1, 5);
+        CHECK_EQ(table.stats().evictions, 0u);
+        CHECK(table.probe(uint64_t(1) << 40, 1, score, depth));
+        CHECK_EQ(score, 5u);
+    }
+}
+
+TEST(transposition, deeperSearchWins) {
+    TranspositionTable table(1 << 12);
+    const uint64_t hash = 0x9E3779B97F4A7C15ULL;
+    table.store(hash, 4, 900);
+    table.store(hash, 2, 100);   // moins profonde : ignorée
+    uint64_t score = 0;
+    unsigned depth = 0;
+    CHECK(table.probe(hash, 4, score, depth));
+    CHECK_EQ(score, 900u);
+    CHECK(!table.probe(hash, 5, score, depth));
+    CHECK_EQ(depth, 4u);
+    table.store(hash, 6, 1500);
+    CHECK(table.probe(hash, 5, score, depth));
+    CHECK_EQ(score, 1500u);
+
+    // Paquet plein : l'entrée la moins profonde est remplacée
+    const uint64_t buckets = table.entries() / KBucketEntries;
+    for (unsigned k = 1; k <= KBucketEntries; ++k) table.store(hash + k * buckets, 10 + k, k);
+    CHECK_EQ(table.stats().evictions, 1u);
+    CHECK(!table.probe(hash, 1, score, depth));
+    CHECK(table.probe(hash + buckets, 11, score, depth));
+}
@@ -0,0 +1,133 @@
+/**
+ * @file daily.cpp
+ * @brief Calendrier du défi du jour : préparation des graines d'une année et inspection
+ *
+ * Exemples : candy_daily generate defis.cal --start=2027-01-01 --days=365 --threads=8
+ *            candy_daily show defis.cal 2027-03-14 --days=7
+ *
+ * generate choisit la graine de chaque jour (voir engine/daily.h), cherche
+ * son par et écrit le calendrier ; show affiche la graine, le par et le
+ * jugement des jours demandés (par défaut : aujourd'hui).
+ */
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../engine/daily.h"
+#include "../engine/game.h"
+#include "../engine/grid.h"
+
+using namespace std;
+
+namespace {
+
+const unsigned KDailyDays (365);
+const unsigned KDailyGames (3000);
+const unsigned KDailyEasyMoves (3);
+const unsigned KDailyMaxEasyPerMille (150);
+const unsigned KDailyEarlyMoves (5);
+const unsigned KDailyMaxBlockedPerMille (10);
+const unsigned KDailyAttempts (32);
+const unsigned KDailyBeam (64);
+const uint64_t KDailyProofBudget (2000000);
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " generate CALENDRIER [--start=AAAA-MM-JJ] [--days=N] [--seed=S] [--threads=N]\n"
+         << "        [--games=N] [--easy-moves=N] [--max-easy=POUR_MILLE] [--early-moves=N] [--max-blocked=POUR_MILLE]\n"
+         << "        [--attempts=N] [--beam=N] [--proof=N]\n"
+         << "        " << executable << " show CALENDRIER [AAAA-MM-JJ] [--days=N]\n";
+}
+
+} // namespace
+
+int main (int argc, char ** argv) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const string command = argv[1];
+    const string fileName = argv[2];
+    uint32_t firstDay = dailyDay(time(nullptr));
+    unsigned days = command == "show" ? 1 : KDailyDays;
+    uint64_t seed = 1;
+    unsigned threads = 0;
+    DailyCriteria criteria = {KGridSize, KNbCandies, KDailyGames, KDailyEasyMoves, KDailyMaxEasyPerMille,
+                              KDailyEarlyMoves, KDailyMaxBlockedPerMille, KDailyAttempts, KDailyBeam,
+                              KDailyProofBudget};
+    for (int a = 3; a < argc; ++a) {
+        const string arg = argv[a];
+        bool valid = true;
+        if (arg.rfind("--start=", 0) == 0) valid = parseDailyDate(arg.substr(8), firstDay);
+        else if (arg.rfind("--days=", 0) == 0) days = atoi(argv[a] + 7);
+        else if (arg.rfind("--seed=", 0) == 0) seed = strtoull(argv[a] + 7, nullptr, 10);
+        else if (arg.rfind("--threads=", 0) == 0) threads = atoi(argv[a] + 10);
+        else if (arg.rfind("--games=", 0) == 0) criteria.games = atoi(argv[a] + 8);
+        else if (arg.rfind("--easy-moves=", 0) == 0) criteria.easyMoves = atoi(argv[a] + 13);
+        else if (arg.rfind("--max-easy=", 0) == 0) criteria.maxEasyPerMille = atoi(argv[a] + 11);
+        else if (arg.rfind("--early-moves=", 0) == 0) criteria.earlyMoves = atoi(argv[a] + 14);
+        else if (arg.rfind("--max-blocked=", 0) == 0) criteria.maxBlockedPerMille = atoi(argv[a] + 14);
+        else if (arg.rfind("--attempts=", 0) == 0) criteria.maxAttempts = atoi(argv[a] + 11);
+        else if (arg.rfind("--beam=", 0) == 0) criteria.beamWidth = atoi(argv[a] + 7);
+        else if (arg.rfind("--proof=", 0) == 0) criteria.proofBudget = strtoull(argv[a] + 8, nullptr, 10);
+        else if (command == "show" && a == 3) valid = parseDailyDate(arg, firstDay);
+        else valid = false;
+        if (!valid) {
+            cerr << "Argument invalide : " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (command == "generate") {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        vector<DailyRecord> records;
+        const DailyReport report = generateDailySeeds(seed, firstDay, days, criteria, threads, records);
+        if (!writeDailyCalendar(fileName, firstDay, criteria.gridSize, criteria.nbCandies, records)) {
+            cerr << "Impossible d'écrire le calendrier " << fileName << endl;
+            return 1;
+        }
+        unsigned proven = 0;
+        double pars = 0;
+        for (const DailyRecord & record : records) {
+            proven += record.parProven;
+            pars += record.par;
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << days << " jours à partir du " << dailyDate(firstDay) << " écrits dans " << fileName << "\n"
+             << report.candidates << " graines jugées sur " << report.games << " parties simulées : "
+             << report.rejectedEasy << " trop faciles, " << report.rejectedBlocked << " bloquées tôt, "
+             << report.unresolved << " jours sans graine acceptée\n"
+             << fixed << setprecision(2) << "par moyen " << (days ? pars / days : 0.0) << ", " << proven
+             << " par prouvés, " << setprecision(1) << seconds << " s" << endl;
+        return 0;
+    }
+
+    if (command == "show") {
+        DailyCalendar calendar;
+        if (!calendar.open(fileName)) {
+            cerr << "Calendrier illisible : " << fileName << endl;
+            return 1;
+        }
+        cout << calendar.size() << " jours à partir du " << dailyDate(calendar.firstDay()) << ", grille "
+             << calendar.gridSize() << "x" << calendar.gridSize() << ", " << calendar.nbCandies() << " bonbons\n";
+        for (unsigned k = 0; k < days; ++k) {
+            DailyRecord record;
+            if (!calendar.record(firstDay + k, record)) {
+                cout << dailyDate(firstDay + k) << " : hors du calendrier\n";
+                continue;
+            }
+            cout << dailyDate(firstDay + k) << " : graine " << record.seed << ", par " << record.par
+                 << (record.parProven ? " (prouvé)" : "") << ", " << unsigned(record.attempts) << " essai(s), "
+                 << record.easyPerMille << " pour mille trop faciles, " << record.blockedPerMille
+                 << " pour mille bloquées tôt\n";
+        }
+        return 0;
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file levels.cpp
+ * @brief Outil des paquets de niveaux : compilation du format texte, génération et inspection
+ *
+ * Exemples : candy_levels build levels/niveaux.txt niveaux.pack
+ *            candy_levels generate 10000 8 essai.pack --seed=3
+ *            candy_levels info niveaux.pack 2
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../engine/level.h"
+
+using namespace std;
+
+namespace {
+
+const char * modeWord (unsigned mode) {
+    switch (mode) {
+    case ModeClassic: return "classique";
+    case ModeTimeTrial: return "contre-la-montre";
+    case ModeTarget: return "cible";
+    }
+    return "?";
+}
+
+/**
+ * @brief Niveau tiré au hasard : trous symétriques sur les bords, bloqueurs et gelée au centre
+ */
+LevelData randomLevel (unsigned size) {
+    LevelData level;
+    level.record.size = size;
+    level.record.nbCandies = 4 + rand() % 3;
+    level.record.mode = rand() % 3;
+    level.record.maxMoves = 15 + rand() % 20;
+    level.record.timeLimit = 45 + rand() % 60;
+    level.record.targetScore = 500 + 100 * (rand() % 20);
+    for (unsigned c = 0; c < KMaxLevelCandies; ++c) level.record.spawnWeights[c] = 1 + rand() % 4;
+
+    level.cells.assign(size * size, KLevelCellCandy);
+    for (unsigned i = 0; i < size; ++i) {
+        for (unsigned j = 0; j < size / 2; ++j) {
+            uint8_t cell = KLevelCellCandy;
+            bool border = i == 0 || i == size - 1 || j == 0;
+            unsigned draw = rand() % 100;
+            if (border && draw < 20) cell = KLevelCellHole;
+            else if (!border && draw < 6) cell = KLevelCellBlocker;
+            else if (!border && draw < 30) cell = KLevelCellCandy | ((1 + rand() % 2) << KLevelJellyShift);
+            level.cells[i * size + j] = cell;
+            level.cells[i * size + size - 1 - j] = cell;
+        }
+    }
+    setLevelSpawn(level, vector<uint8_t>(), vector<vector<uint8_t> >());
+    return level;
+}
+
+void printLevel (size_t index, const LevelView & view) {
+    const LevelRecord & r = *view.record;
+    cout << "# niveau " << index << "\nniveau\ntaille " << r.size << "\nbonbons " << unsigned(r.nbCandies)
+         << "\nmode " << modeWord(r.mode) << "\ncoups " << r.maxMoves << "\ntemps " << r.timeLimit
+         << "\nobjectif " << r.targetScore << "\npoids";
+    for (unsigned c = 0; c < r.nbCandies; ++c) cout << " " << unsigned(r.spawnWeights[c]);
+    vector<uint8_t> script;
+    vector<vector<uint8_t> > queues;
+    readLevelSpawn(view, script, queues);
+    if (!script.empty()) {
+        cout << "\nsequence";
+        for (uint8_t colour : script) cout << " " << unsigned(colour);
+    }
+    for (size_t abs = 0; abs < queues.size(); ++abs) {
+        if (queues[abs].empty()) continue;
+        cout << "\ncolonne " << abs;
+        for (uint8_t colour : queues[abs]) cout << " " << unsigned(colour);
+    }
+    cout << "\ngrille\n";
+    for (unsigned i = 0; i < r.size; ++i) {
+        for (unsigned j = 0; j < r.size; ++j) {
+            const uint8_t cell = view.cells[i * r.size + j];
+            const unsigned jelly = cell >> KLevelJellyShift;
+            if ((cell & KLevelCellKindMask) == KLevelCellHole) cout << 'X';
+            else if ((cell & KLevelCellKindMask) == KLevelCellBlocker) cout << '#';
+            else if (jelly > 0) cout << char('0' + min(jelly, 9u));
+            else cout << '.';
+        }
+        cout << "\n";
+    }
+    cout << "fin" << endl;
+}
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " build SOURCE.txt PAQUET\n"
+         << "        " << executable << " generate NOMBRE TAILLE PAQUET [--seed=S]\n"
+         << "        " << executable << " info PAQUET [NIVEAU]\n";
+}
+
+} // namespace
+
+int main (int argc, char ** argv) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const string command = argv[1];
+
+    if (command == "build" && argc == 4) {
+        ifstream source(argv[2]);
+        if (!source) {
+            cerr << "Impossible d'ouvrir " << argv[2] << endl;
+            return 1;
+        }
+        vector<LevelData> levels;
+        string error;
+        if (!parseLevels(source, levels, error)) {
+            cerr << argv[2] << ", " << error << endl;
+            return 1;
+        }
+        if (!writeLevelPack(argv[3], levels)) {
+            cerr << "Impossible d'écrire " << argv[3] << endl;
+            return 1;
+        }
+        cout << levels.size() << " niveaux écrits dans " << argv[3] << endl;
+        return 0;
+    }
+
+    if (command == "generate" && argc >= 5) {
+        const unsigned count = atoi(argv[2]);
+        const unsigned size = atoi(argv[3]);
+        unsigned seed = 1;
+        if (argc == 6 && string(argv[5]).rfind("--seed=", 0) == 0) seed = atoi(argv[5] + 7);
+        if (size < 3 || size > 1024) {
+            cerr << "La taille doit être entre 3 et 1024." << endl;
+            return 1;
+        }
+        srand(seed);
+        vector<LevelData> levels;
+        for (unsigned n = 0; n < count; ++n) levels.push_back(randomLevel(size));
+        if (!writeLevelPack(argv[4], levels)) {
+            cerr << "Impossible d'écrire " << argv[4] << endl;
+            return 1;
+        }
+        cout << count << " niveaux écrits dans " << argv[4] << endl;
+        return 0;
+    }
+
+    if (command == "info") {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        LevelPack pack;
+        if (!pack.open(argv[2])) {
+            cerr << "Paquet de niveaux illisible : " << argv[2] << endl;
+            return 1;
+        }
+        double openUs = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        if (argc == 4) {
+            LevelView view;
+            size_t index = atol(argv[3]);
+            if (!pack.level(index, view)) {
+                cerr << "Niveau " << index << " absent ou corrompu." << endl;
+                return 1;
+            }
+            printLevel(index, view);
+            return 0;
+        }
+        cout << pack.size() << " niveaux (ouverture : " << openUs << " us)" << endl;
+        return 0;
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
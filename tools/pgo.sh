@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+# Chaîne complète d'optimisation guidée par profil (PGO) :
+#   1. construit le moteur instrumenté (preset pgo-generate)
+#   2. joue des milliers de parties simulées avec graines pour collecter les profils
+#   3. reconstruit avec les profils (preset pgo-use) et la référence sans PGO (preset release)
+#   4. compare le débit de cascades avant / après dans _build/pgo-report.txt
+#
+# Usage : tools/pgo.sh            (depuis n'importe où)
+# Variables : GAMES (parties par mode et par configuration, defaut 2000)
+#             RUNS  (mesures par configuration pour le rapport, defaut 3)
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+cd "$ROOT"
+
+GAMES="${GAMES:-2000}"
+RUNS="${RUNS:-3}"
+PROFILE_DIR="$ROOT/_build/pgo-profiles"
+REPORT="$ROOT/_build/pgo-report.txt"
+
+# Configurations (taille:bonbons) du jeu réel et des variantes de la partie libre :
+# le comportement des branches du match/cascade dépend beaucoup des deux.
+TRAINING_CONFIGS="8:4 8:3 8:5 8:6 8:7 16:4 16:6 32:5"
+REPORT_CONFIGS="8:4 8:6 16:4 32:5"
+
+log () { echo "==> $*"; }
+
+# --- 1. CONSTRUCTION INSTRUMENTEE ---
+
+log "Construction instrumentée"
+rm -rf "$PROFILE_DIR"
+cmake --preset pgo-generate >/dev/null
+cmake --build --preset pgo-generate --target candy_sim
+
+# --- 2. COLLECTE DES PROFILS ---
+
+log "Collecte des profils ($GAMES parties par mode et par configuration)"
+seed=1
+for config in $TRAINING_CONFIGS; do
+    size="${config%%:*}"
+    candies="${config##*:}"
+    games="$GAMES"
+    # Les grandes grilles coûtent beaucoup plus cher par partie
+    if [ "$size" -gt 8 ]; then games=$(( GAMES / (size / 8) )); fi
+    echo "    grille ${size}x${size}, ${candies} bonbons, ${games} parties par mode"
+    "$ROOT/_build/pgo-generate/candy_sim" --mode=all --games="$games" --seed="$seed" \
+        --size="$size" --candies="$candies" >/dev/null
+    seed=$(( seed + games ))
+done
+
+compiler="$(sed -n 's/^set(CMAKE_CXX_COMPILER_ID "\(.*\)")/\1/p' "$ROOT"/_build/pgo-generate/CMakeFiles/*/CMakeCXXCompiler.cmake)"
+if [ "$compiler" = "Clang" ] || [ "$compiler" = "AppleClang" ]; then
+    log "Fusion des profils Clang"
+    llvm-profdata merge -output="$PROFILE_DIR/default.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+# --- 3. CONSTRUCTIONS OPTIMISEES ---
+
+log "Construction avec profils"
+cmake --preset pgo-use >/dev/null
+cmake --build --preset pgo-use --target candy_sim candy_bench
+
+log "Construction de référence (release sans PGO)"
+cmake --preset release >/dev/null
+cmake --build --preset release --target candy_sim candy_bench
+
+# --- 4. RAPPORT ---
+
+# Meilleur débit de cascades (matchs résolus par seconde) sur RUNS mesures
+best_throughput () {
+    local binary="$1" size="$2" candies="$3" mode="$4"
+    local best=0 value
+    for _ in $(seq "$RUNS"); do
+        value="$("$binary" --mode="$mode" --games="$GAMES" --seed=100000 --size="$size" --candies="$candies" --json \
+            | sed -n 's/.*"cascades_per_second": \([0-9.e+]*\).*/\1/p')"
+        best="$(awk -v a="$best" -v b="$value" 'BEGIN { print (b > a) ? b : a }')"
+    done
+    echo "$best"
+}
+
+log "Mesures pour le rapport"
+{
+    echo "Rapport PGO - $(date '+%Y-%m-%d %H:%M') - compilateur : ${compiler:-inconnu}"
+    echo "Débit de cascades (matchs résolus / seconde), meilleur de $RUNS mesures, $GAMES parties"
+    echo
+    printf "%-10s %-18s %14s %14s %9s\n" "grille" "mode" "release" "pgo" "gain"
+    for config in $REPORT_CONFIGS; do
+        size="${config%%:*}"
+        candies="${config##*:}"
+        for mode in classic timetrial target; do
+            before="$(best_throughput "$ROOT/_build/release/candy_sim" "$size" "$candies" "$mode")"
+            after="$(best_throughput "$ROOT/_build/pgo-use/candy_sim" "$size" "$candies" "$mode")"
+            awk -v g="${size}x${size}/${candies}" -v m="$mode" -v a="$before" -v b="$after" \
+                'BEGIN { printf "%-10s %-18s %14.0f %14.0f %+8.1f%%\n", g, m, a, b, (b / a - 1) * 100 }'
+        done
+    done
+} | tee "$REPORT"
+
+"$ROOT/_build/release/candy_bench" --benchmark_filter='BM_resolveCascade/8/|BM_resolveCascade/64/' \
+    --benchmark_out="$ROOT/_build/pgo-bench-release.json" >/dev/null
+"$ROOT/_build/pgo-use/candy_bench" --benchmark_filter='BM_resolveCascade/8/|BM_resolveCascade/64/' \
+    --benchmark_out="$ROOT/_build/pgo-bench-pgo.json" >/dev/null
+
+echo
+echo "Rapport écrit dans $REPORT"
+echo "Benchmarks de cascade : _build/pgo-bench-release.json et _build/pgo-bench-pgo.json"
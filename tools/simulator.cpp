@@ -0,0 +1,370 @@
+/**
+ * @file simulator.cpp
+ * @brief Simulateur sans terminal : joue des milliers de parties avec graines et affiche un bilan
+ *
+ * Exemple : candy_sim --mode=all --games=1000 --seed=1 --json
+ *           candy_sim --levels=niveaux.pack --games=5000
+ *           candy_sim --mode=target --weights=1,1,1,1 --sweep=1:1:6
+ *           candy_sim --robot=greedy --threads=4 --games=200
+ */
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../engine/events.h"
+#include "../engine/instrument.h"
+#include "../engine/simulation.h"
+#include "../engine/trace.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * @struct ModeSummary
+ * @brief Totaux d'un mode sur toutes les parties simulées
+ */
+struct ModeSummary {
+    string name;
+    unsigned games;
+    unsigned long long score;
+    unsigned long long moves;
+    unsigned long long matches;
+    unsigned long long deadMoves;
+    unsigned long long reshuffles;
+    unsigned maxCombo;
+    unsigned targetsReached;
+    double seconds;
+    string weights;   // poids d'apparition ("" : tirage uniforme)
+};
+
+const char * modeName (GameMode mode) {
+    switch (mode) {
+    case ModeClassic: return "classique";
+    case ModeTimeTrial: return "contre-la-montre";
+    case ModeTarget: return "cible";
+    }
+    return "?";
+}
+
+string weightsText (const vector<unsigned> & weights) {
+    string text;
+    for (size_t c = 0; c < weights.size(); ++c) text += (c > 0 ? "," : "") + to_string(weights[c]);
+    return text;
+}
+
+/**
+ * @brief Lit une liste d'entiers séparés par sep (ex: "3,1,1,1" ou "1:1:6")
+ */
+bool parseList (const string & text, char sep, vector<unsigned> & values) {
+    istringstream in(text);
+    string item;
+    values.clear();
+    while (getline(in, item, sep)) {
+        if (item.empty() || item.find_first_not_of("0123456789") != string::npos) return false;
+        values.push_back(atoi(item.c_str()));
+    }
+    return !values.empty();
+}
+
+/**
+ * @param weights Poids d'apparition de chaque couleur, vide pour le tirage uniforme
+ * @param robot Evaluateur du robot glouton, nul pour le robot qui joue au hasard
+ */
+ModeSummary runMode (GameMode mode, unsigned games, unsigned firstSeed, unsigned gridSize, unsigned nbCandies,
+                     const vector<unsigned> & weights, MoveEvaluator * robot) {
+    ModeSummary summary = {modeName(mode), games, 0, 0, 0, 0, 0, 0, 0, 0.0, weightsText(weights)};
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned g = 0; g < games; ++g) {
+        SimConfig config = {mode, firstSeed + g, gridSize, nbCandies, nullptr, weights.empty() ? nullptr : weights.data(),
+                            robot, nullptr};
+        SimResult result = simulateGame(config);
+        summary.score = scoreAdd(summary.score, result.score);
+        summary.moves += result.moves;
+        summary.matches += result.matches;
+        summary.deadMoves += result.deadMoves;
+        summary.reshuffles += result.reshuffles;
+        if (result.maxCombo > summary.maxCombo) summary.maxCombo = result.maxCombo;
+        if (result.reachedTarget) summary.targetsReached++;
+    }
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+/**
+ * @brief Joue les parties sur les niveaux d'un paquet (un seul niveau, ou tous à tour de rôle)
+ * @param levelIndex Niveau joué, ou -1 pour passer d'un niveau au suivant à chaque partie
+ * @param robot Evaluateur du robot glouton, nul pour le robot qui joue au hasard
+ */
+ModeSummary runLevels (const LevelPack & pack, long levelIndex, unsigned games, unsigned firstSeed,
+                       MoveEvaluator * robot) {
+    ModeSummary summary = {"niveaux", games, 0, 0, 0, 0, 0, 0, 0, 0.0, ""};
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned g = 0; g < games; ++g) {
+        LevelView view;
+        pack.level(levelIndex >= 0 ? levelIndex : g % pack.size(), view);
+        SimConfig config = {GameMode(view.record->mode), firstSeed + g, view.record->size, view.record->nbCandies, &view, nullptr,
+                            robot, nullptr};
+        SimResult result = simulateGame(config);
+        summary.score = scoreAdd(summary.score, result.score);
+        summary.moves += result.moves;
+        summary.matches += result.matches;
+        summary.deadMoves += result.deadMoves;
+        summary.reshuffles += result.reshuffles;
+        if (result.maxCombo > summary.maxCombo) summary.maxCombo = result.maxCombo;
+        if (result.reachedTarget) summary.targetsReached++;
+    }
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return summary;
+}
+
+void printText (const ModeSummary & s) {
+    cout << "--- Mode " << s.name << " : " << s.games << " parties";
+    if (!s.weights.empty()) cout << " (poids " << s.weights << ")";
+    cout << " ---" << endl;
+    cout << fixed << setprecision(2);
+    cout << "  Score moyen        : " << double(s.score) / s.games << endl;
+    cout << "  Coups moyens       : " << double(s.moves) / s.games << endl;
+    cout << "  Matchs par coup    : " << double(s.matches) / s.moves << endl;
+    cout << "  Coups sans issue   : " << s.deadMoves << endl;
+    cout << "  Grilles melangees  : " << s.reshuffles << endl;
+    cout << "  Combo maximal      : " << s.maxCombo << endl;
+    if (s.name == "cible" || s.name == "niveaux") cout << "  Objectifs atteints : " << s.targetsReached << endl;
+    cout << "  Temps              : " << s.seconds << " s" << endl;
+    cout << "  Cascades / seconde : " << setprecision(0) << s.matches / s.seconds << endl;
+    cout << defaultfloat;
+}
+
+void printJson (const vector<ModeSummary> & summaries, unsigned gridSize, unsigned nbCandies, unsigned firstSeed,
+                const string & robot) {
+    cout << "{\n  \"grid_size\": " << gridSize << ",\n  \"nb_candies\": " << nbCandies
+         << ",\n  \"first_seed\": " << firstSeed << ",\n  \"robot\": \"" << robot << "\",\n  \"modes\": [\n";
+    cout << setprecision(10);
+    for (size_t i = 0; i < summaries.size(); ++i) {
+        const ModeSummary & s = summaries[i];
+        cout << "    {\"mode\": \"" << s.name << "\", \"weights\": \"" << s.weights << "\", \"games\": " << s.games
+             << ", \"score\": " << s.score << ", \"moves\": " << s.moves
+             << ", \"matches\": " << s.matches << ", \"dead_moves\": " << s.deadMoves
+             << ", \"reshuffles\": " << s.reshuffles
+             << ", \"max_combo\": " << s.maxCombo << ", \"targets_reached\": " << s.targetsReached
+             << ", \"seconds\": " << s.seconds
+             << ", \"cascades_per_second\": " << s.matches / s.seconds << "}"
+             << (i + 1 < summaries.size() ? "," : "") << "\n";
+    }
+    cout << "  ]\n}" << endl;
+}
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " [options]\n"
+         << "  --mode=classic|timetrial|target|all   mode(s) simulé(s) (defaut all)\n"
+         << "  --games=N                             parties par mode (defaut 1000)\n"
+         << "  --seed=S                              graine de la première partie (defaut 1)\n"
+         << "  --size=N                              taille de la grille (defaut " << KGridSize << ")\n"
+         << "  --candies=N                           types de bonbons (defaut " << KNbCandies << ")\n"
+         << "  --weights=P1,P2,...                   poids d'apparition de chaque couleur (defaut uniforme)\n"
+         << "  --sweep=C:MIN:MAX[:PAS]               fait varier le poids de la couleur C (réglage de difficulté)\n"
+         << "  --levels=PAQUET                       joue les niveaux d'un paquet (candy_levels build)\n"
+         << "  --level=N                             seulement le niveau N du paquet (defaut : tous)\n"
+         << "  --robot=random|greedy                 coup au hasard, ou coup qui rapporte le plus (defaut random)\n"
+         << "  --threads=N                           fils du robot glouton (defaut : un par cœur)\n"
+         << "  --json                                bilan au format JSON\n"
+         << "  --trace=FICHIER                       chronologie Chrome trace (build avec CANDY_TRACE)\n"
+         << "  --events=FICHIER                      enregistre les événements des parties, une ligne chacun\n";
+}
+
+/**
+ * @brief Bilan du flux d'événements : publiés, lus par chaque abonné, perdus, et décompte par type
+ */
+void printEvents (ostream & out, const EventStream & events, const EventSubscriber & writer,
+                  const EventSubscriber & counter, const unsigned long long counts []) {
+    out << "--- Evenements : " << events.published() << " publies ---" << endl;
+    out << "  Ecrits             : " << writer.received() << " (" << writer.dropped() << " perdus)" << endl;
+    out << "  Comptes            : " << counter.received() << " (" << counter.dropped() << " perdus)" << endl;
+    for (unsigned kind = EventMoveApplied; kind <= EventGameOver; ++kind)
+        out << "  " << left << setw(19) << eventName(EventKind(kind)) << ": " << counts[kind] << endl;
+    out << right;
+}
+
+} // namespace
+
+int main (int argc, char ** argv) {
+    string mode = "all";
+    unsigned games = 1000;
+    unsigned firstSeed = 1;
+    unsigned gridSize = KGridSize;
+    unsigned nbCandies = KNbCandies;
+    bool json = false;
+    string traceFile;
+    string eventsFile;
+    string levelsFile;
+    long levelIndex = -1;
+    vector<unsigned> weights;
+    vector<unsigned> sweep;
+    string robotName = "random";
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--mode=", 0) == 0) mode = arg.substr(7);
+        else if (arg.rfind("--games=", 0) == 0) games = atoi(arg.substr(8).c_str());
+        else if (arg.rfind("--seed=", 0) == 0) firstSeed = atoi(arg.substr(7).c_str());
+        else if (arg.rfind("--size=", 0) == 0) gridSize = atoi(arg.substr(7).c_str());
+        else if (arg.rfind("--candies=", 0) == 0) nbCandies = atoi(arg.substr(10).c_str());
+        else if (arg.rfind("--weights=", 0) == 0) {
+            if (!parseList(arg.substr(10), ',', weights)) {
+                cerr << "Poids invalides : " << arg.substr(10) << endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--sweep=", 0) == 0) {
+            if (!parseList(arg.substr(8), ':', sweep) || sweep.size() < 3 || sweep.size() > 4) {
+                cerr << "Balayage invalide (attendu C:MIN:MAX[:PAS]) : " << arg.substr(8) << endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--levels=", 0) == 0) levelsFile = arg.substr(9);
+        else if (arg.rfind("--level=", 0) == 0) levelIndex = atol(arg.substr(8).c_str());
+        else if (arg.rfind("--robot=", 0) == 0) robotName = arg.substr(8);
+        else if (arg.rfind("--threads=", 0) == 0) threads = atoi(arg.substr(10).c_str());
+        else if (arg == "--json") json = true;
+        else if (arg.rfind("--trace=", 0) == 0) traceFile = arg.substr(8);
+        else if (arg.rfind("--events=", 0) == 0) eventsFile = arg.substr(9);
+        else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (games == 0 || gridSize < 3 || nbCandies < 3) {
+        cerr << "Il faut au moins 1 partie, une grille de 3x3 et 3 types de bonbons." << endl;
+        return 1;
+    }
+
+    if (!sweep.empty() && weights.empty()) weights.assign(nbCandies, 1);
+    if (!weights.empty() && weights.size() != nbCandies) {
+        cerr << "Il faut un poids par type de bonbon (" << nbCandies << ")." << endl;
+        return 1;
+    }
+    if (nbCandies > KMaxSpawnColours) {
+        cerr << "Au plus " << KMaxSpawnColours << " types de bonbons." << endl;
+        return 1;
+    }
+    unsigned sweepStep = sweep.size() == 4 ? sweep[3] : 1;
+    if (!sweep.empty() && (sweep[0] < 1 || sweep[0] > nbCandies || sweep[1] > sweep[2] || sweepStep == 0)) {
+        cerr << "Balayage invalide : couleur entre 1 et " << nbCandies << ", MIN <= MAX et PAS > 0." << endl;
+        return 1;
+    }
+    AliasTable check;
+    if (!weights.empty() && sweep.empty() && !buildAliasTable(check, weights.data(), nbCandies)) {
+        cerr << "Au moins un poids doit être non nul." << endl;
+        return 1;
+    }
+
+    if (robotName != "random" && robotName != "greedy") {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    vector<GameMode> modes;
+    if (mode == "classic" || mode == "all") modes.push_back(ModeClassic);
+    if (mode == "timetrial" || mode == "all") modes.push_back(ModeTimeTrial);
+    if (mode == "target" || mode == "all") modes.push_back(ModeTarget);
+    if (modes.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!traceFile.empty()) {
+#ifdef CANDY_TRACE
+        if (!traceStart(traceFile)) {
+            cerr << "Impossible d'ouvrir le fichier de trace " << traceFile << endl;
+            return 1;
+        }
+#else
+        cerr << "Trace ignorée : reconstruire avec -DCANDY_TRACE=ON" << endl;
+#endif
+    }
+
+    LevelPack pack;
+    if (!levelsFile.empty()) {
+        if (!pack.open(levelsFile) || pack.size() == 0) {
+            cerr << "Paquet de niveaux illisible : " << levelsFile << endl;
+            return 1;
+        }
+        // Tous les niveaux joués sont vérifiés avant de lancer les parties
+        LevelView view;
+        for (size_t i = 0; i < pack.size(); ++i) {
+            if ((levelIndex < 0 || long(i) == levelIndex) && !pack.level(i, view)) {
+                cerr << "Niveau " << i << " absent ou corrompu dans " << levelsFile << endl;
+                return 1;
+            }
+        }
+        if (levelIndex >= long(pack.size())) {
+            cerr << "Le paquet ne contient que " << pack.size() << " niveaux." << endl;
+            return 1;
+        }
+    }
+
+    unique_ptr<MoveEvaluator> robot;
+    if (robotName == "greedy") robot.reset(new MoveEvaluator(threads));
+
+    // Evénements : un abonné les écrit dans le fichier, un autre les compte, chacun sur son fil
+    ofstream eventsOut;
+    unique_ptr<EventStream> events;
+    unique_ptr<EventSubscriber> writer;
+    unique_ptr<EventSubscriber> counter;
+    unsigned long long eventCounts [EventGameOver + 1] = {};
+    if (!eventsFile.empty()) {
+        eventsOut.open(eventsFile);
+        if (!eventsOut) {
+            cerr << "Impossible d'ouvrir le fichier d'événements " << eventsFile << endl;
+            return 1;
+        }
+        events.reset(new EventStream());
+        writer.reset(new EventSubscriber(*events, [&] (const GameEvent & event) { writeEvent(eventsOut, event); }));
+        counter.reset(new EventSubscriber(*events, [&] (const GameEvent & event) { eventCounts[event.kind]++; }));
+    }
+    EventScope eventScope(events.get());
+
+    vector<ModeSummary> summaries;
+    if (!levelsFile.empty()) {
+        summaries.push_back(runLevels(pack, levelIndex, games, firstSeed, robot.get()));
+        if (!json) printText(summaries.back());
+    }
+    else {
+        // Sans balayage, un seul jeu de poids ; avec, un bilan par poids de la couleur balayée
+        vector<vector<unsigned> > weightSets;
+        if (sweep.empty()) {
+            weightSets.push_back(weights);
+        }
+        else {
+            for (unsigned w = sweep[1]; w <= sweep[2]; w += sweepStep) {
+                weights[sweep[0] - 1] = w;
+                if (buildAliasTable(check, weights.data(), nbCandies)) weightSets.push_back(weights);
+            }
+        }
+        for (const vector<unsigned> & set : weightSets) {
+            for (GameMode m : modes) {
+                summaries.push_back(runMode(m, games, firstSeed, gridSize, nbCandies, set, robot.get()));
+                if (!json) printText(summaries.back());
+            }
+        }
+    }
+    if (json) printJson(summaries, gridSize, nbCandies, firstSeed, robotName);
+    if (events) {
+        // Les abonnés lisent la fin du flux avant de s'arrêter
+        writer->stop();
+        counter->stop();
+        printEvents(json ? cerr : cout, *events, *writer, *counter, eventCounts);
+    }
+    CANDY_TRACE_STOP();
+    CANDY_INSTR_REPORT("candy_sim");
+    return 0;
+}
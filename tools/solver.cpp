@@ -0,0 +1,92 @@
+/**
+ * @file solver.cpp
+ * @brief Par des graines du mode Cible : plus petit nombre d'échanges trouvé pour atteindre la cible
+ *
+ * Exemples : candy_solve 20261019
+ *            candy_solve 1 --count=30 --beam=32 --threads=8
+ *            candy_solve 7 --target=500 --moves
+ *
+ * Pour chaque graine (de GRAINE à GRAINE + count - 1), affiche le par, s'il
+ * est prouvé (voir engine/solver.h), le score de la solution rejouée depuis
+ * le début et le temps de la recherche ; avec --moves, la suite des échanges
+ * (ligne colonne direction, comme la saisie du jeu).
+ */
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../engine/game.h"
+#include "../engine/solver.h"
+
+using namespace std;
+
+namespace {
+
+const unsigned KSolveBeam (64);
+const unsigned KSolveTableMb (64);
+const uint64_t KSolveProofBudget (5000000);
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " GRAINE [--count=N] [--beam=N] [--threads=N] [--target=S]\n"
+         << "        [--max-moves=N] [--proof=N] [--size=N] [--candies=N] [--table=Mo] [--moves]\n";
+}
+
+} // namespace
+
+int main (int argc, char ** argv) {
+    if (argc < 2 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+    SolveConfig config;
+    config.seed = strtoull(argv[1], nullptr, 10);
+    config.gridSize = KGridSize;
+    config.nbCandies = KNbCandies;
+    config.targetScore = KTargetScore;
+    config.beamWidth = KSolveBeam;
+    config.maxMoves = KSolveMaxMoves;
+    config.threads = 0;
+    config.proofBudget = KSolveProofBudget;
+    config.tableBytes = size_t(KSolveTableMb) << 20;
+    unsigned count = 1;
+    bool showMoves = false;
+    for (int a = 2; a < argc; ++a) {
+        const string arg = argv[a];
+        if (arg.rfind("--count=", 0) == 0) count = atoi(argv[a] + 8);
+        else if (arg.rfind("--beam=", 0) == 0) config.beamWidth = atoi(argv[a] + 7);
+        else if (arg.rfind("--threads=", 0) == 0) config.threads = atoi(argv[a] + 10);
+        else if (arg.rfind("--target=", 0) == 0) config.targetScore = strtoull(argv[a] + 9, nullptr, 10);
+        else if (arg.rfind("--max-moves=", 0) == 0) config.maxMoves = atoi(argv[a] + 12);
+        else if (arg.rfind("--proof=", 0) == 0) config.proofBudget = strtoull(argv[a] + 8, nullptr, 10);
+        else if (arg.rfind("--size=", 0) == 0) config.gridSize = atoi(argv[a] + 7);
+        else if (arg.rfind("--candies=", 0) == 0) config.nbCandies = atoi(argv[a] + 10);
+        else if (arg.rfind("--table=", 0) == 0) config.tableBytes = size_t(atoi(argv[a] + 8)) << 20;
+        else if (arg == "--moves") showMoves = true;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.gridSize < 3 || config.nbCandies < 3) {
+        cerr << "Il faut une grille d'au moins 3 cases de côté et au moins 3 bonbons." << endl;
+        return 1;
+    }
+
+    for (unsigned k = 0; k < count; ++k, ++config.seed) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        const SolveResult result = solveTarget(config);
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "graine " << config.seed << " : ";
+        if (!result.found) cout << "cible non atteinte en " << min(config.maxMoves, KSolveMaxMoves) << " coups";
+        else cout << "par " << result.par << (result.proven ? " prouvé" : " non prouvé") << " (score rejoué "
+                  << replaySolution(config, result.moves) << ")";
+        cout << ", " << result.nodes << " coups essayés, " << result.pruned << " états écartés, table "
+             << int(result.table.hitRate() * 100) << " % de succès, " << seconds << " s" << endl;
+        if (showMoves && result.found) {
+            for (const SolveMove & move : result.moves)
+                cout << "  " << move.pos.ord << " " << move.pos.abs << " " << move.direction << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file stats.cpp
+ * @brief Outil de l'entrepôt des statistiques : bilan d'un joueur et génération de parties d'essai
+ *
+ * Exemples : candy_stats show statistiques rafael
+ *            candy_stats show statistiques --days=7
+ *            candy_stats generate essai 100000000 --players=50000 --seed=3
+ *
+ * show donne, par mode, le nombre de parties, le score moyen, le meilleur,
+ * les centiles 50, 90 et 99 et la profondeur moyenne des combos, puis les
+ * coups pour atteindre la cible période par période, et le temps des requêtes.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../engine/spawn.h"
+#include "../engine/stats.h"
+
+using namespace std;
+
+namespace {
+
+const unsigned KStatsPlayers (1000);
+const unsigned KStatsDays (1);
+const unsigned KDaySeconds (86400);
+const size_t KShownPeriods (30);            // dernières périodes affichées
+const size_t KGenerateBatch (1 << 20);      // parties écrites par ajout
+const uint32_t KGenerateSpan (365 * KDaySeconds);
+
+const char * modeWord (unsigned mode) {
+    switch (mode) {
+    case ModeClassic: return "classique";
+    case ModeTimeTrial: return "contre-la-montre";
+    case ModeTarget: return "cible";
+    }
+    return "?";
+}
+
+string dayOf (uint32_t time) {
+    const time_t seconds = time;
+    char text [16];
+    strftime(text, sizeof(text), "%Y-%m-%d", gmtime(&seconds));
+    return text;
+}
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " show ENTREPOT [PSEUDO] [--days=N]\n"
+         << "        " << executable << " generate ENTREPOT NOMBRE [--players=N] [--seed=S]\n";
+}
+
+/**
+ * @brief Partie tirée au hasard : le mode Cible demande moins de coups avec le temps (le joueur progresse)
+ */
+GameRecord randomGame (uint32_t players, uint32_t now) {
+    GameRecord game;
+    game.player = spawnRandom() % players;
+    game.mode = spawnRandom() % KNbGameModes;
+    game.time = now - spawnRandom() % KGenerateSpan;
+    const uint32_t age = (now - game.time) / KDaySeconds;
+    game.moves = game.mode == ModeTarget ? 10 + age / 20 + spawnRandom() % 15 : 20 + spawnRandom() % 30;
+    game.comboSteps = game.moves + spawnRandom() % (game.moves + 1);
+    game.score = uint64_t(game.comboSteps) * (50 + spawnRandom() % 100);
+    return game;
+}
+
+} // namespace
+
+int main (int argc, char ** argv) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const string command = argv[1];
+    string pseudo;
+    unsigned days = KStatsDays;
+    unsigned players = KStatsPlayers;
+    uint64_t seed = 1;
+    for (int a = 3; a < argc; ++a) {
+        const string arg = argv[a];
+        if (arg.rfind("--days=", 0) == 0) days = atoi(argv[a] + 7);
+        else if (arg.rfind("--players=", 0) == 0) players = atoi(argv[a] + 10);
+        else if (arg.rfind("--seed=", 0) == 0) seed = strtoull(argv[a] + 7, nullptr, 10);
+        else if (command == "show" && a == 3) pseudo = arg;
+    }
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    if (command == "generate" && argc >= 4) {
+        const size_t count = strtoull(argv[3], nullptr, 10);
+        if (players == 0) {
+            cerr << "Il faut au moins un joueur." << endl;
+            return 1;
+        }
+        StatsWriter writer(argv[2]);
+        vector<uint32_t> ids (players);
+        for (unsigned p = 0; p < players; ++p) ids[p] = writer.player("joueur_" + to_string(p));
+
+        uint64_t state = seed;
+        RandomScope randomScope(&state);
+        const uint32_t now = time(nullptr);
+        vector<GameRecord> batch;
+        for (size_t done = 0; done < count; done += batch.size()) {
+            batch.resize(min(KGenerateBatch, count - done));
+            for (GameRecord & game : batch) {
+                game = randomGame(players, now);
+                game.player = ids[game.player];
+            }
+            if (!writer.append(batch.data(), batch.size())) {
+                cerr << "Impossible d'écrire l'entrepôt " << argv[2] << endl;
+                return 1;
+            }
+        }
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << count << " parties de " << players << " joueurs ajoutées à " << argv[2] << " (" << seconds << " s)"
+             << endl;
+        return 0;
+    }
+
+    if (command == "show") {
+        StatsStore store;
+        if (!store.open(argv[2])) {
+            cerr << "Entrepôt illisible : " << argv[2] << endl;
+            return 1;
+        }
+        const StatColumns & columns = store.columns();
+        uint32_t player = KNoPlayer;
+        if (!pseudo.empty()) {
+            player = store.players().find(pseudo);
+            if (player == KNoPlayer) {
+                cerr << "Aucune partie pour " << pseudo << endl;
+                return 1;
+            }
+        }
+        const chrono::steady_clock::time_point opened = chrono::steady_clock::now();
+
+        cout << columns.count << " parties, " << store.players().size() << " joueurs ; bilan de "
+             << (pseudo.empty() ? "tous les joueurs" : pseudo) << "\n\n"
+             << left << setw(18) << "mode" << right << setw(12) << "parties" << setw(12) << "moyenne"
+             << setw(12) << "meilleur" << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99"
+             << setw(10) << "combo" << "\n";
+        uint64_t counts [KNbGameModes];
+        countGamesPerMode(columns, player, counts);
+        const vector<double> percents = {50, 90, 99};
+        for (unsigned mode = 0; mode < KNbGameModes; ++mode) {
+            cout << left << setw(18) << modeWord(mode) << right << setw(12) << counts[mode];
+            if (counts[mode] == 0) {
+                cout << "\n";
+                continue;
+            }
+            const StatSummary summary = summarizeGames(columns, player, GameMode(mode));
+            vector<uint64_t> scores;
+            scorePercentiles(columns, player, GameMode(mode), percents, scores);
+            cout << fixed << setprecision(1) << setw(12) << summary.averageScore() << setw(12) << summary.bestScore;
+            for (uint64_t score : scores) cout << setw(10) << score;
+            cout << setprecision(2) << setw(10) << summary.averageCombo() << "\n";
+        }
+
+        vector<TimeBucket> buckets;
+        movesOverTime(columns, player, max(1u, days) * KDaySeconds, buckets);
+        if (!buckets.empty()) {
+            cout << "\nCoups pour atteindre la cible (périodes de " << max(1u, days) << " jour(s)) :\n";
+            for (size_t k = buckets.size() - min(buckets.size(), KShownPeriods); k < buckets.size(); ++k) {
+                cout << dayOf(buckets[k].start) << " : " << setw(10) << buckets[k].games << " parties, "
+                     << setprecision(1) << buckets[k].averageMoves() << " coups en moyenne\n";
+            }
+        }
+        const chrono::steady_clock::time_point done = chrono::steady_clock::now();
+        cout << setprecision(3) << "\nOuverture : " << chrono::duration<double>(opened - start).count()
+             << " s, requêtes : " << chrono::duration<double>(done - opened).count() << " s" << endl;
+        return 0;
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}
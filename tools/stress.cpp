@@ -0,0 +1,130 @@
+/**
+ * @file stress.cpp
+ * @brief Essai de charge des grilles en tuiles : création, remplissage et réaction en chaîne
+ *
+ * Exemples : candy_stress create grille.til 100000 --seed=3
+ *            candy_stress cascade grille.til --matches=1000
+ *
+ * cascade pose des alignements verticaux de 3 au hasard puis résout toute
+ * la réaction en chaîne, et donne les tuiles touchées, les défauts de page
+ * et la mémoire résidente maximale du processus.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../engine/spawn.h"
+#include "../engine/tiled.h"
+
+using namespace std;
+
+namespace {
+
+const unsigned KStressCandies (5);
+const unsigned KStressMatches (100);
+
+void printUsage (const char * executable) {
+    cout << "Usage : " << executable << " create FICHIER TAILLE [--candies=N] [--seed=S]\n"
+         << "        " << executable << " cascade FICHIER [--matches=N] [--steps=N] [--seed=S]\n";
+}
+
+/**
+ * @brief Alignement vertical de 3 posé avant la réaction en chaîne
+ */
+struct Forced {
+    unsigned abs;
+    unsigned ord;
+    unsigned colour;
+};
+
+bool reopen (TiledBoard & board, const char * fileName) {
+    board.close();
+    if (board.open(fileName)) return true;
+    cerr << "Grille en tuiles illisible : " << fileName << endl;
+    return false;
+}
+
+long maxResidentKb () {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+} // namespace
+
+int main (int argc, char ** argv) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const string command = argv[1];
+    unsigned nbCandies = KStressCandies;
+    unsigned matches = KStressMatches;
+    unsigned maxSteps = 0;
+    uint64_t seed = 1;
+    for (int a = 3; a < argc; ++a) {
+        const string arg = argv[a];
+        if (arg.rfind("--candies=", 0) == 0) nbCandies = atoi(argv[a] + 10);
+        else if (arg.rfind("--matches=", 0) == 0) matches = atoi(argv[a] + 10);
+        else if (arg.rfind("--steps=", 0) == 0) maxSteps = atoi(argv[a] + 8);
+        else if (arg.rfind("--seed=", 0) == 0) seed = strtoull(argv[a] + 7, nullptr, 10);
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    TiledBoard board;
+
+    if (command == "create" && argc >= 4) {
+        const unsigned size = atoi(argv[3]);
+        if (size < 3 || nbCandies < 3 || nbCandies > 15) {
+            cerr << "La taille doit être au moins 3 et le nombre de bonbons entre 3 et 15." << endl;
+            return 1;
+        }
+        if (!board.create(argv[2], size, nbCandies)) {
+            cerr << "Impossible de créer " << argv[2] << endl;
+            return 1;
+        }
+        board.fill(seed);
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Grille " << size << " x " << size << " écrite dans " << argv[2] << " ("
+             << board.fileBytes() / (1024 * 1024) << " Mo, " << seconds << " s, mémoire max "
+             << maxResidentKb() / 1024 << " Mo)" << endl;
+        return 0;
+    }
+
+    if (command == "cascade") {
+        if (!reopen(board, argv[2])) return 1;
+        const unsigned size = board.size();
+        // Alignements posés bande par bande, la grille est rouverte entre deux bandes : les pages
+        // touchées sont rendues et la mémoire maximale mesurée reste celle de la réaction en chaîne
+        vector<Forced> forced (matches);
+        uint64_t state = seed;
+        {
+            RandomScope randomScope(&state);
+            for (Forced & match : forced) {
+                match.abs = spawnRandom() % size;
+                match.ord = spawnRandom() % (size - 2);
+                match.colour = spawnRandom() % board.nbCandies() + 1;
+            }
+        }
+        sort(forced.begin(), forced.end(), [] (const Forced & a, const Forced & b) { return a.abs < b.abs; });
+        for (size_t k = 0; k < forced.size(); ++k) {
+            if (k > 0 && forced[k].abs / KTileSide != forced[k - 1].abs / KTileSide && !reopen(board, argv[2])) return 1;
+            for (unsigned i = forced[k].ord; i < forced[k].ord + 3; ++i) board.set(i, forced[k].abs, forced[k].colour);
+        }
+        if (!reopen(board, argv[2])) return 1;
+        const TiledReport report = board.resolve(forkSeed(seed, size), maxSteps);
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "Pas : " << report.steps << "\nCases vidées : " << report.cleared
+             << "\nTuiles lues : " << report.tileVisits << " (" << report.tilesTouched << " différentes)"
+             << "\nDéfauts de page : " << report.minorFaults << " mineurs, " << report.majorFaults << " majeurs"
+             << "\nTemps : " << seconds << " s\nMémoire max : " << maxResidentKb() / 1024 << " Mo" << endl;
+        return 0;
+    }
+
+    printUsage(argv[0]);
+    return 1;
+}